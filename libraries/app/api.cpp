@@ -25,8 +25,10 @@
 
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_worker_pool.hpp>
 #include <graphene/app/application.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/db_with.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/utilities/key_conversion.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
@@ -49,6 +51,7 @@ template class fc::api<graphene::app::crypto_api>;
 template class fc::api<graphene::app::asset_api>;
 template class fc::api<graphene::app::orders_api>;
 template class fc::api<graphene::app::custom_operations_api>;
+template class fc::api<graphene::app::metrics_api>;
 template class fc::api<graphene::debug_witness::debug_api>;
 template class fc::api<graphene::app::login_api>;
 
@@ -58,10 +61,16 @@ namespace graphene { namespace app {
     login_api::login_api(application& a)
     :_app(a)
     {
+       api_call_statistics* stats = _app.get_api_call_statistics();
+       if( stats != nullptr )
+          _connection_id = stats->register_connection();
     }
 
     login_api::~login_api()
     {
+       api_call_statistics* stats = _app.get_api_call_statistics();
+       if( stats != nullptr )
+          stats->unregister_connection( _connection_id );
     }
 
     bool login_api::login(const string& user, const string& password)
@@ -83,6 +92,10 @@ namespace graphene { namespace app {
 
        for( const std::string& api_name : acc->allowed_apis )
           enable_api( api_name );
+
+       api_call_statistics* stats = _app.get_api_call_statistics();
+       if( stats != nullptr )
+          stats->set_connection_user( _connection_id, user );
        return true;
     }
 
@@ -90,7 +103,9 @@ namespace graphene { namespace app {
     {
        if( api_name == "database_api" )
        {
-          _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ), &( _app.get_options() ) );
+          _database_api = std::make_shared< database_api >( std::ref( *_app.chain_database() ), &( _app.get_options() ),
+                                                            _app.get_api_worker_pool(),
+                                                            _app.get_api_call_statistics(), _connection_id );
        }
        else if( api_name == "block_api" )
        {
@@ -102,7 +117,7 @@ namespace graphene { namespace app {
        }
        else if( api_name == "history_api" )
        {
-          _history_api = std::make_shared< history_api >( _app );
+          _history_api = std::make_shared< history_api >( _app, _connection_id );
        }
        else if( api_name == "network_node_api" )
        {
@@ -114,7 +129,7 @@ namespace graphene { namespace app {
        }
        else if( api_name == "asset_api" )
        {
-          _asset_api = std::make_shared< asset_api >( _app );
+          _asset_api = std::make_shared< asset_api >( _app, _connection_id );
        }
        else if( api_name == "orders_api" )
        {
@@ -125,6 +140,10 @@ namespace graphene { namespace app {
           if( _app.get_plugin( "custom_operations" ) )
              _custom_operations_api = std::make_shared< custom_operations_api >( std::ref( _app ) );
        }
+       else if( api_name == "metrics_api" )
+       {
+          _metrics_api = std::make_shared< metrics_api >( std::ref( _app ) );
+       }
        else if( api_name == "debug_api" )
        {
           // can only enable this API if the plugin was loaded
@@ -195,6 +214,48 @@ namespace graphene { namespace app {
        return fc::future<fc::variant>(prom).wait();
     }
 
+    vector<network_broadcast_api::transaction_batch_result> network_broadcast_api::broadcast_transaction_batch(
+          const vector<precomputable_transaction>& trxs )
+    {
+       FC_ASSERT( _app.p2p_node() != nullptr, "Not connected to P2P network, can't broadcast!" );
+       const auto configured_limit = _app.get_options().api_limit_broadcast_transaction_batch;
+       FC_ASSERT( trxs.size() <= configured_limit,
+                  "Number of transactions can not be greater than ${configured_limit}",
+                  ("configured_limit", configured_limit) );
+
+       graphene::chain::database& db = *_app.chain_database();
+       db.precompute_parallel( trxs ).wait();
+
+       vector<transaction_batch_result> results;
+       results.reserve( trxs.size() );
+       vector<signed_transaction> accepted;
+       accepted.reserve( trxs.size() );
+       {
+          // publish the state once for the whole batch instead of once per transaction
+          graphene::chain::detail::chain_state_write_guard write_guard( db );
+          for( const auto& trx : trxs )
+          {
+             transaction_batch_result result;
+             result.id = trx.id();
+             try
+             {
+                db.push_transaction( trx );
+                result.accepted = true;
+                accepted.push_back( trx );
+             }
+             catch( const fc::exception& e )
+             {
+                result.error = e.to_string();
+             }
+             results.push_back( std::move( result ) );
+          }
+       }
+
+       if( !accepted.empty() )
+          _app.p2p_node()->broadcast_transactions( accepted );
+       return results;
+    }
+
     void network_broadcast_api::broadcast_block( const signed_block& b )
     {
        FC_ASSERT( _app.p2p_node() != nullptr, "Not connected to P2P network, can't broadcast!" );
@@ -256,6 +317,37 @@ namespace graphene { namespace app {
        return _app.p2p_node()->set_advanced_node_parameters(params);
     }
 
+    metrics_api::metrics_api( application& a ) : _app( a )
+    {
+    }
+
+    std::map<std::string, api_method_statistics> metrics_api::get_api_call_statistics() const
+    {
+       return get_statistics().get_method_statistics();
+    }
+
+    std::vector<api_connection_statistics> metrics_api::get_api_connection_statistics() const
+    {
+       return get_statistics().get_connection_statistics();
+    }
+
+    std::string metrics_api::get_prometheus_metrics() const
+    {
+       return get_statistics().get_prometheus_text();
+    }
+
+    void metrics_api::reset_api_call_statistics()
+    {
+       get_statistics().reset();
+    }
+
+    api_call_statistics& metrics_api::get_statistics() const
+    {
+       api_call_statistics* stats = _app.get_api_call_statistics();
+       FC_ASSERT( stats != nullptr, "API call statistics are not enabled, see enable-api-call-statistics" );
+       return *stats;
+    }
+
     fc::api<network_broadcast_api> login_api::network_broadcast()const
     {
        FC_ASSERT(_network_broadcast_api);
@@ -304,6 +396,12 @@ namespace graphene { namespace app {
        return *_orders_api;
     }
 
+    fc::api<metrics_api> login_api::metrics() const
+    {
+       FC_ASSERT(_metrics_api);
+       return *_metrics_api;
+    }
+
     fc::api<graphene::debug_witness::debug_api> login_api::debug() const
     {
        FC_ASSERT(_debug_api);
@@ -316,34 +414,62 @@ namespace graphene { namespace app {
        return *_custom_operations_api;
     }
 
+    template<typename Lambda>
+    auto history_api::run_locked( const char* method, Lambda&& f )const -> decltype( f() )
+    {
+       api_worker_pool* pool = _app.get_api_worker_pool();
+       if( pool == nullptr )
+          return f();
+       return pool->run( *_app.chain_database(), method, f );
+    }
+
+    template<typename Lambda>
+    auto history_api::measure( const char* method, Lambda&& f )const -> decltype( f() )
+    {
+       api_call_statistics* stats = _app.get_api_call_statistics();
+       if( stats == nullptr )
+          return f();
+       return stats->measure( _connection_id, method, f );
+    }
+
+    template<typename Lambda>
+    auto history_api::run_read( const char* method, Lambda&& f )const -> decltype( f() )
+    {
+       return measure( method, [this,method,&f]() -> decltype( f() ) {
+          return run_locked( method, f );
+       } );
+    }
+
     vector<order_history_object> history_api::get_fill_order_history( std::string asset_a, std::string asset_b,
                                                                       uint32_t limit )const
     {
-       auto market_hist_plugin = _app.get_plugin<market_history_plugin>( "market_history" );
-       FC_ASSERT( market_hist_plugin, "Market history plugin is not enabled" );
-       FC_ASSERT(_app.chain_database());
-       const auto& db = *_app.chain_database();
-       asset_id_type a = database_api.get_asset_id_from_string( asset_a );
-       asset_id_type b = database_api.get_asset_id_from_string( asset_b );
-       if( a > b ) std::swap(a,b);
-       const auto& history_idx = db.get_index_type<graphene::market_history::history_index>().indices().get<by_key>();
-       history_key hkey;
-       hkey.base = a;
-       hkey.quote = b;
-       hkey.sequence = std::numeric_limits<int64_t>::min();
-
-       uint32_t count = 0;
-       auto itr = history_idx.lower_bound( hkey );
-       vector<order_history_object> result;
-       while( itr != history_idx.end() && count < limit)
-       {
-          if( itr->key.base != a || itr->key.quote != b ) break;
-          result.push_back( *itr );
-          ++itr;
-          ++count;
-       }
+       return run_read( "history_api.get_fill_order_history", [&]() {
+          auto market_hist_plugin = _app.get_plugin<market_history_plugin>( "market_history" );
+          FC_ASSERT( market_hist_plugin, "Market history plugin is not enabled" );
+          FC_ASSERT(_app.chain_database());
+          const auto& db = *_app.chain_database();
+          asset_id_type a = database_api.get_asset_id_from_string( asset_a );
+          asset_id_type b = database_api.get_asset_id_from_string( asset_b );
+          if( a > b ) std::swap(a,b);
+          const auto& history_idx = db.get_index_type<graphene::market_history::history_index>().indices().get<by_key>();
+          history_key hkey;
+          hkey.base = a;
+          hkey.quote = b;
+          hkey.sequence = std::numeric_limits<int64_t>::min();
+
+          uint32_t count = 0;
+          auto itr = history_idx.lower_bound( hkey );
+          vector<order_history_object> result;
+          while( itr != history_idx.end() && count < limit)
+          {
+             if( itr->key.base != a || itr->key.quote != b ) break;
+             result.push_back( *itr );
+             ++itr;
+             ++count;
+          }
 
-       return result;
+          return result;
+       } );
     }
 
     vector<operation_history_object> history_api::get_account_history( const std::string account_id_or_name,
@@ -359,18 +485,31 @@ namespace graphene { namespace app {
                   "limit can not be greater than ${configured_limit}",
                   ("configured_limit", configured_limit) );
 
-       vector<operation_history_object> result;
-       account_id_type account;
-       try {
-          account = database_api.get_account_id_from_string(account_id_or_name);
-          const account_transaction_history_object& node = account(db).statistics(db).most_recent_op(db);
-          if(start == operation_history_id_type() || start.instance.value > node.operation_id.instance.value)
-             start = node.operation_id;
-       } catch(...) { return result; }
-
+       std::shared_ptr<elasticsearch::elasticsearch_plugin> es;
        if(_app.is_plugin_enabled("elasticsearch")) {
-          auto es = _app.get_plugin<elasticsearch::elasticsearch_plugin>("elasticsearch");
-          if(es.get()->get_running_mode() != elasticsearch::mode::only_save) {
+          es = _app.get_plugin<elasticsearch::elasticsearch_plugin>("elasticsearch");
+          if(es.get()->get_running_mode() == elasticsearch::mode::only_save)
+             es.reset();
+       }
+
+       // One sample for the whole call, including the wait for elasticsearch
+       const char* method = "history_api.get_account_history";
+       return measure( method, [&]() -> vector<operation_history_object> {
+          vector<operation_history_object> result;
+          account_id_type account;
+          auto resolve_start = [&]() {
+             account = database_api.get_account_id_from_string(account_id_or_name);
+             const account_transaction_history_object& node = account(db).statistics(db).most_recent_op(db);
+             if(start == operation_history_id_type() || start.instance.value > node.operation_id.instance.value)
+                start = node.operation_id;
+          };
+
+          // Note: do not hold the chain state lock of an API worker thread while waiting for elasticsearch
+          if(es) {
+             try {
+                run_locked( method, resolve_start );
+             } catch(...) { return result; }
+
              if(!_app.elasticsearch_thread)
                 _app.elasticsearch_thread= std::make_shared<fc::thread>("elasticsearch");
 
@@ -378,24 +517,31 @@ namespace graphene { namespace app {
                 return es->get_account_history(account, stop, limit, start);
              }, "thread invoke for method " BOOST_PP_STRINGIZE(method_name)).wait();
           }
-       }
 
-       const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
-       const auto& by_op_idx = hist_idx.indices().get<by_op>();
-       auto index_start = by_op_idx.begin();
-       auto itr = by_op_idx.lower_bound(boost::make_tuple(account, start));
+          // The account lookup and the index walk see the same chain state
+          return run_locked( method, [&]() {
+             try {
+                resolve_start();
+             } catch(...) { return result; }
 
-       while(itr != index_start && itr->account == account && itr->operation_id.instance.value > stop.instance.value && result.size() < limit)
-       {
-          if(itr->operation_id.instance.value <= start.instance.value)
-             result.push_back(itr->operation_id(db));
-          --itr;
-       }
-       if(stop.instance.value == 0 && result.size() < limit && itr->account == account) {
-         result.push_back(itr->operation_id(db));
-       }
+             const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
+             const auto& by_op_idx = hist_idx.indices().get<by_op>();
+             auto index_start = by_op_idx.begin();
+             auto itr = by_op_idx.lower_bound(boost::make_tuple(account, start));
 
-       return result;
+             while(itr != index_start && itr->account == account && itr->operation_id.instance.value > stop.instance.value && result.size() < limit)
+             {
+                if(itr->operation_id.instance.value <= start.instance.value)
+                   result.push_back(itr->operation_id(db));
+                --itr;
+             }
+             if(stop.instance.value == 0 && result.size() < limit && itr->account == account) {
+               result.push_back(itr->operation_id(db));
+             }
+
+             return result;
+          } );
+       } );
     }
 
     vector<operation_history_object> history_api::get_account_history_operations( const std::string account_id_or_name,
@@ -404,42 +550,44 @@ namespace graphene { namespace app {
                                                                        operation_history_id_type stop,
                                                                        uint32_t limit ) const
     {
-       FC_ASSERT( _app.chain_database() );
-       const auto& db = *_app.chain_database();
-
-       const auto configured_limit = _app.get_options().api_limit_get_account_history_operations;
-       FC_ASSERT( limit <= configured_limit,
-                  "limit can not be greater than ${configured_limit}",
-                  ("configured_limit", configured_limit) );
-
-       vector<operation_history_object> result;
-       account_id_type account;
-       try {
-          account = database_api.get_account_id_from_string(account_id_or_name);
-       } catch(...) { return result; }
-       const auto& stats = account(db).statistics(db);
-       if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
-       const account_transaction_history_object* node = &stats.most_recent_op(db);
-       if( start == operation_history_id_type() )
-          start = node->operation_id;
-
-       while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
-       {
-          if( node->operation_id.instance.value <= start.instance.value ) {
+       return run_read( "history_api.get_account_history_operations", [&]() {
+          FC_ASSERT( _app.chain_database() );
+          const auto& db = *_app.chain_database();
+
+          const auto configured_limit = _app.get_options().api_limit_get_account_history_operations;
+          FC_ASSERT( limit <= configured_limit,
+                     "limit can not be greater than ${configured_limit}",
+                     ("configured_limit", configured_limit) );
+
+          vector<operation_history_object> result;
+          account_id_type account;
+          try {
+             account = database_api.get_account_id_from_string(account_id_or_name);
+          } catch(...) { return result; }
+          const auto& stats = account(db).statistics(db);
+          if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
+          const account_transaction_history_object* node = &stats.most_recent_op(db);
+          if( start == operation_history_id_type() )
+             start = node->operation_id;
+
+          while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
+          {
+             if( node->operation_id.instance.value <= start.instance.value ) {
 
-             if(node->operation_id(db).op.which() == operation_type)
-               result.push_back( node->operation_id(db) );
+                if(node->operation_id(db).op.which() == operation_type)
+                  result.push_back( node->operation_id(db) );
+             }
+             if( node->next == account_transaction_history_id_type() )
+                node = nullptr;
+             else node = &node->next(db);
           }
-          if( node->next == account_transaction_history_id_type() )
-             node = nullptr;
-          else node = &node->next(db);
-       }
-       if( stop.instance.value == 0 && result.size() < limit ) {
-          auto head = db.find(account_transaction_history_id_type());
-          if (head != nullptr && head->account == account && head->operation_id(db).op.which() == operation_type)
-            result.push_back(head->operation_id(db));
-       }
-       return result;
+          if( stop.instance.value == 0 && result.size() < limit ) {
+             auto head = db.find(account_transaction_history_id_type());
+             if (head != nullptr && head->account == account && head->operation_id(db).op.which() == operation_type)
+               result.push_back(head->operation_id(db));
+          }
+          return result;
+       } );
     }
 
 
@@ -448,41 +596,43 @@ namespace graphene { namespace app {
                                                                                 uint32_t limit,
                                                                                 uint64_t start ) const
     {
-       FC_ASSERT( _app.chain_database() );
-       const auto& db = *_app.chain_database();
-
-       const auto configured_limit = _app.get_options().api_limit_get_relative_account_history;
-       FC_ASSERT( limit <= configured_limit,
-                  "limit can not be greater than ${configured_limit}",
-                  ("configured_limit", configured_limit) );
-
-       vector<operation_history_object> result;
-       account_id_type account;
-       try {
-          account = database_api.get_account_id_from_string(account_id_or_name);
-       } catch(...) { return result; }
-       const auto& stats = account(db).statistics(db);
-       if( start == 0 )
-          start = stats.total_ops;
-       else
-          start = std::min( stats.total_ops, start );
-
-       if( start >= stop && start > stats.removed_ops && limit > 0 )
-       {
-          const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
-          const auto& by_seq_idx = hist_idx.indices().get<by_seq>();
+       return run_read( "history_api.get_relative_account_history", [&]() {
+          FC_ASSERT( _app.chain_database() );
+          const auto& db = *_app.chain_database();
+
+          const auto configured_limit = _app.get_options().api_limit_get_relative_account_history;
+          FC_ASSERT( limit <= configured_limit,
+                     "limit can not be greater than ${configured_limit}",
+                     ("configured_limit", configured_limit) );
+
+          vector<operation_history_object> result;
+          account_id_type account;
+          try {
+             account = database_api.get_account_id_from_string(account_id_or_name);
+          } catch(...) { return result; }
+          const auto& stats = account(db).statistics(db);
+          if( start == 0 )
+             start = stats.total_ops;
+          else
+             start = std::min( stats.total_ops, start );
+
+          if( start >= stop && start > stats.removed_ops && limit > 0 )
+          {
+             const auto& hist_idx = db.get_index_type<account_transaction_history_index>();
+             const auto& by_seq_idx = hist_idx.indices().get<by_seq>();
 
-          auto itr = by_seq_idx.upper_bound( boost::make_tuple( account, start ) );
-          auto itr_stop = by_seq_idx.lower_bound( boost::make_tuple( account, stop ) );
+             auto itr = by_seq_idx.upper_bound( boost::make_tuple( account, start ) );
+             auto itr_stop = by_seq_idx.lower_bound( boost::make_tuple( account, stop ) );
 
-          do
-          {
-             --itr;
-             result.push_back( itr->operation_id(db) );
+             do
+             {
+                --itr;
+                result.push_back( itr->operation_id(db) );
+             }
+             while ( itr != itr_stop && result.size() < limit );
           }
-          while ( itr != itr_stop && result.size() < limit );
-       }
-       return result;
+          return result;
+       } );
     }
 
     flat_set<uint32_t> history_api::get_market_history_buckets()const
@@ -525,33 +675,34 @@ namespace graphene { namespace app {
                                                            uint32_t bucket_seconds,
                                                            fc::time_point_sec start, fc::time_point_sec end )const
     { try {
+       return run_read( "history_api.get_market_history", [&]() {
+          auto market_hist_plugin = _app.get_plugin<market_history_plugin>( "market_history" );
+          FC_ASSERT( market_hist_plugin, "Market history plugin is not enabled" );
+          FC_ASSERT(_app.chain_database());
 
-       auto market_hist_plugin = _app.get_plugin<market_history_plugin>( "market_history" );
-       FC_ASSERT( market_hist_plugin, "Market history plugin is not enabled" );
-       FC_ASSERT(_app.chain_database());
-
-       const auto& db = *_app.chain_database();
-       asset_id_type a = database_api.get_asset_id_from_string( asset_a );
-       asset_id_type b = database_api.get_asset_id_from_string( asset_b );
-       vector<bucket_object> result;
-       result.reserve(200);
+          const auto& db = *_app.chain_database();
+          asset_id_type a = database_api.get_asset_id_from_string( asset_a );
+          asset_id_type b = database_api.get_asset_id_from_string( asset_b );
+          vector<bucket_object> result;
+          result.reserve(200);
 
-       if( a > b ) std::swap(a,b);
+          if( a > b ) std::swap(a,b);
 
-       const auto& bidx = db.get_index_type<bucket_index>();
-       const auto& by_key_idx = bidx.indices().get<by_key>();
+          const auto& bidx = db.get_index_type<bucket_index>();
+          const auto& by_key_idx = bidx.indices().get<by_key>();
 
-       auto itr = by_key_idx.lower_bound( bucket_key( a, b, bucket_seconds, start ) );
-       while( itr != by_key_idx.end() && itr->key.open <= end && result.size() < 200 )
-       {
-          if( !(itr->key.base == a && itr->key.quote == b && itr->key.seconds == bucket_seconds) )
+          auto itr = by_key_idx.lower_bound( bucket_key( a, b, bucket_seconds, start ) );
+          while( itr != by_key_idx.end() && itr->key.open <= end && result.size() < 200 )
           {
-            return result;
+             if( !(itr->key.base == a && itr->key.quote == b && itr->key.seconds == bucket_seconds) )
+             {
+               return result;
+             }
+             result.push_back(*itr);
+             ++itr;
           }
-          result.push_back(*itr);
-          ++itr;
-       }
-       return result;
+          return result;
+       } );
     } FC_CAPTURE_AND_RETHROW( (asset_a)(asset_b)(bucket_seconds)(start)(end) ) }
 
     vector<liquidity_pool_history_object> history_api::get_liquidity_pool_history(
@@ -561,55 +712,56 @@ namespace graphene { namespace app {
                optional<uint32_t> olimit,
                optional<int64_t> operation_type )const
     { try {
-       FC_ASSERT( _app.get_options().has_market_history_plugin, "Market history plugin is not enabled." );
+       return run_read( "history_api.get_liquidity_pool_history", [&]() {
+          FC_ASSERT( _app.get_options().has_market_history_plugin, "Market history plugin is not enabled." );
 
-       uint32_t limit = olimit.valid() ? *olimit : 101;
+          uint32_t limit = olimit.valid() ? *olimit : 101;
 
-       const auto configured_limit = _app.get_options().api_limit_get_liquidity_pool_history;
-       FC_ASSERT( limit <= configured_limit,
-                  "limit can not be greater than ${configured_limit}",
-                  ("configured_limit", configured_limit) );
+          const auto configured_limit = _app.get_options().api_limit_get_liquidity_pool_history;
+          FC_ASSERT( limit <= configured_limit,
+                     "limit can not be greater than ${configured_limit}",
+                     ("configured_limit", configured_limit) );
 
-       FC_ASSERT( _app.chain_database(), "Internal error: the chain database is not availalbe" );
+          FC_ASSERT( _app.chain_database(), "Internal error: the chain database is not availalbe" );
 
-       const auto& db = *_app.chain_database();
+          const auto& db = *_app.chain_database();
 
-       vector<liquidity_pool_history_object> result;
+          vector<liquidity_pool_history_object> result;
 
-       if( limit == 0 || ( start.valid() && stop.valid() && *start <= *stop ) ) // empty result
-          return result;
+          if( limit == 0 || ( start.valid() && stop.valid() && *start <= *stop ) ) // empty result
+             return result;
 
-       const auto& hist_idx = db.get_index_type<liquidity_pool_history_index>();
+          const auto& hist_idx = db.get_index_type<liquidity_pool_history_index>();
 
-       if( operation_type.valid() ) // one operation type
-       {
-          const auto& idx = hist_idx.indices().get<by_pool_op_type_time>();
-          auto itr = start.valid() ? idx.lower_bound( boost::make_tuple( pool_id, *operation_type, *start ) )
-                                   : idx.lower_bound( boost::make_tuple( pool_id, *operation_type ) );
-          auto itr_stop = stop.valid() ? idx.upper_bound( boost::make_tuple( pool_id, *operation_type, *stop ) )
-                                       : idx.upper_bound( boost::make_tuple( pool_id, *operation_type ) );
-          while( itr != itr_stop && result.size() < limit )
+          if( operation_type.valid() ) // one operation type
           {
-             result.push_back( *itr );
-             ++itr;
+             const auto& idx = hist_idx.indices().get<by_pool_op_type_time>();
+             auto itr = start.valid() ? idx.lower_bound( boost::make_tuple( pool_id, *operation_type, *start ) )
+                                      : idx.lower_bound( boost::make_tuple( pool_id, *operation_type ) );
+             auto itr_stop = stop.valid() ? idx.upper_bound( boost::make_tuple( pool_id, *operation_type, *stop ) )
+                                          : idx.upper_bound( boost::make_tuple( pool_id, *operation_type ) );
+             while( itr != itr_stop && result.size() < limit )
+             {
+                result.push_back( *itr );
+                ++itr;
+             }
           }
-       }
-       else // all operation types
-       {
-          const auto& idx = hist_idx.indices().get<by_pool_time>();
-          auto itr = start.valid() ? idx.lower_bound( boost::make_tuple( pool_id, *start ) )
-                                   : idx.lower_bound( pool_id );
-          auto itr_stop = stop.valid() ? idx.upper_bound( boost::make_tuple( pool_id, *stop ) )
-                                       : idx.upper_bound( pool_id );
-          while( itr != itr_stop && result.size() < limit )
+          else // all operation types
           {
-             result.push_back( *itr );
-             ++itr;
+             const auto& idx = hist_idx.indices().get<by_pool_time>();
+             auto itr = start.valid() ? idx.lower_bound( boost::make_tuple( pool_id, *start ) )
+                                      : idx.lower_bound( pool_id );
+             auto itr_stop = stop.valid() ? idx.upper_bound( boost::make_tuple( pool_id, *stop ) )
+                                          : idx.upper_bound( pool_id );
+             while( itr != itr_stop && result.size() < limit )
+             {
+                result.push_back( *itr );
+                ++itr;
+             }
           }
-       }
-
-       return result;
 
+          return result;
+       } );
     } FC_CAPTURE_AND_RETHROW( (pool_id)(start)(stop)(olimit)(operation_type) ) }
 
     vector<liquidity_pool_history_object> history_api::get_liquidity_pool_history_by_sequence(
@@ -619,59 +771,60 @@ namespace graphene { namespace app {
                optional<uint32_t> olimit,
                optional<int64_t> operation_type )const
     { try {
-       FC_ASSERT( _app.get_options().has_market_history_plugin, "Market history plugin is not enabled." );
+       return run_read( "history_api.get_liquidity_pool_history_by_sequence", [&]() {
+          FC_ASSERT( _app.get_options().has_market_history_plugin, "Market history plugin is not enabled." );
 
-       uint32_t limit = olimit.valid() ? *olimit : 101;
+          uint32_t limit = olimit.valid() ? *olimit : 101;
 
-       const auto configured_limit = _app.get_options().api_limit_get_liquidity_pool_history;
-       FC_ASSERT( limit <= configured_limit,
-                  "limit can not be greater than ${configured_limit}",
-                  ("configured_limit", configured_limit) );
+          const auto configured_limit = _app.get_options().api_limit_get_liquidity_pool_history;
+          FC_ASSERT( limit <= configured_limit,
+                     "limit can not be greater than ${configured_limit}",
+                     ("configured_limit", configured_limit) );
 
-       FC_ASSERT( _app.chain_database(), "Internal error: the chain database is not availalbe" );
+          FC_ASSERT( _app.chain_database(), "Internal error: the chain database is not availalbe" );
 
-       const auto& db = *_app.chain_database();
+          const auto& db = *_app.chain_database();
 
-       vector<liquidity_pool_history_object> result;
+          vector<liquidity_pool_history_object> result;
 
-       if( limit == 0 ) // empty result
-          return result;
+          if( limit == 0 ) // empty result
+             return result;
 
-       const auto& hist_idx = db.get_index_type<liquidity_pool_history_index>();
+          const auto& hist_idx = db.get_index_type<liquidity_pool_history_index>();
 
-       if( operation_type.valid() ) // one operation type
-       {
-          const auto& idx = hist_idx.indices().get<by_pool_op_type_seq>();
-          const auto& idx_t = hist_idx.indices().get<by_pool_op_type_time>();
-          auto itr = start.valid() ? idx.lower_bound( boost::make_tuple( pool_id, *operation_type, *start ) )
-                                   : idx.lower_bound( boost::make_tuple( pool_id, *operation_type ) );
-          auto itr_temp = stop.valid() ? idx_t.upper_bound( boost::make_tuple( pool_id, *operation_type, *stop ) )
-                                       : idx_t.upper_bound( boost::make_tuple( pool_id, *operation_type ) );
-          auto itr_stop = ( itr_temp == idx_t.end() ? idx.end() : idx.iterator_to( *itr_temp ) );
-          while( itr != itr_stop && result.size() < limit )
+          if( operation_type.valid() ) // one operation type
           {
-             result.push_back( *itr );
-             ++itr;
+             const auto& idx = hist_idx.indices().get<by_pool_op_type_seq>();
+             const auto& idx_t = hist_idx.indices().get<by_pool_op_type_time>();
+             auto itr = start.valid() ? idx.lower_bound( boost::make_tuple( pool_id, *operation_type, *start ) )
+                                      : idx.lower_bound( boost::make_tuple( pool_id, *operation_type ) );
+             auto itr_temp = stop.valid() ? idx_t.upper_bound( boost::make_tuple( pool_id, *operation_type, *stop ) )
+                                          : idx_t.upper_bound( boost::make_tuple( pool_id, *operation_type ) );
+             auto itr_stop = ( itr_temp == idx_t.end() ? idx.end() : idx.iterator_to( *itr_temp ) );
+             while( itr != itr_stop && result.size() < limit )
+             {
+                result.push_back( *itr );
+                ++itr;
+             }
           }
-       }
-       else // all operation types
-       {
-          const auto& idx = hist_idx.indices().get<by_pool_seq>();
-          const auto& idx_t = hist_idx.indices().get<by_pool_time>();
-          auto itr = start.valid() ? idx.lower_bound( boost::make_tuple( pool_id, *start ) )
-                                   : idx.lower_bound( pool_id );
-          auto itr_temp = stop.valid() ? idx_t.upper_bound( boost::make_tuple( pool_id, *stop ) )
-                                       : idx_t.upper_bound( pool_id );
-          auto itr_stop = ( itr_temp == idx_t.end() ? idx.end() : idx.iterator_to( *itr_temp ) );
-          while( itr != itr_stop && result.size() < limit )
+          else // all operation types
           {
-             result.push_back( *itr );
-             ++itr;
+             const auto& idx = hist_idx.indices().get<by_pool_seq>();
+             const auto& idx_t = hist_idx.indices().get<by_pool_time>();
+             auto itr = start.valid() ? idx.lower_bound( boost::make_tuple( pool_id, *start ) )
+                                      : idx.lower_bound( pool_id );
+             auto itr_temp = stop.valid() ? idx_t.upper_bound( boost::make_tuple( pool_id, *stop ) )
+                                          : idx_t.upper_bound( pool_id );
+             auto itr_stop = ( itr_temp == idx_t.end() ? idx.end() : idx.iterator_to( *itr_temp ) );
+             while( itr != itr_stop && result.size() < limit )
+             {
+                result.push_back( *itr );
+                ++itr;
+             }
           }
-       }
-
-       return result;
 
+          return result;
+       } );
     } FC_CAPTURE_AND_RETHROW( (pool_id)(start)(stop)(olimit)(operation_type) ) }
 
 
@@ -732,84 +885,106 @@ namespace graphene { namespace app {
     }
 
     // asset_api
-    asset_api::asset_api(graphene::app::application& app) :
+    asset_api::asset_api(graphene::app::application& app, uint64_t connection_id) :
           _app(app),
           _db( *app.chain_database()),
           database_api( std::ref(*app.chain_database()), &(app.get_options())
-          ) { }
+          ),
+          _connection_id( connection_id ) { }
     asset_api::~asset_api() { }
 
+    template<typename Lambda>
+    auto asset_api::run_read( const char* method, Lambda&& f )const -> decltype( f() )
+    {
+       auto run = [this,method,&f]() -> decltype( f() ) {
+          api_worker_pool* pool = _app.get_api_worker_pool();
+          if( pool == nullptr )
+             return f();
+          return pool->run( _db, method, f );
+       };
+       api_call_statistics* stats = _app.get_api_call_statistics();
+       if( stats == nullptr )
+          return run();
+       return stats->measure( _connection_id, method, run );
+    }
+
     vector<account_asset_balance> asset_api::get_asset_holders( std::string asset, uint32_t start, uint32_t limit ) const
     {
-       const auto configured_limit = _app.get_options().api_limit_get_asset_holders;
-       FC_ASSERT( limit <= configured_limit,
-                  "limit can not be greater than ${configured_limit}",
-                  ("configured_limit", configured_limit) );
+       return run_read( "asset_api.get_asset_holders", [&]() {
+          const auto configured_limit = _app.get_options().api_limit_get_asset_holders;
+          FC_ASSERT( limit <= configured_limit,
+                     "limit can not be greater than ${configured_limit}",
+                     ("configured_limit", configured_limit) );
 
-       asset_id_type asset_id = database_api.get_asset_id_from_string( asset );
-       const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-       auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
+          asset_id_type asset_id = database_api.get_asset_id_from_string( asset );
+          const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+          auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
 
-       vector<account_asset_balance> result;
+          vector<account_asset_balance> result;
 
-       uint32_t index = 0;
-       for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
-       {
-          if( result.size() >= limit )
-             break;
+          uint32_t index = 0;
+          for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
+          {
+             if( result.size() >= limit )
+                break;
 
-          if( bal.balance.value == 0 )
-             continue;
+             if( bal.balance.value == 0 )
+                continue;
 
-          if( index++ < start )
-             continue;
+             if( index++ < start )
+                continue;
 
-          const auto account = _db.find(bal.owner);
+             const auto account = _db.find(bal.owner);
 
-          account_asset_balance aab;
-          aab.name       = account->name;
-          aab.account_id = account->id;
-          aab.amount     = bal.balance.value;
+             account_asset_balance aab;
+             aab.name       = account->name;
+             aab.account_id = account->id;
+             aab.amount     = bal.balance.value;
 
-          result.push_back(aab);
-       }
+             result.push_back(aab);
+          }
 
-       return result;
+          return result;
+       } );
     }
     // get number of asset holders.
     int asset_api::get_asset_holders_count( std::string asset ) const {
-       const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-       asset_id_type asset_id = database_api.get_asset_id_from_string( asset );
-       auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
+       return run_read( "asset_api.get_asset_holders_count", [&]() {
+          const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+          asset_id_type asset_id = database_api.get_asset_id_from_string( asset );
+          auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
 
-       int count = boost::distance(range) - 1;
+          int count = boost::distance(range) - 1;
 
-       return count;
+          return count;
+       } );
     }
     // function to get vector of system assets with holders count.
     vector<asset_holders> asset_api::get_all_asset_holders() const {
-       vector<asset_holders> result;
-       vector<asset_id_type> total_assets;
-       for( const asset_object& asset_obj : _db.get_index_type<asset_index>().indices() )
-       {
-          const auto& dasset_obj = asset_obj.dynamic_asset_data_id(_db);
+       return run_read( "asset_api.get_all_asset_holders", [&]() {
+          vector<asset_holders> result;
+          vector<asset_id_type> total_assets;
+          for( const asset_object& asset_obj : _db.get_index_type<asset_index>().indices() )
+          {
+             const auto& dasset_obj = asset_obj.dynamic_asset_data_id(_db);
 
-          asset_id_type asset_id;
-          asset_id = dasset_obj.id;
+             asset_id_type asset_id;
+             asset_id = dasset_obj.id;
 
-          const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-          auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
+             const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+             auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
 
-          int count = boost::distance(range) - 1;
+             int count = boost::distance(range) - 1;
 
-          asset_holders ah;
-          ah.asset_id       = asset_id;
-          ah.count     = count;
+             asset_holders ah;
+             ah.asset_id       = asset_id;
+             ah.count     = count;
 
-          result.push_back(ah);
-       }
+             result.push_back(ah);
+          }
 
-       return result;
+          return result;
+       } );
     }
 
    // orders_api
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/api_call_statistics.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace graphene { namespace app {
+
+void api_latency_histogram::record( const fc::microseconds& latency )
+{
+   const uint64_t us = latency.count() > 0 ? latency.count() : 0;
+   ++count;
+   total_us += us;
+   if( us > max_us )
+      max_us = us;
+
+   size_t bucket = 0;
+   while( bucket + 1 < bucket_count && ( uint64_t(1) << bucket ) <= us )
+      ++bucket;
+   ++buckets[bucket];
+}
+
+namespace {
+
+   void record_call_in( api_method_statistics& stats, const fc::microseconds& latency, bool failed )
+   {
+      ++stats.calls;
+      if( failed )
+         ++stats.errors;
+      stats.latency.record( latency );
+   }
+
+   void record_sample_in( api_method_statistics& stats, uint64_t result_bytes,
+                          const fc::microseconds& serialization_time )
+   {
+      const uint64_t us = serialization_time.count() > 0 ? serialization_time.count() : 0;
+      ++stats.sampled_calls;
+      stats.sampled_result_bytes += result_bytes;
+      stats.max_result_bytes = std::max( stats.max_result_bytes, result_bytes );
+      stats.sampled_serialization_us += us;
+      stats.max_serialization_us = std::max( stats.max_serialization_us, us );
+   }
+
+   api_method_statistics& find_or_add( std::map<std::string, api_method_statistics>& methods, const char* method )
+   {
+      auto itr = methods.find( method );
+      if( itr == methods.end() )
+         itr = methods.emplace( method, api_method_statistics() ).first;
+      return itr->second;
+   }
+
+   void write_metric_header( std::ostream& out, const char* name, const char* type, const char* help )
+   {
+      out << "# HELP " << name << ' ' << help << '\n';
+      out << "# TYPE " << name << ' ' << type << '\n';
+   }
+
+} // anonymous namespace
+
+api_call_statistics::api_call_statistics( uint32_t sample_interval )
+   : _sample_interval( sample_interval )
+{
+}
+
+uint64_t api_call_statistics::register_connection()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   const uint64_t id = _next_connection_id++;
+   auto& conn = _connections[id];
+   conn.connection_id = id;
+   conn.connected_since = fc::time_point::now();
+   return id;
+}
+
+void api_call_statistics::set_connection_user( uint64_t connection_id, const std::string& user )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   auto itr = _connections.find( connection_id );
+   if( itr != _connections.end() )
+      itr->second.user = user;
+}
+
+void api_call_statistics::unregister_connection( uint64_t connection_id )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _connections.erase( connection_id );
+}
+
+bool api_call_statistics::record_call( uint64_t connection_id, const char* method, const fc::microseconds& latency,
+                                       bool failed )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   api_method_statistics& stats = find_or_add( _methods, method );
+   record_call_in( stats, latency, failed );
+
+   auto itr = _connections.find( connection_id );
+   if( itr != _connections.end() )
+      record_call_in( find_or_add( itr->second.methods, method ), latency, failed );
+
+   return !failed && _sample_interval > 0 && ( stats.calls - 1 ) % _sample_interval == 0;
+}
+
+void api_call_statistics::record_sample( uint64_t connection_id, const char* method, uint64_t result_bytes,
+                                         const fc::microseconds& serialization_time )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   record_sample_in( find_or_add( _methods, method ), result_bytes, serialization_time );
+
+   auto itr = _connections.find( connection_id );
+   if( itr != _connections.end() )
+      record_sample_in( find_or_add( itr->second.methods, method ), result_bytes, serialization_time );
+}
+
+std::map<std::string, api_method_statistics> api_call_statistics::get_method_statistics()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   return _methods;
+}
+
+std::vector<api_connection_statistics> api_call_statistics::get_connection_statistics()const
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   std::vector<api_connection_statistics> result;
+   result.reserve( _connections.size() );
+   for( const auto& item : _connections )
+      result.push_back( item.second );
+   return result;
+}
+
+std::string api_call_statistics::get_prometheus_text()const
+{
+   const auto methods = get_method_statistics();
+   const auto connections = get_connection_statistics();
+
+   std::ostringstream out;
+
+   write_metric_header( out, "graphene_api_calls_total", "counter", "Number of API calls" );
+   for( const auto& item : methods )
+      out << "graphene_api_calls_total{method=\"" << item.first << "\"} " << item.second.calls << '\n';
+
+   write_metric_header( out, "graphene_api_call_errors_total", "counter", "Number of API calls which failed" );
+   for( const auto& item : methods )
+      out << "graphene_api_call_errors_total{method=\"" << item.first << "\"} " << item.second.errors << '\n';
+
+   write_metric_header( out, "graphene_api_call_latency_microseconds", "histogram", "Latency of API calls" );
+   for( const auto& item : methods )
+   {
+      const api_latency_histogram& hist = item.second.latency;
+      uint64_t cumulative = 0;
+      // bucket N counts latencies below 2^N microseconds, i.e. up to 2^N - 1 since latencies are integers
+      for( size_t i = 0; i + 1 < hist.buckets.size(); ++i )
+      {
+         cumulative += hist.buckets[i];
+         out << "graphene_api_call_latency_microseconds_bucket{method=\"" << item.first << "\",le=\""
+             << ( ( uint64_t(1) << i ) - 1 ) << "\"} " << cumulative << '\n';
+      }
+      out << "graphene_api_call_latency_microseconds_bucket{method=\"" << item.first << "\",le=\"+Inf\"} "
+          << hist.count << '\n';
+      out << "graphene_api_call_latency_microseconds_sum{method=\"" << item.first << "\"} " << hist.total_us << '\n';
+      out << "graphene_api_call_latency_microseconds_count{method=\"" << item.first << "\"} " << hist.count << '\n';
+   }
+
+   write_metric_header( out, "graphene_api_sampled_calls_total", "counter",
+                        "Number of API calls whose result size and serialization time were measured" );
+   for( const auto& item : methods )
+      out << "graphene_api_sampled_calls_total{method=\"" << item.first << "\"} " << item.second.sampled_calls << '\n';
+
+   write_metric_header( out, "graphene_api_sampled_result_bytes_total", "counter",
+                        "Total JSON size of the sampled API call results" );
+   for( const auto& item : methods )
+      out << "graphene_api_sampled_result_bytes_total{method=\"" << item.first << "\"} "
+          << item.second.sampled_result_bytes << '\n';
+
+   write_metric_header( out, "graphene_api_sampled_serialization_microseconds_total", "counter",
+                        "Total serialization time of the sampled API call results" );
+   for( const auto& item : methods )
+      out << "graphene_api_sampled_serialization_microseconds_total{method=\"" << item.first << "\"} "
+          << item.second.sampled_serialization_us << '\n';
+
+   // calls and latency per connection, summed over all methods
+   std::vector<std::pair<uint64_t, uint64_t>> connection_totals;
+   connection_totals.reserve( connections.size() );
+   for( const auto& conn : connections )
+   {
+      std::pair<uint64_t, uint64_t> totals( 0, 0 );
+      for( const auto& item : conn.methods )
+      {
+         totals.first += item.second.calls;
+         totals.second += item.second.latency.total_us;
+      }
+      connection_totals.push_back( totals );
+   }
+
+   write_metric_header( out, "graphene_api_connection_calls_total", "counter",
+                        "Number of API calls per open connection" );
+   for( size_t i = 0; i < connections.size(); ++i )
+      out << "graphene_api_connection_calls_total{connection=\"" << connections[i].connection_id << "\"} "
+          << connection_totals[i].first << '\n';
+
+   write_metric_header( out, "graphene_api_connection_latency_microseconds_total", "counter",
+                        "Total latency of the API calls per open connection" );
+   for( size_t i = 0; i < connections.size(); ++i )
+      out << "graphene_api_connection_latency_microseconds_total{connection=\"" << connections[i].connection_id
+          << "\"} " << connection_totals[i].second << '\n';
+
+   return out.str();
+}
+
+void api_call_statistics::reset()
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   _methods.clear();
+   for( auto& item : _connections )
+      item.second.methods.clear();
+}
+
+} } // graphene::app
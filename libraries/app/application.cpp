@@ -26,7 +26,9 @@
 #include <graphene/app/application.hpp>
 #include <graphene/app/plugin.hpp>
 
+#include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/db_with.hpp>
+#include <graphene/chain/genesis_loader.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/protocol/fee_schedule.hpp>
 #include <graphene/protocol/types.hpp>
@@ -105,6 +107,13 @@ namespace detail {
       return initial_state;
    }
 
+   /// Returns the fee paid by an operation
+   struct operation_fee_visitor
+   {
+      typedef graphene::protocol::asset result_type;
+      template<typename Operation>
+      result_type operator()( const Operation& op )const { return op.fee; }
+   };
 
 }
 
@@ -146,6 +155,9 @@ void application_impl::reset_p2p_node(const fc::path& data_dir)
       _p2p_network->add_seed_nodes(seeds);
    }
 
+   if( _options->count("p2p-io-threads") )
+      _p2p_network->set_io_thread_count( _options->at("p2p-io-threads").as<uint16_t>() );
+
    if( _options->count("p2p-endpoint") )
       _p2p_network->listen_on_endpoint(fc::ip::endpoint::from_string(_options->at("p2p-endpoint").as<string>()), true);
    else
@@ -249,6 +261,23 @@ void application_impl::initialize(const fc::path& data_dir, shared_ptr<boost::pr
       _force_validate = true;
    }
 
+   if( _options->count("api-worker-threads") > 0 )
+   {
+      const uint16_t num_threads = _options->at("api-worker-threads").as<uint16_t>();
+      if( num_threads > 0 )
+      {
+         _api_worker_pool = std::make_unique<api_worker_pool>( num_threads );
+         ilog( "Serving read-only API calls with ${n} worker thread(s)", ("n", num_threads) );
+      }
+   }
+
+   if( _options->count("enable-api-call-statistics") > 0 && _options->at("enable-api-call-statistics").as<bool>() )
+   {
+      const uint32_t sample_interval = _options->at("api-call-statistics-sample-interval").as<uint32_t>();
+      _api_call_statistics = std::make_unique<api_call_statistics>( sample_interval );
+      ilog( "Recording API call statistics, sampling the result of every ${n}th call", ("n", sample_interval) );
+   }
+
    if ( _options->count("enable-subscribe-to-all") > 0 )
       _app_options.enable_subscribe_to_all = _options->at( "enable-subscribe-to-all" ).as<bool>();
 
@@ -393,17 +422,30 @@ void application_impl::set_api_limit() {
       _app_options.api_limit_get_liquidity_pool_history =
             _options->at("api-limit-get-liquidity-pool-history").as<uint64_t>();
    }
+   if(_options->count("api-limit-broadcast-transaction-batch") > 0) {
+      _app_options.api_limit_broadcast_transaction_batch =
+            _options->at("api-limit-broadcast-transaction-batch").as<uint64_t>();
+   }
 }
 
 graphene::chain::genesis_state_type application_impl::initialize_genesis_state() const
 {
    try {
       ilog("Initializing database...");
-      if( _options->count("genesis-json") > 0 )
+      FC_ASSERT( _options->count("genesis-json") == 0 || _options->count("genesis-binary") == 0,
+                 "Only one of genesis-json and genesis-binary can be specified" );
+      if( _options->count("genesis-json") > 0 || _options->count("genesis-binary") > 0 )
       {
+         graphene::chain::genesis_state_type genesis;
          std::string genesis_str;
-         fc::read_file_contents( _options->at("genesis-json").as<boost::filesystem::path>(), genesis_str );
-         auto genesis = fc::json::from_string( genesis_str ).as<graphene::chain::genesis_state_type>( 20 );
+         if( _options->count("genesis-binary") > 0 )
+            genesis = graphene::chain::read_binary_genesis(
+                            _options->at("genesis-binary").as<boost::filesystem::path>() );
+         else
+         {
+            fc::read_file_contents( _options->at("genesis-json").as<boost::filesystem::path>(), genesis_str );
+            genesis = graphene::chain::parse_genesis_json( genesis_str );
+         }
          bool modified_genesis = false;
          if( _options->count("genesis-timestamp") > 0 )
          {
@@ -427,6 +469,16 @@ graphene::chain::genesis_state_type application_impl::initialize_genesis_state()
             modified_genesis = true;
             ilog("Set init witness key to ${init_key}", ("init_key", init_key));
          }
+         if( _options->count("genesis-binary") > 0 )
+         {
+            // the binary file carries the chain ID of the JSON text it was created from
+            if( modified_genesis )
+            {
+               wlog("WARNING:  GENESIS WAS MODIFIED, YOUR CHAIN ID MAY BE DIFFERENT");
+               genesis.initial_chain_id = fc::sha256::hash( genesis.initial_chain_id.str() + "BOGUS" );
+            }
+            return genesis;
+         }
          if( modified_genesis )
          {
             wlog("WARNING:  GENESIS WAS MODIFIED, YOUR CHAIN ID MAY BE DIFFERENT");
@@ -441,7 +493,7 @@ graphene::chain::genesis_state_type application_impl::initialize_genesis_state()
          graphene::egenesis::compute_egenesis_json( egenesis_json );
          FC_ASSERT( egenesis_json != "" );
          FC_ASSERT( graphene::egenesis::get_egenesis_json_hash() == fc::sha256::hash( egenesis_json ) );
-         auto genesis = fc::json::from_string( egenesis_json ).as<graphene::chain::genesis_state_type>( 20 );
+         auto genesis = graphene::chain::parse_genesis_json( egenesis_json );
          genesis.initial_chain_id = fc::sha256::hash( egenesis_json );
          return genesis;
       }
@@ -665,6 +717,29 @@ void application_impl::handle_transaction(const graphene::net::trx_message& tran
    _chain_db->push_transaction( transaction_message.trx );
 } FC_CAPTURE_AND_RETHROW( (transaction_message) ) }
 
+uint64_t application_impl::get_transaction_priority(const graphene::net::trx_message& transaction_message)
+{
+   // fees paid in other assets are valued at their core exchange rate, since this is what the fee pool pays for them
+   try {
+      graphene::protocol::share_type core_fees = 0;
+      for( const auto& op : transaction_message.trx.operations )
+      {
+         const graphene::protocol::asset fee = op.visit( operation_fee_visitor() );
+         if( fee.asset_id == graphene::protocol::asset_id_type() )
+            core_fees += fee.amount;
+         else if( const auto* fee_asset = _chain_db->find( fee.asset_id ) )
+            core_fees += ( fee * fee_asset->options.core_exchange_rate ).amount;
+      }
+      if( core_fees <= 0 )
+         return 0;
+      const uint64_t size = std::max<uint64_t>( fc::raw::pack_size( transaction_message.trx ), 1 );
+      return static_cast<uint64_t>( core_fees.value ) * 1024 / size;
+   } catch( const fc::exception& ) {
+      // e.g. an overflow, or an exchange rate which doesn't match the fee asset: let handle_transaction reject it
+      return 0;
+   }
+}
+
 void application_impl::handle_message(const message& message_to_process)
 {
    // not a transaction, not a block
@@ -723,11 +798,9 @@ std::vector<item_hash_t> application_impl::get_block_ids(const std::vector<item_
        FC_THROW_EXCEPTION( graphene::net::peer_is_on_an_unreachable_fork,
                            "Unable to provide a list of blocks starting at any of the blocks in peer's synopsis" );
    }
-   for( uint32_t num = block_header::num_from_id(last_known_block_id);
-        num <= _chain_db->head_block_num() && result.size() < limit;
-        ++num )
-      if( num > 0 )
-         result.push_back(_chain_db->get_block_id_for_num(num));
+   // the ids come from the in-memory index of the block database in one call, without reading any block
+   const uint32_t first_block_num = std::max<uint32_t>( block_header::num_from_id(last_known_block_id), 1 );
+   result = _chain_db->get_block_ids_for_nums( first_block_num, limit );
 
    if( !result.empty() && block_header::num_from_id(result.back()) < _chain_db->head_block_num() )
       remaining_item_count = _chain_db->head_block_num() - block_header::num_from_id(result.back());
@@ -754,6 +827,12 @@ message application_impl::get_item(const item_id& id)
    return trx_message( _chain_db->get_recent_transaction( id.item_hash ) );
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
+std::vector<std::vector<char>> application_impl::get_packed_blocks(uint32_t first_block_num, uint32_t count,
+                                                                   size_t max_bytes)
+{ try {
+   return _chain_db->get_packed_blocks( first_block_num, count, max_bytes );
+} FC_CAPTURE_AND_RETHROW( (first_block_num)(count)(max_bytes) ) }
+
 chain_id_type application_impl::get_chain_id() const
 {
    return _chain_db->get_chain_id();
@@ -1002,6 +1081,8 @@ void application_impl::shutdown()
    if( _websocket_server )
       _websocket_server.reset();
    // TODO wait until all connections are closed and messages handled?
+   if( _api_worker_pool )
+      _api_worker_pool.reset();
 
    // plugins E.G. witness_plugin may send data to p2p network, so shutdown them first
    ilog( "Shutting down plugins" );
@@ -1097,6 +1178,9 @@ void application::set_program_options(boost::program_options::options_descriptio
           "Whether to enable P2P network. Note: if delayed_node plugin is enabled, "
           "this option will be ignored and P2P network will always be disabled.")
          ("p2p-endpoint", bpo::value<string>(), "Endpoint for P2P node to listen on")
+         ("p2p-io-threads", bpo::value<uint16_t>()->default_value(0),
+          "Number of threads which read, decrypt, hash and decode P2P messages, "
+          "default to 0 for doing it on the P2P thread")
          ("seed-node,s", bpo::value<vector<string>>()->composing(),
           "P2P nodes to connect to on startup (may specify multiple times)")
          ("seed-nodes", bpo::value<string>()->composing(),
@@ -1114,11 +1198,21 @@ void application::set_program_options(boost::program_options::options_descriptio
           "A HTTP header similar to X-Forwarded-For (XFF), used by the RPC server to extract clients' address info, "
           "usually added by a trusted reverse proxy")
          ("genesis-json", bpo::value<boost::filesystem::path>(), "File to read Genesis State from")
+         ("genesis-binary", bpo::value<boost::filesystem::path>(),
+          "Binary file to read Genesis State from, as written by genesis_update --out-binary")
          ("dbg-init-key", bpo::value<string>(),
           "Block signing key to use for init witnesses, overrides genesis file, for debug")
          ("api-access", bpo::value<boost::filesystem::path>(), "JSON file specifying API permissions")
          ("io-threads", bpo::value<uint16_t>()->implicit_value(0),
           "Number of IO threads, default to 0 for auto-configuration")
+         ("api-worker-threads", bpo::value<uint16_t>()->default_value(0),
+          "Number of threads which serve read-only calls of database_api, history_api and asset_api, "
+          "default to 0 for serving them on the main thread which also applies blocks")
+         ("enable-api-call-statistics", bpo::value<bool>()->implicit_value(true),
+          "Whether to record per-method and per-connection statistics of API calls, "
+          "which can be queried with metrics_api")
+         ("api-call-statistics-sample-interval", bpo::value<uint32_t>()->default_value(100),
+          "Measure result size and serialization time of every Nth call of each API method, 0 to disable")
          ("enable-subscribe-to-all", bpo::value<bool>()->implicit_value(true),
           "Whether allow API clients to subscribe to universal object creation and removal events")
          ("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
@@ -1187,6 +1281,8 @@ void application::set_program_options(boost::program_options::options_descriptio
           "Set maximum limit value for database APIs which query for liquidity pools")
          ("api-limit-get-liquidity-pool-history", boost::program_options::value<uint64_t>()->default_value(101),
           "Set maximum limit value for APIs which query for history of liquidity pools")
+         ("api-limit-broadcast-transaction-batch", boost::program_options::value<uint64_t>()->default_value(1000),
+          "Set maximum number of transactions in a call of network_broadcast_api::broadcast_transaction_batch")
          ;
    command_line_options.add(configuration_file_options);
    command_line_options.add_options()
@@ -1256,6 +1352,16 @@ std::shared_ptr<chain::database> application::chain_database() const
    return my->_chain_db;
 }
 
+api_worker_pool* application::get_api_worker_pool() const
+{
+   return my->_api_worker_pool.get();
+}
+
+api_call_statistics* application::get_api_call_statistics() const
+{
+   return my->_api_call_statistics.get();
+}
+
 void application::set_block_production(bool producing_blocks)
 {
    my->set_block_production(producing_blocks);
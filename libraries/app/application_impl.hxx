@@ -5,6 +5,8 @@
 
 #include <graphene/app/application.hpp>
 #include <graphene/app/api_access.hpp>
+#include <graphene/app/api_call_statistics.hpp>
+#include <graphene/app/api_worker_pool.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/protocol/types.hpp>
 #include <graphene/net/message.hpp>
@@ -67,6 +69,9 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
 
       void handle_transaction(const graphene::net::trx_message& transaction_message) override;
 
+      /// Returns the fees paid by the transaction, in core asset, per kilobyte
+      uint64_t get_transaction_priority(const graphene::net::trx_message& transaction_message) override;
+
       void handle_message(const graphene::net::message& message_to_process) override;
 
       bool is_included_block(const graphene::chain::block_id_type& block_id);
@@ -90,6 +95,9 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
        */
       graphene::net::message get_item(const graphene::net::item_id& id) override;
 
+      std::vector<std::vector<char>> get_packed_blocks(uint32_t first_block_num, uint32_t count,
+                                                       size_t max_bytes) override;
+
       graphene::chain::chain_id_type get_chain_id()const override;
 
       /**
@@ -218,6 +226,8 @@ class application_impl : public net::node_delegate, public std::enable_shared_fr
       std::shared_ptr<graphene::net::node>                  _p2p_network;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
+      std::unique_ptr<api_worker_pool>                 _api_worker_pool;
+      std::unique_ptr<api_call_statistics>             _api_call_statistics;
 
       std::map<string, std::shared_ptr<abstract_plugin>> _active_plugins;
       std::map<string, std::shared_ptr<abstract_plugin>> _available_plugins;
@@ -25,6 +25,7 @@
 #include "database_api_impl.hxx"
 
 #include <graphene/app/util.hpp>
+#include <graphene/chain/db_with.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <graphene/protocol/pts_address.hpp>
@@ -47,14 +48,23 @@ namespace graphene { namespace app {
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
-database_api::database_api( graphene::chain::database& db, const application_options* app_options )
-   : my( std::make_unique<database_api_impl>( db, app_options ) ) {}
+database_api::database_api( graphene::chain::database& db, const application_options* app_options,
+                            api_worker_pool* worker_pool, api_call_statistics* call_stats, uint64_t connection_id )
+   : my( std::make_unique<database_api_impl>( db, app_options, worker_pool, call_stats, connection_id ) ) {}
 
 database_api::~database_api() {}
 
-database_api_impl::database_api_impl( graphene::chain::database& db, const application_options* app_options )
-:_db(db), _app_options(app_options)
+database_api_impl::database_api_impl( graphene::chain::database& db, const application_options* app_options,
+                                      api_worker_pool* worker_pool, api_call_statistics* call_stats,
+                                      uint64_t connection_id )
+:_db(db), _app_options(app_options), _worker_pool(worker_pool), _call_stats(call_stats),
+ _connection_id(connection_id)
 {
+   // All calls of one connection are served by the same worker thread, so that the subscription state
+   // below is never accessed by two threads at once
+   if( _worker_pool != nullptr )
+      _worker_thread = &_worker_pool->next_thread();
+
    dlog("creating database api ${x}", ("x",int64_t(this)) );
    _new_connection = _db.new_objects.connect([this](const vector<object_id_type>& ids,
                                                     const flat_set<account_id_type>& impacted_accounts) {
@@ -109,7 +119,9 @@ database_api_impl::~database_api_impl()
 
 fc::variants database_api::get_objects( const vector<object_id_type>& ids, optional<bool> subscribe )const
 {
-   return my->get_objects( ids, subscribe );
+   return my->run_read( "database_api.get_objects", [&]() {
+      return my->get_objects( ids, subscribe );
+   } );
 }
 
 fc::variants database_api_impl::get_objects( const vector<object_id_type>& ids, optional<bool> subscribe )const
@@ -141,6 +153,7 @@ fc::variants database_api_impl::get_objects( const vector<object_id_type>& ids,
 
 void database_api::set_subscribe_callback( std::function<void(const variant&)> cb, bool notify_remove_create )
 {
+   graphene::chain::detail::chain_state_write_guard write_guard( my->_db );
    my->set_subscribe_callback( cb, notify_remove_create );
 }
 
@@ -160,6 +173,7 @@ void database_api_impl::set_subscribe_callback( std::function<void(const variant
 
 void database_api::set_auto_subscription( bool enable )
 {
+   graphene::chain::detail::chain_state_write_guard write_guard( my->_db );
    my->set_auto_subscription( enable );
 }
 
@@ -170,6 +184,7 @@ void database_api_impl::set_auto_subscription( bool enable )
 
 void database_api::set_pending_transaction_callback( std::function<void(const variant&)> cb )
 {
+   graphene::chain::detail::chain_state_write_guard write_guard( my->_db );
    my->set_pending_transaction_callback( cb );
 }
 
@@ -180,6 +195,7 @@ void database_api_impl::set_pending_transaction_callback( std::function<void(con
 
 void database_api::set_block_applied_callback( std::function<void(const variant& block_id)> cb )
 {
+   graphene::chain::detail::chain_state_write_guard write_guard( my->_db );
    my->set_block_applied_callback( cb );
 }
 
@@ -190,6 +206,7 @@ void database_api_impl::set_block_applied_callback( std::function<void(const var
 
 void database_api::cancel_all_subscriptions()
 {
+   graphene::chain::detail::chain_state_write_guard write_guard( my->_db );
    my->cancel_all_subscriptions(true, true);
 }
 
@@ -203,8 +220,19 @@ void database_api_impl::cancel_all_subscriptions( bool reset_callback, bool rese
 
    _notify_remove_create = false;
    _subscribed_accounts.clear();
-   static fc::bloom_parameters param(10000, 1.0/100, 1024*8*8*2);
-   _subscribe_filter = fc::bloom_filter(param);
+   _subscribe_filter.clear();
+}
+
+subscription_filter_statistics database_api::get_subscription_statistics()const
+{
+   return my->run_read( "database_api.get_subscription_statistics", [&]() {
+      return my->get_subscription_statistics();
+   } );
+}
+
+subscription_filter_statistics database_api_impl::get_subscription_statistics()const
+{
+   return _subscribe_filter.get_statistics();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -215,7 +243,9 @@ void database_api_impl::cancel_all_subscriptions( bool reset_callback, bool rese
 
 optional<block_header> database_api::get_block_header(uint32_t block_num)const
 {
-   return my->get_block_header( block_num );
+   return my->run_read( "database_api.get_block_header", [&]() {
+      return my->get_block_header( block_num );
+   } );
 }
 
 optional<block_header> database_api_impl::get_block_header(uint32_t block_num) const
@@ -227,7 +257,9 @@ optional<block_header> database_api_impl::get_block_header(uint32_t block_num) c
 }
 map<uint32_t, optional<block_header>> database_api::get_block_header_batch(const vector<uint32_t> block_nums)const
 {
-   return my->get_block_header_batch( block_nums );
+   return my->run_read( "database_api.get_block_header_batch", [&]() {
+      return my->get_block_header_batch( block_nums );
+   } );
 }
 
 map<uint32_t, optional<block_header>> database_api_impl::get_block_header_batch(
@@ -243,7 +275,9 @@ map<uint32_t, optional<block_header>> database_api_impl::get_block_header_batch(
 
 optional<signed_block> database_api::get_block(uint32_t block_num)const
 {
-   return my->get_block( block_num );
+   return my->run_read( "database_api.get_block", [&]() {
+      return my->get_block( block_num );
+   } );
 }
 
 optional<signed_block> database_api_impl::get_block(uint32_t block_num)const
@@ -253,16 +287,20 @@ optional<signed_block> database_api_impl::get_block(uint32_t block_num)const
 
 processed_transaction database_api::get_transaction( uint32_t block_num, uint32_t trx_in_block )const
 {
-   return my->get_transaction( block_num, trx_in_block );
+   return my->run_read( "database_api.get_transaction", [&]() {
+      return my->get_transaction( block_num, trx_in_block );
+   } );
 }
 
 optional<signed_transaction> database_api::get_recent_transaction_by_id( const transaction_id_type& id )const
 {
-   try {
-      return my->_db.get_recent_transaction( id );
-   } catch ( ... ) {
-      return optional<signed_transaction>();
-   }
+   return my->run_read( "database_api.get_recent_transaction_by_id", [&]() -> optional<signed_transaction> {
+      try {
+         return my->_db.get_recent_transaction( id );
+      } catch ( ... ) {
+         return optional<signed_transaction>();
+      }
+   } );
 }
 
 processed_transaction database_api_impl::get_transaction(uint32_t block_num, uint32_t trx_num)const
@@ -281,7 +319,9 @@ processed_transaction database_api_impl::get_transaction(uint32_t block_num, uin
 
 chain_property_object database_api::get_chain_properties()const
 {
-   return my->get_chain_properties();
+   return my->run_read( "database_api.get_chain_properties", [&]() {
+      return my->get_chain_properties();
+   } );
 }
 
 chain_property_object database_api_impl::get_chain_properties()const
@@ -291,7 +331,9 @@ chain_property_object database_api_impl::get_chain_properties()const
 
 global_property_object database_api::get_global_properties()const
 {
-   return my->get_global_properties();
+   return my->run_read( "database_api.get_global_properties", [&]() {
+      return my->get_global_properties();
+   } );
 }
 
 global_property_object database_api_impl::get_global_properties()const
@@ -301,7 +343,9 @@ global_property_object database_api_impl::get_global_properties()const
 
 fc::variant_object database_api::get_config()const
 {
-   return my->get_config();
+   return my->run_read( "database_api.get_config", [&]() {
+      return my->get_config();
+   } );
 }
 
 fc::variant_object database_api_impl::get_config()const
@@ -311,7 +355,9 @@ fc::variant_object database_api_impl::get_config()const
 
 chain_id_type database_api::get_chain_id()const
 {
-   return my->get_chain_id();
+   return my->run_read( "database_api.get_chain_id", [&]() {
+      return my->get_chain_id();
+   } );
 }
 
 chain_id_type database_api_impl::get_chain_id()const
@@ -321,7 +367,9 @@ chain_id_type database_api_impl::get_chain_id()const
 
 dynamic_global_property_object database_api::get_dynamic_global_properties()const
 {
-   return my->get_dynamic_global_properties();
+   return my->run_read( "database_api.get_dynamic_global_properties", [&]() {
+      return my->get_dynamic_global_properties();
+   } );
 }
 
 dynamic_global_property_object database_api_impl::get_dynamic_global_properties()const
@@ -337,7 +385,9 @@ dynamic_global_property_object database_api_impl::get_dynamic_global_properties(
 
 vector<flat_set<account_id_type>> database_api::get_key_references( vector<public_key_type> key )const
 {
-   return my->get_key_references( key );
+   return my->run_read( "database_api.get_key_references", [&]() {
+      return my->get_key_references( key );
+   } );
 }
 
 /**
@@ -398,7 +448,9 @@ vector<flat_set<account_id_type>> database_api_impl::get_key_references( vector<
 
 bool database_api::is_public_key_registered(string public_key) const
 {
-    return my->is_public_key_registered(public_key);
+   return my->run_read( "database_api.is_public_key_registered", [&]() {
+       return my->is_public_key_registered(public_key);
+   } );
 }
 
 bool database_api_impl::is_public_key_registered(string public_key) const
@@ -438,13 +490,17 @@ bool database_api_impl::is_public_key_registered(string public_key) const
 
 account_id_type database_api::get_account_id_from_string(const std::string& name_or_id)const
 {
-   return my->get_account_from_string( name_or_id )->id;
+   return my->run_read( "database_api.get_account_id_from_string", [&]() {
+      return my->get_account_from_string( name_or_id )->id;
+   } );
 }
 
 vector<optional<account_object>> database_api::get_accounts( const vector<std::string>& account_names_or_ids,
                                                              optional<bool> subscribe )const
 {
-   return my->get_accounts( account_names_or_ids, subscribe );
+   return my->run_read( "database_api.get_accounts", [&]() {
+      return my->get_accounts( account_names_or_ids, subscribe );
+   } );
 }
 
 vector<optional<account_object>> database_api_impl::get_accounts( const vector<std::string>& account_names_or_ids,
@@ -468,12 +524,16 @@ vector<optional<account_object>> database_api_impl::get_accounts( const vector<s
 std::map<string,full_account> database_api::get_full_accounts( const vector<string>& names_or_ids,
                                                                optional<bool> subscribe )
 {
-   return my->get_full_accounts( names_or_ids, subscribe );
+   return my->run_read( "database_api.get_full_accounts", [&]() {
+      return my->get_full_accounts( names_or_ids, subscribe );
+   } );
 }
 
 vector<account_statistics_object> database_api::get_top_voters(uint32_t limit)const
 {
-   return my->get_top_voters( limit );
+   return my->run_read( "database_api.get_top_voters", [&]() {
+      return my->get_top_voters( limit );
+   } );
 }
 
 std::map<std::string, full_account> database_api_impl::get_full_accounts( const vector<std::string>& names_or_ids,
@@ -678,7 +738,9 @@ vector<account_statistics_object> database_api_impl::get_top_voters(uint32_t lim
 
 optional<account_object> database_api::get_account_by_name( string name )const
 {
-   return my->get_account_by_name( name );
+   return my->run_read( "database_api.get_account_by_name", [&]() {
+      return my->get_account_by_name( name );
+   } );
 }
 
 optional<account_object> database_api_impl::get_account_by_name( string name )const
@@ -692,7 +754,9 @@ optional<account_object> database_api_impl::get_account_by_name( string name )co
 
 vector<account_id_type> database_api::get_account_references( const std::string account_id_or_name )const
 {
-   return my->get_account_references( account_id_or_name );
+   return my->run_read( "database_api.get_account_references", [&]() {
+      return my->get_account_references( account_id_or_name );
+   } );
 }
 
 vector<account_id_type> database_api_impl::get_account_references( const std::string account_id_or_name )const
@@ -718,7 +782,9 @@ vector<account_id_type> database_api_impl::get_account_references( const std::st
 
 vector<optional<account_object>> database_api::lookup_account_names(const vector<string>& account_names)const
 {
-   return my->lookup_account_names( account_names );
+   return my->run_read( "database_api.lookup_account_names", [&]() {
+      return my->lookup_account_names( account_names );
+   } );
 }
 
 vector<optional<account_object>> database_api_impl::lookup_account_names(const vector<string>& account_names)const
@@ -730,7 +796,9 @@ map<string,account_id_type> database_api::lookup_accounts( const string& lower_b
                                                            uint32_t limit,
                                                            optional<bool> subscribe )const
 {
-   return my->lookup_accounts( lower_bound_name, limit, subscribe );
+   return my->run_read( "database_api.lookup_accounts", [&]() {
+      return my->lookup_accounts( lower_bound_name, limit, subscribe );
+   } );
 }
 
 map<string,account_id_type> database_api_impl::lookup_accounts( const string& lower_bound_name,
@@ -764,7 +832,9 @@ map<string,account_id_type> database_api_impl::lookup_accounts( const string& lo
 
 uint64_t database_api::get_account_count()const
 {
-   return my->get_account_count();
+   return my->run_read( "database_api.get_account_count", [&]() {
+      return my->get_account_count();
+   } );
 }
 
 uint64_t database_api_impl::get_account_count()const
@@ -781,7 +851,9 @@ uint64_t database_api_impl::get_account_count()const
 vector<asset> database_api::get_account_balances( const std::string& account_name_or_id,
                                                   const flat_set<asset_id_type>& assets )const
 {
-   return my->get_account_balances( account_name_or_id, assets );
+   return my->run_read( "database_api.get_account_balances", [&]() {
+      return my->get_account_balances( account_name_or_id, assets );
+   } );
 }
 
 vector<asset> database_api_impl::get_account_balances( const std::string& account_name_or_id,
@@ -813,12 +885,16 @@ vector<asset> database_api_impl::get_account_balances( const std::string& accoun
 vector<asset> database_api::get_named_account_balances( const std::string& name,
                                                         const flat_set<asset_id_type>& assets )const
 {
-   return my->get_account_balances( name, assets );
+   return my->run_read( "database_api.get_named_account_balances", [&]() {
+      return my->get_account_balances( name, assets );
+   } );
 }
 
 vector<balance_object> database_api::get_balance_objects( const vector<address>& addrs )const
 {
-   return my->get_balance_objects( addrs );
+   return my->run_read( "database_api.get_balance_objects", [&]() {
+      return my->get_balance_objects( addrs );
+   } );
 }
 
 vector<balance_object> database_api_impl::get_balance_objects( const vector<address>& addrs )const
@@ -846,7 +922,9 @@ vector<balance_object> database_api_impl::get_balance_objects( const vector<addr
 
 vector<asset> database_api::get_vested_balances( const vector<balance_id_type>& objs )const
 {
-   return my->get_vested_balances( objs );
+   return my->run_read( "database_api.get_vested_balances", [&]() {
+      return my->get_vested_balances( objs );
+   } );
 }
 
 vector<asset> database_api_impl::get_vested_balances( const vector<balance_id_type>& objs )const
@@ -864,7 +942,9 @@ vector<asset> database_api_impl::get_vested_balances( const vector<balance_id_ty
 
 vector<vesting_balance_object> database_api::get_vesting_balances( const std::string account_id_or_name )const
 {
-   return my->get_vesting_balances( account_id_or_name );
+   return my->run_read( "database_api.get_vesting_balances", [&]() {
+      return my->get_vesting_balances( account_id_or_name );
+   } );
 }
 
 vector<vesting_balance_object> database_api_impl::get_vesting_balances( const std::string account_id_or_name )const
@@ -892,14 +972,18 @@ vector<vesting_balance_object> database_api_impl::get_vesting_balances( const st
 
 asset_id_type database_api::get_asset_id_from_string(const std::string& symbol_or_id)const
 {
-   return my->get_asset_from_string( symbol_or_id )->id;
+   return my->run_read( "database_api.get_asset_id_from_string", [&]() {
+      return my->get_asset_from_string( symbol_or_id )->id;
+   } );
 }
 
 vector<optional<extended_asset_object>> database_api::get_assets(
       const vector<std::string>& asset_symbols_or_ids,
       optional<bool> subscribe )const
 {
-   return my->get_assets( asset_symbols_or_ids, subscribe );
+   return my->run_read( "database_api.get_assets", [&]() {
+      return my->get_assets( asset_symbols_or_ids, subscribe );
+   } );
 }
 
 vector<optional<extended_asset_object>> database_api_impl::get_assets(
@@ -923,7 +1007,9 @@ vector<optional<extended_asset_object>> database_api_impl::get_assets(
 
 vector<extended_asset_object> database_api::list_assets(const string& lower_bound_symbol, uint32_t limit)const
 {
-   return my->list_assets( lower_bound_symbol, limit );
+   return my->run_read( "database_api.list_assets", [&]() {
+      return my->list_assets( lower_bound_symbol, limit );
+   } );
 }
 
 vector<extended_asset_object> database_api_impl::list_assets(const string& lower_bound_symbol, uint32_t limit)const
@@ -951,7 +1037,9 @@ vector<extended_asset_object> database_api_impl::list_assets(const string& lower
 
 uint64_t database_api::get_asset_count()const
 {
-   return my->get_asset_count();
+   return my->run_read( "database_api.get_asset_count", [&]() {
+      return my->get_asset_count();
+   } );
 }
 
 uint64_t database_api_impl::get_asset_count()const
@@ -962,7 +1050,9 @@ uint64_t database_api_impl::get_asset_count()const
 vector<extended_asset_object> database_api::get_assets_by_issuer(const std::string& issuer_name_or_id,
                                                                  asset_id_type start, uint32_t limit)const
 {
-   return my->get_assets_by_issuer(issuer_name_or_id, start, limit);
+   return my->run_read( "database_api.get_assets_by_issuer", [&]() {
+      return my->get_assets_by_issuer(issuer_name_or_id, start, limit);
+   } );
 }
 
 vector<extended_asset_object> database_api_impl::get_assets_by_issuer(const std::string& issuer_name_or_id,
@@ -990,7 +1080,9 @@ vector<extended_asset_object> database_api_impl::get_assets_by_issuer(const std:
 vector<optional<extended_asset_object>> database_api::lookup_asset_symbols(
                                                          const vector<string>& symbols_or_ids )const
 {
-   return my->lookup_asset_symbols( symbols_or_ids );
+   return my->run_read( "database_api.lookup_asset_symbols", [&]() {
+      return my->lookup_asset_symbols( symbols_or_ids );
+   } );
 }
 
 vector<optional<extended_asset_object>> database_api_impl::lookup_asset_symbols(
@@ -1007,7 +1099,9 @@ vector<optional<extended_asset_object>> database_api_impl::lookup_asset_symbols(
 
 vector<limit_order_object> database_api::get_limit_orders(std::string a, std::string b, uint32_t limit)const
 {
-   return my->get_limit_orders( a, b, limit );
+   return my->run_read( "database_api.get_limit_orders", [&]() {
+      return my->get_limit_orders( a, b, limit );
+   } );
 }
 
 vector<limit_order_object> database_api_impl::get_limit_orders( const std::string& a, const std::string& b,
@@ -1028,7 +1122,9 @@ vector<limit_order_object> database_api_impl::get_limit_orders( const std::strin
 vector<limit_order_object> database_api::get_limit_orders_by_account( const string& account_name_or_id,
                               optional<uint32_t> limit, optional<limit_order_id_type> start_id )
 {
-   return my->get_limit_orders_by_account( account_name_or_id, limit, start_id );
+   return my->run_read( "database_api.get_limit_orders_by_account", [&]() {
+      return my->get_limit_orders_by_account( account_name_or_id, limit, start_id );
+   } );
 }
 
 vector<limit_order_object> database_api_impl::get_limit_orders_by_account( const string& account_name_or_id,
@@ -1069,7 +1165,9 @@ vector<limit_order_object> database_api::get_account_limit_orders(
                               const string& account_name_or_id, const string &base, const string &quote,
                               uint32_t limit, optional<limit_order_id_type> ostart_id, optional<price> ostart_price )
 {
-   return my->get_account_limit_orders( account_name_or_id, base, quote, limit, ostart_id, ostart_price );
+   return my->run_read( "database_api.get_account_limit_orders", [&]() {
+      return my->get_account_limit_orders( account_name_or_id, base, quote, limit, ostart_id, ostart_price );
+   } );
 }
 
 vector<limit_order_object> database_api_impl::get_account_limit_orders(
@@ -1159,7 +1257,9 @@ vector<limit_order_object> database_api_impl::get_account_limit_orders(
 
 vector<call_order_object> database_api::get_call_orders(const std::string& a, uint32_t limit)const
 {
-   return my->get_call_orders( a, limit );
+   return my->run_read( "database_api.get_call_orders", [&]() {
+      return my->get_call_orders( a, limit );
+   } );
 }
 
 vector<call_order_object> database_api_impl::get_call_orders(const std::string& a, uint32_t limit)const
@@ -1188,7 +1288,9 @@ vector<call_order_object> database_api_impl::get_call_orders(const std::string&
 vector<call_order_object> database_api::get_call_orders_by_account(const std::string& account_name_or_id,
                                                                    asset_id_type start, uint32_t limit)const
 {
-   return my->get_call_orders_by_account( account_name_or_id, start, limit );
+   return my->run_read( "database_api.get_call_orders_by_account", [&]() {
+      return my->get_call_orders_by_account( account_name_or_id, start, limit );
+   } );
 }
 
 vector<call_order_object> database_api_impl::get_call_orders_by_account(const std::string& account_name_or_id,
@@ -1215,7 +1317,9 @@ vector<call_order_object> database_api_impl::get_call_orders_by_account(const st
 
 vector<force_settlement_object> database_api::get_settle_orders(const std::string& a, uint32_t limit)const
 {
-   return my->get_settle_orders( a, limit );
+   return my->run_read( "database_api.get_settle_orders", [&]() {
+      return my->get_settle_orders( a, limit );
+   } );
 }
 
 vector<force_settlement_object> database_api_impl::get_settle_orders(const std::string& a, uint32_t limit)const
@@ -1246,7 +1350,9 @@ vector<force_settlement_object> database_api::get_settle_orders_by_account(
       force_settlement_id_type start,
       uint32_t limit )const
 {
-   return my->get_settle_orders_by_account( account_name_or_id, start, limit);
+   return my->run_read( "database_api.get_settle_orders_by_account", [&]() {
+      return my->get_settle_orders_by_account( account_name_or_id, start, limit);
+   } );
 }
 
 vector<force_settlement_object> database_api_impl::get_settle_orders_by_account(
@@ -1276,7 +1382,9 @@ vector<force_settlement_object> database_api_impl::get_settle_orders_by_account(
 
 vector<call_order_object> database_api::get_margin_positions( const std::string account_id_or_name )const
 {
-   return my->get_margin_positions( account_id_or_name );
+   return my->run_read( "database_api.get_margin_positions", [&]() {
+      return my->get_margin_positions( account_id_or_name );
+   } );
 }
 
 vector<call_order_object> database_api_impl::get_margin_positions( const std::string account_id_or_name )const
@@ -1301,7 +1409,9 @@ vector<call_order_object> database_api_impl::get_margin_positions( const std::st
 vector<collateral_bid_object> database_api::get_collateral_bids( const std::string& asset,
                                                                  uint32_t limit, uint32_t start )const
 {
-   return my->get_collateral_bids( asset, limit, start );
+   return my->run_read( "database_api.get_collateral_bids", [&]() {
+      return my->get_collateral_bids( asset, limit, start );
+   } );
 }
 
 vector<collateral_bid_object> database_api_impl::get_collateral_bids( const std::string& asset,
@@ -1339,6 +1449,7 @@ vector<collateral_bid_object> database_api_impl::get_collateral_bids( const std:
 void database_api::subscribe_to_market( std::function<void(const variant&)> callback,
                                         const std::string& a, const std::string& b )
 {
+   graphene::chain::detail::chain_state_write_guard write_guard( my->_db );
    my->subscribe_to_market( callback, a, b );
 }
 
@@ -1355,6 +1466,7 @@ void database_api_impl::subscribe_to_market( std::function<void(const variant&)>
 
 void database_api::unsubscribe_from_market(const std::string& a, const std::string& b)
 {
+   graphene::chain::detail::chain_state_write_guard write_guard( my->_db );
    my->unsubscribe_from_market( a, b );
 }
 
@@ -1370,7 +1482,9 @@ void database_api_impl::unsubscribe_from_market(const std::string& a, const std:
 
 market_ticker database_api::get_ticker( const string& base, const string& quote )const
 {
-    return my->get_ticker( base, quote );
+   return my->run_read( "database_api.get_ticker", [&]() {
+       return my->get_ticker( base, quote );
+   } );
 }
 
 market_ticker database_api_impl::get_ticker( const string& base, const string& quote, bool skip_order_book )const
@@ -1404,7 +1518,9 @@ market_ticker database_api_impl::get_ticker( const string& base, const string& q
 
 market_volume database_api::get_24_volume( const string& base, const string& quote )const
 {
-    return my->get_24_volume( base, quote );
+   return my->run_read( "database_api.get_24_volume", [&]() {
+       return my->get_24_volume( base, quote );
+   } );
 }
 
 market_volume database_api_impl::get_24_volume( const string& base, const string& quote )const
@@ -1423,7 +1539,9 @@ market_volume database_api_impl::get_24_volume( const string& base, const string
 
 order_book database_api::get_order_book( const string& base, const string& quote, unsigned limit )const
 {
-   return my->get_order_book( base, quote, limit);
+   return my->run_read( "database_api.get_order_book", [&]() {
+      return my->get_order_book( base, quote, limit);
+   } );
 }
 
 order_book database_api_impl::get_order_book( const string& base, const string& quote, unsigned limit )const
@@ -1475,7 +1593,9 @@ order_book database_api_impl::get_order_book( const string& base, const string&
 
 vector<market_ticker> database_api::get_top_markets(uint32_t limit)const
 {
-   return my->get_top_markets(limit);
+   return my->run_read( "database_api.get_top_markets", [&]() {
+      return my->get_top_markets(limit);
+   } );
 }
 
 vector<market_ticker> database_api_impl::get_top_markets(uint32_t limit)const
@@ -1512,7 +1632,9 @@ vector<market_trade> database_api::get_trade_history( const string& base,
                                                       fc::time_point_sec stop,
                                                       unsigned limit )const
 {
-   return my->get_trade_history( base, quote, start, stop, limit );
+   return my->run_read( "database_api.get_trade_history", [&]() {
+      return my->get_trade_history( base, quote, start, stop, limit );
+   } );
 }
 
 vector<market_trade> database_api_impl::get_trade_history( const string& base,
@@ -1614,7 +1736,9 @@ vector<market_trade> database_api::get_trade_history_by_sequence(
                                                       fc::time_point_sec stop,
                                                       unsigned limit )const
 {
-   return my->get_trade_history_by_sequence( base, quote, start, stop, limit );
+   return my->run_read( "database_api.get_trade_history_by_sequence", [&]() {
+      return my->get_trade_history_by_sequence( base, quote, start, stop, limit );
+   } );
 }
 
 vector<market_trade> database_api_impl::get_trade_history_by_sequence(
@@ -1736,10 +1860,12 @@ vector<extended_liquidity_pool_object> database_api::list_liquidity_pools(
             optional<liquidity_pool_id_type> start_id,
             optional<bool> with_statistics )const
 {
-   return my->list_liquidity_pools(
-            limit,
-            start_id,
-            with_statistics );
+   return my->run_read( "database_api.list_liquidity_pools", [&]() {
+      return my->list_liquidity_pools(
+               limit,
+               start_id,
+               with_statistics );
+   } );
 }
 
 vector<extended_liquidity_pool_object> database_api_impl::list_liquidity_pools(
@@ -1780,11 +1906,13 @@ vector<extended_liquidity_pool_object> database_api::get_liquidity_pools_by_asse
             optional<liquidity_pool_id_type> start_id,
             optional<bool> with_statistics )const
 {
-   return my->get_liquidity_pools_by_asset_a(
-            asset_symbol_or_id,
-            limit,
-            start_id,
-            with_statistics );
+   return my->run_read( "database_api.get_liquidity_pools_by_asset_a", [&]() {
+      return my->get_liquidity_pools_by_asset_a(
+               asset_symbol_or_id,
+               limit,
+               start_id,
+               with_statistics );
+   } );
 }
 
 vector<extended_liquidity_pool_object> database_api_impl::get_liquidity_pools_by_asset_a(
@@ -1806,11 +1934,13 @@ vector<extended_liquidity_pool_object> database_api::get_liquidity_pools_by_asse
             optional<liquidity_pool_id_type> start_id,
             optional<bool> with_statistics )const
 {
-   return my->get_liquidity_pools_by_asset_b(
-            asset_symbol_or_id,
-            limit,
-            start_id,
-            with_statistics );
+   return my->run_read( "database_api.get_liquidity_pools_by_asset_b", [&]() {
+      return my->get_liquidity_pools_by_asset_b(
+               asset_symbol_or_id,
+               limit,
+               start_id,
+               with_statistics );
+   } );
 }
 
 vector<extended_liquidity_pool_object> database_api_impl::get_liquidity_pools_by_asset_b(
@@ -1832,11 +1962,13 @@ vector<extended_liquidity_pool_object> database_api::get_liquidity_pools_by_one_
             const optional<liquidity_pool_id_type>& start_id,
             const optional<bool>& with_statistics )const
 {
-   return my->get_liquidity_pools_by_one_asset(
-            asset_symbol_or_id,
-            limit,
-            start_id,
-            with_statistics );
+   return my->run_read( "database_api.get_liquidity_pools_by_one_asset", [&]() {
+      return my->get_liquidity_pools_by_one_asset(
+               asset_symbol_or_id,
+               limit,
+               start_id,
+               with_statistics );
+   } );
 }
 
 vector<extended_liquidity_pool_object> database_api_impl::get_liquidity_pools_by_one_asset(
@@ -1885,12 +2017,14 @@ vector<extended_liquidity_pool_object> database_api::get_liquidity_pools_by_both
             optional<liquidity_pool_id_type> start_id,
             optional<bool> with_statistics )const
 {
-   return my->get_liquidity_pools_by_both_assets(
-            asset_symbol_or_id_a,
-            asset_symbol_or_id_b,
-            limit,
-            start_id,
-            with_statistics );
+   return my->run_read( "database_api.get_liquidity_pools_by_both_assets", [&]() {
+      return my->get_liquidity_pools_by_both_assets(
+               asset_symbol_or_id_a,
+               asset_symbol_or_id_b,
+               limit,
+               start_id,
+               with_statistics );
+   } );
 }
 
 vector<extended_liquidity_pool_object> database_api_impl::get_liquidity_pools_by_both_assets(
@@ -1937,10 +2071,12 @@ vector<optional<extended_liquidity_pool_object>> database_api::get_liquidity_poo
             optional<bool> subscribe,
             optional<bool> with_statistics )const
 {
-   return my->get_liquidity_pools(
-            ids,
-            subscribe,
-            with_statistics );
+   return my->run_read( "database_api.get_liquidity_pools", [&]() {
+      return my->get_liquidity_pools(
+               ids,
+               subscribe,
+               with_statistics );
+   } );
 }
 
 vector<optional<extended_liquidity_pool_object>> database_api_impl::get_liquidity_pools(
@@ -1983,10 +2119,12 @@ vector<optional<extended_liquidity_pool_object>> database_api::get_liquidity_poo
             optional<bool> subscribe,
             optional<bool> with_statistics )const
 {
-   return my->get_liquidity_pools_by_share_asset(
-            asset_symbols_or_ids,
-            subscribe,
-            with_statistics );
+   return my->run_read( "database_api.get_liquidity_pools_by_share_asset", [&]() {
+      return my->get_liquidity_pools_by_share_asset(
+               asset_symbols_or_ids,
+               subscribe,
+               with_statistics );
+   } );
 }
 
 vector<optional<extended_liquidity_pool_object>> database_api_impl::get_liquidity_pools_by_share_asset(
@@ -2029,11 +2167,13 @@ vector<extended_liquidity_pool_object> database_api::get_liquidity_pools_by_owne
             optional<asset_id_type> start_id,
             optional<bool> with_statistics )const
 {
-   return my->get_liquidity_pools_by_owner(
-            account_name_or_id,
-            limit,
-            start_id,
-            with_statistics );
+   return my->run_read( "database_api.get_liquidity_pools_by_owner", [&]() {
+      return my->get_liquidity_pools_by_owner(
+               account_name_or_id,
+               limit,
+               start_id,
+               with_statistics );
+   } );
 }
 
 vector<extended_liquidity_pool_object> database_api_impl::get_liquidity_pools_by_owner(
@@ -2083,7 +2223,9 @@ vector<extended_liquidity_pool_object> database_api_impl::get_liquidity_pools_by
 
 vector<optional<witness_object>> database_api::get_witnesses(const vector<witness_id_type>& witness_ids)const
 {
-   return my->get_witnesses( witness_ids );
+   return my->run_read( "database_api.get_witnesses", [&]() {
+      return my->get_witnesses( witness_ids );
+   } );
 }
 
 vector<optional<witness_object>> database_api_impl::get_witnesses(const vector<witness_id_type>& witness_ids)const
@@ -2100,7 +2242,9 @@ vector<optional<witness_object>> database_api_impl::get_witnesses(const vector<w
 
 fc::optional<witness_object> database_api::get_witness_by_account(const std::string account_id_or_name)const
 {
-   return my->get_witness_by_account( account_id_or_name );
+   return my->run_read( "database_api.get_witness_by_account", [&]() {
+      return my->get_witness_by_account( account_id_or_name );
+   } );
 }
 
 fc::optional<witness_object> database_api_impl::get_witness_by_account(const std::string account_id_or_name) const
@@ -2116,7 +2260,9 @@ fc::optional<witness_object> database_api_impl::get_witness_by_account(const std
 map<string, witness_id_type> database_api::lookup_witness_accounts( const string& lower_bound_name,
                                                                     uint32_t limit )const
 {
-   return my->lookup_witness_accounts( lower_bound_name, limit );
+   return my->run_read( "database_api.lookup_witness_accounts", [&]() {
+      return my->lookup_witness_accounts( lower_bound_name, limit );
+   } );
 }
 
 map<string, witness_id_type> database_api_impl::lookup_witness_accounts( const string& lower_bound_name,
@@ -2150,7 +2296,9 @@ map<string, witness_id_type> database_api_impl::lookup_witness_accounts( const s
 
 uint64_t database_api::get_witness_count()const
 {
-   return my->get_witness_count();
+   return my->run_read( "database_api.get_witness_count", [&]() {
+      return my->get_witness_count();
+   } );
 }
 
 uint64_t database_api_impl::get_witness_count()const
@@ -2167,7 +2315,9 @@ uint64_t database_api_impl::get_witness_count()const
 vector<optional<committee_member_object>> database_api::get_committee_members(
                                              const vector<committee_member_id_type>& committee_member_ids )const
 {
-   return my->get_committee_members( committee_member_ids );
+   return my->run_read( "database_api.get_committee_members", [&]() {
+      return my->get_committee_members( committee_member_ids );
+   } );
 }
 
 vector<optional<committee_member_object>> database_api_impl::get_committee_members(
@@ -2186,7 +2336,9 @@ vector<optional<committee_member_object>> database_api_impl::get_committee_membe
 fc::optional<committee_member_object> database_api::get_committee_member_by_account(
                                          const std::string account_id_or_name )const
 {
-   return my->get_committee_member_by_account( account_id_or_name );
+   return my->run_read( "database_api.get_committee_member_by_account", [&]() {
+      return my->get_committee_member_by_account( account_id_or_name );
+   } );
 }
 
 fc::optional<committee_member_object> database_api_impl::get_committee_member_by_account(
@@ -2203,7 +2355,9 @@ fc::optional<committee_member_object> database_api_impl::get_committee_member_by
 map<string, committee_member_id_type> database_api::lookup_committee_member_accounts(
                                          const string& lower_bound_name, uint32_t limit )const
 {
-   return my->lookup_committee_member_accounts( lower_bound_name, limit );
+   return my->run_read( "database_api.lookup_committee_member_accounts", [&]() {
+      return my->lookup_committee_member_accounts( lower_bound_name, limit );
+   } );
 }
 
 map<string, committee_member_id_type> database_api_impl::lookup_committee_member_accounts(
@@ -2237,7 +2391,9 @@ map<string, committee_member_id_type> database_api_impl::lookup_committee_member
 
 uint64_t database_api::get_committee_count()const
 {
-    return my->get_committee_count();
+   return my->run_read( "database_api.get_committee_count", [&]() {
+       return my->get_committee_count();
+   } );
 }
 
 uint64_t database_api_impl::get_committee_count()const
@@ -2254,7 +2410,9 @@ uint64_t database_api_impl::get_committee_count()const
 
 vector<worker_object> database_api::get_all_workers( const optional<bool> is_expired )const
 {
-   return my->get_all_workers( is_expired );
+   return my->run_read( "database_api.get_all_workers", [&]() {
+      return my->get_all_workers( is_expired );
+   } );
 }
 
 vector<worker_object> database_api_impl::get_all_workers( const optional<bool> is_expired )const
@@ -2287,7 +2445,9 @@ vector<worker_object> database_api_impl::get_all_workers( const optional<bool> i
 
 vector<worker_object> database_api::get_workers_by_account(const std::string account_id_or_name)const
 {
-   return my->get_workers_by_account( account_id_or_name );
+   return my->run_read( "database_api.get_workers_by_account", [&]() {
+      return my->get_workers_by_account( account_id_or_name );
+   } );
 }
 
 vector<worker_object> database_api_impl::get_workers_by_account(const std::string account_id_or_name)const
@@ -2306,7 +2466,9 @@ vector<worker_object> database_api_impl::get_workers_by_account(const std::strin
 
 uint64_t database_api::get_worker_count()const
 {
-    return my->get_worker_count();
+   return my->run_read( "database_api.get_worker_count", [&]() {
+       return my->get_worker_count();
+   } );
 }
 
 uint64_t database_api_impl::get_worker_count()const
@@ -2324,7 +2486,9 @@ uint64_t database_api_impl::get_worker_count()const
 
 vector<variant> database_api::lookup_vote_ids( const vector<vote_id_type>& votes )const
 {
-   return my->lookup_vote_ids( votes );
+   return my->run_read( "database_api.lookup_vote_ids", [&]() {
+      return my->lookup_vote_ids( votes );
+   } );
 }
 
 vector<variant> database_api_impl::lookup_vote_ids( const vector<vote_id_type>& votes )const
@@ -2401,7 +2565,9 @@ vector<variant> database_api_impl::lookup_vote_ids( const vector<vote_id_type>&
 
 std::string database_api::get_transaction_hex(const signed_transaction& trx)const
 {
-   return my->get_transaction_hex( trx );
+   return my->run_read( "database_api.get_transaction_hex", [&]() {
+      return my->get_transaction_hex( trx );
+   } );
 }
 
 std::string database_api_impl::get_transaction_hex(const signed_transaction& trx)const
@@ -2412,7 +2578,9 @@ std::string database_api_impl::get_transaction_hex(const signed_transaction& trx
 std::string database_api::get_transaction_hex_without_sig(
    const transaction &trx) const
 {
-   return my->get_transaction_hex_without_sig(trx);
+   return my->run_read( "database_api.get_transaction_hex_without_sig", [&]() {
+      return my->get_transaction_hex_without_sig(trx);
+   } );
 }
 
 std::string database_api_impl::get_transaction_hex_without_sig(
@@ -2424,7 +2592,9 @@ std::string database_api_impl::get_transaction_hex_without_sig(
 set<public_key_type> database_api::get_required_signatures( const signed_transaction& trx,
                                                             const flat_set<public_key_type>& available_keys )const
 {
-   return my->get_required_signatures( trx, available_keys );
+   return my->run_read( "database_api.get_required_signatures", [&]() {
+      return my->get_required_signatures( trx, available_keys );
+   } );
 }
 
 set<public_key_type> database_api_impl::get_required_signatures( const signed_transaction& trx,
@@ -2445,11 +2615,15 @@ set<public_key_type> database_api_impl::get_required_signatures( const signed_tr
 
 set<public_key_type> database_api::get_potential_signatures( const signed_transaction& trx )const
 {
-   return my->get_potential_signatures( trx );
+   return my->run_read( "database_api.get_potential_signatures", [&]() {
+      return my->get_potential_signatures( trx );
+   } );
 }
 set<address> database_api::get_potential_address_signatures( const signed_transaction& trx )const
 {
-   return my->get_potential_address_signatures( trx );
+   return my->run_read( "database_api.get_potential_address_signatures", [&]() {
+      return my->get_potential_address_signatures( trx );
+   } );
 }
 
 set<public_key_type> database_api_impl::get_potential_signatures( const signed_transaction& trx )const
@@ -2522,7 +2696,9 @@ set<address> database_api_impl::get_potential_address_signatures( const signed_t
 
 bool database_api::verify_authority( const signed_transaction& trx )const
 {
-   return my->verify_authority( trx );
+   return my->run_read( "database_api.verify_authority", [&]() {
+      return my->verify_authority( trx );
+   } );
 }
 
 bool database_api_impl::verify_authority( const signed_transaction& trx )const
@@ -2541,7 +2717,9 @@ bool database_api_impl::verify_authority( const signed_transaction& trx )const
 bool database_api::verify_account_authority( const string& account_name_or_id,
                                              const flat_set<public_key_type>& signers )const
 {
-   return my->verify_account_authority( account_name_or_id, signers );
+   return my->run_read( "database_api.verify_account_authority", [&]() {
+      return my->verify_account_authority( account_name_or_id, signers );
+   } );
 }
 
 bool database_api_impl::verify_account_authority( const string& account_name_or_id,
@@ -2583,7 +2761,9 @@ processed_transaction database_api_impl::validate_transaction( const signed_tran
 vector< fc::variant > database_api::get_required_fees( const vector<operation>& ops,
                                                        const std::string& asset_id_or_symbol )const
 {
-   return my->get_required_fees( ops, asset_id_or_symbol );
+   return my->run_read( "database_api.get_required_fees", [&]() {
+      return my->get_required_fees( ops, asset_id_or_symbol );
+   } );
 }
 
 /**
@@ -2673,7 +2853,9 @@ vector< fc::variant > database_api_impl::get_required_fees( const vector<operati
 
 vector<proposal_object> database_api::get_proposed_transactions( const std::string account_id_or_name )const
 {
-   return my->get_proposed_transactions( account_id_or_name );
+   return my->run_read( "database_api.get_proposed_transactions", [&]() {
+      return my->get_proposed_transactions( account_id_or_name );
+   } );
 }
 
 vector<proposal_object> database_api_impl::get_proposed_transactions( const std::string account_id_or_name )const
@@ -2709,7 +2891,9 @@ vector<proposal_object> database_api_impl::get_proposed_transactions( const std:
 vector<blinded_balance_object> database_api::get_blinded_balances(
                                   const flat_set<commitment_type>& commitments )const
 {
-   return my->get_blinded_balances( commitments );
+   return my->run_read( "database_api.get_blinded_balances", [&]() {
+      return my->get_blinded_balances( commitments );
+   } );
 }
 
 vector<blinded_balance_object> database_api_impl::get_blinded_balances(
@@ -2738,7 +2922,9 @@ vector<withdraw_permission_object> database_api::get_withdraw_permissions_by_giv
                                       withdraw_permission_id_type start,
                                       uint32_t limit)const
 {
-   return my->get_withdraw_permissions_by_giver( account_id_or_name, start, limit );
+   return my->run_read( "database_api.get_withdraw_permissions_by_giver", [&]() {
+      return my->get_withdraw_permissions_by_giver( account_id_or_name, start, limit );
+   } );
 }
 
 vector<withdraw_permission_object> database_api_impl::get_withdraw_permissions_by_giver(
@@ -2772,7 +2958,9 @@ vector<withdraw_permission_object> database_api::get_withdraw_permissions_by_rec
                                       withdraw_permission_id_type start,
                                       uint32_t limit)const
 {
-   return my->get_withdraw_permissions_by_recipient( account_id_or_name, start, limit );
+   return my->run_read( "database_api.get_withdraw_permissions_by_recipient", [&]() {
+      return my->get_withdraw_permissions_by_recipient( account_id_or_name, start, limit );
+   } );
 }
 
 vector<withdraw_permission_object> database_api_impl::get_withdraw_permissions_by_recipient(
@@ -2808,7 +2996,9 @@ vector<withdraw_permission_object> database_api_impl::get_withdraw_permissions_b
 
 optional<htlc_object> database_api::get_htlc( htlc_id_type id, optional<bool> subscribe )const
 {
-   return my->get_htlc( id, subscribe );
+   return my->run_read( "database_api.get_htlc", [&]() {
+      return my->get_htlc( id, subscribe );
+   } );
 }
 
 fc::optional<htlc_object> database_api_impl::get_htlc( htlc_id_type id, optional<bool> subscribe )const
@@ -2824,7 +3014,9 @@ fc::optional<htlc_object> database_api_impl::get_htlc( htlc_id_type id, optional
 vector<htlc_object> database_api::get_htlc_by_from( const std::string account_id_or_name,
                                                     htlc_id_type start, uint32_t limit )const
 {
-   return my->get_htlc_by_from(account_id_or_name, start, limit);
+   return my->run_read( "database_api.get_htlc_by_from", [&]() {
+      return my->get_htlc_by_from(account_id_or_name, start, limit);
+   } );
 }
 
 vector<htlc_object> database_api_impl::get_htlc_by_from( const std::string account_id_or_name,
@@ -2854,7 +3046,9 @@ vector<htlc_object> database_api_impl::get_htlc_by_from( const std::string accou
 vector<htlc_object> database_api::get_htlc_by_to( const std::string account_id_or_name,
                                                   htlc_id_type start, uint32_t limit )const
 {
-   return my->get_htlc_by_to(account_id_or_name, start, limit);
+   return my->run_read( "database_api.get_htlc_by_to", [&]() {
+      return my->get_htlc_by_to(account_id_or_name, start, limit);
+   } );
 }
 
 vector<htlc_object> database_api_impl::get_htlc_by_to( const std::string account_id_or_name,
@@ -2883,7 +3077,9 @@ vector<htlc_object> database_api_impl::get_htlc_by_to( const std::string account
 
 vector<htlc_object> database_api::list_htlcs(const htlc_id_type start, uint32_t limit)const
 {
-   return my->list_htlcs(start, limit);
+   return my->run_read( "database_api.list_htlcs", [&]() {
+      return my->list_htlcs(start, limit);
+   } );
 }
 
 vector<htlc_object> database_api_impl::list_htlcs(const htlc_id_type start, uint32_t limit) const
@@ -2915,9 +3111,11 @@ vector<ticket_object> database_api::list_tickets(
             optional<uint32_t> limit,
             optional<ticket_id_type> start_id )const
 {
-   return my->list_tickets(
-            limit,
-            start_id );
+   return my->run_read( "database_api.list_tickets", [&]() {
+      return my->list_tickets(
+               limit,
+               start_id );
+   } );
 }
 
 vector<ticket_object> database_api_impl::list_tickets(
@@ -2955,10 +3153,12 @@ vector<ticket_object> database_api::get_tickets_by_account(
             optional<uint32_t> limit,
             optional<ticket_id_type> start_id )const
 {
-   return my->get_tickets_by_account(
-            account_name_or_id,
-            limit,
-            start_id );
+   return my->run_read( "database_api.get_tickets_by_account", [&]() {
+      return my->get_tickets_by_account(
+               account_name_or_id,
+               limit,
+               start_id );
+   } );
 }
 
 vector<ticket_object> database_api_impl::get_tickets_by_account(
@@ -3244,10 +3444,12 @@ void database_api_impl::on_applied_block()
    if(_market_subscriptions.size() == 0)
       return;
 
-   const auto& ops = _db.get_applied_operations();
-   map< std::pair<asset_id_type,asset_id_type>, vector<pair<operation, operation_result>> > subscribed_markets_ops;
-   for(const optional< operation_history_object >& o_op : ops)
+   // the operations are serialized later, keep the log of this block instead of copying them
+   const auto ops = _db.share_applied_operations();
+   map< std::pair<asset_id_type,asset_id_type>, vector<size_t> > subscribed_markets_ops;
+   for( size_t i = 0; i < ops->size(); ++i )
    {
+      const optional< operation_history_object >& o_op = (*ops)[i];
       if( !o_op.valid() )
          continue;
       const operation_history_object& op = *o_op;
@@ -3270,16 +3472,29 @@ void database_api_impl::on_applied_block()
       }
       if( market.valid() && _market_subscriptions.count(*market) > 0 )
          // FIXME this may cause fill_order_operation be pushed before order creation
-         subscribed_markets_ops[*market].emplace_back(std::make_pair(op.op, op.result));
+         subscribed_markets_ops[*market].push_back( i );
    }
+   if( subscribed_markets_ops.empty() )
+      return;
    /// we need to ensure the database_api is not deleted for the life of the async operation
    auto capture_this = shared_from_this();
-   fc::async([this,capture_this,subscribed_markets_ops](){
-      for(auto item : subscribed_markets_ops)
+   fc::async([this,capture_this,ops,subscribed_markets_ops](){
+      for(const auto& item : subscribed_markets_ops)
       {
          auto itr = _market_subscriptions.find(item.first);
          if(itr != _market_subscriptions.end())
-            itr->second(fc::variant(item.second, GRAPHENE_NET_MAX_NESTED_OBJECTS));
+         {
+            // the same as a variant of vector<pair<operation, operation_result>>
+            fc::variants updates;
+            updates.reserve( item.second.size() );
+            for( size_t i : item.second )
+            {
+               const operation_history_object& op = *(*ops)[i];
+               updates.emplace_back( fc::variants{ fc::variant( op.op, GRAPHENE_NET_MAX_NESTED_OBJECTS - 2 ),
+                                                   fc::variant( op.result, GRAPHENE_NET_MAX_NESTED_OBJECTS - 2 ) } );
+            }
+            itr->second( fc::variant( std::move( updates ) ) );
+         }
       }
    });
 }
@@ -22,9 +22,10 @@
  * THE SOFTWARE.
  */
 
+#include <graphene/app/api_call_statistics.hpp>
+#include <graphene/app/api_worker_pool.hpp>
 #include <graphene/app/database_api.hpp>
-
-#include <fc/bloom_filter.hpp>
+#include <graphene/app/subscription_filter.hpp>
 
 #define GET_REQUIRED_FEES_MAX_RECURSION 4
 
@@ -36,7 +37,9 @@ typedef std::map< std::pair<graphene::chain::asset_id_type, graphene::chain::ass
 class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 {
    public:
-      explicit database_api_impl( graphene::chain::database& db, const application_options* app_options );
+      database_api_impl( graphene::chain::database& db, const application_options* app_options,
+                         api_worker_pool* worker_pool, api_call_statistics* call_stats,
+                         uint64_t connection_id );
       virtual ~database_api_impl();
 
       // Objects
@@ -48,6 +51,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       void set_pending_transaction_callback( std::function<void(const variant&)> cb );
       void set_block_applied_callback( std::function<void(const variant& block_id)> cb );
       void cancel_all_subscriptions(bool reset_callback, bool reset_market_subscriptions);
+      subscription_filter_statistics get_subscription_statistics()const;
 
       // Blocks and transactions
       optional<block_header> get_block_header(uint32_t block_num)const;
@@ -344,6 +348,30 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
          return results;
       }
 
+      ////////////////////////////////////////////////
+      // Worker threads
+      ////////////////////////////////////////////////
+
+      // Executes a read-only call on the worker thread of this API instance, or in place if there is no worker pool,
+      // and records it in the API call statistics if they are enabled
+      template<typename Lambda>
+      auto run_read( const char* method, Lambda&& f )const -> decltype( f() )
+      {
+         if( _call_stats == nullptr )
+            return run_on_worker( method, f );
+         return _call_stats->measure( _connection_id, method, [this,method,&f]() {
+            return run_on_worker( method, f );
+         } );
+      }
+
+      template<typename Lambda>
+      auto run_on_worker( const char* method, Lambda& f )const -> decltype( f() )
+      {
+         if( _worker_pool == nullptr )
+            return f();
+         return _worker_pool->run_on( *_worker_thread, _db, method, f );
+      }
+
       ////////////////////////////////////////////////
       // Subscription
       ////////////////////////////////////////////////
@@ -359,40 +387,24 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       }
 
       // Note:
-      //   Different type of object_id<T> objects could become identical after packed.
-      //   For example, both `account_id_type a=1.2.0` and `asset_id_type b=1.3.0` will become `0` after packed.
-      //   In order to avoid collision, we don't use a template function here, instead, we implicitly convert all
-      //   object IDs to `object_id_type` when subscribing.
-      //
-      //   If need to subscribe to other data types, override this function with the types as parameter.
-      //   For example, we had a `get_subscription_key( const public_key_type& item )` function here, which was
-      //   removed lately since we no longer subscribe to public keys.
-      vector<char> get_subscription_key( const object_id_type& item )const
-      {
-         return fc::raw::pack(item);
-      }
-
-      template<typename T>
-      void subscribe_to_item( const T& item )const
+      //   Different type of object_id<T> objects could be identical if only their instances were compared.
+      //   For example, `account_id_type a=1.2.0` and `asset_id_type b=1.3.0` both have instance `0`.
+      //   In order to avoid collision, all object IDs are implicitly converted to `object_id_type`, which includes
+      //   the space and the type, when subscribing.
+      void subscribe_to_item( const object_id_type& item )const
       {
          if( !_subscribe_callback )
             return;
 
-         vector<char> key = get_subscription_key( item );
-         if( !_subscribe_filter.contains( key.data(), key.size() ) )
-         {
-            _subscribe_filter.insert( key.data(), key.size() );
-         }
+         _subscribe_filter.insert( item );
       }
 
-      template<typename T>
-      bool is_subscribed_to_item( const T& item )const
+      bool is_subscribed_to_item( const object_id_type& item )const
       {
          if( !_subscribe_callback )
             return false;
 
-         vector<char> key = get_subscription_key( item );
-         return _subscribe_filter.contains( key.data(), key.size() );
+         return _subscribe_filter.contains( item );
       }
 
       // for full-account subscription
@@ -451,7 +463,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       bool _notify_remove_create = false;
       bool _enabled_auto_subscription = true;
 
-      mutable fc::bloom_filter  _subscribe_filter;
+      mutable subscription_filter  _subscribe_filter;
       std::set<account_id_type> _subscribed_accounts;
 
       std::function<void(const fc::variant&)> _subscribe_callback;
@@ -469,6 +481,12 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
       graphene::chain::database& _db;
       const application_options* _app_options = nullptr;
 
+      api_worker_pool* _worker_pool = nullptr;
+      fc::thread*      _worker_thread = nullptr;
+
+      api_call_statistics* _call_stats = nullptr;
+      uint64_t             _connection_id = 0;
+
       const graphene::api_helper_indexes::amount_in_collateral_index* amount_in_collateral_index;
       const graphene::api_helper_indexes::asset_in_liquidity_pools_index* asset_in_liquidity_pools_index;
 };
@@ -23,6 +23,7 @@
  */
 #pragma once
 
+#include <graphene/app/api_call_statistics.hpp>
 #include <graphene/app/database_api.hpp>
 
 #include <graphene/protocol/types.hpp>
@@ -122,8 +123,10 @@ namespace graphene { namespace app {
    class history_api
    {
       public:
-         history_api(application& app)
-               :_app(app), database_api( std::ref(*app.chain_database()), &(app.get_options())) {}
+         /// @param connection_id the ID of the API connection this instance serves, used for call statistics
+         history_api(application& app, uint64_t connection_id = 0)
+               :_app(app), database_api( std::ref(*app.chain_database()), &(app.get_options())),
+                _connection_id(connection_id) {}
 
          /**
           * @brief Get operations relevant to the specificed account
@@ -280,8 +283,21 @@ namespace graphene { namespace app {
                optional<int64_t> operation_type = optional<int64_t>() )const;
 
       private:
+           /// Executes a read-only call on an API worker thread if they are enabled, otherwise in place,
+           /// and records it in the API call statistics if they are enabled
+           template<typename Lambda>
+           auto run_read( const char* method, Lambda&& f )const -> decltype( f() );
+           /// Same as @ref run_read without recording the call, for methods which record themselves with
+           /// @ref measure
+           template<typename Lambda>
+           auto run_locked( const char* method, Lambda&& f )const -> decltype( f() );
+           /// Executes @p f in place and records it in the API call statistics if they are enabled
+           template<typename Lambda>
+           auto measure( const char* method, Lambda&& f )const -> decltype( f() );
+
            application& _app;
            graphene::app::database_api database_api;
+           uint64_t _connection_id = 0;
    };
 
    /**
@@ -322,6 +338,13 @@ namespace graphene { namespace app {
             processed_transaction trx;
          };
 
+         struct transaction_batch_result
+         {
+            transaction_id_type       id;
+            bool                      accepted = false;
+            fc::optional<std::string> error; ///< why the transaction was rejected
+         };
+
          typedef std::function<void(variant/*transaction_confirmation*/)> confirmation_callback;
 
          /**
@@ -348,6 +371,18 @@ namespace graphene { namespace app {
           */
          fc::variant broadcast_transaction_synchronous(const precomputable_transaction& trx);
 
+         /**
+          * @brief Broadcast a batch of transactions to the network
+          * @param trxs The transactions to broadcast
+          * @return The result of each transaction, in the same order as @p trxs
+          *
+          * The signatures of all transactions are recovered in parallel, then the transactions are pushed to the
+          * local database one after another. Unlike with @ref broadcast_transaction, a transaction which fails to
+          * apply does not stop the others, its error is reported in its result instead. The accepted transactions
+          * are broadcast to the peers together.
+          */
+         vector<transaction_batch_result> broadcast_transaction_batch( const vector<precomputable_transaction>& trxs );
+
          /**
           * @brief Broadcast a signed block to the network
           * @param block The signed block to broadcast
@@ -512,7 +547,8 @@ namespace graphene { namespace app {
    class asset_api
    {
       public:
-         asset_api(graphene::app::application& app);
+         /// @param connection_id the ID of the API connection this instance serves, used for call statistics
+         asset_api(graphene::app::application& app, uint64_t connection_id = 0);
          ~asset_api();
 
          /**
@@ -538,9 +574,15 @@ namespace graphene { namespace app {
          vector<asset_holders> get_all_asset_holders() const;
 
       private:
+         /// Executes a read-only call on an API worker thread if they are enabled, otherwise in place,
+         /// and records it in the API call statistics if they are enabled
+         template<typename Lambda>
+         auto run_read( const char* method, Lambda&& f )const -> decltype( f() );
+
          graphene::app::application& _app;
          graphene::chain::database& _db;
          graphene::app::database_api database_api;
+         uint64_t _connection_id = 0;
    };
 
    /**
@@ -604,6 +646,43 @@ namespace graphene { namespace app {
          application& _app;
          graphene::app::database_api database_api;
    };
+
+   /**
+    * @brief The metrics_api class exposes statistics of the node for monitoring.
+    *
+    * The API call statistics are only recorded if the node runs with enable-api-call-statistics.
+    */
+   class metrics_api
+   {
+      public:
+         metrics_api(application& a);
+
+         /**
+          * @brief Get the call statistics of all API methods
+          * @return The statistics keyed by API method name, e.g. "database_api.get_objects"
+          */
+         std::map<std::string, api_method_statistics> get_api_call_statistics() const;
+
+         /**
+          * @brief Get the per-method call statistics of all open API connections
+          */
+         std::vector<api_connection_statistics> get_api_connection_statistics() const;
+
+         /**
+          * @brief Get the API call statistics in the Prometheus text exposition format
+          */
+         std::string get_prometheus_metrics() const;
+
+         /**
+          * @brief Clear all API call statistics
+          */
+         void reset_api_call_statistics();
+
+      private:
+         api_call_statistics& get_statistics() const;
+
+         application& _app;
+   };
 } } // graphene::app
 
 extern template class fc::api<graphene::app::block_api>;
@@ -615,6 +694,7 @@ extern template class fc::api<graphene::app::asset_api>;
 extern template class fc::api<graphene::app::orders_api>;
 extern template class fc::api<graphene::debug_witness::debug_api>;
 extern template class fc::api<graphene::app::custom_operations_api>;
+extern template class fc::api<graphene::app::metrics_api>;
 
 namespace graphene { namespace app {
    /**
@@ -654,6 +734,8 @@ namespace graphene { namespace app {
          fc::api<asset_api> asset()const;
          /// @brief Retrieve the orders API
          fc::api<orders_api> orders()const;
+         /// @brief Retrieve the metrics API
+         fc::api<metrics_api> metrics()const;
          /// @brief Retrieve the debug API (if available)
          fc::api<graphene::debug_witness::debug_api> debug()const;
          /// @brief Retrieve the custom operations API
@@ -674,6 +756,8 @@ namespace graphene { namespace app {
          optional< fc::api<orders_api> > _orders_api;
          optional< fc::api<graphene::debug_witness::debug_api> > _debug_api;
          optional< fc::api<custom_operations_api> > _custom_operations_api;
+         optional< fc::api<metrics_api> > _metrics_api;
+         uint64_t _connection_id = 0; ///< the ID of this connection in the API call statistics
    };
 
 }}  // graphene::app
@@ -682,6 +766,8 @@ extern template class fc::api<graphene::app::login_api>;
 
 FC_REFLECT( graphene::app::network_broadcast_api::transaction_confirmation,
         (id)(block_num)(trx_num)(trx) )
+FC_REFLECT( graphene::app::network_broadcast_api::transaction_batch_result,
+        (id)(accepted)(error) )
 FC_REFLECT( graphene::app::verify_range_result,
         (success)(min_val)(max_val) )
 FC_REFLECT( graphene::app::verify_range_proof_rewind_result,
@@ -714,6 +800,7 @@ FC_API(graphene::app::network_broadcast_api,
        (broadcast_transaction)
        (broadcast_transaction_with_callback)
        (broadcast_transaction_synchronous)
+       (broadcast_transaction_batch)
        (broadcast_block)
      )
 FC_API(graphene::app::network_node_api,
@@ -745,6 +832,12 @@ FC_API(graphene::app::orders_api,
 FC_API(graphene::app::custom_operations_api,
        (get_storage_info)
      )
+FC_API(graphene::app::metrics_api,
+       (get_api_call_statistics)
+       (get_api_connection_statistics)
+       (get_prometheus_metrics)
+       (reset_api_call_statistics)
+     )
 FC_API(graphene::app::login_api,
        (login)
        (block)
@@ -757,4 +850,5 @@ FC_API(graphene::app::login_api,
        (orders)
        (debug)
        (custom_operations)
+       (metrics)
      )
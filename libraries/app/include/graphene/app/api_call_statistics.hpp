@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/protocol/config.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/time.hpp>
+#include <fc/variant.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   /**
+    * @brief Latency distribution of the calls of one API method
+    *
+    * Bucket N counts the calls which took less than 2^N microseconds (and at least 2^(N-1)),
+    * the last bucket also counts everything slower than that.
+    */
+   struct api_latency_histogram
+   {
+      static constexpr size_t bucket_count = 24; ///< the last bucket starts at ~4.2 seconds
+
+      uint64_t              count    = 0;
+      uint64_t              total_us = 0;
+      uint64_t              max_us   = 0;
+      std::vector<uint64_t> buckets  = std::vector<uint64_t>( bucket_count, 0 );
+
+      void record( const fc::microseconds& latency );
+   };
+
+   /// Statistics of the calls of one API method
+   struct api_method_statistics
+   {
+      uint64_t              calls  = 0;
+      uint64_t              errors = 0; ///< calls which ended with an exception
+      api_latency_histogram latency;
+
+      /// Result size and serialization time are only measured for every N-th call, see @ref api_call_statistics
+      uint64_t              sampled_calls            = 0;
+      uint64_t              sampled_result_bytes     = 0; ///< total JSON size of the sampled results
+      uint64_t              max_result_bytes         = 0;
+      uint64_t              sampled_serialization_us = 0; ///< total serialization time of the sampled results
+      uint64_t              max_serialization_us     = 0;
+   };
+
+   /// Statistics of the API calls made through one connection
+   struct api_connection_statistics
+   {
+      uint64_t                                     connection_id = 0;
+      std::string                                  user;
+      fc::time_point_sec                           connected_since;
+      std::map<std::string, api_method_statistics> methods;
+   };
+
+   /**
+    * @brief Per-method and per-connection statistics of API calls
+    *
+    * Every call is counted and its latency is recorded in a histogram. The cost of serializing the result is
+    * measured for the first and then every @p sample_interval-th call of each method only, so the overhead stays
+    * at a map lookup and a mutex per call for the rest.
+    *
+    * All methods are thread safe, calls may be recorded from API worker threads.
+    */
+   class api_call_statistics
+   {
+      public:
+         explicit api_call_statistics( uint32_t sample_interval );
+
+         /// Registers a new API connection and returns its ID
+         uint64_t register_connection();
+         void set_connection_user( uint64_t connection_id, const std::string& user );
+         void unregister_connection( uint64_t connection_id );
+
+         /**
+          * @brief Execute @p f and record the call
+          * @param connection_id the connection the call came from, as returned by @ref register_connection
+          * @param method the name of the API method
+          * @param f the call to execute
+          */
+         template<typename Lambda>
+         auto measure( uint64_t connection_id, const char* method, Lambda&& f ) -> decltype( f() );
+
+         /**
+          * @brief Record a completed call
+          * @return whether the result of this call should be sampled with @ref record_sample
+          */
+         bool record_call( uint64_t connection_id, const char* method, const fc::microseconds& latency,
+                           bool failed );
+         void record_sample( uint64_t connection_id, const char* method, uint64_t result_bytes,
+                             const fc::microseconds& serialization_time );
+
+         /// Serialize @p result the way the RPC server does and record its size and serialization time
+         template<typename Result>
+         void sample_result( uint64_t connection_id, const char* method, const Result& result )
+         {
+            const fc::time_point start = fc::time_point::now();
+            try
+            {
+               const fc::variant v( result, GRAPHENE_MAX_NESTED_OBJECTS );
+               const auto bytes = fc::json::to_string( v, fc::json::stringify_large_ints_and_doubles,
+                                                       GRAPHENE_MAX_NESTED_OBJECTS ).size();
+               record_sample( connection_id, method, bytes, fc::time_point::now() - start );
+            }
+            catch( const fc::exception& )
+            {
+               // the RPC server will fail to serialize the result too and report it to the caller
+            }
+         }
+
+         /// Returns a copy of the statistics, keyed by method name
+         std::map<std::string, api_method_statistics> get_method_statistics()const;
+         /// Returns a copy of the statistics of the currently open connections
+         std::vector<api_connection_statistics> get_connection_statistics()const;
+         /// Returns the statistics in the Prometheus text exposition format
+         std::string get_prometheus_text()const;
+
+         /// Clears all statistics, open connections are kept
+         void reset();
+
+      private:
+         const uint32_t                                _sample_interval;
+
+         mutable std::mutex                            _mutex;
+         uint64_t                                      _next_connection_id = 1;
+         std::map<std::string, api_method_statistics>  _methods;
+         std::map<uint64_t, api_connection_statistics> _connections;
+   };
+
+   namespace detail {
+
+      template<typename Lambda>
+      auto call_counting_errors( api_call_statistics& stats, uint64_t connection_id, const char* method,
+                                 const fc::time_point& start, Lambda& f ) -> decltype( f() )
+      {
+         try
+         {
+            return f();
+         }
+         catch( ... )
+         {
+            stats.record_call( connection_id, method, fc::time_point::now() - start, true );
+            throw;
+         }
+      }
+
+      template<typename Result>
+      struct measured_call
+      {
+         template<typename Lambda>
+         static Result call( api_call_statistics& stats, uint64_t connection_id, const char* method, Lambda& f )
+         {
+            const fc::time_point start = fc::time_point::now();
+            Result result = call_counting_errors( stats, connection_id, method, start, f );
+            if( stats.record_call( connection_id, method, fc::time_point::now() - start, false ) )
+               stats.sample_result( connection_id, method, result );
+            return result;
+         }
+      };
+
+      template<>
+      struct measured_call<void>
+      {
+         template<typename Lambda>
+         static void call( api_call_statistics& stats, uint64_t connection_id, const char* method, Lambda& f )
+         {
+            const fc::time_point start = fc::time_point::now();
+            call_counting_errors( stats, connection_id, method, start, f );
+            stats.record_call( connection_id, method, fc::time_point::now() - start, false );
+         }
+      };
+
+   } // detail
+
+   template<typename Lambda>
+   auto api_call_statistics::measure( uint64_t connection_id, const char* method, Lambda&& f ) -> decltype( f() )
+   {
+      return detail::measured_call<decltype( f() )>::call( *this, connection_id, method, f );
+   }
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::api_latency_histogram, (count)(total_us)(max_us)(buckets) )
+FC_REFLECT( graphene::app::api_method_statistics,
+            (calls)(errors)(latency)
+            (sampled_calls)(sampled_result_bytes)(max_result_bytes)
+            (sampled_serialization_us)(max_serialization_us) )
+FC_REFLECT( graphene::app::api_connection_statistics, (connection_id)(user)(connected_since)(methods) )
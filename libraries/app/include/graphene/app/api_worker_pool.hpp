@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   /**
+    * @brief A pool of threads which serve read-only API calls off the thread which applies blocks
+    *
+    * A call is executed on a worker thread while holding @ref graphene::chain::database::chain_state_mutex
+    * shared, so it always observes the state published by the last completed push_block, push_transaction etc.
+    * The calling fiber is suspended until the call completes, which leaves the calling thread free to apply
+    * blocks in the meantime. Block application only has to wait for the calls which are already running when
+    * it starts.
+    */
+   class api_worker_pool
+   {
+      public:
+         explicit api_worker_pool( uint16_t num_threads );
+         ~api_worker_pool();
+
+         size_t size()const { return _threads.size(); }
+
+         /// Returns the next worker thread in round-robin order
+         fc::thread& next_thread();
+
+         /// Whether the current thread is one of the worker threads of this pool
+         bool is_worker_thread()const;
+
+         /**
+          * @brief Execute @p f on worker thread @p t and wait for the result
+          *
+          * Nested calls (i.e. calls from a worker thread of this pool) are executed in place, without taking
+          * the lock again.
+          *
+          * @param t the worker thread to use, must belong to this pool
+          * @param db the database whose state @p f reads
+          * @param method the name of the API method, used to name the task
+          * @param f the call to execute
+          */
+         template<typename Lambda>
+         auto run_on( fc::thread& t, const graphene::chain::database& db, const char* method, Lambda&& f )
+            -> decltype( f() )
+         {
+            if( is_worker_thread() )
+               return f();
+            return t.async( [&db,&f]() {
+               boost::shared_lock<boost::shared_mutex> lock( db.chain_state_mutex() );
+               return f();
+            }, method ).wait();
+         }
+
+         /// Same as @ref run_on, using the next worker thread in round-robin order
+         template<typename Lambda>
+         auto run( const graphene::chain::database& db, const char* method, Lambda&& f ) -> decltype( f() )
+         {
+            return run_on( next_thread(), db, method, std::forward<Lambda>( f ) );
+         }
+
+      private:
+         std::vector<std::unique_ptr<fc::thread>> _threads;
+         std::atomic<uint32_t>                    _next_thread { 0 };
+   };
+
+} } // graphene::app
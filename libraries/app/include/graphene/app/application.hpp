@@ -34,6 +34,8 @@ namespace graphene { namespace app {
    using std::string;
 
    class abstract_plugin;
+   class api_worker_pool;
+   class api_call_statistics;
 
    class application_options
    {
@@ -75,6 +77,7 @@ namespace graphene { namespace app {
          uint64_t api_limit_get_tickets = 101;
          uint64_t api_limit_get_liquidity_pools = 101;
          uint64_t api_limit_get_liquidity_pool_history = 101;
+         uint64_t api_limit_broadcast_transaction_batch = 1000;
    };
 
    class application
@@ -129,6 +132,10 @@ namespace graphene { namespace app {
 
          net::node_ptr                    p2p_node();
          std::shared_ptr<chain::database> chain_database()const;
+         /// Returns the pool of threads which serve read-only API calls, or null if it is disabled
+         api_worker_pool*                 get_api_worker_pool()const;
+         /// Returns the API call statistics, or null if they are not recorded
+         api_call_statistics*             get_api_call_statistics()const;
          void set_api_limit();
          void set_block_production(bool producing_blocks);
          fc::optional< api_access_info > get_api_access_info( const string& username )const;
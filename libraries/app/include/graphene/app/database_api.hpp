@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/app/api_objects.hpp>
+#include <graphene/app/subscription_filter.hpp>
 
 #include <graphene/protocol/types.hpp>
 
@@ -60,6 +61,8 @@ using std::vector;
 using std::map;
 
 class database_api_impl;
+class api_worker_pool;
+class api_call_statistics;
 
 /**
  * @brief The database_api class implements the RPC API for the chain database.
@@ -71,7 +74,17 @@ class database_api_impl;
 class database_api
 {
    public:
-      database_api(graphene::chain::database& db, const application_options* app_options = nullptr );
+      /**
+       * @param db the chain database
+       * @param app_options the application options, may be null
+       * @param worker_pool if not null, read-only calls are served by a thread of this pool instead of the
+       *                    calling thread, see @ref api_worker_pool
+       * @param call_stats if not null, calls are recorded there
+       * @param connection_id the ID of the connection this instance serves, as registered in @p call_stats
+       */
+      database_api( graphene::chain::database& db, const application_options* app_options = nullptr,
+                    api_worker_pool* worker_pool = nullptr, api_call_statistics* call_stats = nullptr,
+                    uint64_t connection_id = 0 );
       ~database_api();
 
       /////////////
@@ -148,6 +161,12 @@ class database_api
        * This unsubscribes from all subscribed markets and objects.
        */
       void cancel_all_subscriptions();
+      /**
+       * @brief Get the statistics of the object subscriptions of this connection
+       * @return the number of subscribed objects, the fill ratio of the subscription filter, whether it is
+       *         saturated, i.e. reports all objects as subscribed, and how many lookups it answered
+       */
+      subscription_filter_statistics get_subscription_statistics()const;
 
       /////////////////////////////
       // Blocks and transactions //
@@ -1131,6 +1150,7 @@ FC_API(graphene::app::database_api,
    (set_pending_transaction_callback)
    (set_block_applied_callback)
    (cancel_all_subscriptions)
+   (get_subscription_statistics)
 
    // Blocks and transactions
    (get_block_header)
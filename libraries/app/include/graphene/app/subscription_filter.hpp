@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/protocol/object_id.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace graphene { namespace app {
+
+   /// Telemetry of the subscription filter of one API connection
+   struct subscription_filter_statistics
+   {
+      uint64_t items      = 0; ///< object IDs in the filter
+      uint64_t capacity   = 0; ///< number of slots of the filter at its current size
+      double   fill_ratio = 0; ///< items / capacity
+      bool     saturated  = false; ///< the filter is full at its maximum size and reports every ID as subscribed
+
+      uint64_t lookups = 0; ///< calls of @ref subscription_filter::contains
+      uint64_t matches = 0; ///< lookups which reported the ID as subscribed
+      /// Lookups answered by saturation, an upper bound of the false positives
+      uint64_t saturated_matches = 0;
+      uint64_t resizes = 0;
+   };
+
+   /**
+    * @brief Remembers the objects an API client is subscribed to
+    *
+    * A cuckoo hash set of object IDs, each ID is stored in one of two buckets of @ref slots_per_bucket slots.
+    * The IDs are stored scrambled by a bijective mix, whose low bits select the first bucket and whose high bits
+    * select the second one, so checks hash nothing twice and do not allocate. Since the whole ID is kept there are
+    * no false positives, the filter can double in size and IDs can be removed again.
+    *
+    * The filter grows up to @ref max_buckets buckets. If it is full at that size it saturates, i.e. it reports
+    * every ID as subscribed from then on, so no subscription is lost, until it is cleared.
+    *
+    * The filter is not thread safe. The API serializes access to it through the chain state lock and the worker
+    * thread of its connection.
+    */
+   class subscription_filter
+   {
+      public:
+         static constexpr uint32_t slots_per_bucket = 4;
+         static constexpr uint32_t initial_buckets  = 64;
+         static constexpr uint32_t max_buckets      = 1 << 15; ///< 1 MiB, about 120000 objects
+         static constexpr uint32_t max_kicks        = 500;
+
+         subscription_filter();
+
+         void insert( graphene::db::object_id_type id );
+         bool contains( graphene::db::object_id_type id )const;
+         /// Removes @p id, returns whether it was found
+         bool remove( graphene::db::object_id_type id );
+         /// Removes all IDs and shrinks the filter to its initial size, the lookup counters are kept
+         void clear();
+
+         size_t size()const { return _items; }
+         subscription_filter_statistics get_statistics()const;
+
+      private:
+         /// The scrambled ID, never 0
+         static uint64_t slot_key( graphene::db::object_id_type id );
+
+         uint32_t first_bucket( uint64_t key )const { return key & ( _bucket_count - 1 ); }
+         uint32_t other_bucket( uint32_t bucket, uint64_t key )const
+         {
+            // xor keeps the pair symmetric, other_bucket( other_bucket( b, key ), key ) == b
+            return ( bucket ^ static_cast<uint32_t>( key >> 32 ) ) & ( _bucket_count - 1 );
+         }
+         bool     find( uint64_t key )const;
+         /// Puts @p key into a free slot of @p bucket if there is one
+         bool     put( uint32_t bucket, uint64_t key );
+         /// Puts @p key into one of its buckets without growing, returns the key left over if they are full
+         uint64_t place( uint64_t key );
+         /// Doubles the number of buckets, returns false if the filter is at its maximum size
+         bool     grow();
+
+         std::vector<uint64_t> _slots; ///< 0 marks an empty slot
+         uint32_t              _bucket_count = initial_buckets;
+         uint64_t              _items = 0;
+         uint32_t              _kick_state = 0;
+         bool                  _saturated = false;
+
+         mutable uint64_t      _lookups = 0;
+         mutable uint64_t      _matches = 0;
+         mutable uint64_t      _saturated_matches = 0;
+         uint64_t              _resizes = 0;
+   };
+
+} } // graphene::app
+
+FC_REFLECT( graphene::app::subscription_filter_statistics,
+            (items)(capacity)(fill_ratio)(saturated)
+            (lookups)(matches)(saturated_matches)(resizes) )
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/subscription_filter.hpp>
+
+#include <initializer_list>
+#include <utility>
+
+namespace graphene { namespace app {
+
+subscription_filter::subscription_filter()
+{
+   clear();
+}
+
+uint64_t subscription_filter::slot_key( graphene::db::object_id_type id )
+{
+   // splitmix64 finalizer, a bijection which maps only 0 to 0
+   uint64_t x = id.number + 1;
+   x ^= x >> 30;
+   x *= 0xbf58476d1ce4e5b9ULL;
+   x ^= x >> 27;
+   x *= 0x94d049bb133111ebULL;
+   x ^= x >> 31;
+   return x == 0 ? 1 : x; // only for an ID with all bits set, which does not exist
+}
+
+bool subscription_filter::find( uint64_t key )const
+{
+   const uint32_t first = first_bucket( key );
+   for( uint32_t bucket : { first, other_bucket( first, key ) } )
+   {
+      const uint64_t* slots = _slots.data() + bucket * slots_per_bucket;
+      for( uint32_t i = 0; i < slots_per_bucket; ++i )
+         if( slots[i] == key )
+            return true;
+   }
+   return false;
+}
+
+bool subscription_filter::put( uint32_t bucket, uint64_t key )
+{
+   uint64_t* slots = _slots.data() + bucket * slots_per_bucket;
+   for( uint32_t i = 0; i < slots_per_bucket; ++i )
+   {
+      if( slots[i] == 0 )
+      {
+         slots[i] = key;
+         return true;
+      }
+   }
+   return false;
+}
+
+uint64_t subscription_filter::place( uint64_t key )
+{
+   const uint32_t first = first_bucket( key );
+   uint32_t bucket = other_bucket( first, key );
+   if( put( first, key ) || put( bucket, key ) )
+      return 0;
+   // both buckets are full, evict a random key and move it to its other bucket, repeatedly
+   for( uint32_t kick = 0; kick < max_kicks; ++kick )
+   {
+      _kick_state = _kick_state * 1664525 + 1013904223;
+      std::swap( key, _slots[ bucket * slots_per_bucket + ( _kick_state >> 30 ) % slots_per_bucket ] );
+      bucket = other_bucket( bucket, key );
+      if( put( bucket, key ) )
+         return 0;
+   }
+   return key;
+}
+
+bool subscription_filter::grow()
+{
+   if( _bucket_count >= max_buckets )
+      return false;
+
+   std::vector<uint64_t> old_slots( size_t( _bucket_count ) * 2 * slots_per_bucket, 0 );
+   old_slots.swap( _slots );
+   _bucket_count *= 2;
+   ++_resizes;
+   for( uint64_t key : old_slots )
+   {
+      if( key == 0 )
+         continue;
+      uint64_t left = place( key );
+      while( left != 0 )
+      {
+         if( !grow() )
+            return false;
+         left = place( left );
+      }
+   }
+   return true;
+}
+
+void subscription_filter::insert( graphene::db::object_id_type id )
+{
+   if( _saturated )
+      return;
+   const uint64_t key = slot_key( id );
+   if( find( key ) )
+      return;
+
+   ++_items;
+   uint64_t left = place( key );
+   while( left != 0 )
+   {
+      if( !grow() )
+      {
+         // a key has no place any more, from now on everything has to be reported as subscribed
+         _saturated = true;
+         return;
+      }
+      left = place( left );
+   }
+}
+
+bool subscription_filter::contains( graphene::db::object_id_type id )const
+{
+   ++_lookups;
+   if( _saturated )
+   {
+      ++_matches;
+      ++_saturated_matches;
+      return true;
+   }
+   const bool found = find( slot_key( id ) );
+   if( found )
+      ++_matches;
+   return found;
+}
+
+bool subscription_filter::remove( graphene::db::object_id_type id )
+{
+   if( _saturated )
+      return false;
+   const uint64_t key = slot_key( id );
+   const uint32_t first = first_bucket( key );
+   for( uint32_t bucket : { first, other_bucket( first, key ) } )
+   {
+      uint64_t* slots = _slots.data() + bucket * slots_per_bucket;
+      for( uint32_t i = 0; i < slots_per_bucket; ++i )
+      {
+         if( slots[i] == key )
+         {
+            slots[i] = 0;
+            --_items;
+            return true;
+         }
+      }
+   }
+   return false;
+}
+
+void subscription_filter::clear()
+{
+   _bucket_count = initial_buckets;
+   _slots.assign( size_t( _bucket_count ) * slots_per_bucket, 0 );
+   _items = 0;
+   _saturated = false;
+}
+
+subscription_filter_statistics subscription_filter::get_statistics()const
+{
+   subscription_filter_statistics stats;
+   stats.items = _items;
+   stats.capacity = _slots.size();
+   stats.fill_ratio = double( _items ) / _slots.size();
+   stats.saturated = _saturated;
+   stats.lookups = _lookups;
+   stats.matches = _matches;
+   stats.saturated_matches = _saturated_matches;
+   stats.resizes = _resizes;
+   return stats;
+}
+
+} } // graphene::app
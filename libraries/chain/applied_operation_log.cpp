@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/applied_operation_log.hpp>
+
+namespace graphene { namespace chain {
+
+applied_operation_log::entry_type& applied_operation_log::next_entry()
+{
+   if( _size == capacity() )
+      _chunks.emplace_back( std::make_unique<chunk_type>() );
+   return (*this)[ _size++ ];
+}
+
+operation_history_object& applied_operation_log::push_back( const operation& op )
+{
+   entry_type& entry = next_entry();
+   entry = operation_history_object( op );
+   return *entry;
+}
+
+operation_history_object& applied_operation_log::push_back( operation&& op )
+{
+   entry_type& entry = next_entry();
+   entry = operation_history_object( std::move( op ) );
+   return *entry;
+}
+
+void applied_operation_log::truncate( size_t new_size )
+{
+   // release the operations, the chunks are kept for reuse
+   for( size_t i = new_size; i < _size; ++i )
+      (*this)[i].reset();
+   if( new_size < _size )
+      _size = new_size;
+}
+
+} } // graphene::chain
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/apply_profiler.hpp>
+#include <graphene/protocol/operations.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace chain {
+
+namespace {
+
+   const char* const block_phase_names[] =
+   {
+      "validate_header",
+      "transactions",
+      "update_global_data",
+      "process_tickets",
+      "maintenance",
+      "clear_expired_transactions",
+      "clear_expired_proposals",
+      "clear_expired_orders",
+      "clear_expired_htlcs",
+      "update_expired_feeds",
+      "update_core_exchange_rates",
+      "update_withdraw_permissions",
+      "update_witness_schedule",
+      "notify_applied_block",
+      "notify_changed_objects"
+   };
+   static_assert( sizeof( block_phase_names ) / sizeof( block_phase_names[0] ) == apply_profiler::BLOCK_PHASE_COUNT,
+                  "Every block phase needs a name" );
+
+   struct operation_name_visitor
+   {
+      typedef void result_type;
+
+      template<typename T>
+      void operator()( const T& )
+      {
+         std::string name = fc::get_typename<T>::name();
+         const auto pos = name.rfind( "::" );
+         if( pos != std::string::npos )
+            name = name.substr( pos + 2 );
+         const std::string suffix = "_operation";
+         if( name.size() > suffix.size() && name.compare( name.size() - suffix.size(), suffix.size(), suffix ) == 0 )
+            name.resize( name.size() - suffix.size() );
+         names.push_back( std::move( name ) );
+      }
+
+      std::vector<std::string> names;
+   };
+
+   const std::vector<std::string>& operation_names()
+   {
+      static const std::vector<std::string> names = []() {
+         operation_name_visitor visitor;
+         operation op;
+         for( int i = 0; i < op.count(); ++i )
+         {
+            op.set_which( i );
+            op.visit( visitor );
+         }
+         return visitor.names;
+      }();
+      return names;
+   }
+
+   void log_entries( const char* title, const std::map<std::string, apply_profile_entry>& entries )
+   {
+      std::vector<std::pair<std::string, apply_profile_entry>> sorted( entries.begin(), entries.end() );
+      std::sort( sorted.begin(), sorted.end(), []( const auto& a, const auto& b ) {
+         return a.second.total_us > b.second.total_us;
+      } );
+      ilog( "${title}:", ("title", title) );
+      for( const auto& item : sorted )
+      {
+         const auto& e = item.second;
+         ilog( "   ${name}: count ${count}, total ${total} ms, avg ${avg} us, max ${max} us, "
+               "creates ${c}, modifies ${m}, removes ${r}, undo ${u} bytes",
+               ("name", item.first)("count", e.count)("total", e.total_us / 1000)
+               ("avg", e.count > 0 ? e.total_us / e.count : 0)("max", e.max_us)
+               ("c", e.creates)("m", e.modifies)("r", e.removes)("u", e.undo_bytes) );
+      }
+   }
+
+} // anonymous namespace
+
+apply_profiler::phase_scope::phase_scope( apply_profiler* profiler, block_phase phase )
+   : _profiler( profiler ), _phase( phase )
+{
+   if( _profiler != nullptr )
+      _start = _profiler->take_snapshot();
+}
+
+apply_profiler::phase_scope::~phase_scope()
+{
+   if( _profiler != nullptr )
+      add( _profiler->_phases[_phase], _start, _profiler->take_snapshot() );
+}
+
+void apply_profiler::phase_scope::next( block_phase phase )
+{
+   if( _profiler != nullptr )
+   {
+      const snapshot now = _profiler->take_snapshot();
+      add( _profiler->_phases[_phase], _start, now );
+      _start = now;
+   }
+   _phase = phase;
+}
+
+apply_profiler::operation_scope::operation_scope( apply_profiler* profiler, size_t operation_type )
+   : _profiler( profiler ), _operation_type( operation_type )
+{
+   if( _profiler != nullptr )
+      _start = _profiler->take_snapshot();
+}
+
+apply_profiler::operation_scope::~operation_scope()
+{
+   if( _profiler == nullptr )
+      return;
+   auto& operations = _profiler->_operations;
+   if( operations.size() <= _operation_type )
+      operations.resize( _operation_type + 1 );
+   add( operations[_operation_type], _start, _profiler->take_snapshot() );
+}
+
+apply_profiler::apply_profiler( const db::object_database& db ) : _db( db )
+{
+}
+
+apply_profiler::snapshot apply_profiler::take_snapshot()const
+{
+   const auto& counters = _db.get_change_counters();
+   snapshot s;
+   s.time       = fc::time_point::now();
+   s.creates    = counters.creates;
+   s.modifies   = counters.modifies;
+   s.removes    = counters.removes;
+   s.undo_bytes = _db._undo_db.saved_bytes();
+   return s;
+}
+
+void apply_profiler::add( apply_profile_entry& entry, const snapshot& start, const snapshot& end )
+{
+   const int64_t elapsed = ( end.time - start.time ).count();
+   const uint64_t us = elapsed > 0 ? elapsed : 0;
+   ++entry.count;
+   entry.total_us   += us;
+   entry.max_us      = std::max( entry.max_us, us );
+   entry.creates    += end.creates - start.creates;
+   entry.modifies   += end.modifies - start.modifies;
+   entry.removes    += end.removes - start.removes;
+   entry.undo_bytes += end.undo_bytes - start.undo_bytes;
+}
+
+apply_profile apply_profiler::get_profile()const
+{
+   apply_profile result;
+   // every applied block passes validate_header exactly once
+   result.blocks = _phases[validate_header].count;
+   for( size_t i = 0; i < _phases.size(); ++i )
+   {
+      if( _phases[i].count > 0 )
+         result.phases[ block_phase_names[i] ] = _phases[i];
+   }
+   const auto& names = operation_names();
+   for( size_t i = 0; i < _operations.size(); ++i )
+   {
+      if( _operations[i].count > 0 )
+         result.operations[ i < names.size() ? names[i] : std::to_string( i ) ] = _operations[i];
+   }
+   return result;
+}
+
+void apply_profiler::reset()
+{
+   _phases.fill( apply_profile_entry() );
+   _operations.clear();
+}
+
+void apply_profiler::log_summary()const
+{
+   const apply_profile profile = get_profile();
+   ilog( "Block apply profile of ${n} blocks", ("n", profile.blocks) );
+   log_entries( "Block phases", profile.phases );
+   log_entries( "Operations", profile.operations );
+}
+
+} } // graphene::chain
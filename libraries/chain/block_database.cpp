@@ -26,6 +26,8 @@
 #include <fc/io/raw.hpp>
 #include <boost/endian/buffers.hpp>
 
+#include <algorithm>
+
 namespace graphene { namespace chain {
 
 struct index_entry
@@ -45,6 +47,7 @@ namespace graphene { namespace chain {
 
 void block_database::open( const fc::path& dbdir )
 { try {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    fc::create_directories(dbdir);
    _block_num_to_pos.exceptions(std::ios_base::failbit | std::ios_base::badbit);
    _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
@@ -60,8 +63,38 @@ void block_database::open( const fc::path& dbdir )
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
      _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
    }
+   load_block_ids();
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
+void block_database::load_block_ids()
+{
+   boost::unique_lock<boost::shared_mutex> ids_guard( _block_ids_mutex );
+   _block_ids.clear();
+   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
+   const size_t entry_count = _block_num_to_pos.tellg() / sizeof( index_entry );
+   _block_ids.reserve( entry_count );
+
+   // read the index in large chunks, it has one entry per block of the chain
+   constexpr size_t entries_per_chunk = 4096;
+   std::vector<index_entry> chunk( entries_per_chunk );
+   _block_num_to_pos.seekg( 0 );
+   for( size_t read = 0; read < entry_count; )
+   {
+      const size_t count = std::min( entries_per_chunk, entry_count - read );
+      _block_num_to_pos.read( (char*)chunk.data(), count * sizeof( index_entry ) );
+      for( size_t i = 0; i < count; ++i )
+         _block_ids.push_back( chunk[i].block_size.value() > 0 ? chunk[i].block_id : block_id_type() );
+      read += count;
+   }
+}
+
+void block_database::truncate_block_ids( size_t size )const
+{
+   boost::unique_lock<boost::shared_mutex> ids_guard( _block_ids_mutex );
+   if( _block_ids.size() > size )
+      _block_ids.resize( size );
+}
+
 bool block_database::is_open()const
 {
   return _blocks.is_open();
@@ -69,18 +102,24 @@ bool block_database::is_open()const
 
 void block_database::close()
 {
+  std::lock_guard<std::mutex> guard( _streams_mutex );
   _blocks.close();
   _block_num_to_pos.close();
+  boost::unique_lock<boost::shared_mutex> ids_guard( _block_ids_mutex );
+  _block_ids.clear();
+  _block_ids.shrink_to_fit();
 }
 
 void block_database::flush()
 {
+  std::lock_guard<std::mutex> guard( _streams_mutex );
   _blocks.flush();
   _block_num_to_pos.flush();
 }
 
 void block_database::store( const block_id_type& _id, const signed_block& b )
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    block_id_type id = _id;
    if( id == block_id_type() )
    {
@@ -96,10 +135,17 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
    e.block_id   = id;
    _blocks.write( vec.data(), vec.size() );
    _block_num_to_pos.write( (char*)&e, sizeof(e) );
+
+   const uint32_t block_num = block_header::num_from_id(id);
+   boost::unique_lock<boost::shared_mutex> ids_guard( _block_ids_mutex );
+   if( _block_ids.size() <= block_num )
+      _block_ids.resize( block_num + 1 );
+   _block_ids[block_num] = id;
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    index_entry e;
    int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
    _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
@@ -114,6 +160,10 @@ void block_database::remove( const block_id_type& id )
       e.block_size = 0;
       _block_num_to_pos.seekp( sizeof(e) * int64_t(block_header::num_from_id(id)) );
       _block_num_to_pos.write( (char*)&e, sizeof(e) );
+
+      boost::unique_lock<boost::shared_mutex> ids_guard( _block_ids_mutex );
+      if( block_header::num_from_id(id) < _block_ids.size() )
+         _block_ids[block_header::num_from_id(id)] = block_id_type();
    }
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
@@ -122,35 +172,38 @@ bool block_database::contains( const block_id_type& id )const
    if( id == block_id_type() )
       return false;
 
-   index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_header::num_from_id(id));
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() < int64_t(index_pos + sizeof(e)) )
-      return false;
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-   return e.block_id == id && e.block_size.value() > 0;
+   boost::shared_lock<boost::shared_mutex> ids_guard( _block_ids_mutex );
+   const uint32_t block_num = block_header::num_from_id(id);
+   return block_num < _block_ids.size() && _block_ids[block_num] == id;
 }
 
 block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
-   index_entry e;
-   int64_t index_pos = sizeof(e) * int64_t(block_num);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   boost::shared_lock<boost::shared_mutex> ids_guard( _block_ids_mutex );
+   if ( block_num >= _block_ids.size() )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
+   FC_ASSERT( _block_ids[block_num] != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
+   return _block_ids[block_num];
+}
 
-   FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
-   return e.block_id;
+vector<block_id_type> block_database::fetch_block_ids( uint32_t first_block_num, uint32_t count )const
+{
+   vector<block_id_type> result;
+   boost::shared_lock<boost::shared_mutex> ids_guard( _block_ids_mutex );
+   if( first_block_num >= _block_ids.size() )
+      return result;
+   const size_t end = std::min<size_t>( _block_ids.size(), size_t( first_block_num ) + count );
+   result.reserve( end - first_block_num );
+   for( size_t block_num = first_block_num; block_num < end && _block_ids[block_num] != block_id_type(); ++block_num )
+      result.push_back( _block_ids[block_num] );
+   return result;
 }
 
 optional<signed_block> block_database::fetch_optional( const block_id_type& id )const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    try
    {
       index_entry e;
@@ -183,6 +236,7 @@ optional<signed_block> block_database::fetch_optional( const block_id_type& id )
 
 optional<signed_block> block_database::fetch_by_number( uint32_t block_num )const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    try
    {
       index_entry e;
@@ -210,6 +264,54 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
+vector<vector<char>> block_database::fetch_packed_range( uint32_t first_block_num, uint32_t count,
+                                                        size_t max_bytes )const
+{
+   vector<vector<char>> result;
+   if( count == 0 )
+      return result;
+   std::lock_guard<std::mutex> guard( _streams_mutex );
+   try
+   {
+      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
+      const int64_t index_size = _block_num_to_pos.tellg();
+      const int64_t first_index_pos = sizeof(index_entry) * int64_t(first_block_num);
+      if( index_size <= first_index_pos )
+         return result;
+
+      // read the index entries of the whole range at once, the blocks are stored one after the other too
+      const size_t entry_count = std::min<size_t>( count, ( index_size - first_index_pos ) / sizeof(index_entry) );
+      vector<index_entry> entries( entry_count );
+      _block_num_to_pos.seekg( first_index_pos, _block_num_to_pos.beg );
+      _block_num_to_pos.read( (char*)entries.data(), entries.size() * sizeof(index_entry) );
+
+      size_t total_bytes = 0;
+      for( const index_entry& e : entries )
+      {
+         const size_t block_size = e.block_size.value();
+         if( e.block_id == block_id_type() || block_size == 0 )
+            break;
+         if( !result.empty() && total_bytes + block_size > max_bytes )
+            break;
+         vector<char> data( block_size );
+         _blocks.seekg( e.block_pos.value() );
+         _blocks.read( data.data(), block_size );
+         total_bytes += block_size;
+         result.push_back( std::move( data ) );
+      }
+   }
+   catch (const fc::exception&)
+   {
+   }
+   catch (const std::exception&)
+   {
+   }
+   // clear the error flags of a short read, so that the next fetch works
+   _blocks.clear();
+   _block_num_to_pos.clear();
+   return result;
+}
+
 optional<index_entry> block_database::last_index_entry()const {
    try
    {
@@ -250,6 +352,7 @@ optional<index_entry> block_database::last_index_entry()const {
             {
             }
          fc::resize_file( _index_filename, pos );
+         truncate_block_ids( pos / sizeof(index_entry) );
       }
    }
    catch (const fc::exception&)
@@ -263,13 +366,18 @@ optional<index_entry> block_database::last_index_entry()const {
 
 optional<signed_block> block_database::last()const
 {
-   optional<index_entry> entry = last_index_entry();
+   optional<index_entry> entry;
+   {
+      std::lock_guard<std::mutex> guard( _streams_mutex );
+      entry = last_index_entry();
+   }
    if( entry.valid() ) return fetch_by_number( block_header::num_from_id(entry->block_id) );
    return optional<signed_block>();
 }
 
 optional<block_id_type> block_database::last_id()const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    optional<index_entry> entry = last_index_entry();
    if( entry.valid() ) return entry->block_id;
    return optional<block_id_type>();
@@ -277,11 +385,13 @@ optional<block_id_type> block_database::last_id()const
 
 size_t block_database::blocks_current_position()const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    return (size_t)_blocks.tellg();
 }
 
 size_t block_database::total_block_size()const
 {
+   std::lock_guard<std::mutex> guard( _streams_mutex );
    _blocks.seekg( 0, _blocks.end );
    return (size_t)_blocks.tellg();
 }
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/custom_authority_predicate_cache.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace chain {
+
+custom_authority_predicate_cache& custom_authority_predicate_cache::instance()
+{
+   static custom_authority_predicate_cache cache;
+   return cache;
+}
+
+std::shared_ptr<const restriction_program> custom_authority_predicate_cache::get(
+      const vector<restriction>& restrictions, unsigned_int operation_type )
+{
+   fc::sha256::encoder enc;
+   fc::raw::pack( enc, operation_type );
+   fc::raw::pack( enc, restrictions );
+   const fc::sha256 key = enc.result();
+
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto itr = _programs.find( key );
+      if( itr != _programs.end() )
+      {
+         auto program = itr->second.lock();
+         if( program )
+         {
+            ++_hits;
+            return program;
+         }
+      }
+   }
+
+   // Compile without holding the lock, if another thread compiles the same predicate meanwhile, the first one wins
+   ++_misses;
+   auto compiled = std::make_shared<const restriction_program>(
+                      compile_restriction_program( restrictions, operation_type ) );
+
+   std::lock_guard<std::mutex> lock( _mutex );
+   auto& entry = _programs[key];
+   auto program = entry.lock();
+   if( program )
+      return program;
+   entry = compiled;
+   if( _programs.size() >= _purge_size )
+      purge_expired();
+   return compiled;
+}
+
+void custom_authority_predicate_cache::purge_expired()
+{
+   for( auto itr = _programs.begin(); itr != _programs.end(); )
+   {
+      if( itr->second.expired() )
+         itr = _programs.erase( itr );
+      else
+         ++itr;
+   }
+   _purge_size = std::max<size_t>( 64, _programs.size() * 2 );
+}
+
+custom_authority_predicate_cache_stats custom_authority_predicate_cache::get_stats()const
+{
+   custom_authority_predicate_cache_stats stats;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      for( const auto& entry : _programs )
+         if( !entry.second.expired() )
+            ++stats.size;
+   }
+   stats.hits = _hits;
+   stats.misses = _misses;
+   return stats;
+}
+
+void custom_authority_predicate_cache::clear()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _programs.clear();
+   _purge_size = 64;
+   _hits = 0;
+   _misses = 0;
+}
+
+} } // graphene::chain
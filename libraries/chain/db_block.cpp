@@ -64,6 +64,25 @@ block_id_type  database::get_block_id_for_num( uint32_t block_num )const
    return _block_id_to_block.fetch_block_id( block_num );
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
+std::vector<block_id_type> database::get_block_ids_for_nums( uint32_t first_block_num, uint32_t count )const
+{ try {
+   // ids above the head block may be left over from a fork we switched away from
+   const uint32_t head_num = head_block_num();
+   if( first_block_num > head_num )
+      return {};
+   return _block_id_to_block.fetch_block_ids( first_block_num, std::min( count, head_num - first_block_num + 1 ) );
+} FC_CAPTURE_AND_RETHROW( (first_block_num)(count) ) }
+
+std::vector<std::vector<char>> database::get_packed_blocks( uint32_t first_block_num, uint32_t count,
+                                                           size_t max_bytes )const
+{ try {
+   const uint32_t head_num = head_block_num();
+   if( first_block_num == 0 || first_block_num > head_num )
+      return {};
+   return _block_id_to_block.fetch_packed_range( first_block_num, std::min( count, head_num - first_block_num + 1 ),
+                                                 max_bytes );
+} FC_CAPTURE_AND_RETHROW( (first_block_num)(count)(max_bytes) ) }
+
 optional<signed_block> database::fetch_block_by_id( const block_id_type& id )const
 {
    auto b = _fork_db.fetch_block( id );
@@ -116,6 +135,7 @@ std::vector<block_id_type> database::get_block_ids_on_fork(block_id_type head_of
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
 //   idump((new_block.block_num())(new_block.id())(new_block.timestamp)(new_block.previous));
+   detail::chain_state_write_guard write_guard( *this );
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -231,10 +251,10 @@ void database::verify_signing_witness( const signed_block& new_block, const fork
    FC_ASSERT( new_block.timestamp >= fork_entry.next_block_time );
    uint32_t slot_num = ( new_block.timestamp - fork_entry.next_block_time ).to_seconds() / block_interval();
    uint64_t index = ( fork_entry.next_block_aslot + slot_num ) % fork_entry.scheduled_witnesses->size();
-   const auto& scheduled_witness = (*fork_entry.scheduled_witnesses)[index];
-   FC_ASSERT( new_block.witness == scheduled_witness.first, "Witness produced block at wrong time",
+   const scheduled_witness_slot& scheduled_witness = (*fork_entry.scheduled_witnesses)[index];
+   FC_ASSERT( new_block.witness == scheduled_witness.witness, "Witness produced block at wrong time",
               ("block witness",new_block.witness)("scheduled",scheduled_witness)("slot_num",slot_num) );
-   FC_ASSERT( new_block.validate_signee( scheduled_witness.second ) );
+   FC_ASSERT( new_block.validate_signee( scheduled_witness.signing_key ) );
 }
 
 void database::update_witnesses( fork_item& fork_entry )const
@@ -245,14 +265,7 @@ void database::update_witnesses( fork_item& fork_entry )const
    fork_entry.next_block_aslot = dpo.current_aslot + 1;
    fork_entry.next_block_time = get_slot_time( 1 );
 
-   const witness_schedule_object& wso = get_witness_schedule_object();
-   fork_entry.scheduled_witnesses = std::make_shared< vector< pair< witness_id_type, public_key_type > > >();
-   fork_entry.scheduled_witnesses->reserve( wso.current_shuffled_witnesses.size() );
-   for( size_t i = 0; i < wso.current_shuffled_witnesses.size(); ++i )
-   {
-       const auto& witness = wso.current_shuffled_witnesses[i](*this);
-       fork_entry.scheduled_witnesses->emplace_back( wso.current_shuffled_witnesses[i], witness.signing_key );
-   }
+   fork_entry.scheduled_witnesses = get_witness_schedule();
 }
 
 /**
@@ -268,6 +281,7 @@ processed_transaction database::push_transaction( const precomputable_transactio
 { try {
    // see https://github.com/bitshares/bitshares-core/issues/1573
    FC_ASSERT( fc::raw::pack_size( trx ) < (1024 * 1024), "Transaction exceeds maximum transaction size." );
+   detail::chain_state_write_guard write_guard( *this );
    processed_transaction result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -303,6 +317,7 @@ processed_transaction database::_push_transaction( const precomputable_transacti
 
 processed_transaction database::validate_transaction( const signed_transaction& trx )
 {
+   detail::chain_state_write_guard write_guard( *this );
    auto session = _undo_db.start_undo_session();
    return _apply_transaction( trx );
 }
@@ -333,7 +348,7 @@ processed_transaction database::push_proposal(const proposal_object& proposal)
    eval_state.operation_results.reserve(proposal.proposed_transaction.operations.size());
    processed_transaction ptrx(proposal.proposed_transaction);
    eval_state._trx = &ptrx;
-   size_t old_applied_ops_size = _applied_ops.size();
+   size_t old_applied_ops_size = _applied_ops->size();
 
    try {
       push_proposal_nesting_guard guard( _push_proposal_nesting_depth, *this );
@@ -347,15 +362,15 @@ processed_transaction database::push_proposal(const proposal_object& proposal)
    } catch ( const fc::exception& e ) {
       if( head_block_time() <= HARDFORK_483_TIME )
       {
-         for( size_t i=old_applied_ops_size,n=_applied_ops.size(); i<n; i++ )
+         for( size_t i=old_applied_ops_size,n=_applied_ops->size(); i<n; i++ )
          {
-            ilog( "removing failed operation from applied_ops: ${op}", ("op", *(_applied_ops[i])) );
-            _applied_ops[i].reset();
+            ilog( "removing failed operation from applied_ops: ${op}", ("op", *((*_applied_ops)[i])) );
+            (*_applied_ops)[i].reset();
          }
       }
       else
       {
-         _applied_ops.resize( old_applied_ops_size );
+         _applied_ops->truncate( old_applied_ops_size );
       }
       wlog( "${e}", ("e",e.to_detail_string() ) );
       throw;
@@ -372,6 +387,7 @@ signed_block database::generate_block(
    uint32_t skip /* = 0 */
    )
 { try {
+   detail::chain_state_write_guard write_guard( *this );
    signed_block result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -503,6 +519,7 @@ signed_block database::_generate_block(
  */
 void database::pop_block()
 { try {
+   detail::chain_state_write_guard write_guard( *this );
    _pending_tx_session.reset();
    auto fork_db_head = _fork_db.head();
    FC_ASSERT( fork_db_head, "Trying to pop() from empty fork database!?" );
@@ -519,6 +536,7 @@ void database::pop_block()
 
 void database::clear_pending()
 { try {
+   detail::chain_state_write_guard write_guard( *this );
    assert( (_pending_tx.size() == 0) || _pending_tx_session.valid() );
    _pending_tx.clear();
    _pending_tx_session.reset();
@@ -526,28 +544,35 @@ void database::clear_pending()
 
 uint32_t database::push_applied_operation( const operation& op )
 {
-   _applied_ops.emplace_back(op);
-   operation_history_object& oh = *(_applied_ops.back());
+   return push_applied_operation( operation( op ) );
+}
+uint32_t database::push_applied_operation( operation&& op )
+{
+   operation_history_object& oh = _applied_ops->push_back( std::move( op ) );
    oh.block_num    = _current_block_num;
    oh.trx_in_block = _current_trx_in_block;
    oh.op_in_trx    = _current_op_in_trx;
    oh.virtual_op   = _current_virtual_op++;
-   return _applied_ops.size() - 1;
+   return _applied_ops->size() - 1;
 }
 void database::set_applied_operation_result( uint32_t op_id, const operation_result& result )
 {
-   assert( op_id < _applied_ops.size() );
-   if( _applied_ops[op_id] )
-      _applied_ops[op_id]->result = result;
+   assert( op_id < _applied_ops->size() );
+   auto& entry = (*_applied_ops)[op_id];
+   if( entry )
+      entry->result = result;
    else
    {
       elog( "Could not set operation result (head_block_num=${b})", ("b", head_block_num()) );
    }
 }
 
-const vector<optional< operation_history_object > >& database::get_applied_operations() const
+void database::clear_applied_operations()
 {
-   return _applied_ops;
+   if( _applied_ops.use_count() > 1 ) // an observer still holds the log of the last block
+      _applied_ops = std::make_shared<applied_operation_log>();
+   else
+      _applied_ops->clear();
 }
 
 //////////////////// private methods ////////////////////
@@ -576,7 +601,7 @@ void database::_apply_block( const signed_block& next_block )
 { try {
    uint32_t next_block_num = next_block.block_num();
    uint32_t skip = get_node_properties().skip_flags;
-   _applied_ops.clear();
+   clear_applied_operations();
 
    if( !(skip & skip_block_size_check) )
    {
@@ -590,6 +615,7 @@ void database::_apply_block( const signed_block& next_block )
               ("next_block",next_block)
               ("id",next_block.id()) );
 
+   apply_profiler::phase_scope phase( _apply_profiler.get(), apply_profiler::validate_header );
    const witness_object& signing_witness = validate_block_header(skip, next_block);
    const auto& global_props = get_global_properties();
    const auto& dynamic_global_props = get_dynamic_global_properties();
@@ -606,6 +632,7 @@ void database::_apply_block( const signed_block& next_block )
 
    _issue_453_affected_assets.clear();
 
+   phase.next( apply_profiler::transactions );
    for( const auto& trx : next_block.transactions )
    {
       /* We do not need to push the undo state for each transaction
@@ -621,6 +648,7 @@ void database::_apply_block( const signed_block& next_block )
    _current_op_in_trx    = 0;
    _current_virtual_op   = 0;
 
+   phase.next( apply_profiler::update_global_data );
    const uint32_t missed = update_witness_missed_blocks( next_block );
    update_global_dynamic_data( next_block, missed );
 
@@ -631,19 +659,30 @@ void database::_apply_block( const signed_block& next_block )
    update_signing_witness(signing_witness, next_block);
    update_last_irreversible_block();
 
+   phase.next( apply_profiler::process_tickets );
    process_tickets();
 
    // Are we at the maintenance interval?
    if( maint_needed )
+   {
+      phase.next( apply_profiler::maintenance );
       perform_chain_maintenance(next_block, global_props);
+   }
 
+   phase.next( apply_profiler::clear_expired_transactions );
    create_block_summary(next_block);
    clear_expired_transactions();
+   phase.next( apply_profiler::clear_expired_proposals );
    clear_expired_proposals();
+   phase.next( apply_profiler::clear_expired_orders );
    clear_expired_orders();
+   phase.next( apply_profiler::clear_expired_htlcs );
    clear_expired_htlcs();
+   phase.next( apply_profiler::update_expired_feeds );
    update_expired_feeds();       // this will update expired feeds and some core exchange rates
+   phase.next( apply_profiler::update_core_exchange_rates );
    update_core_exchange_rates(); // this will update remaining core exchange rates
+   phase.next( apply_profiler::update_withdraw_permissions );
    update_withdraw_permissions();
 
    // n.b., update_maintenance_flag() happens this late
@@ -651,15 +690,18 @@ void database::_apply_block( const signed_block& next_block )
    // TODO:  figure out if we could collapse this function into
    // update_global_dynamic_data() as perhaps these methods only need
    // to be called for header validation?
+   phase.next( apply_profiler::update_witness_schedule );
    update_maintenance_flag( maint_needed );
    update_witness_schedule();
    if( !_node_property_object.debug_updates.empty() )
       apply_debug_updates();
 
    // notify observers that the block has been applied
+   phase.next( apply_profiler::notify_applied_block );
    notify_applied_block( next_block ); //emit
-   _applied_ops.clear();
+   clear_applied_operations();
 
+   phase.next( apply_profiler::notify_changed_objects );
    notify_changed_objects();
 } FC_CAPTURE_AND_RETHROW( (next_block.block_num()) )  }
 
@@ -764,6 +806,7 @@ operation_result database::apply_operation(transaction_evaluation_state& eval_st
    FC_ASSERT( u_which < _operation_evaluators.size(), "No registered evaluator for operation ${op}", ("op",op) );
    unique_ptr<op_evaluator>& eval = _operation_evaluators[ u_which ];
    FC_ASSERT( eval, "No registered evaluator for operation ${op}", ("op",op) );
+   apply_profiler::operation_scope profile( _apply_profiler.get(), u_which );
    auto op_id = push_applied_operation( op );
    auto result = eval->evaluate( eval_state, op, true );
    set_applied_operation_result( op_id, result );
@@ -821,7 +864,7 @@ void database::_precompute_parallel( const Trx* trx, const size_t count, const u
 {
    for( size_t i = 0; i < count; ++i, ++trx )
    {
-      trx->validate(); // TODO - parallelize wrt confidential operations
+      trx->validate(); // skips the commitments verified by precompute_parallel
       if ( !(skip & skip_block_size_check) )
          trx->get_packed_size();
       if( !(skip&skip_transaction_dupe_check) )
@@ -840,6 +883,15 @@ fc::future<void> database::precompute_parallel( const signed_block& block, const
          _precompute_parallel( &block.transactions[0], block.transactions.size(), skip );
       else
       {
+         // The commitments of confidential transactions are much more expensive to verify than anything else,
+         // so verify them one transaction per task first to spread them evenly over the threads
+         std::vector<fc::future<void>> verifiers;
+         for( const auto& trx : block.transactions )
+            if( trx.has_commitments() )
+               verifiers.push_back( fc::do_parallel( [&trx] () { trx.verify_commitments(); } ) );
+         for( auto& verifier : verifiers )
+            verifier.wait();
+
          uint32_t chunks = fc::asio::default_io_service_scope::get_num_threads();
          uint32_t chunk_size = ( block.transactions.size() + chunks - 1 ) / chunks;
          workers.reserve( chunks + 1 );
@@ -875,4 +927,36 @@ fc::future<void> database::precompute_parallel( const precomputable_transaction&
    });
 }
 
+fc::future<void> database::precompute_parallel( const std::vector<precomputable_transaction>& trxs )const
+{ try {
+   if( trxs.empty() )
+      return fc::future< void >( fc::promise< void >::create( true ) );
+
+   const size_t chunks = fc::asio::default_io_service_scope::get_num_threads();
+   const size_t chunk_size = ( trxs.size() + chunks - 1 ) / chunks;
+   std::vector<fc::future<void>> workers;
+   workers.reserve( chunks );
+   for( size_t base = 0; base < trxs.size(); base += chunk_size )
+      workers.push_back( fc::do_parallel( [this,&trxs,base,chunk_size] () {
+         const size_t end = std::min( base + chunk_size, trxs.size() );
+         for( size_t i = base; i < end; ++i )
+         {
+            try
+            {
+               _precompute_parallel( &trxs[i], 1, skip_nothing );
+            }
+            catch( const fc::exception& )
+            {
+               // pushing the transaction will fail with the same error
+            }
+         }
+      }) );
+
+   auto first = workers.begin();
+   auto worker = first;
+   while( ++worker != workers.end() )
+      worker->wait();
+   return *first;
+} FC_LOG_AND_RETHROW() }
+
 } }
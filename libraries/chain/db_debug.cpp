@@ -23,6 +23,7 @@
  */
 
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/db_with.hpp>
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
@@ -197,6 +198,7 @@ void database::apply_debug_updates()
 
 void database::debug_update( const fc::variant_object& update )
 {
+   detail::chain_state_write_guard write_guard( *this );
    block_id_type head_id = head_block_id();
    auto it = _node_property_object.debug_updates.find( head_id );
    if( it == _node_property_object.debug_updates.end() )
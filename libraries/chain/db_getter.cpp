@@ -110,7 +110,7 @@ vector<authority> database::get_viable_custom_authorities(
    vector<authority> results;
    for (const auto& cust_auth : valid_auths) {
       try {
-         auto result = cust_auth.get().get_predicate()(op);
+         auto result = (*cust_auth.get().get_predicate())(op);
          if (result.success)
             results.emplace_back(cust_auth.get().auth);
          else if (rejected_authorities != nullptr)
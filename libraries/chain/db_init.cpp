@@ -141,6 +141,8 @@ void database::initialize_evaluators()
 void database::initialize_indexes()
 {
    reset_indexes();
+   _expiry_wheel.clear();
+   _witness_schedule_cache.clear();
    _undo_db.set_max_size( GRAPHENE_MIN_UNDO_HISTORY );
 
    //Protocol object indexes
@@ -149,22 +151,38 @@ void database::initialize_indexes()
 
    add_index< primary_index<account_index, 20> >(); // ~1 million accounts per chunk
    add_index< primary_index<committee_member_index, 8> >(); // 256 members per chunk
-   add_index< primary_index<witness_index, 10> >(); // 1024 witnesses per chunk
-   add_index< primary_index<limit_order_index > >();
+   auto witness_idx = add_index< primary_index<witness_index, 10> >(); // 1024 witnesses per chunk
+   witness_idx->add_secondary_index<witness_schedule_cache_index>( &_witness_schedule_cache );
+   auto limit_order_idx = add_index< primary_index<limit_order_index > >();
+   limit_order_idx->add_secondary_index< expiry_wheel_index<limit_order_object> >( &_expiry_wheel,
+         expiry_wheel::expiring_limit_order, []( const limit_order_object& o ) { return o.expiration; } );
    add_index< primary_index<call_order_index > >();
-   add_index< primary_index<proposal_index > >();
-   add_index< primary_index<withdraw_permission_index > >();
+   auto proposal_idx = add_index< primary_index<proposal_index > >();
+   proposal_idx->add_secondary_index< expiry_wheel_index<proposal_object> >( &_expiry_wheel,
+         expiry_wheel::expiring_proposal, []( const proposal_object& o ) { return o.expiration_time; } );
+   auto withdraw_permission_idx = add_index< primary_index<withdraw_permission_index > >();
+   withdraw_permission_idx->add_secondary_index< expiry_wheel_index<withdraw_permission_object> >( &_expiry_wheel,
+         expiry_wheel::expiring_withdraw_permission,
+         []( const withdraw_permission_object& o ) { return o.expiration; } );
    add_index< primary_index<vesting_balance_index> >();
    add_index< primary_index<worker_index> >();
    add_index< primary_index<balance_index> >();
    add_index< primary_index<blinded_balance_index> >();
-   add_index< primary_index< htlc_index> >();
+   auto htlc_idx = add_index< primary_index< htlc_index> >();
+   htlc_idx->add_secondary_index< expiry_wheel_index<htlc_object> >( &_expiry_wheel,
+         expiry_wheel::expiring_htlc, []( const htlc_object& o ) { return o.conditions.time_lock.expiration; } );
    add_index< primary_index< custom_authority_index> >();
-   add_index< primary_index<ticket_index> >();
+   auto ticket_idx = add_index< primary_index<ticket_index> >();
+   ticket_idx->add_secondary_index< expiry_wheel_index<ticket_object> >( &_expiry_wheel,
+         expiry_wheel::ticket_update, []( const ticket_object& o ) { return o.next_auto_update_time; } );
    add_index< primary_index<liquidity_pool_index> >();
 
    //Implementation object indexes
-   add_index< primary_index<transaction_index                             > >();
+   auto transaction_idx = add_index< primary_index<transaction_index                             > >();
+   // clear_expired_transactions() removes transactions once the head block time is past their expiration
+   transaction_idx->add_secondary_index< expiry_wheel_index<transaction_history_object> >( &_expiry_wheel,
+         expiry_wheel::expiring_transaction,
+         []( const transaction_history_object& o ) { return o.get_expiration() + 1; } );
 
    auto bal_idx = add_index< primary_index<account_balance_index          > >();
    bal_idx->add_secondary_index<balances_by_account_index>();
@@ -176,7 +194,8 @@ void database::initialize_indexes()
    add_index< primary_index<simple_index<asset_dynamic_data_object       >> >();
    add_index< primary_index<simple_index<block_summary_object            >> >();
    add_index< primary_index<simple_index<chain_property_object          > > >();
-   add_index< primary_index<simple_index<witness_schedule_object        > > >();
+   auto witness_schedule_idx = add_index< primary_index<simple_index<witness_schedule_object> > >();
+   witness_schedule_idx->add_secondary_index<witness_schedule_cache_index>( &_witness_schedule_cache );
    add_index< primary_index<simple_index<budget_record_object           > > >();
    add_index< primary_index< special_authority_index                      > >();
    add_index< primary_index< buyback_index                                > >();
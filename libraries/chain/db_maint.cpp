@@ -1487,6 +1487,11 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    if ( dgpo.next_maintenance_time <= HARDFORK_CORE_2262_TIME && next_maintenance_time > HARDFORK_CORE_2262_TIME )
       process_hf_2262(*this);
 
+   // Merge stable tickets and remove lock_forever tickets without value
+   if ( dgpo.next_maintenance_time <= HARDFORK_TICKET_COMPACTION_TIME
+        && next_maintenance_time > HARDFORK_TICKET_COMPACTION_TIME )
+      compact_tickets();
+
    modify(dgpo, [last_vote_tally_time, next_maintenance_time](dynamic_global_property_object& d) {
       d.next_maintenance_time = next_maintenance_time;
       d.last_vote_tally_time = last_vote_tally_time;
@@ -25,6 +25,7 @@
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/chain_property_object.hpp>
+#include <graphene/chain/custom_authority_object.hpp>
 #include <graphene/chain/witness_schedule_object.hpp>
 #include <graphene/chain/special_authority_object.hpp>
 #include <graphene/chain/operation_history_object.hpp>
@@ -32,6 +33,7 @@
 #include <graphene/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/thread/parallel.hpp>
 
 #include <fstream>
 #include <functional>
@@ -160,8 +162,18 @@ void database::reindex( fc::path data_dir )
    _undo_db.enable();
    auto end = fc::time_point::now();
    ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
+   if( _apply_profiler )
+      _apply_profiler->log_summary();
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
+void database::enable_apply_profiler( bool enable )
+{
+   if( !enable )
+      _apply_profiler.reset();
+   else if( !_apply_profiler )
+      _apply_profiler = std::make_unique<apply_profiler>( *this );
+}
+
 void database::wipe(const fc::path& data_dir, bool include_blocks)
 {
    ilog("Wiping database", ("include_blocks", include_blocks));
@@ -222,11 +234,45 @@ void database::open(
                     ("last_block->id", last_block)("head_block_id",head_block_num()) );
          reindex( data_dir );
       }
+      warm_custom_authority_predicates();
       _opened = true;
    }
    FC_CAPTURE_LOG_AND_RETHROW( (data_dir) )
 }
 
+void database::warm_custom_authority_predicates()const
+{ try {
+   const auto& idx = get_index_type<custom_authority_index>().indices().get<by_id>();
+   if( idx.empty() )
+      return;
+
+   const vector<std::reference_wrapper<const custom_authority_object>> auths( idx.begin(), idx.end() );
+   const size_t chunks = fc::asio::default_io_service_scope::get_num_threads();
+   const size_t chunk_size = ( auths.size() + chunks - 1 ) / chunks;
+   std::vector<fc::future<void>> workers;
+   workers.reserve( chunks );
+   for( size_t base = 0; base < auths.size(); base += chunk_size )
+      workers.push_back( fc::do_parallel( [&auths,base,chunk_size] () {
+         const size_t end = std::min( base + chunk_size, auths.size() );
+         for( size_t i = base; i < end; ++i )
+         {
+            try {
+               auths[i].get().get_predicate();
+            } catch( const fc::exception& e ) {
+               // Evaluation reports the error again, see get_viable_custom_authorities
+               wlog( "Unable to compile the predicate of custom authority ${id}: ${e}",
+                     ("id", auths[i].get().id)("e", e.to_detail_string()) );
+            }
+         }
+      }) );
+   for( auto& worker : workers )
+      worker.wait();
+
+   const auto stats = custom_authority_predicate_cache::instance().get_stats();
+   ilog( "Compiled the predicates of ${n} custom authorities, ${u} unique",
+         ("n", auths.size())("u", stats.size) );
+} FC_CAPTURE_AND_RETHROW() }
+
 void database::close(bool rewind)
 {
    if (!_opened)
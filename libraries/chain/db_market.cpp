@@ -185,7 +185,7 @@ void database::cancel_bid(const collateral_bid_object& bid, bool create_virtual_
       vop.bidder = bid.bidder;
       vop.additional_collateral = bid.inv_swan_price.base;
       vop.debt_covered = asset( 0, bid.inv_swan_price.quote.asset_id );
-      push_applied_operation( vop );
+      push_applied_operation( std::move( vop ) );
    }
    remove(bid);
 }
@@ -230,7 +230,7 @@ void database::cancel_settle_order(const force_settlement_object& order, bool cr
       vop.settlement = order.id;
       vop.account = order.owner;
       vop.amount = order.balance;
-      push_applied_operation( vop );
+      push_applied_operation( std::move( vop ) );
    }
    remove(order);
 }
@@ -326,7 +326,7 @@ void database::cancel_limit_order( const limit_order_object& order, bool create_
    }
 
    if( create_virtual_op )
-      push_applied_operation( vop );
+      push_applied_operation( std::move( vop ) );
 
    remove(order);
 }
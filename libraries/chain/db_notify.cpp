@@ -315,6 +315,14 @@ struct get_impacted_account_visitor
    {
       _impacted.insert( op.fee_payer() ); // account
    }
+   void operator()( const ticket_merge_operation& op )
+   {
+      _impacted.insert( op.fee_payer() ); // account
+   }
+   void operator()( const ticket_prune_operation& op )
+   {
+      _impacted.insert( op.fee_payer() ); // account
+   }
    void operator()( const liquidity_pool_create_operation& op )
    {
       _impacted.insert( op.fee_payer() ); // account
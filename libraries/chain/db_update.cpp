@@ -38,6 +38,8 @@
 
 #include <graphene/protocol/fee_schedule.hpp>
 
+#include <array>
+
 namespace graphene { namespace chain {
 
 void database::update_global_dynamic_data( const signed_block& b, const uint32_t missed_blocks )
@@ -144,6 +146,8 @@ void database::clear_expired_transactions()
 { try {
    //Look for expired transactions in the deduplication list, and remove them.
    //Transactions must have expired by at least two forking windows in order to be removed.
+   if( !_expiry_wheel.has_due( expiry_wheel::expiring_transaction, head_block_time() ) )
+      return;
    auto& transaction_idx = static_cast<transaction_index&>(get_mutable_index(implementation_ids,
                                                                              impl_transaction_history_object_type));
    const auto& dedupe_index = transaction_idx.indices().get<by_expiration>();
@@ -153,6 +157,8 @@ void database::clear_expired_transactions()
 
 void database::clear_expired_proposals()
 {
+   if( !_expiry_wheel.has_due( expiry_wheel::expiring_proposal, head_block_time() ) )
+      return;
    const auto& proposal_expiration_index = get_index_type<proposal_index>().indices().get<by_expiration>();
    while( !proposal_expiration_index.empty() && proposal_expiration_index.begin()->expiration_time <= head_block_time() )
    {
@@ -281,8 +287,9 @@ void database::clear_expired_orders()
          bool before_core_hardfork_342 = ( maint_time <= HARDFORK_CORE_342_TIME ); // better rounding
          bool before_core_hardfork_606 = ( maint_time <= HARDFORK_CORE_606_TIME ); // feed always trigger call
 
+         const bool limit_orders_due = _expiry_wheel.has_due( expiry_wheel::expiring_limit_order, head_time );
          auto& limit_index = get_index_type<limit_order_index>().indices().get<by_expiration>();
-         while( !limit_index.empty() && limit_index.begin()->expiration <= head_time )
+         while( limit_orders_due && !limit_index.empty() && limit_index.begin()->expiration <= head_time )
          {
             const limit_order_object& order = *limit_index.begin();
             auto base_asset = order.sell_price.base.asset_id;
@@ -580,6 +587,8 @@ void database::update_maintenance_flag( bool new_maintenance_flag )
 
 void database::update_withdraw_permissions()
 {
+   if( !_expiry_wheel.has_due( expiry_wheel::expiring_withdraw_permission, head_block_time() ) )
+      return;
    auto& permit_index = get_index_type<withdraw_permission_index>().indices().get<by_expiration>();
    while( !permit_index.empty() && permit_index.begin()->expiration <= head_block_time() )
       remove(*permit_index.begin());
@@ -587,6 +596,8 @@ void database::update_withdraw_permissions()
 
 void database::clear_expired_htlcs()
 {
+   if( !_expiry_wheel.has_due( expiry_wheel::expiring_htlc, head_block_time() ) )
+      return;
    const auto& htlc_idx = get_index_type<htlc_index>().indices().get<by_expiration>();
    while ( htlc_idx.begin() != htlc_idx.end()
          && htlc_idx.begin()->conditions.time_lock.expiration <= head_block_time() )
@@ -597,15 +608,18 @@ void database::clear_expired_htlcs()
       // notify related parties
       htlc_refund_operation vop( obj.id, obj.transfer.from, obj.transfer.to, amount,
          obj.conditions.hash_lock.preimage_hash, obj.conditions.hash_lock.preimage_size );
-      push_applied_operation( vop );
+      push_applied_operation( std::move( vop ) );
       remove( obj );
    }
 }
 
 generic_operation_result database::process_tickets()
 {
+   if( !_expiry_wheel.has_due( expiry_wheel::ticket_update, head_block_time() ) )
+      return generic_operation_result();
    const auto maint_time = get_dynamic_global_properties().next_maintenance_time;
    ticket_version version = ( HARDFORK_CORE_2262_PASSED(maint_time) ? ticket_v2 : ticket_v1 );
+   const bool compact = HARDFORK_TICKET_COMPACTION_PASSED(maint_time);
 
    generic_operation_result result;
    share_type total_delta_pob;
@@ -678,12 +692,29 @@ generic_operation_result database::process_tickets()
             aso.total_pol_value += delta_other_value;
          });
 
+         if( compact && ticket.status == stable )
+         {
+            const ticket_id_type ticket_id = ticket.id;
+            if( ticket.current_type == lock_forever ) // it lost all the value
+            {
+               prune_ticket( ticket );
+               result.updated_objects.erase( ticket_id );
+               result.removed_objects.insert( ticket_id );
+            }
+            else
+            {
+               const ticket_object* into_ticket = merge_stable_ticket( ticket );
+               if( into_ticket != nullptr )
+               {
+                  result.updated_objects.erase( ticket_id );
+                  result.removed_objects.insert( ticket_id );
+                  result.updated_objects.insert( into_ticket->id );
+               }
+            }
+         }
       }
-      // TODO if a lock_forever ticket lost all the value, remove it
    }
 
-   // TODO merge stable tickets with the same account and the same type
-
    // Update global data
    if( total_delta_pob != 0 || total_delta_inactive != 0 )
    {
@@ -697,4 +728,65 @@ generic_operation_result database::process_tickets()
    return result;
 }
 
+void database::merge_ticket( const ticket_object& ticket, const ticket_object& into_ticket )
+{
+   push_applied_operation( ticket_merge_operation( ticket.account, ticket.id, into_ticket.id, ticket.amount ) );
+   // The value of a stable ticket is proportional to its amount, so the statistics of the account do not change
+   modify( into_ticket, [&ticket]( ticket_object& o ) {
+      o.amount += ticket.amount;
+      o.value += ticket.value;
+   });
+   remove( ticket );
+}
+
+const ticket_object* database::merge_stable_ticket( const ticket_object& ticket )
+{
+   auto range = get_index_type<ticket_index>().indices().get<by_account>().equal_range( ticket.account );
+   for( auto itr = range.first; itr != range.second; ++itr )
+   {
+      if( itr->id != ticket.id && itr->status == stable && itr->current_type == ticket.current_type )
+      {
+         const ticket_object& into_ticket = *itr;
+         merge_ticket( ticket, into_ticket );
+         return &into_ticket;
+      }
+   }
+   return nullptr;
+}
+
+void database::prune_ticket( const ticket_object& ticket )
+{
+   push_applied_operation( ticket_prune_operation( ticket.account, ticket.id, ticket.amount ) );
+   // The amount stays in the inactive totals of the account and of the chain, which keep it voting as a PoB
+   // participant, and in the supply.  It is kept in total_pruned_inactive instead of the ticket
+   modify( get_dynamic_global_properties(), [&ticket]( dynamic_global_property_object& dgp ) {
+      dgp.total_pruned_inactive += ticket.amount.amount;
+   });
+   remove( ticket );
+}
+
+void database::compact_tickets()
+{
+   const auto& idx = get_index_type<ticket_index>().indices().get<by_account>();
+   auto itr = idx.begin();
+   while( itr != idx.end() )
+   {
+      const account_id_type account = itr->account;
+      std::array<const ticket_object*, TICKET_TYPE_COUNT> into_tickets {};
+      while( itr != idx.end() && itr->account == account )
+      {
+         const ticket_object& ticket = *itr;
+         ++itr; // the ticket may be removed below
+         if( ticket.status != stable )
+            continue;
+         if( ticket.current_type == lock_forever ) // a stable lock_forever ticket has no value
+            prune_ticket( ticket );
+         else if( into_tickets[ticket.current_type] == nullptr )
+            into_tickets[ticket.current_type] = &ticket;
+         else
+            merge_ticket( ticket, *into_tickets[ticket.current_type] );
+      }
+   }
+}
+
 } }
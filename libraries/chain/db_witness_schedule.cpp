@@ -34,11 +34,31 @@ namespace graphene { namespace chain {
 using boost::container::flat_set;
 
 witness_id_type database::get_scheduled_witness( uint32_t slot_num )const
+{
+   return get_scheduled_witness_slot( slot_num ).witness;
+}
+
+scheduled_witness_slot database::get_scheduled_witness_slot( uint32_t slot_num )const
 {
    const dynamic_global_property_object& dpo = get_dynamic_global_properties();
-   const witness_schedule_object& wso = get_witness_schedule_object();
+   const witness_schedule_ptr schedule = get_witness_schedule();
    uint64_t current_aslot = dpo.current_aslot + slot_num;
-   return wso.current_shuffled_witnesses[ current_aslot % wso.current_shuffled_witnesses.size() ];
+   return (*schedule)[ current_aslot % schedule->size() ];
+}
+
+witness_schedule_ptr database::get_witness_schedule()const
+{
+   witness_schedule_ptr schedule = _witness_schedule_cache.get();
+   if( schedule )
+      return schedule;
+
+   const witness_schedule_object& wso = get_witness_schedule_object();
+   auto new_schedule = std::make_shared<witness_schedule>();
+   new_schedule->reserve( wso.current_shuffled_witnesses.size() );
+   for( const witness_id_type& w : wso.current_shuffled_witnesses )
+      new_schedule->push_back( { w, w(*this).signing_key } );
+   _witness_schedule_cache.set( new_schedule );
+   return new_schedule;
 }
 
 fc::time_point_sec database::get_slot_time(uint32_t slot_num)const
@@ -84,8 +104,8 @@ uint32_t database::update_witness_missed_blocks( const signed_block& b )
    uint32_t missed_blocks = get_slot_at_time( b.timestamp );
    FC_ASSERT( missed_blocks != 0, "Trying to push double-produced block onto current block?!" );
    missed_blocks--;
-   const auto& witnesses = witness_schedule_id_type()(*this).current_shuffled_witnesses;
-   if( missed_blocks < witnesses.size() )
+   const witness_schedule_ptr witnesses = get_witness_schedule();
+   if( missed_blocks < witnesses->size() )
       for( uint32_t i = 0; i < missed_blocks; ++i ) {
          const auto& witness_missed = get_scheduled_witness( i+1 )(*this);
          modify( witness_missed, []( witness_object& w ) {
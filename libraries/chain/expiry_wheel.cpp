@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/expiry_wheel.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace graphene { namespace chain {
+
+void expiry_wheel::schedule( expiry_kind kind, object_id_type id, time_point_sec deadline )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( deadline == time_point_sec::maximum() ) // never expires
+   {
+      remove( id );
+      return;
+   }
+
+   auto itr = _entries.find( id );
+   if( itr == _entries.end() )
+      itr = _entries.emplace( id, entry() ).first;
+   else if( itr->second.deadline == deadline.sec_since_epoch() && itr->second.kind == kind )
+      return; // unchanged
+   else if( itr->second.due )
+      --_due_count[itr->second.kind];
+   itr->second.deadline = deadline.sec_since_epoch();
+   itr->second.kind = kind;
+   itr->second.due = false;
+   place( id, itr->second );
+}
+
+void expiry_wheel::cancel( object_id_type id )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   remove( id );
+}
+
+void expiry_wheel::remove( object_id_type id )
+{
+   auto itr = _entries.find( id );
+   if( itr == _entries.end() )
+      return;
+   if( itr->second.due )
+      --_due_count[itr->second.kind];
+   // slot entries of removed objects are dropped when their slot is processed
+   _entries.erase( itr );
+}
+
+bool expiry_wheel::has_due( expiry_kind kind, time_point_sec now )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   advance( now.sec_since_epoch() );
+   return _due_count[kind] > 0;
+}
+
+size_t expiry_wheel::size()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _entries.size();
+}
+
+size_t expiry_wheel::due_count( expiry_kind kind )const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _due_count[kind];
+}
+
+void expiry_wheel::clear()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _cursor = 0;
+   _entries.clear();
+   for( auto& slot : _near )
+      slot.clear();
+   _far.clear();
+   _due_count.fill( 0 );
+}
+
+void expiry_wheel::place( object_id_type id, entry& e )
+{
+   if( e.deadline <= _cursor )
+   {
+      e.due = true;
+      ++_due_count[e.kind];
+   }
+   else if( e.deadline - _cursor < near_slots )
+      _near[ e.deadline & ( near_slots - 1 ) ].emplace_back( id, e.deadline );
+   else
+      _far[ e.deadline >> near_bits ].emplace_back( id, e.deadline );
+}
+
+void expiry_wheel::replace( std::vector<slot_entry>& entries )
+{
+   for( const auto& item : entries )
+   {
+      auto itr = _entries.find( item.first );
+      if( itr != _entries.end() && !itr->second.due && itr->second.deadline == item.second )
+         place( item.first, itr->second );
+   }
+}
+
+void expiry_wheel::advance( uint32_t now )
+{
+   if( now <= _cursor )
+      return;
+
+   // Process the near slots up to now, or all of them if the wheel turns at least once
+   const uint32_t old_cursor = _cursor;
+   const uint32_t steps = std::min<uint32_t>( now - old_cursor, near_slots );
+   _cursor = now;
+   for( uint32_t i = 1; i <= steps; ++i )
+   {
+      auto& slot = _near[ ( old_cursor + i ) & ( near_slots - 1 ) ];
+      if( slot.empty() )
+         continue;
+      std::vector<slot_entry> entries;
+      entries.swap( slot );
+      replace( entries );
+   }
+
+   // Bring the far buckets which overlap the range of the near slots into range
+   const uint32_t near_end = ( now > std::numeric_limits<uint32_t>::max() - near_slots )
+                             ? std::numeric_limits<uint32_t>::max() : now + near_slots;
+   std::vector<slot_entry> later; // still out of range, their bucket comes into range at a later advance
+   while( !_far.empty() && ( _far.begin()->first << near_bits ) < near_end )
+   {
+      std::vector<slot_entry> entries;
+      entries.swap( _far.begin()->second );
+      _far.erase( _far.begin() );
+      for( const auto& item : entries )
+      {
+         auto itr = _entries.find( item.first );
+         if( itr == _entries.end() || itr->second.due || itr->second.deadline != item.second )
+            continue;
+         if( item.second >= near_end )
+            later.push_back( item );
+         else
+            place( item.first, itr->second );
+      }
+   }
+   for( const auto& item : later )
+      _far[ item.second >> near_bits ].push_back( item );
+}
+
+} } // graphene::chain
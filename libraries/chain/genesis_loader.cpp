@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/genesis_loader.hpp>
+
+#include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+
+#include <cctype>
+#include <fstream>
+
+namespace graphene { namespace chain { namespace detail {
+
+   /// Header of a binary genesis file, followed by the packed genesis state
+   struct binary_genesis_header
+   {
+      static constexpr uint32_t expected_magic = 0x4e454754; // "TGEN"
+      static constexpr uint32_t current_version = 1;
+
+      uint32_t      magic = expected_magic;
+      uint32_t      version = current_version;
+      chain_id_type chain_id;
+      fc::sha256    digest; ///< of the packed genesis state
+   };
+
+} } } // graphene::chain::detail
+
+FC_REFLECT( graphene::chain::detail::binary_genesis_header, (magic)(version)(chain_id)(digest) )
+
+namespace graphene { namespace chain {
+
+namespace detail {
+
+   /// Walks the top-level object of a JSON document, locating values without converting them
+   class json_scanner
+   {
+      public:
+         explicit json_scanner( const std::string& json ) : _json( json ) {}
+
+         void skip_whitespace()
+         {
+            while( _pos < _json.size() && std::isspace( static_cast<unsigned char>( _json[_pos] ) ) )
+               ++_pos;
+         }
+
+         /// Consumes @p c after optional whitespace if it is the next character
+         bool try_consume( char c )
+         {
+            skip_whitespace();
+            if( _pos < _json.size() && _json[_pos] == c )
+            {
+               ++_pos;
+               return true;
+            }
+            return false;
+         }
+
+         void expect( char c )
+         {
+            FC_ASSERT( try_consume( c ), "Invalid genesis JSON: expected '${c}' at offset ${p}",
+                       ("c", std::string( 1, c ))("p", _pos) );
+         }
+
+         /// Skips the next value and returns its text
+         std::string next_value()
+         {
+            skip_whitespace();
+            const size_t begin = _pos;
+            FC_ASSERT( _pos < _json.size(), "Invalid genesis JSON: unexpected end of input" );
+            const char first = _json[_pos];
+            if( first == '"' )
+               skip_string();
+            else if( first == '{' || first == '[' )
+            {
+               uint32_t depth = 0;
+               do
+               {
+                  const char c = _json[_pos];
+                  if( c == '"' )
+                     skip_string();
+                  else
+                  {
+                     if( c == '{' || c == '[' )
+                        ++depth;
+                     else if( c == '}' || c == ']' )
+                        --depth;
+                     ++_pos;
+                  }
+               } while( depth > 0 && _pos < _json.size() );
+               FC_ASSERT( depth == 0, "Invalid genesis JSON: unterminated value at offset ${p}", ("p", begin) );
+            }
+            else
+            {
+               while( _pos < _json.size() && _json[_pos] != ',' && _json[_pos] != '}' && _json[_pos] != ']'
+                      && _json[_pos] != ':' && !std::isspace( static_cast<unsigned char>( _json[_pos] ) ) )
+                  ++_pos;
+            }
+            FC_ASSERT( _pos > begin, "Invalid genesis JSON: expected a value at offset ${p}", ("p", begin) );
+            return _json.substr( begin, _pos - begin );
+         }
+
+         /// Calls @p f with the text of each element of the array which comes next
+         template<typename Lambda>
+         void for_each_element( Lambda&& f )
+         {
+            expect( '[' );
+            if( try_consume( ']' ) )
+               return;
+            do
+            {
+               f( next_value() );
+            } while( try_consume( ',' ) );
+            expect( ']' );
+         }
+
+         bool at_end()
+         {
+            skip_whitespace();
+            return _pos >= _json.size();
+         }
+
+      private:
+         void skip_string()
+         {
+            ++_pos; // opening quote
+            while( _pos < _json.size() && _json[_pos] != '"' )
+               _pos += ( _json[_pos] == '\\' ? 2 : 1 );
+            FC_ASSERT( _pos < _json.size(), "Invalid genesis JSON: unterminated string" );
+            ++_pos; // closing quote
+         }
+
+         const std::string& _json;
+         size_t             _pos = 0;
+   };
+
+} // detail
+
+genesis_state_type parse_genesis_json( const std::string& json, uint32_t max_depth )
+{ try {
+   genesis_state_type lists;
+   std::string others = "{";
+
+   const auto read_list = [max_depth]( detail::json_scanner& scanner, auto& list ) {
+      using element_type = typename std::decay_t<decltype(list)>::value_type;
+      scanner.for_each_element( [&list,max_depth]( const std::string& element ) {
+         list.push_back( fc::json::from_string( element ).as<element_type>( max_depth ) );
+      });
+   };
+
+   detail::json_scanner scanner( json );
+   scanner.expect( '{' );
+   if( !scanner.try_consume( '}' ) )
+   {
+      do
+      {
+         const std::string key = fc::json::from_string( scanner.next_value() ).as_string();
+         scanner.expect( ':' );
+         if( key == "initial_accounts" )
+            read_list( scanner, lists.initial_accounts );
+         else if( key == "initial_assets" )
+            read_list( scanner, lists.initial_assets );
+         else if( key == "initial_balances" )
+            read_list( scanner, lists.initial_balances );
+         else if( key == "initial_vesting_balances" )
+            read_list( scanner, lists.initial_vesting_balances );
+         else if( key == "initial_witness_candidates" )
+            read_list( scanner, lists.initial_witness_candidates );
+         else if( key == "initial_committee_candidates" )
+            read_list( scanner, lists.initial_committee_candidates );
+         else if( key == "initial_worker_candidates" )
+            read_list( scanner, lists.initial_worker_candidates );
+         else
+         {
+            if( others.size() > 1 )
+               others += ',';
+            others += fc::json::to_string( key );
+            others += ':';
+            others += scanner.next_value();
+         }
+      } while( scanner.try_consume( ',' ) );
+      scanner.expect( '}' );
+   }
+   FC_ASSERT( scanner.at_end(), "Invalid genesis JSON: unexpected data after the top-level object" );
+   others += '}';
+
+   genesis_state_type genesis = fc::json::from_string( others ).as<genesis_state_type>( max_depth );
+   genesis.initial_accounts = std::move( lists.initial_accounts );
+   genesis.initial_assets = std::move( lists.initial_assets );
+   genesis.initial_balances = std::move( lists.initial_balances );
+   genesis.initial_vesting_balances = std::move( lists.initial_vesting_balances );
+   genesis.initial_witness_candidates = std::move( lists.initial_witness_candidates );
+   genesis.initial_committee_candidates = std::move( lists.initial_committee_candidates );
+   genesis.initial_worker_candidates = std::move( lists.initial_worker_candidates );
+   return genesis;
+} FC_CAPTURE_AND_RETHROW() }
+
+void write_binary_genesis( const fc::path& file, const genesis_state_type& genesis )
+{ try {
+   const std::vector<char> packed = fc::raw::pack( genesis );
+   detail::binary_genesis_header header;
+   header.chain_id = genesis.initial_chain_id;
+   header.digest = fc::sha256::hash( packed.data(), packed.size() );
+
+   const std::vector<char> packed_header = fc::raw::pack( header );
+   std::ofstream out( file.generic_string(), std::ios::binary | std::ios::trunc );
+   FC_ASSERT( out.good(), "Unable to open ${f} for writing", ("f", file) );
+   out.write( packed_header.data(), packed_header.size() );
+   out.write( packed.data(), packed.size() );
+   out.close();
+   FC_ASSERT( !out.fail(), "Unable to write ${f}", ("f", file) );
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+genesis_state_type read_binary_genesis( const fc::path& file )
+{ try {
+   std::string contents;
+   fc::read_file_contents( file, contents );
+
+   fc::datastream<const char*> ds( contents.data(), contents.size() );
+   detail::binary_genesis_header header;
+   fc::raw::unpack( ds, header );
+   FC_ASSERT( header.magic == detail::binary_genesis_header::expected_magic, "Not a binary genesis file" );
+   FC_ASSERT( header.version == detail::binary_genesis_header::current_version,
+              "Unsupported binary genesis version ${v}", ("v", header.version) );
+
+   const char* const packed = contents.data() + ds.tellp();
+   const size_t packed_size = ds.remaining();
+   FC_ASSERT( fc::sha256::hash( packed, packed_size ) == header.digest, "The binary genesis file is corrupted" );
+
+   genesis_state_type genesis;
+   fc::datastream<const char*> genesis_ds( packed, packed_size );
+   fc::raw::unpack( genesis_ds, genesis );
+   FC_ASSERT( genesis.initial_chain_id == header.chain_id,
+              "The chain ID of the binary genesis state does not match the one it was written with" );
+   return genesis;
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
+} } // graphene::chain
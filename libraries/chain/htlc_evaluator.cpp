@@ -159,7 +159,7 @@ namespace graphene {
          htlc_redeemed_operation virt_op( htlc_obj->id, htlc_obj->transfer.from, htlc_obj->transfer.to, o.redeemer,
                amount, htlc_obj->conditions.hash_lock.preimage_hash, htlc_obj->conditions.hash_lock.preimage_size,
                o.preimage );
-         db().push_applied_operation( virt_op );
+         db().push_applied_operation( std::move( virt_op ) );
          db().remove(*htlc_obj);
          return void_result();
       }
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/operation_history_object.hpp>
+
+#include <array>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief The operations applied since the last block started, in the order they were applied
+    *
+    * The log is append-only while a block is applied and is read by the observers of the block. Entries are
+    * stored in chunks of @ref chunk_size which are never moved, so references to entries stay valid while the
+    * log grows, and an operation is not copied again once it is in the log. Cleared entries keep their chunks,
+    * so the log of the next block normally does not allocate memory for the entries themselves.
+    *
+    * An entry is null if the operation was part of a failed proposal before HARDFORK_483_TIME.
+    */
+   class applied_operation_log
+   {
+      public:
+         using entry_type = optional<operation_history_object>;
+
+         static constexpr size_t chunk_bits = 8;
+         static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+
+         class const_iterator
+         {
+            public:
+               using iterator_category = std::forward_iterator_tag;
+               using value_type        = entry_type;
+               using difference_type   = std::ptrdiff_t;
+               using pointer           = const entry_type*;
+               using reference         = const entry_type&;
+
+               const_iterator( const applied_operation_log& log, size_t index ) : _log( &log ), _index( index ) {}
+
+               reference operator*()const { return (*_log)[_index]; }
+               pointer operator->()const { return &(*_log)[_index]; }
+               const_iterator& operator++() { ++_index; return *this; }
+               const_iterator operator++(int) { const_iterator tmp( *this ); ++_index; return tmp; }
+               bool operator==( const const_iterator& o )const { return _index == o._index; }
+               bool operator!=( const const_iterator& o )const { return _index != o._index; }
+
+            private:
+               const applied_operation_log* _log;
+               size_t                       _index;
+         };
+
+         size_t size()const { return _size; }
+         bool empty()const { return _size == 0; }
+         /// Number of entries the log can hold without allocating a new chunk
+         size_t capacity()const { return _chunks.size() * chunk_size; }
+
+         const entry_type& operator[]( size_t index )const
+         {
+            return (*_chunks[ index >> chunk_bits ])[ index & ( chunk_size - 1 ) ];
+         }
+         entry_type& operator[]( size_t index )
+         {
+            return (*_chunks[ index >> chunk_bits ])[ index & ( chunk_size - 1 ) ];
+         }
+
+         const_iterator begin()const { return const_iterator( *this, 0 ); }
+         const_iterator end()const { return const_iterator( *this, _size ); }
+
+         /// Appends @p op and returns its entry
+         operation_history_object& push_back( const operation& op );
+         operation_history_object& push_back( operation&& op );
+
+         /// Removes the entries from index @p new_size on
+         void truncate( size_t new_size );
+         void clear() { truncate( 0 ); }
+
+      private:
+         using chunk_type = std::array<entry_type, chunk_size>;
+
+         entry_type& next_entry();
+
+         std::vector<std::unique_ptr<chunk_type>> _chunks;
+         size_t                                   _size = 0;
+   };
+
+} } // graphene::chain
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/db/object_database.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <array>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /// Accumulated cost of one operation type or block phase
+   struct apply_profile_entry
+   {
+      uint64_t count      = 0;
+      uint64_t total_us   = 0;
+      uint64_t max_us     = 0;
+      uint64_t creates    = 0; ///< number of objects created
+      uint64_t modifies   = 0; ///< number of objects modified
+      uint64_t removes    = 0; ///< number of objects removed
+      uint64_t undo_bytes = 0; ///< size of the object copies saved for undo
+   };
+
+   /// A copy of the data collected by an @ref apply_profiler
+   struct apply_profile
+   {
+      uint64_t                                   blocks = 0;
+      std::map<std::string, apply_profile_entry> operations; ///< keyed by operation name, e.g. "limit_order_create"
+      std::map<std::string, apply_profile_entry> phases;     ///< keyed by block phase name, e.g. "clear_expired_orders"
+   };
+
+   /**
+    * @brief Aggregates the cost of applying blocks per operation type and per block phase
+    *
+    * Operations are measured in database::apply_operation, phases in database::_apply_block. The figures are
+    * inclusive, e.g. the operations executed by a proposal are counted in proposal_update too, and all operations
+    * of a block are counted in the transactions phase.
+    *
+    * The profiler is only used by the thread which applies blocks and is not thread safe.
+    */
+   class apply_profiler
+   {
+      public:
+         enum block_phase
+         {
+            validate_header,
+            transactions,
+            update_global_data, ///< missed blocks, dynamic global properties, inflation, signing witness and LIB
+            process_tickets,
+            maintenance,
+            clear_expired_transactions,
+            clear_expired_proposals,
+            clear_expired_orders,
+            clear_expired_htlcs,
+            update_expired_feeds,
+            update_core_exchange_rates,
+            update_withdraw_permissions,
+            update_witness_schedule,
+            notify_applied_block,
+            notify_changed_objects,
+            BLOCK_PHASE_COUNT
+         };
+
+         /// State of the clock and of the change counters of the database at some point
+         struct snapshot
+         {
+            fc::time_point time;
+            uint64_t       creates    = 0;
+            uint64_t       modifies   = 0;
+            uint64_t       removes    = 0;
+            uint64_t       undo_bytes = 0;
+         };
+
+         /// Measures one block phase after another, does nothing if there is no profiler
+         class phase_scope
+         {
+            public:
+               phase_scope( apply_profiler* profiler, block_phase phase );
+               ~phase_scope();
+
+               /// Ends the current phase and starts @p phase
+               void next( block_phase phase );
+
+            private:
+               apply_profiler* const _profiler;
+               block_phase           _phase;
+               snapshot              _start;
+         };
+
+         /// Measures the application of one operation, does nothing if there is no profiler
+         class operation_scope
+         {
+            public:
+               operation_scope( apply_profiler* profiler, size_t operation_type );
+               ~operation_scope();
+
+            private:
+               apply_profiler* const _profiler;
+               const size_t          _operation_type;
+               snapshot              _start;
+         };
+
+         explicit apply_profiler( const db::object_database& db );
+
+         apply_profile get_profile()const;
+         void reset();
+
+         /// Logs the collected data, most expensive entries first
+         void log_summary()const;
+
+      private:
+         snapshot take_snapshot()const;
+         static void add( apply_profile_entry& entry, const snapshot& start, const snapshot& end );
+
+         const db::object_database&                         _db;
+         std::array<apply_profile_entry, BLOCK_PHASE_COUNT> _phases;
+         std::vector<apply_profile_entry>                   _operations; ///< indexed by operation type
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::apply_profile_entry,
+            (count)(total_us)(max_us)(creates)(modifies)(removes)(undo_bytes) )
+FC_REFLECT( graphene::chain::apply_profile, (blocks)(operations)(phases) )
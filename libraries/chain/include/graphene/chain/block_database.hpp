@@ -23,10 +23,13 @@
  */
 #pragma once
 #include <fstream>
+#include <mutex>
 #include <graphene/protocol/block.hpp>
 
 #include <fc/filesystem.hpp>
 
+#include <boost/thread/shared_mutex.hpp>
+
 namespace graphene { namespace chain {
    struct index_entry;
    using namespace graphene::protocol;
@@ -44,16 +47,33 @@ namespace graphene { namespace chain {
 
          bool                   contains( const block_id_type& id )const;
          block_id_type          fetch_block_id( uint32_t block_num )const;
+         /// Returns the ids of up to @p count stored blocks starting at @p first_block_num, stops at the first gap
+         vector<block_id_type>  fetch_block_ids( uint32_t first_block_num, uint32_t count )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /**
+          * Returns the blocks @p first_block_num, @p first_block_num + 1, ... as they are stored (packed), without
+          * unpacking them.  Stops after @p count blocks, at the first gap, or before the total size exceeds
+          * @p max_bytes, but always returns the first block if it is stored.
+          */
+         vector<vector<char>>   fetch_packed_range( uint32_t first_block_num, uint32_t count, size_t max_bytes )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
          size_t                 blocks_current_position()const;
          size_t                 total_block_size()const;
       private:
          optional<index_entry> last_index_entry()const;
+         void load_block_ids();
+         void truncate_block_ids( size_t size )const;
          fc::path _index_filename;
          mutable std::fstream _blocks;
          mutable std::fstream _block_num_to_pos;
+         /// Serializes access to the stream positions, blocks may be fetched from API worker threads
+         mutable std::mutex _streams_mutex;
+
+         /// In-memory copy of the block ids in the index, by block number, zero where no block is stored.
+         /// Id lookups are served from here so that they neither touch the disk nor wait for block reads.
+         mutable std::vector<block_id_type> _block_ids;
+         mutable boost::shared_mutex        _block_ids_mutex;
    };
 } }
@@ -25,6 +25,7 @@
 #include <graphene/protocol/authority.hpp>
 #include <graphene/protocol/custom_authority.hpp>
 #include <graphene/protocol/restriction_predicate.hpp>
+#include <graphene/chain/custom_authority_predicate_cache.hpp>
 #include <graphene/db/generic_index.hpp>
 #include <graphene/chain/types.hpp>
 #include <boost/multi_index/composite_key.hpp>
@@ -37,9 +38,11 @@ namespace graphene { namespace chain {
     *
     */
    class custom_authority_object : public abstract_object<custom_authority_object> {
-      /// Unreflected field to store a cache of the predicate function
-      /// Note that this cache can be modified when the object is const!
-      mutable optional<restriction_predicate_function> predicate_cache;
+      /// Unreflected field to store a reference to the compiled predicate, shared through the
+      /// @ref custom_authority_predicate_cache
+      /// Note that this cache can be modified when the object is const! It is accessed atomically, because
+      /// read-only API calls may evaluate the predicate of the same object concurrently.
+      mutable std::shared_ptr<const restriction_program> predicate_cache;
 
    public:
       static constexpr uint8_t space_id = protocol_ids;
@@ -65,18 +68,21 @@ namespace graphene { namespace chain {
          return rs;
       }
       /// Get predicate, from cache if possible, and update cache if not (modifies const object!)
-      restriction_predicate_function get_predicate() const {
-         if (!predicate_cache.valid())
-            update_predicate_cache();
+      std::shared_ptr<const restriction_program> get_predicate() const {
+         auto predicate = std::atomic_load(&predicate_cache);
+         if (!predicate)
+            predicate = update_predicate_cache();
 
-         return *predicate_cache;
+         return predicate;
       }
-      /// Regenerate predicate function and update predicate cache
-      void update_predicate_cache() const {
-         predicate_cache = get_restriction_predicate(get_restrictions(), operation_type);
+      /// Look up or compile the predicate and update predicate cache
+      std::shared_ptr<const restriction_program> update_predicate_cache() const {
+         auto predicate = custom_authority_predicate_cache::instance().get(get_restrictions(), operation_type);
+         std::atomic_store(&predicate_cache, predicate);
+         return predicate;
       }
       /// Clear the cache of the predicate function
-      void clear_predicate_cache() { predicate_cache.reset(); }
+      void clear_predicate_cache() { std::atomic_store(&predicate_cache, {}); }
    };
 
    struct by_account_custom;
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/protocol/restriction.hpp>
+#include <graphene/protocol/restriction_predicate.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace graphene { namespace chain {
+
+   /// Counters of a @ref custom_authority_predicate_cache
+   struct custom_authority_predicate_cache_stats
+   {
+      uint64_t size   = 0; ///< number of compiled predicates which are still in use
+      uint64_t hits   = 0;
+      uint64_t misses = 0;
+   };
+
+   /**
+    * @brief Process-wide cache of compiled custom authority predicates
+    *
+    * Predicates are keyed by the operation type and a hash of the restrictions, so all custom authorities with
+    * identical restrictions share a single compiled @ref restriction_program, and a custom authority object which
+    * was copied into undo state, reloaded from disk or modified without changing its restrictions does not have to
+    * compile its predicate again.
+    *
+    * The cache only keeps weak references, a predicate is released when the last custom authority object using it
+    * drops it. The cache is thread safe.
+    */
+   class custom_authority_predicate_cache
+   {
+      public:
+         static custom_authority_predicate_cache& instance();
+
+         /// Returns the compiled predicate for @p restrictions, compiling it if it is not cached yet
+         std::shared_ptr<const restriction_program> get( const vector<restriction>& restrictions,
+                                                         unsigned_int operation_type );
+
+         custom_authority_predicate_cache_stats get_stats()const;
+
+         /// Drops all entries and resets the counters
+         void clear();
+
+      private:
+         /// Drops the entries of released predicates, must be called with the mutex locked
+         void purge_expired();
+
+         mutable std::mutex                                                       _mutex;
+         std::unordered_map<fc::sha256, std::weak_ptr<const restriction_program>> _programs;
+         size_t                                                                   _purge_size = 64;
+         std::atomic<uint64_t>                                                    _hits { 0 };
+         std::atomic<uint64_t>                                                    _misses { 0 };
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::custom_authority_predicate_cache_stats, (size)(hits)(misses) )
@@ -32,6 +32,10 @@
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/genesis_state.hpp>
+#include <graphene/chain/apply_profiler.hpp>
+#include <graphene/chain/applied_operation_log.hpp>
+#include <graphene/chain/expiry_wheel.hpp>
+#include <graphene/chain/witness_schedule_cache.hpp>
 #include <graphene/chain/evaluator.hpp>
 
 #include <graphene/db/object_database.hpp>
@@ -41,6 +45,8 @@
 
 #include <fc/log/logger.hpp>
 
+#include <boost/thread/shared_mutex.hpp>
+
 #include <map>
 
 namespace graphene { namespace protocol { struct predicate_result; } }
@@ -59,10 +65,13 @@ namespace graphene { namespace chain {
    class limit_order_object;
    class collateral_bid_object;
    class call_order_object;
+   class ticket_object;
 
    struct budget_record;
    enum class vesting_balance_type;
 
+   namespace detail { struct chain_state_write_guard; }
+
    /**
     *   @class database
     *   @brief tracks the blockchain state in an extensible manner
@@ -135,8 +144,14 @@ namespace graphene { namespace chain {
          bool                       is_known_block( const block_id_type& id )const;
          bool                       is_known_transaction( const transaction_id_type& id )const;
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
+         /// Returns the ids of up to @p count blocks of the current chain, starting at @p first_block_num
+         std::vector<block_id_type> get_block_ids_for_nums( uint32_t first_block_num, uint32_t count )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /// Returns up to @p count packed blocks of the current chain starting at @p first_block_num, at most
+         /// @p max_bytes in total but at least one block
+         std::vector<std::vector<char>> get_packed_blocks( uint32_t first_block_num, uint32_t count,
+                                                           size_t max_bytes )const;
          const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -183,8 +198,16 @@ namespace graphene { namespace chain {
           *  @return the op_id which can be used to set the result after it has finished being applied.
           */
          uint32_t  push_applied_operation( const operation& op );
+         /// Same as above, moving @p op into the log, e.g. for virtual operations built in place
+         uint32_t  push_applied_operation( operation&& op );
          void      set_applied_operation_result( uint32_t op_id, const operation_result& r );
-         const vector<optional< operation_history_object > >& get_applied_operations()const;
+         const applied_operation_log& get_applied_operations()const { return *_applied_ops; }
+         /**
+          *  Returns a handle to the applied operations which stays valid and unchanged after the block,
+          *  for observers which process them later, e.g. asynchronously. The next block starts a new log
+          *  instead of reusing this one while a handle is held.
+          */
+         std::shared_ptr<const applied_operation_log> share_applied_operations()const { return _applied_ops; }
 
          string to_pretty_string( const asset& a )const;
 
@@ -239,6 +262,12 @@ namespace graphene { namespace chain {
           */
          witness_id_type get_scheduled_witness(uint32_t slot_num)const;
 
+         /// Same as @ref get_scheduled_witness, also returning the signing key of the witness
+         scheduled_witness_slot get_scheduled_witness_slot(uint32_t slot_num)const;
+
+         /// Returns the witness schedule of the current round with the signing keys, shared until it changes
+         witness_schedule_ptr get_witness_schedule()const;
+
          /**
           * Get the time at which the given slot occurs.
           *
@@ -522,6 +551,14 @@ namespace graphene { namespace chain {
          /// Enable or disable tracking of votes of standby witnesses and committee members
          inline void enable_standby_votes_tracking(bool enable)  { _track_standby_votes = enable; }
 
+         /// Enable or disable the block apply profiler, disabling it discards the collected data
+         void enable_apply_profiler( bool enable );
+         /// Returns the block apply profiler, or null if it is disabled
+         apply_profiler* get_apply_profiler()const { return _apply_profiler.get(); }
+
+         /// Returns the deadlines of the objects which are processed when they expire
+         const expiry_wheel& get_expiry_wheel()const { return _expiry_wheel; }
+
          /** Precomputes digests, signatures and operation validations depending
           *  on skip flags. "Expensive" computations may be done in a parallel
           *  thread.
@@ -541,10 +578,33 @@ namespace graphene { namespace chain {
           *         precomputations applied
           */
          fc::future<void> precompute_parallel( const precomputable_transaction& trx )const;
+
+         /** Precomputes digests, signatures and operation validations of a batch of transactions in parallel
+          *  threads. Unlike for a block, a failure of one transaction does not stop the precomputation of the
+          *  others, the failure will be reported again when the transaction is pushed.
+          *
+          * @param trxs the transactions to preprocess
+          * @return a future that will resolve when all transactions have been processed
+          */
+         fc::future<void> precompute_parallel( const std::vector<precomputable_transaction>& trxs )const;
+
+         /**
+          * @brief Readers-writer lock which protects the object graph against concurrent API readers
+          *
+          * API worker threads hold it shared while serving read-only calls. The methods which modify chain
+          * state (push_block, push_transaction, generate_block, pop_block, clear_pending, validate_transaction
+          * and debug_update) hold it exclusively for their whole duration, so readers only ever observe the
+          * state published by a completed call of one of them. See @ref detail::chain_state_write_guard.
+          */
+         boost::shared_mutex& chain_state_mutex()const { return _chain_state_mutex; }
    private:
          template<typename Trx>
          void _precompute_parallel( const Trx* trx, const size_t count, const uint32_t skip )const;
 
+         /// Compiles the predicates of all custom authorities in parallel, see
+         /// @ref custom_authority_predicate_cache
+         void warm_custom_authority_predicates()const;
+
    protected:
          //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
          void pop_undo() { object_database::pop_undo(); }
@@ -589,6 +649,15 @@ namespace graphene { namespace chain {
       public:
          generic_operation_result process_tickets();
       private:
+         /// Merges @p ticket into @p into_ticket, both must be stable and of the same account and type
+         void merge_ticket( const ticket_object& ticket, const ticket_object& into_ticket );
+         /// Merges a stable ticket into another stable ticket of the same account and type if there is one,
+         /// returns the ticket it was merged into or null
+         const ticket_object* merge_stable_ticket( const ticket_object& ticket );
+         /// Removes a lock_forever ticket without value and burns its amount
+         void prune_ticket( const ticket_object& ticket );
+         /// Merges and prunes the tickets of all accounts, a one-time process at the ticket compaction hardfork
+         void compact_tickets();
          void update_global_dynamic_data( const signed_block& b, const uint32_t missed_blocks );
          void update_signing_witness(const witness_object& signing_witness, const signed_block& new_block);
          void update_last_irreversible_block();
@@ -644,7 +713,9 @@ namespace graphene { namespace chain {
           * order they occur and is cleared after the applied_block signal is
           * emited.
           */
-         vector<optional<operation_history_object> >  _applied_ops;
+         std::shared_ptr<applied_operation_log>  _applied_ops = std::make_shared<applied_operation_log>();
+         /// Empties the applied operations, keeping the memory of the log unless it is shared
+         void clear_applied_operations();
 
          uint32_t                          _current_block_num    = 0;
          uint16_t                          _current_trx_in_block = 0;
@@ -665,6 +736,15 @@ namespace graphene { namespace chain {
          /// Set it to true to provide accurate data to API clients, set to false to have better performance.
          bool                              _track_standby_votes = true;
 
+         /// Collects the cost of applying blocks if enabled, see @ref enable_apply_profiler
+         std::unique_ptr<apply_profiler>   _apply_profiler;
+
+         /// Tells the per-block sweeps whether anything has expired, fed by secondary indexes
+         expiry_wheel                      _expiry_wheel;
+
+         /// The schedule of the current round, rebuilt on demand after secondary indexes drop it
+         mutable witness_schedule_cache    _witness_schedule_cache;
+
          /**
           * Whether database is successfully opened or not.
           *
@@ -677,6 +757,12 @@ namespace graphene { namespace chain {
          // Counts nested proposal updates
          uint32_t                           _push_proposal_nesting_depth = 0;
 
+         /// Guards the object graph against API worker threads, see @ref chain_state_mutex
+         mutable boost::shared_mutex        _chain_state_mutex;
+         /// Counts nested chain_state_write_guard instances, only accessed from the thread which applies blocks
+         uint32_t                           _chain_state_write_depth = 0;
+         friend struct detail::chain_state_write_guard;
+
          /// Tracks assets affected by bitshares-core issue #453 before hard fork #615 in one block
          flat_set<asset_id_type>           _issue_453_affected_assets;
 
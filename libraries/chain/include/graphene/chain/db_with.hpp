@@ -104,6 +104,36 @@ struct pending_transactions_restorer
    std::vector< processed_transaction > _pending_transactions;
 };
 
+/**
+ * Holds the chain state mutex of the database exclusively while the object
+ * graph is being modified.
+ *
+ * Nested guards on the same thread are no-ops, so a public method which modifies
+ * the database may freely call other such methods (e.g. push_block calling
+ * pop_block when switching forks).  Releasing the outermost guard is the point
+ * at which the new state becomes visible to API worker threads.
+ */
+struct chain_state_write_guard
+{
+   explicit chain_state_write_guard( database& db )
+      : _db( db )
+   {
+      if( _db._chain_state_write_depth++ == 0 )
+         _db._chain_state_mutex.lock();
+   }
+
+   ~chain_state_write_guard()
+   {
+      if( --_db._chain_state_write_depth == 0 )
+         _db._chain_state_mutex.unlock();
+   }
+
+   chain_state_write_guard( const chain_state_write_guard& ) = delete;
+   chain_state_write_guard& operator=( const chain_state_write_guard& ) = delete;
+
+   database& _db;
+};
+
 /**
  * Set the skip_flags to the given value, call callback,
  * then reset skip_flags to their previous value after
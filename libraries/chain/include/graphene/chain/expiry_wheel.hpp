@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/types.hpp>
+#include <graphene/db/index.hpp>
+
+#include <array>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Tracks the deadlines of the objects which the chain processes when they expire
+    *
+    * Deadlines within the next @ref near_slots seconds are kept in a wheel of one-second slots, later deadlines
+    * wait in coarse buckets of @ref near_slots seconds until they come into range. Advancing the wheel moves the
+    * entries whose deadline has passed to the due set, so whether anything of a kind has expired is known without
+    * probing the ordered expiration indexes of the objects.
+    *
+    * The wheel is fed by @ref expiry_wheel_index secondary indexes, so it follows object creation, modification,
+    * removal, undo and loading from disk. It only tells whether a sweep has to run. The sweeps still walk their
+    * ordered indexes, which define the order of processing.
+    *
+    * An entry stays due until its object is removed or gets a later deadline. The wheel does not move back when
+    * blocks are popped, so an entry may be due too early afterwards, which only costs a sweep which finds nothing.
+    *
+    * Objects are loaded from disk in parallel, so the wheel is thread safe.
+    */
+   class expiry_wheel
+   {
+      public:
+         enum expiry_kind : uint8_t
+         {
+            expiring_transaction,         ///< transaction_history_object, for deduplication
+            expiring_proposal,
+            expiring_limit_order,
+            expiring_htlc,
+            expiring_withdraw_permission,
+            ticket_update,
+            EXPIRY_KIND_COUNT
+         };
+
+         static constexpr uint32_t near_bits  = 12;
+         static constexpr uint32_t near_slots = 1 << near_bits; ///< about 68 minutes
+
+         /// Sets the deadline of object @p id, replacing its previous deadline if any
+         void schedule( expiry_kind kind, object_id_type id, time_point_sec deadline );
+         void cancel( object_id_type id );
+
+         /// Advances the wheel to @p now and returns whether there are entries of @p kind whose deadline has passed
+         bool has_due( expiry_kind kind, time_point_sec now );
+
+         size_t size()const;
+         size_t due_count( expiry_kind kind )const;
+         void clear();
+
+      private:
+         struct entry
+         {
+            uint32_t    deadline = 0;
+            expiry_kind kind = EXPIRY_KIND_COUNT;
+            bool        due = false;
+         };
+         /// Object ID and deadline, stale if the deadline of the entry has changed meanwhile
+         using slot_entry = std::pair<object_id_type, uint32_t>;
+
+         void advance( uint32_t now );
+         void remove( object_id_type id );
+         void place( object_id_type id, entry& e );
+         /// Places the entries of a slot again, dropping the stale ones
+         void replace( std::vector<slot_entry>& entries );
+
+         mutable std::mutex                                 _mutex;
+         uint32_t                                           _cursor = 0; ///< entries up to this time are due
+         std::unordered_map<object_id_type, entry>          _entries;
+         std::vector<std::vector<slot_entry>>               _near { near_slots };
+         std::map<uint32_t, std::vector<slot_entry>>        _far; ///< keyed by deadline >> near_bits
+         std::array<size_t, EXPIRY_KIND_COUNT>              _due_count {};
+   };
+
+   /**
+    * @brief Registers the deadlines of the objects of one index with an @ref expiry_wheel
+    */
+   template<typename ObjectType>
+   class expiry_wheel_index : public secondary_index
+   {
+      public:
+         using deadline_getter = time_point_sec (*)( const ObjectType& );
+
+         expiry_wheel_index( expiry_wheel* wheel, expiry_wheel::expiry_kind kind, deadline_getter get_deadline )
+            : _wheel( *wheel ), _kind( kind ), _get_deadline( get_deadline ) {}
+
+         virtual void object_inserted( const object& obj ) override { schedule( obj ); }
+         virtual void object_removed( const object& obj ) override { _wheel.cancel( obj.id ); }
+         virtual void object_modified( const object& after ) override { schedule( after ); }
+
+      private:
+         void schedule( const object& obj )
+         {
+            _wheel.schedule( _kind, obj.id, _get_deadline( static_cast<const ObjectType&>( obj ) ) );
+         }
+
+         expiry_wheel&                   _wheel;
+         const expiry_wheel::expiry_kind _kind;
+         const deadline_getter           _get_deadline;
+   };
+
+} } // graphene::chain
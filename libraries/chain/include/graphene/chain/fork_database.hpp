@@ -26,6 +26,7 @@
 #include <graphene/protocol/block.hpp>
 
 #include <graphene/chain/types.hpp>
+#include <graphene/chain/witness_schedule_cache.hpp>
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
@@ -49,10 +50,11 @@ namespace graphene { namespace chain {
       block_id_type         id;
       signed_block          data;
 
-      // contains witness block signing keys scheduled *after* the block has been applied
-      shared_ptr< vector< pair< witness_id_type, public_key_type > > > scheduled_witnesses;
-      uint64_t                                                         next_block_aslot = 0;
-      fc::time_point_sec                                               next_block_time;
+      // contains witness block signing keys scheduled *after* the block has been applied,
+      // shared with the other blocks of the same round
+      witness_schedule_ptr  scheduled_witnesses;
+      uint64_t              next_block_aslot = 0;
+      fc::time_point_sec    next_block_time;
    };
    typedef shared_ptr<fork_item> item_ptr;
 
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/genesis_state.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <string>
+
+namespace graphene { namespace chain {
+
+   /**
+    * @brief Parses a genesis state from JSON without building a variant tree of the whole document
+    *
+    * The members of the top-level object are located by a lightweight scanner. The elements of the lists of
+    * accounts, assets, balances, vesting balances, witnesses, committee members and workers are converted one at
+    * a time, so the memory needed on top of the text is about the size of the resulting genesis state. The other
+    * members are small and converted together.
+    *
+    * The chain ID is not set, the caller computes it from the text.
+    *
+    * @param json the text of a genesis JSON file
+    * @param max_depth the maximum nesting depth of the elements
+    */
+   genesis_state_type parse_genesis_json( const std::string& json, uint32_t max_depth = 20 );
+
+   /**
+    * @brief Writes a genesis state in binary form, including its chain ID
+    *
+    * A binary genesis file loads much faster than JSON. @ref read_binary_genesis checks its integrity and that the
+    * chain ID is the one it was written with, so a node started from the binary file joins the same chain as a node
+    * started from the JSON file the chain ID was computed from.
+    */
+   void write_binary_genesis( const fc::path& file, const genesis_state_type& genesis );
+
+   /// Reads a genesis state written by @ref write_binary_genesis
+   genesis_state_type read_binary_genesis( const fc::path& file );
+
+} } // graphene::chain
@@ -77,6 +77,8 @@ namespace graphene { namespace chain {
          share_type        witness_budget;
          share_type        total_pob;
          share_type        total_inactive;
+         /// The part of @ref total_inactive whose lock_forever tickets were removed because they had no value
+         share_type        total_pruned_inactive;
          uint32_t          accounts_registered_this_interval = 0;
          /**
           *  Every time a block is missed this increases by
@@ -54,6 +54,7 @@ struct hardfork_visitor {
                                         liquidity_pool_deposit_operation,
                                         liquidity_pool_withdraw_operation,
                                         liquidity_pool_exchange_operation >;
+   using ticket_compaction_ops = TL::list< ticket_merge_operation, ticket_prune_operation >;
    fc::time_point_sec now;
 
    hardfork_visitor(fc::time_point_sec now) : now(now) {}
@@ -72,6 +73,9 @@ struct hardfork_visitor {
    template<typename Op>
    std::enable_if_t<TL::contains<liquidity_pool_ops, Op>(), bool>
    visit() { return HARDFORK_LIQUIDITY_POOL_PASSED(now); }
+   template<typename Op>
+   std::enable_if_t<TL::contains<ticket_compaction_ops, Op>(), bool>
+   visit() { return HARDFORK_TICKET_COMPACTION_PASSED(now); }
    /// @}
 
    /// typelist::runtime::dispatch adaptor
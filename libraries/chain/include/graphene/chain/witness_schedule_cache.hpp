@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/chain/types.hpp>
+#include <graphene/db/index.hpp>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+   /// A slot of a witness schedule round
+   struct scheduled_witness_slot
+   {
+      witness_id_type witness;
+      public_key_type signing_key;
+   };
+
+   /// The witnesses of one round in the order they are scheduled, with their signing keys
+   using witness_schedule = std::vector<scheduled_witness_slot>;
+   using witness_schedule_ptr = std::shared_ptr<const witness_schedule>;
+
+   /**
+    * @brief Caches the witness schedule of the current round with the signing keys of the witnesses
+    *
+    * The schedule is built from @ref witness_schedule_object once per round and shared, e.g. with the fork
+    * database, instead of being looked up object by object for every slot. @ref witness_schedule_cache_index
+    * secondary indexes drop it when the schedule or the signing key of a scheduled witness changes, including
+    * by undo and when loading from disk.
+    *
+    * Objects are loaded from disk in parallel, and API threads may rebuild the schedule concurrently,
+    * so the cache is thread safe.
+    */
+   class witness_schedule_cache
+   {
+      public:
+         /// Returns the cached schedule, or null if it has to be rebuilt
+         witness_schedule_ptr get()const
+         {
+            std::lock_guard<std::mutex> guard( _mutex );
+            return _schedule;
+         }
+
+         void set( witness_schedule_ptr schedule )
+         {
+            std::lock_guard<std::mutex> guard( _mutex );
+            _schedule = std::move( schedule );
+         }
+
+         void clear() { set( witness_schedule_ptr() ); }
+
+         /// Drops the cached schedule if @p witness is scheduled in it with another signing key
+         void signing_key_changed( witness_id_type witness, const public_key_type& signing_key );
+
+      private:
+         mutable std::mutex   _mutex;
+         witness_schedule_ptr _schedule;
+   };
+
+   /**
+    * @brief Keeps a @ref witness_schedule_cache in sync with the witness and the witness schedule objects
+    */
+   class witness_schedule_cache_index : public secondary_index
+   {
+      public:
+         explicit witness_schedule_cache_index( witness_schedule_cache* cache ) : _cache( *cache ) {}
+
+         virtual void object_inserted( const object& obj ) override { changed( obj ); }
+         virtual void object_removed( const object& obj ) override { changed( obj ); }
+         virtual void object_modified( const object& after ) override { changed( after ); }
+
+      private:
+         void changed( const object& obj );
+
+         witness_schedule_cache& _cache;
+   };
+
+} } // graphene::chain
+
+FC_REFLECT( graphene::chain::scheduled_witness_slot, (witness)(signing_key) )
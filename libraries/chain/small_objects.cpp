@@ -109,6 +109,7 @@ FC_REFLECT_DERIVED_NO_TYPENAME( graphene::chain::dynamic_global_property_object,
                     (witness_budget)
                     (total_pob)
                     (total_inactive)
+                    (total_pruned_inactive)
                     (accounts_registered_this_interval)
                     (recently_missed_count)
                     (current_aslot)
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/chain/witness_schedule_cache.hpp>
+#include <graphene/chain/witness_object.hpp>
+
+namespace graphene { namespace chain {
+
+void witness_schedule_cache::signing_key_changed( witness_id_type witness, const public_key_type& signing_key )
+{
+   std::lock_guard<std::mutex> guard( _mutex );
+   if( !_schedule )
+      return;
+   for( const scheduled_witness_slot& slot : *_schedule )
+   {
+      if( slot.witness == witness && slot.signing_key != signing_key )
+      {
+         _schedule.reset();
+         return;
+      }
+   }
+}
+
+void witness_schedule_cache_index::changed( const object& obj )
+{
+   // witness objects are modified by every block they produce, only a new signing key matters
+   if( obj.id.is<witness_id_type>() )
+   {
+      const witness_object& witness = static_cast<const witness_object&>( obj );
+      _cache.signing_key_changed( witness.id, witness.signing_key );
+   }
+   else
+      _cache.clear();
+}
+
+} } // graphene::chain
@@ -73,6 +73,8 @@ namespace graphene { namespace db {
          virtual void               move_from( object& obj ) = 0;
          virtual variant            to_variant()const  = 0;
          virtual vector<char>       pack()const = 0;
+         /// Size of the object itself, not counting memory allocated by its members
+         virtual size_t             object_size()const = 0;
    };
 
    /**
@@ -97,6 +99,7 @@ namespace graphene { namespace db {
          }
          virtual variant to_variant()const { return variant( static_cast<const DerivedClass&>(*this), MAX_NESTING ); }
          virtual vector<char> pack()const  { return fc::raw::pack( static_cast<const DerivedClass&>(*this) ); }
+         virtual size_t  object_size()const { return sizeof( DerivedClass ); }
    };
 
    typedef flat_map<uint8_t, object_id_type> annotation_map;
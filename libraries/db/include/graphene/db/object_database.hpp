@@ -39,6 +39,14 @@ namespace graphene { namespace db {
    class object_database
    {
       public:
+         /// Numbers of object changes since the database was opened
+         struct change_counters
+         {
+            uint64_t creates  = 0;
+            uint64_t modifies = 0;
+            uint64_t removes  = 0;
+         };
+
          object_database();
          ~object_database();
 
@@ -153,6 +161,8 @@ namespace graphene { namespace db {
 
          fc::path get_data_dir()const { return _data_dir; }
 
+         const change_counters& get_change_counters()const { return _change_counters; }
+
          /** public for testing purposes only... should be private in practice. */
          undo_database                          _undo_db;
      protected:
@@ -176,6 +186,7 @@ namespace graphene { namespace db {
 
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+         change_counters                                           _change_counters;
    };
 
 } } // graphene::db
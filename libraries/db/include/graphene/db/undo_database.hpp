@@ -120,6 +120,8 @@ namespace graphene { namespace db {
          void set_max_size(size_t new_max_size) { _max_size = new_max_size; }
          size_t max_size()const { return _max_size; }
          uint32_t active_sessions()const { return _active_sessions; }
+         /// Total size of the object copies saved for undo since the database was opened, see @ref object::object_size
+         uint64_t saved_bytes()const { return _saved_bytes; }
 
          const undo_state& head()const;
 
@@ -133,6 +135,7 @@ namespace graphene { namespace db {
          std::deque<undo_state>  _stack;
          object_database&        _db;
          size_t                  _max_size = 256;
+         uint64_t                _saved_bytes = 0;
    };
 
 } } // graphene::db
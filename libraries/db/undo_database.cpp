@@ -82,6 +82,7 @@ void undo_database::on_modify( const object& obj )
    auto itr =  state.old_values.find(obj.id);
    if( itr != state.old_values.end() ) return;
    state.old_values[obj.id] = obj.clone();
+   _saved_bytes += obj.object_size();
 }
 void undo_database::on_remove( const object& obj )
 {
@@ -103,6 +104,7 @@ void undo_database::on_remove( const object& obj )
    }
    if( state.removed.count(obj.id) > 0 ) return;
    state.removed[obj.id] = obj.clone();
+   _saved_bytes += obj.object_size();
 }
 
 void undo_database::undo()
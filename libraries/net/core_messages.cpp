@@ -25,6 +25,13 @@
 
 #include <fc/io/raw.hpp>
 
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <algorithm>
+
 namespace graphene { namespace net {
 
   const core_message_type_enum trx_message::type                             = core_message_type_enum::trx_message_type;
@@ -46,6 +53,97 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum fetch_block_range_message::type               = core_message_type_enum::fetch_block_range_message_type;
+  const core_message_type_enum block_range_message::type                     = core_message_type_enum::block_range_message_type;
+
+  block_range_message::block_range_message(uint32_t first_block_num, const std::vector<std::vector<char>>& blocks,
+                                           block_range_codec codec) :
+    first_block_num(first_block_num),
+    block_count(blocks.size()),
+    codec(codec)
+  {
+    size_t total_size = 0;
+    for( const std::vector<char>& block : blocks )
+      total_size += block.size();
+
+    if( codec == block_range_codec::uncompressed )
+    {
+      packed_blocks.reserve( total_size );
+      for( const std::vector<char>& block : blocks )
+        packed_blocks.insert( packed_blocks.end(), block.begin(), block.end() );
+      return;
+    }
+
+    FC_ASSERT( codec == block_range_codec::zlib, "Unsupported block range codec ${c}", ("c", codec) );
+    packed_blocks.reserve( total_size / 2 );
+    {
+      boost::iostreams::filtering_ostream out;
+      out.push( boost::iostreams::zlib_compressor( boost::iostreams::zlib::best_speed ) );
+      out.push( boost::iostreams::back_inserter( packed_blocks ) );
+      for( const std::vector<char>& block : blocks )
+        out.write( block.data(), block.size() );
+    } // destroying the stream flushes the compressor
+  }
+
+  std::vector<signed_block> block_range_message::get_blocks()const
+  {
+    std::vector<char> decompressed;
+    const std::vector<char>* data = &packed_blocks;
+    if( codec == block_range_codec::zlib )
+    {
+      try
+      {
+        boost::iostreams::filtering_istream in;
+        in.push( boost::iostreams::zlib_decompressor() );
+        in.push( boost::iostreams::array_source( packed_blocks.data(), packed_blocks.size() ) );
+        char buffer[4096];
+        while( in.read( buffer, sizeof(buffer) ), in.gcount() > 0 )
+        {
+          decompressed.insert( decompressed.end(), buffer, buffer + in.gcount() );
+          // the decompressed blocks have to fit in a message, don't let a peer inflate more than that
+          FC_ASSERT( decompressed.size() <= MAX_MESSAGE_SIZE, "Block range decompresses to more than ${max} bytes",
+                     ("max", MAX_MESSAGE_SIZE) );
+        }
+        FC_ASSERT( !in.bad(), "Unable to decompress block range" );
+      }
+      catch( const boost::iostreams::zlib_error& e )
+      {
+        FC_THROW( "Unable to decompress block range: ${what}", ("what", e.what()) );
+      }
+      data = &decompressed;
+    }
+    else
+      FC_ASSERT( codec == block_range_codec::uncompressed, "Unsupported block range codec ${c}", ("c", codec) );
+
+    std::vector<signed_block> blocks;
+    blocks.reserve( std::min<size_t>( block_count, MAX_BLOCKS_TO_HANDLE_AT_ONCE ) );
+    fc::datastream<const char*> ds( data->data(), data->size() );
+    for( uint32_t i = 0; i < block_count; ++i )
+    {
+      blocks.emplace_back();
+      fc::raw::unpack( ds, blocks.back(), GRAPHENE_NET_MAX_NESTED_OBJECTS );
+    }
+    FC_ASSERT( ds.remaining() == 0, "Unexpected data after the blocks of a block range" );
+    return blocks;
+  }
+
+  std::shared_ptr<const void> decode_message_payload( uint32_t msg_type, const char* data, size_t size )
+  {
+    fc::datastream<const char*> ds( data, size );
+    if( msg_type == block_message_type )
+    {
+      auto block = std::make_shared<block_message>();
+      fc::raw::unpack( ds, *block );
+      return block;
+    }
+    if( msg_type == trx_message_type )
+    {
+      auto trx = std::make_shared<trx_message>();
+      fc::raw::unpack( ds, *trx );
+      return trx;
+    }
+    return std::shared_ptr<const void>();
+  }
 
 } } // graphene::net
 
@@ -128,6 +226,15 @@ FC_REFLECT_DERIVED_NO_TYPENAME(graphene::net::get_current_connections_reply_mess
                                                             (upload_rate_one_hour)
                                                             (download_rate_one_hour)
                                                             (current_connections))
+FC_REFLECT_DERIVED_NO_TYPENAME(graphene::net::fetch_block_range_message, BOOST_PP_SEQ_NIL,
+                                                 (first_block_num)
+                                                 (block_count)
+                                                 (codec))
+FC_REFLECT_DERIVED_NO_TYPENAME(graphene::net::block_range_message, BOOST_PP_SEQ_NIL,
+                                           (first_block_num)
+                                           (block_count)
+                                           (codec)
+                                           (packed_blocks))
 
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::trx_message )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::block_message )
@@ -151,3 +258,5 @@ GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::check_firewall_reply_m
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::get_current_connections_request_message )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::current_connection_data )
 GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::get_current_connections_reply_message )
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::fetch_block_range_message )
+GRAPHENE_IMPLEMENT_EXTERNAL_SERIALIZATION( graphene::net::block_range_message )
@@ -62,6 +62,13 @@
 
 #define GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES        (1024 * 1024)
 
+/**
+ * When the messages of a connection are read on an I/O thread, this is the number
+ * of messages which may wait to be handled by the node before the connection
+ * stops reading from its socket
+ */
+#define GRAPHENE_NET_MAX_UNDELIVERED_MESSAGES                64
+
 /**
  * When we receive a message from the network, we advertise it to
  * our peers and save a copy in a cache were we will find it if
@@ -73,6 +80,14 @@
  */
 #define GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS        5
 
+/**
+ * Upper bound on the total size of the messages in the message cache.  When
+ * it is exceeded, the least recently requested messages of the oldest block
+ * are dropped before their time.  Can be changed at runtime with the
+ * "message_cache_max_bytes" advanced node parameter.
+ */
+#define GRAPHENE_NET_MESSAGE_CACHE_MAX_BYTES                 (64 * 1024 * 1024)
+
 /**
  * We prevent a peer from offering us a list of blocks which, if we fetched them
  * all, would result in a blockchain that extended into the future.
@@ -107,8 +122,25 @@
  */
 #define GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH               10000
 
+/**
+ * Upper bound on the size of the (uncompressed) blocks sent in one reply to a
+ * fetch_block_range_message, keeps the reply well below MAX_MESSAGE_SIZE.
+ * A reply always carries at least one block.
+ */
+#define GRAPHENE_NET_MAX_BLOCK_RANGE_BYTES                   (1024 * 1024)
+
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
 
+/**
+ * Transactions received from a peer are queued and processed at no more than
+ * GRAPHENE_NET_MAX_TRX_PER_SECOND per peer, with bursts of up to this many
+ * seconds worth of transactions.  When a peer has more than
+ * GRAPHENE_NET_MAX_QUEUED_TRX_PER_PEER transactions waiting, the ones paying
+ * the lowest fees are dropped.
+ */
+#define GRAPHENE_NET_TRX_BURST_SECONDS                       2
+#define GRAPHENE_NET_MAX_QUEUED_TRX_PER_PEER                 2000
+
 #define GRAPHENE_NET_MAX_NESTED_OBJECTS                      (250)
 
 #define MAXIMUM_PEERDB_SIZE 1000
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+namespace graphene { namespace net {
+
+  /**
+   *  @brief A set which can be iterated without locking, while it is being changed
+   *
+   *  The elements are kept in an immutable std::unordered_set behind a shared_ptr.  Readers take a snapshot,
+   *  which only copies the shared_ptr, and can iterate it for as long as they like, even across fiber switches
+   *  and while the set is changed, which makes removing elements inside a loop over the set safe.  Writers copy
+   *  the set, change the copy and publish it, so changes are expensive.  Meant for small sets which are read much
+   *  more often than they change, like the connections of a node.
+   */
+  template <class Key, class Hash = std::hash<Key>, class Pred = std::equal_to<Key> >
+  class copy_on_write_set
+  {
+    public:
+      using set_type = std::unordered_set<Key, Hash, Pred>;
+
+      /// The contents of the set at one point in time, later changes of the set don't affect it
+      class snapshot_type
+      {
+        public:
+          using const_iterator = typename set_type::const_iterator;
+
+          explicit snapshot_type( std::shared_ptr<const set_type> elements ) : _elements( std::move( elements ) ) {}
+
+          const_iterator begin()const { return _elements->begin(); }
+          const_iterator end()const { return _elements->end(); }
+          size_t size()const { return _elements->size(); }
+          bool empty()const { return _elements->empty(); }
+          bool contains( const Key& key )const { return _elements->find( key ) != _elements->end(); }
+
+        private:
+          std::shared_ptr<const set_type> _elements;
+      };
+
+      copy_on_write_set() : _elements( std::make_shared<const set_type>() ) {}
+      copy_on_write_set( const copy_on_write_set& ) = delete;
+      copy_on_write_set& operator=( const copy_on_write_set& ) = delete;
+
+      snapshot_type snapshot()const { return snapshot_type( std::atomic_load( &_elements ) ); }
+
+      size_t size()const { return snapshot().size(); }
+      bool empty()const { return snapshot().empty(); }
+      bool contains( const Key& key )const { return snapshot().contains( key ); }
+
+      /// @return false if the key was in the set already
+      bool insert( const Key& key )
+      {
+        std::lock_guard<std::mutex> guard( _write_mutex );
+        const std::shared_ptr<const set_type> current = std::atomic_load( &_elements );
+        if( current->find( key ) != current->end() )
+          return false;
+        auto changed = std::make_shared<set_type>( *current );
+        changed->insert( key );
+        std::atomic_store( &_elements, std::shared_ptr<const set_type>( std::move( changed ) ) );
+        return true;
+      }
+
+      /// @return the number of elements removed
+      size_t erase( const Key& key )
+      {
+        std::lock_guard<std::mutex> guard( _write_mutex );
+        const std::shared_ptr<const set_type> current = std::atomic_load( &_elements );
+        if( current->find( key ) == current->end() )
+          return 0;
+        auto changed = std::make_shared<set_type>( *current );
+        changed->erase( key );
+        std::atomic_store( &_elements, std::shared_ptr<const set_type>( std::move( changed ) ) );
+        return 1;
+      }
+
+      void clear()
+      {
+        std::lock_guard<std::mutex> guard( _write_mutex );
+        std::atomic_store( &_elements, std::make_shared<const set_type>() );
+      }
+
+    private:
+      /// Only accessed with std::atomic_load and std::atomic_store
+      std::shared_ptr<const set_type> _elements;
+      /// Serializes the writers, so that no change is lost
+      std::mutex                      _write_mutex;
+  };
+
+} } // graphene::net
@@ -85,6 +85,8 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    fetch_block_range_message_type               = 5018,
+    block_range_message_type                     = 5019,
     core_message_type_last                       = 5099
   };
 
@@ -399,6 +401,71 @@ namespace graphene { namespace net {
     std::vector<current_connection_data> current_connections;
   };
 
+  /**
+   *  Optional protocol features, a node advertises the ones it supports in the "features" field of the
+   *  user data of its hello message.  A feature is only used on a connection if both sides support it.
+   */
+  enum peer_feature_flags
+  {
+    block_range_sync_feature  = 1 << 0, ///< understands fetch_block_range_message and block_range_message
+    zlib_block_ranges_feature = 1 << 1  ///< can send and receive zlib compressed block ranges
+  };
+
+  enum class block_range_codec { uncompressed, zlib };
+
+  /**
+   *  Requests the blocks @ref first_block_num to @ref first_block_num + @ref block_count - 1 of the
+   *  peer's current chain.  Used during syncing instead of a fetch_items_message with the ids of the
+   *  blocks, when the peer supports block_range_sync_feature.
+   */
+  struct fetch_block_range_message
+  {
+    static const core_message_type_enum type;
+
+    uint32_t first_block_num = 0;
+    uint32_t block_count = 0;
+    /// the codec the requester would like the blocks to be sent with, the peer may choose uncompressed
+    fc::enum_type<uint8_t, block_range_codec> codec = block_range_codec::uncompressed;
+
+    fetch_block_range_message() {}
+    fetch_block_range_message(uint32_t first_block_num, uint32_t block_count, block_range_codec codec) :
+      first_block_num(first_block_num),
+      block_count(block_count),
+      codec(codec)
+    {}
+  };
+
+  /**
+   *  The reply to a fetch_block_range_message.  @ref packed_blocks holds @ref block_count consecutive
+   *  blocks in their packed form, encoded with @ref codec.  The peer sends fewer blocks than were
+   *  requested when the rest would not fit in GRAPHENE_NET_MAX_BLOCK_RANGE_BYTES or it doesn't have them,
+   *  and none at all if it doesn't have the first one.
+   */
+  struct block_range_message
+  {
+    static const core_message_type_enum type;
+
+    uint32_t first_block_num = 0;
+    uint32_t block_count = 0;
+    fc::enum_type<uint8_t, block_range_codec> codec = block_range_codec::uncompressed;
+    std::vector<char> packed_blocks;
+
+    block_range_message() {}
+    /// Concatenates the packed blocks, starting with block @p first_block_num, and encodes them with @p codec
+    block_range_message(uint32_t first_block_num, const std::vector<std::vector<char>>& blocks,
+                        block_range_codec codec);
+
+    /// Decodes and unpacks the blocks, throws if they can't be decoded or there are fewer than @ref block_count
+    std::vector<signed_block> get_blocks()const;
+  };
+
+  /**
+   *  Decodes the payload of a block or transaction message, the large and frequent messages which are worth
+   *  decoding on the I/O thread of the connection.  Returns null for the other types.
+   *  This is the decoder of the message_io_pool of the node.
+   */
+  std::shared_ptr<const void> decode_message_payload( uint32_t msg_type, const char* data, size_t size );
+
 } } // graphene::net
 
 FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
@@ -422,6 +489,8 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (fetch_block_range_message_type)
+                 (block_range_message_type)
                  (core_message_type_last) )
 FC_REFLECT_ENUM(graphene::net::rejection_reason_code, (unspecified)
                                                  (different_chain)
@@ -440,6 +509,8 @@ FC_REFLECT_ENUM(graphene::net::firewalled_state, (unknown)
 FC_REFLECT_ENUM(graphene::net::firewall_check_result, (unable_to_check)
                                                  (unable_to_connect)
                                                  (connection_successful))
+FC_REFLECT_ENUM(graphene::net::block_range_codec, (uncompressed)
+                                             (zlib))
 
 FC_REFLECT_TYPENAME( graphene::net::trx_message )
 FC_REFLECT_TYPENAME( graphene::net::block_message )
@@ -463,6 +534,8 @@ FC_REFLECT_TYPENAME( graphene::net::check_firewall_reply_message )
 FC_REFLECT_TYPENAME( graphene::net::get_current_connections_request_message )
 FC_REFLECT_TYPENAME( graphene::net::current_connection_data )
 FC_REFLECT_TYPENAME( graphene::net::get_current_connections_reply_message )
+FC_REFLECT_TYPENAME( graphene::net::fetch_block_range_message )
+FC_REFLECT_TYPENAME( graphene::net::block_range_message )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::trx_message )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::block_message )
@@ -486,6 +559,8 @@ GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::check_firewall_reply_mes
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::get_current_connections_request_message )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::current_connection_data )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::get_current_connections_reply_message )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::fetch_block_range_message )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::net::block_range_message )
 
 #include <unordered_map>
 #include <fc/crypto/city.hpp>
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/core_messages.hpp>
+
+#include <fc/time.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace graphene { namespace net {
+
+  /**
+   *  @brief A set of recently seen item hashes which forgets the items after a while
+   *
+   *  Items are kept in a ring of time buckets.  New items go into the newest bucket, and a bucket is dropped as
+   *  a whole once all of its items are older than the lifetime, so expiring items costs nothing per item.  An
+   *  item is kept for at least the lifetime and at most the lifetime plus the span of one bucket.
+   *
+   *  Every bucket is an open addressing hash table of 64 bit fingerprints of the item hashes, so inserting an
+   *  item does not allocate memory, and the tables of dropped buckets are reused.  Two different item hashes
+   *  are mistaken for each other with a probability of 2^-64.
+   */
+  class rolling_inventory_filter
+  {
+    public:
+      using fingerprint_type = uint64_t;
+
+      explicit rolling_inventory_filter(
+            fc::microseconds lifetime = fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES),
+            uint32_t number_of_buckets = 8 );
+
+      static fingerprint_type fingerprint( const item_hash_t& hash );
+
+      bool contains( fingerprint_type fp )const;
+      bool contains( const item_hash_t& hash )const { return contains( fingerprint( hash ) ); }
+      bool contains( const item_id& item )const { return contains( item.item_hash ); }
+
+      /// Adds an item to the newest bucket, returns false if the item is known already
+      bool insert( fingerprint_type fp, const fc::time_point& now = fc::time_point::now() );
+      bool insert( const item_hash_t& hash, const fc::time_point& now = fc::time_point::now() )
+      {
+         return insert( fingerprint( hash ), now );
+      }
+      bool insert( const item_id& item, const fc::time_point& now = fc::time_point::now() )
+      {
+         return insert( item.item_hash, now );
+      }
+
+      /// Removes an item, returns false if the item is unknown
+      bool erase( fingerprint_type fp );
+      bool erase( const item_hash_t& hash ) { return erase( fingerprint( hash ) ); }
+      bool erase( const item_id& item ) { return erase( item.item_hash ); }
+
+      /// Drops the buckets whose items are all older than the lifetime, returns the number of items dropped
+      size_t expire( const fc::time_point& now = fc::time_point::now() );
+
+      size_t size()const { return _size; }
+      bool empty()const { return _size == 0; }
+      void clear();
+
+    private:
+      struct bucket
+      {
+        fc::time_point                start;
+        std::vector<fingerprint_type> slots; ///< a power of two, @ref empty_slot or @ref erased_slot if unused
+        size_t                        items = 0;
+        size_t                        used_slots = 0; ///< the items and the erased slots
+
+        bool contains( fingerprint_type fp )const;
+        void insert( fingerprint_type fp );
+        bool erase( fingerprint_type fp );
+        void rehash( size_t number_of_slots );
+      };
+
+      static constexpr fingerprint_type empty_slot  = 0;
+      static constexpr fingerprint_type erased_slot = 1;
+      static constexpr size_t           initial_slots = 16;
+
+      fc::microseconds    _lifetime;
+      fc::microseconds    _bucket_span;
+      std::deque<bucket>  _buckets; ///< oldest first
+      std::vector<bucket> _spare_buckets;
+      size_t              _size = 0;
+  };
+
+} } // graphene::net
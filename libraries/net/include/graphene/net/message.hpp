@@ -29,9 +29,13 @@
 #include <fc/io/varint.hpp>
 #include <fc/network/ip.hpp>
 #include <fc/io/raw_fwd.hpp>
+#include <fc/optional.hpp>
 #include <fc/crypto/ripemd160.hpp>
 #include <fc/reflect/typename.hpp>
 
+#include <memory>
+#include <vector>
+
 namespace graphene { namespace net {
 
   /**
@@ -53,13 +57,72 @@ namespace graphene { namespace net {
 
   using message_hash_type = fc::ripemd160;
 
+  /**
+   *  The immutable, reference counted payload of a message.
+   *
+   *  Copies of a buffer share the same bytes, so a message which is broadcast to many peers is held in memory
+   *  only once, no matter how many message caches and send queues refer to it.  To change the payload, build
+   *  a new vector and assign it.
+   *
+   *  The decoded content is held by the buffer, not by the shared payload, so that the copies which are kept
+   *  around after the message was handled can let go of it with @ref drop_decoded.
+   */
+  class message_buffer
+  {
+     public:
+        message_buffer() = default;
+        message_buffer( std::vector<char>&& bytes );
+
+        /**
+         *  Builds a buffer whose hash, and optionally decoded content, have already been computed, so that
+         *  the thread which handles the message doesn't have to do it again.
+         */
+        message_buffer( std::vector<char>&& bytes, const message_hash_type& id,
+                        std::shared_ptr<const void> decoded = std::shared_ptr<const void>() );
+
+        const char* data()const { return _payload ? _payload->bytes.data() : nullptr; }
+        size_t size()const { return _payload ? _payload->bytes.size() : 0; }
+        bool empty()const { return size() == 0; }
+        const char* begin()const { return data(); }
+        const char* end()const { return data() + size(); }
+        const char& operator[]( size_t index )const { return _payload->bytes[index]; }
+
+        /// Returns a mutable copy of the payload
+        std::vector<char> to_vector()const { return std::vector<char>( begin(), end() ); }
+
+        /// Number of messages sharing this payload
+        long use_count()const { return _payload.use_count(); }
+
+        /// The hash of the payload, if it was given when the buffer was built
+        const fc::optional<message_hash_type>& precomputed_id()const;
+
+        /// The decoded content of the payload, if it was given when the buffer was built
+        const std::shared_ptr<const void>& decoded()const { return _decoded; }
+
+        /// Releases the decoded content, which isn't counted by the caches and queues holding the buffer
+        void drop_decoded() { _decoded.reset(); }
+
+        /// Total size of the payloads of all messages currently held in memory by this process
+        static uint64_t live_bytes();
+
+     private:
+        struct payload
+        {
+           std::vector<char>               bytes;
+           fc::optional<message_hash_type> id;
+        };
+
+        std::shared_ptr<const payload> _payload;
+        std::shared_ptr<const void>    _decoded;
+  };
+
   /**
    *  Abstracts the process of packing/unpacking a message for a 
    *  particular channel.
    */
   struct message : public message_header
   {
-     std::vector<char> data;
+     message_buffer data;
 
      message(){}
 
@@ -69,6 +132,9 @@ namespace graphene { namespace net {
      message( const message& m )
      :message_header(m),data( m.data ){}
 
+     message& operator=( const message& m ) = default;
+     message& operator=( message&& m ) = default;
+
      /**
       *  Assumes that T::type specifies the message type
       */
@@ -82,9 +148,22 @@ namespace graphene { namespace net {
 
      message_hash_type id()const
      {
+        if( data.precomputed_id() )
+           return *data.precomputed_id();
         return fc::ripemd160::hash( data.data(), (uint32_t)data.size() );
      }
 
+     /**
+      *  Same as @ref as, but reuses the object decoded by the connection's I/O thread if there is one.
+      */
+     template<typename T>
+     std::shared_ptr<const T> as_shared()const
+     {
+        if( data.decoded() && msg_type.value() == T::type )
+           return std::static_pointer_cast<const T>( data.decoded() );
+        return std::make_shared<const T>( as<T>() );
+     }
+
      /**
       *  Automatically checks the type and deserializes T in the
       *  opposite process from the constructor.
@@ -118,6 +197,27 @@ namespace graphene { namespace net {
 
 } } // graphene::net
 
+namespace fc {
+   void to_variant( const graphene::net::message_buffer& buffer, variant& v, uint32_t max_depth );
+   void from_variant( const variant& v, graphene::net::message_buffer& buffer, uint32_t max_depth );
+namespace raw {
+   template<typename Stream>
+   void pack( Stream& s, const graphene::net::message_buffer& buffer, uint32_t _max_depth=FC_PACK_MAX_DEPTH )
+   {
+      fc::raw::pack( s, unsigned_int( (uint32_t)buffer.size() ), _max_depth );
+      if( !buffer.empty() )
+         s.write( buffer.data(), buffer.size() );
+   }
+   template<typename Stream>
+   void unpack( Stream& s, graphene::net::message_buffer& buffer, uint32_t _max_depth=FC_PACK_MAX_DEPTH )
+   {
+      std::vector<char> bytes;
+      fc::raw::unpack( s, bytes, _max_depth );
+      buffer = std::move( bytes );
+   }
+} } // fc::raw
+
+FC_REFLECT_TYPENAME( graphene::net::message_buffer )
 FC_REFLECT_TYPENAME( graphene::net::message_header )
 FC_REFLECT_TYPENAME( graphene::net::message )
 
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/net/config.hpp>
+#include <graphene/net/message.hpp>
+#include <graphene/net/node.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <cstring>
+#include <deque>
+#include <list>
+#include <unordered_map>
+
+namespace graphene { namespace net {
+
+  /// Counters of a @ref blockchain_tied_message_cache
+  struct message_cache_statistics
+  {
+    uint32_t messages    = 0; ///< messages currently cached
+    uint64_t bytes       = 0; ///< estimated memory used by the cached messages
+    uint64_t max_bytes   = 0;
+    uint64_t hits        = 0; ///< lookups which found the message
+    uint64_t misses      = 0; ///< lookups which didn't
+    uint64_t evictions   = 0; ///< messages dropped to stay within max_bytes
+    uint64_t expirations = 0; ///< messages dropped because they were too old
+  };
+
+  /**
+   *  @brief The messages we have recently broadcast, kept so that we can serve them when peers request them
+   *
+   *  Messages are kept for a number of blocks.  They are grouped in one bucket per block in which they were
+   *  cached, so when a block is accepted the buckets which became too old are dropped as a whole.  The cache
+   *  also has a byte budget: when it is exceeded, messages are evicted from the oldest bucket, least recently
+   *  requested first.
+   *
+   *  Both lookups, by message hash and by the hash of the contents (transaction id or block id), are hash
+   *  table lookups.
+   */
+  class blockchain_tied_message_cache
+  {
+    public:
+      explicit blockchain_tied_message_cache(
+            uint64_t max_bytes = GRAPHENE_NET_MESSAGE_CACHE_MAX_BYTES,
+            uint32_t duration_in_blocks = GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS );
+
+      void block_accepted();
+      void cache_message( const message& message_to_cache,
+                          const message_hash_type& hash_of_message_to_cache,
+                          const message_propagation_data& propagation_data,
+                          const message_hash_type& message_content_hash );
+      /// Throws fc::key_not_found_exception if the message is not in the cache
+      message get_message( const message_hash_type& hash_of_message_to_lookup );
+      /// Throws fc::key_not_found_exception if no message with these contents is in the cache
+      message_propagation_data get_message_propagation_data(
+            const message_hash_type& hash_of_msg_contents_to_lookup );
+
+      size_t size()const { return _messages.size(); }
+      uint64_t get_max_bytes()const { return _max_bytes; }
+      /// Changes the byte budget, evicting messages right away if it is exceeded
+      void set_max_bytes( uint64_t max_bytes );
+
+      message_cache_statistics get_statistics()const;
+
+    private:
+      /// The hashes are uniformly distributed, so any part of them is a good hash table key
+      struct message_hash_hasher
+      {
+        size_t operator()( const message_hash_type& hash )const
+        {
+          size_t result;
+          static_assert( sizeof(message_hash_type) >= sizeof(result), "message hash too short" );
+          memcpy( &result, hash.data(), sizeof(result) );
+          return result;
+        }
+      };
+
+      struct block_bucket;
+
+      struct message_info
+      {
+        message                  message_body;
+        /// for network performance stats
+        message_propagation_data propagation_data;
+        /// hash of whatever the message contains
+        /// (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
+        message_hash_type        message_contents_hash;
+        uint64_t                 bytes = 0;
+        block_bucket*            bucket = nullptr;
+        std::list<const message_hash_type*>::iterator lru_position;
+      };
+
+      using message_map = std::unordered_map<message_hash_type, message_info, message_hash_hasher>;
+
+      /// The messages cached while the block clock had a given value, least recently used first
+      struct block_bucket
+      {
+        uint32_t                            block_clock = 0;
+        std::list<const message_hash_type*> messages;
+      };
+
+      void erase( const message_hash_type& hash_of_message );
+      void evict_to_budget();
+
+      const uint32_t _duration_in_blocks;
+      uint64_t       _max_bytes;
+      uint32_t       _block_clock = 0;
+
+      message_map                                                                     _messages;
+      /// Points at the keys of @ref _messages, which are stable across rehashing
+      std::unordered_map<message_hash_type, const message_hash_type*, message_hash_hasher> _messages_by_contents;
+      std::deque<block_bucket>                                                        _buckets; ///< oldest first
+
+      uint64_t _bytes       = 0;
+      uint64_t _hits        = 0;
+      uint64_t _misses      = 0;
+      uint64_t _evictions   = 0;
+      uint64_t _expirations = 0;
+  };
+
+} } // graphene::net
+
+FC_REFLECT( graphene::net::message_cache_statistics,
+            (messages)(bytes)(max_bytes)(hits)(misses)(evictions)(expirations) )
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/net/message.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace net {
+
+  /// Counters of the work done by a @ref message_io_pool
+  struct message_io_statistics
+  {
+    uint32_t threads           = 0;
+    uint64_t messages_prepared = 0; ///< messages read, hashed and decoded on the I/O threads
+    uint64_t bytes_prepared    = 0;
+    uint64_t prepare_us        = 0; ///< time spent hashing and decoding
+  };
+
+  /**
+   *  @brief A pool of threads which read, decrypt, hash and decode the messages received by the connections
+   *
+   *  Each connection runs its read loop, its writes and its close on one of the threads of the pool, so its
+   *  socket is only ever used from that thread.  The messages it reads are hashed and, for the types the decoder
+   *  knows, decoded there, then handed over to the node thread through a lock-free queue owned by the connection
+   *  (see message_oriented_connection), in the order they were read.  The node thread is left with the protocol
+   *  logic only.
+   */
+  class message_io_pool
+  {
+    public:
+      /// Returns the decoded payload of a message, or null for the types which aren't decoded in advance
+      using decoder_type = std::function<std::shared_ptr<const void>( uint32_t msg_type, const char* data,
+                                                                      size_t size )>;
+
+      message_io_pool( uint16_t num_threads, decoder_type decoder = decoder_type() );
+      ~message_io_pool();
+
+      size_t size()const { return _threads.size(); }
+
+      /// Returns the thread to run the socket I/O of a new connection on
+      fc::thread& next_thread();
+
+      /// Builds a received message, with its hash and decoded payload, called on the I/O threads
+      message prepare_message( const message_header& header, std::vector<char>&& payload );
+
+      message_io_statistics get_statistics()const;
+
+    private:
+      std::vector<std::unique_ptr<fc::thread>> _threads;
+      std::atomic<uint32_t>                    _next_thread { 0 };
+      decoder_type                             _decoder;
+
+      std::atomic<uint64_t>                    _messages_prepared { 0 };
+      std::atomic<uint64_t>                    _bytes_prepared { 0 };
+      std::atomic<uint64_t>                    _prepare_us { 0 };
+  };
+
+} } // graphene::net
+
+FC_REFLECT( graphene::net::message_io_statistics,
+            (threads)(messages_prepared)(bytes_prepared)(prepare_us) )
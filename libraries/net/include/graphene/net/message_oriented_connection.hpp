@@ -30,6 +30,7 @@ namespace graphene { namespace net {
   namespace detail { class message_oriented_connection_impl; }
 
   class message_oriented_connection;
+  class message_io_pool;
 
   /** receives incoming messages from a message_oriented_connection object */
   class message_oriented_connection_delegate 
@@ -43,7 +44,12 @@ namespace graphene { namespace net {
   class message_oriented_connection
   {
      public:
-       message_oriented_connection(message_oriented_connection_delegate* delegate = nullptr);
+       /**
+        *  @param io_pool if given, the messages are read, hashed and decoded on a thread of this pool, and
+        *         passed to the delegate on the thread which created the connection
+        */
+       message_oriented_connection(message_oriented_connection_delegate* delegate = nullptr,
+                                   message_io_pool* io_pool = nullptr);
        ~message_oriented_connection();
        fc::tcp_socket& get_socket();
 
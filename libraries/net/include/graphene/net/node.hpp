@@ -85,6 +85,17 @@ namespace graphene { namespace net {
           */
          virtual void handle_transaction( const graphene::net::trx_message& trx_msg ) = 0;
 
+         /**
+          *  @brief Called when a new transaction comes in from the network, before it is
+          *         queued to be passed to @ref handle_transaction
+          *
+          *  When a peer sends us more transactions than we are willing to process from it,
+          *  the transactions with the highest priority are processed first.
+          *
+          *  @return the priority of the transaction, e.g. the fees it pays per kilobyte
+          */
+         virtual uint64_t get_transaction_priority( const graphene::net::trx_message& trx_msg ) { return 0; }
+
          /**
           *  @brief Called when a new message comes in from the network other than a
           *         block or a transaction.  Currently there are no other possible 
@@ -111,6 +122,17 @@ namespace graphene { namespace net {
           */
          virtual message get_item( const item_id& id ) = 0;
 
+         /**
+          *  Returns up to @p count consecutive blocks of our current chain starting at block
+          *  @p first_block_num in their packed form, at most @p max_bytes in total but at
+          *  least one block if we have it.  Used to answer fetch_block_range_messages.
+          *
+          *  @return an empty vector if the blocks are not available or the delegate doesn't
+          *          support reading them packed, peers then fall back to fetching by id
+          */
+         virtual std::vector<std::vector<char>> get_packed_blocks( uint32_t first_block_num, uint32_t count,
+                                                                   size_t max_bytes ) { return {}; }
+
          virtual chain_id_type get_chain_id()const = 0;
 
          /**
@@ -281,6 +303,11 @@ namespace graphene { namespace net {
         {
            broadcast( trx_message(trx) );
         }
+        /**
+         *  Add a batch of transactions to the outgoing inventory list at once, so that peers
+         *  are notified of all of them with as few inventory messages as possible.
+         */
+        virtual void  broadcast_transactions( const std::vector<signed_transaction>& trxs );
 
         /**
          *  Node starts the process of fetching all items after item_id of the
@@ -305,6 +332,14 @@ namespace graphene { namespace net {
 
         void set_total_bandwidth_limit(uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second);
 
+        /**
+         *  Reads, decrypts, hashes and decodes the messages received by the connections on a pool of
+         *  @p num_threads threads instead of the p2p thread.  Applies to the connections made afterwards,
+         *  0 (the default) handles everything on the p2p thread.  Connections are not moved to the pool
+         *  while a download bandwidth limit is set.
+         */
+        void set_io_thread_count(uint16_t num_threads);
+
         fc::variant_object network_get_info() const;
         fc::variant_object network_get_usage_stats() const;
 
@@ -27,6 +27,7 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/message_oriented_connection.hpp>
 #include <graphene/net/config.hpp>
+#include <graphene/net/inventory_filter.hpp>
 
 #include <boost/tuple/tuple.hpp>
 
@@ -37,6 +38,7 @@
 #include <boost/multi_index/tag.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <map>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -67,6 +69,8 @@ namespace graphene { namespace net
                               const message& received_message) = 0;
       virtual void on_connection_closed(peer_connection* originating_peer) = 0;
       virtual message get_message_for_item(const item_id& item) = 0;
+      /// The pool which reads the messages of new connections, or nullptr to read them on the node thread
+      virtual message_io_pool* get_message_io_pool() { return nullptr; }
     };
 
     using peer_connection_ptr = std::shared_ptr<peer_connection>;
@@ -128,8 +132,9 @@ namespace graphene { namespace net
         virtual ~queued_message() = default;
       };
 
-      /* when you queue up a 'real_queued_message', a full copy of the message is
-       * stored on the heap until it is sent
+      /* when you queue up a 'real_queued_message', the message is stored on the heap
+       * until it is sent.  The payload is shared with the other copies of the message,
+       * e.g. in the message cache and in the queues of other peers
        */
       struct real_queued_message : queued_message
       {
@@ -140,7 +145,9 @@ namespace graphene { namespace net
                             size_t message_send_time_field_offset = (size_t)-1) :
           message_to_send(std::move(message_to_send)),
           message_send_time_field_offset(message_send_time_field_offset)
-        {}
+        {
+          this->message_to_send.data.drop_decoded();
+        }
 
         message get_message(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
@@ -204,6 +211,7 @@ namespace graphene { namespace net
       fc::optional<fc::time_point_sec> fc_git_revision_unix_timestamp;
       fc::optional<std::string> platform;
       fc::optional<uint32_t> bitness;
+      uint32_t features = 0; /// the peer_feature_flags from the "features" field of the peer's hello user data
 
       // for inbound connections, these fields record what the peer sent us in
       // its hello message.  For outbound, they record what we sent the peer
@@ -228,6 +236,11 @@ namespace graphene { namespace net
       item_hash_t last_block_delegate_has_seen; /// the hash of the last block  this peer has told us about that the peer knows
       fc::time_point_sec last_block_time_delegate_has_seen;
       bool inhibit_fetching_sync_blocks = false;
+      /// the block ranges we've requested from this peer, by first block number, with the ids of the blocks we
+      /// expect.  The ids are in sync_items_requested_from_peer too
+      std::map<uint32_t, std::vector<item_hash_t> > block_ranges_requested_from_peer;
+      /// set when the peer sent none of the blocks of a range we requested, we fetch its blocks by id from then on
+      bool inhibit_block_range_requests = false;
       /// @}
 
       /// non-synchronization state data
@@ -247,8 +260,10 @@ namespace graphene { namespace net
                                                                                                             std::hash<item_id> >,
                                                                           boost::multi_index::ordered_non_unique<boost::multi_index::tag<timestamp_index>,
                                                                                                                  boost::multi_index::member<timestamped_item_id, fc::time_point_sec, &timestamped_item_id::timestamp> > > > timestamped_items_set_type;
-      timestamped_items_set_type inventory_peer_advertised_to_us;
-      timestamped_items_set_type inventory_advertised_to_peer;
+      /// the items this peer has told us about and the items we have told this peer about, both forgotten after
+      /// GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES
+      rolling_inventory_filter inventory_peer_advertised_to_us;
+      rolling_inventory_filter inventory_advertised_to_peer;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
       /// @}
@@ -99,6 +99,10 @@ namespace graphene { namespace net {
     peer_database();
     virtual ~peer_database();
 
+    /**
+     * Loads the database from @p databaseFilename, or from the JSON file of older versions with the same name
+     * and the extension ".json".  From then on, all changes are appended to the file as they are made.
+     */
     void open(const fc::path& databaseFilename);
     void close();
     void clear();
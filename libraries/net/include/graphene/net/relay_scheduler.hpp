@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message.hpp>
+
+#include <fc/network/ip.hpp>
+#include <fc/optional.hpp>
+#include <fc/time.hpp>
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace graphene { namespace net {
+
+  /// Counters of the transaction relay queue of one peer
+  struct relay_queue_statistics
+  {
+    uint32_t queued     = 0; ///< transactions waiting in the queue
+    uint64_t received   = 0; ///< transactions added to the queue
+    uint64_t dispatched = 0; ///< transactions taken from the queue to be processed
+    uint64_t dropped    = 0; ///< transactions dropped because the queue was full
+    double   tokens     = 0; ///< transactions the peer may have processed right now
+  };
+
+  /**
+   *  @brief Decides in which order the transactions received from peers are processed
+   *
+   *  Every peer has its own queue, ordered by the priority of the transactions (fee per kilobyte, as estimated
+   *  by the node delegate) and then by arrival.  The queues are served round-robin, one transaction per turn,
+   *  so that a peer which floods us cannot delay the transactions of other peers.  Each peer also has a token
+   *  bucket which limits the rate of its transactions, and a bounded queue: when the queue is full, the
+   *  transaction with the lowest priority is dropped.
+   *
+   *  Blocks and sync items do not go through the scheduler, they are always processed right away.
+   */
+  class transaction_relay_scheduler
+  {
+    public:
+      /// Identifies the peer a transaction came from, in the node this is the peer_connection
+      using peer_key = const void*;
+
+      struct queued_transaction
+      {
+        message                        message_received;
+        message_hash_type              message_hash;
+        uint64_t                       priority = 0;
+        node_id_t                      originating_node;
+        fc::optional<fc::ip::endpoint> originating_endpoint;
+        fc::time_point                 received_time;
+        uint64_t                       sequence = 0; ///< set by the scheduler
+      };
+
+      /**
+       *  @param transactions_per_second the rate at which the budget of a peer grows
+       *  @param burst the maximum budget of a peer, which is also the budget of a new peer
+       *  @param max_queue_size the maximum number of transactions queued for a peer
+       */
+      transaction_relay_scheduler( double transactions_per_second, double burst, size_t max_queue_size );
+
+      /// Queues a transaction, returns false if it was dropped because the queue of the peer is full
+      bool push( peer_key peer, queued_transaction trx, const fc::time_point& now = fc::time_point::now() );
+
+      /// Returns the next transaction to process, if there is one which is within the budget of its peer
+      fc::optional<queued_transaction> pop( const fc::time_point& now = fc::time_point::now() );
+
+      /// Returns the earliest time @ref pop can return a transaction, or the maximum time if nothing is queued
+      fc::time_point next_ready_time( const fc::time_point& now = fc::time_point::now() )const;
+
+      /// Drops the queue and the budget of a peer which has disconnected, returns the hashes of the dropped
+      /// transactions
+      std::vector<message_hash_type> remove_peer( peer_key peer );
+
+      /// Total number of queued transactions
+      size_t size()const { return _size; }
+
+      /// Whether a transaction with the given message hash is queued for any peer
+      bool contains( const message_hash_type& hash )const { return _queued_hashes.find( hash ) != _queued_hashes.end(); }
+
+      relay_queue_statistics get_statistics( peer_key peer, const fc::time_point& now = fc::time_point::now() )const;
+
+    private:
+      struct by_priority
+      {
+        bool operator()( const queued_transaction& a, const queued_transaction& b )const
+        {
+          if( a.priority != b.priority )
+            return a.priority > b.priority;
+          return a.sequence < b.sequence;
+        }
+      };
+
+      struct peer_queue
+      {
+        std::set<queued_transaction, by_priority> transactions;
+        double                                    tokens = 0;
+        fc::time_point                            last_refill;
+        relay_queue_statistics                    statistics;
+        bool                                      scheduled = false; ///< whether the peer is in the round-robin
+      };
+
+      double tokens_at( const peer_queue& queue, const fc::time_point& now )const;
+      void forget_hash( const message_hash_type& hash );
+
+      const double _transactions_per_second;
+      const double _burst;
+      const size_t _max_queue_size;
+
+      std::unordered_map<peer_key, peer_queue> _peers;
+      std::deque<peer_key>                     _round_robin; ///< the peers with queued transactions
+      /// The hashes of all queued transactions, a transaction may be queued for more than one peer
+      std::unordered_multiset<message_hash_type> _queued_hashes;
+      uint64_t                                 _next_sequence = 0;
+      size_t                                   _size = 0;
+  };
+
+} } // graphene::net
+
+FC_REFLECT( graphene::net::relay_queue_statistics, (queued)(received)(dispatched)(dropped)(tokens) )
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/net/inventory_filter.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace graphene { namespace net {
+
+  constexpr rolling_inventory_filter::fingerprint_type rolling_inventory_filter::empty_slot;
+  constexpr rolling_inventory_filter::fingerprint_type rolling_inventory_filter::erased_slot;
+  constexpr size_t rolling_inventory_filter::initial_slots;
+
+  rolling_inventory_filter::rolling_inventory_filter( fc::microseconds lifetime, uint32_t number_of_buckets )
+    : _lifetime( lifetime ),
+      _bucket_span( lifetime.count() / std::max<uint32_t>( number_of_buckets, 1 ) )
+  {
+  }
+
+  rolling_inventory_filter::fingerprint_type rolling_inventory_filter::fingerprint( const item_hash_t& hash )
+  {
+    // the hashes are uniformly distributed already, only the reserved slot values must be avoided
+    fingerprint_type fp;
+    static_assert( sizeof(item_hash_t) >= sizeof(fp), "item hash too short" );
+    memcpy( &fp, hash.data(), sizeof(fp) );
+    return fp > erased_slot ? fp : fp + 2;
+  }
+
+  bool rolling_inventory_filter::bucket::contains( fingerprint_type fp )const
+  {
+    const size_t mask = slots.size() - 1;
+    for( size_t i = fp & mask; slots[i] != empty_slot; i = ( i + 1 ) & mask )
+      if( slots[i] == fp )
+        return true;
+    return false;
+  }
+
+  void rolling_inventory_filter::bucket::insert( fingerprint_type fp )
+  {
+    // keep at least a quarter of the slots empty, so that lookups of unknown items stop early.
+    // Grow if the table is at least half full of items, otherwise just clean up the erased slots
+    if( ( used_slots + 1 ) * 4 > slots.size() * 3 )
+      rehash( ( items + 1 ) * 2 > slots.size() ? slots.size() * 2 : slots.size() );
+    const size_t mask = slots.size() - 1;
+    size_t i = fp & mask;
+    while( slots[i] != empty_slot && slots[i] != erased_slot )
+      i = ( i + 1 ) & mask;
+    if( slots[i] == empty_slot )
+      ++used_slots;
+    slots[i] = fp;
+    ++items;
+  }
+
+  bool rolling_inventory_filter::bucket::erase( fingerprint_type fp )
+  {
+    const size_t mask = slots.size() - 1;
+    for( size_t i = fp & mask; slots[i] != empty_slot; i = ( i + 1 ) & mask )
+      if( slots[i] == fp )
+      {
+        slots[i] = erased_slot;
+        --items;
+        return true;
+      }
+    return false;
+  }
+
+  void rolling_inventory_filter::bucket::rehash( size_t number_of_slots )
+  {
+    std::vector<fingerprint_type> old_slots( number_of_slots, empty_slot );
+    old_slots.swap( slots );
+    items = 0;
+    used_slots = 0;
+    for( fingerprint_type fp : old_slots )
+      if( fp != empty_slot && fp != erased_slot )
+        insert( fp );
+  }
+
+  bool rolling_inventory_filter::contains( fingerprint_type fp )const
+  {
+    for( const bucket& b : _buckets )
+      if( b.items > 0 && b.contains( fp ) )
+        return true;
+    return false;
+  }
+
+  bool rolling_inventory_filter::insert( fingerprint_type fp, const fc::time_point& now )
+  {
+    if( contains( fp ) )
+      return false;
+    if( _buckets.empty() || now >= _buckets.back().start + _bucket_span )
+    {
+      if( _spare_buckets.empty() )
+      {
+        _buckets.emplace_back();
+        _buckets.back().slots.resize( initial_slots, empty_slot );
+      }
+      else
+      {
+        _buckets.emplace_back( std::move( _spare_buckets.back() ) );
+        _spare_buckets.pop_back();
+      }
+      _buckets.back().start = now;
+    }
+    _buckets.back().insert( fp );
+    ++_size;
+    return true;
+  }
+
+  bool rolling_inventory_filter::erase( fingerprint_type fp )
+  {
+    for( bucket& b : _buckets )
+      if( b.items > 0 && b.erase( fp ) )
+      {
+        --_size;
+        return true;
+      }
+    return false;
+  }
+
+  size_t rolling_inventory_filter::expire( const fc::time_point& now )
+  {
+    size_t dropped = 0;
+    // the items of a bucket are not older than the start of the next bucket
+    while( !_buckets.empty()
+           && ( _buckets.size() == 1 ? _buckets.front().start + _bucket_span : _buckets[1].start ) + _lifetime <= now )
+    {
+      bucket& oldest = _buckets.front();
+      dropped += oldest.items;
+      _size -= oldest.items;
+      if( _spare_buckets.empty() )
+      {
+        std::fill( oldest.slots.begin(), oldest.slots.end(), empty_slot );
+        oldest.items = 0;
+        oldest.used_slots = 0;
+        _spare_buckets.emplace_back( std::move( oldest ) );
+      }
+      _buckets.pop_front();
+    }
+    return dropped;
+  }
+
+  void rolling_inventory_filter::clear()
+  {
+    _buckets.clear();
+    _size = 0;
+  }
+
+} } // graphene::net
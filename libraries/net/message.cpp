@@ -22,9 +22,74 @@
  * THE SOFTWARE.
  */
 #include <fc/io/raw.hpp>
+#include <fc/variant.hpp>
 
 #include <graphene/net/message.hpp>
 
+#include <atomic>
+
+namespace graphene { namespace net {
+
+   namespace {
+      std::atomic<uint64_t> live_message_bytes { 0 };
+   }
+
+   message_buffer::message_buffer( std::vector<char>&& bytes )
+   {
+      if( bytes.empty() )
+         return;
+      live_message_bytes += bytes.size();
+      payload* p = new payload();
+      p->bytes = std::move( bytes );
+      _payload = std::shared_ptr<const payload>( p, []( const payload* p ) {
+                                                       live_message_bytes -= p->bytes.size();
+                                                       delete p;
+                                                    } );
+   }
+
+   message_buffer::message_buffer( std::vector<char>&& bytes, const message_hash_type& id,
+                                   std::shared_ptr<const void> decoded )
+      : _decoded( std::move( decoded ) )
+   {
+      live_message_bytes += bytes.size();
+      payload* p = new payload();
+      p->bytes = std::move( bytes );
+      p->id = id;
+      _payload = std::shared_ptr<const payload>( p, []( const payload* p ) {
+                                                       live_message_bytes -= p->bytes.size();
+                                                       delete p;
+                                                    } );
+   }
+
+   const fc::optional<message_hash_type>& message_buffer::precomputed_id()const
+   {
+      static const fc::optional<message_hash_type> none;
+      return _payload ? _payload->id : none;
+   }
+
+   uint64_t message_buffer::live_bytes()
+   {
+      return live_message_bytes.load();
+   }
+
+} } // graphene::net
+
+namespace fc {
+
+   void to_variant( const graphene::net::message_buffer& buffer, variant& v, uint32_t max_depth )
+   {
+      to_variant( buffer.to_vector(), v, max_depth );
+   }
+
+   void from_variant( const variant& v, graphene::net::message_buffer& buffer, uint32_t max_depth )
+   {
+      std::vector<char> bytes;
+      from_variant( v, bytes, max_depth );
+      buffer = std::move( bytes );
+   }
+
+} // fc
+
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::message_header, BOOST_PP_SEQ_NIL, (size)(msg_type) )
 FC_REFLECT_DERIVED_NO_TYPENAME( graphene::net::message, (graphene::net::message_header), (data) )
 
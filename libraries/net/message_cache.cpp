@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/net/message_cache.hpp>
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace net {
+
+  blockchain_tied_message_cache::blockchain_tied_message_cache( uint64_t max_bytes, uint32_t duration_in_blocks )
+    : _duration_in_blocks( duration_in_blocks ),
+      _max_bytes( max_bytes )
+  {
+  }
+
+  void blockchain_tied_message_cache::block_accepted()
+  {
+    ++_block_clock;
+    // keep the messages cached during the last _duration_in_blocks blocks, plus the current one
+    while( !_buckets.empty() && _buckets.front().block_clock + _duration_in_blocks < _block_clock )
+    {
+      block_bucket& bucket = _buckets.front();
+      _expirations += bucket.messages.size();
+      while( !bucket.messages.empty() )
+        erase( *bucket.messages.front() );
+      _buckets.pop_front();
+    }
+  }
+
+  void blockchain_tied_message_cache::cache_message( const message& message_to_cache,
+                                                     const message_hash_type& hash_of_message_to_cache,
+                                                     const message_propagation_data& propagation_data,
+                                                     const message_hash_type& message_content_hash )
+  {
+    auto inserted = _messages.emplace( hash_of_message_to_cache, message_info() );
+    if( !inserted.second )
+      return;
+
+    if( _buckets.empty() || _buckets.back().block_clock != _block_clock )
+    {
+      _buckets.emplace_back();
+      _buckets.back().block_clock = _block_clock;
+    }
+    block_bucket& bucket = _buckets.back();
+    const message_hash_type* key = &inserted.first->first;
+
+    message_info& info = inserted.first->second;
+    info.message_body = message_to_cache;
+    // only the payload is counted in the budget
+    info.message_body.data.drop_decoded();
+    info.propagation_data = propagation_data;
+    info.message_contents_hash = message_content_hash;
+    info.bytes = message_to_cache.data.size() + sizeof(message_map::value_type) + sizeof(*key);
+    info.bucket = &bucket;
+    info.lru_position = bucket.messages.insert( bucket.messages.end(), key );
+    _bytes += info.bytes;
+
+    if( message_content_hash != message_hash_type() )
+      _messages_by_contents[message_content_hash] = key;
+
+    evict_to_budget();
+  }
+
+  message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup )
+  {
+    auto iter = _messages.find( hash_of_message_to_lookup );
+    if( iter == _messages.end() )
+    {
+      ++_misses;
+      FC_THROW_EXCEPTION( fc::key_not_found_exception, "Requested message not in cache" );
+    }
+    ++_hits;
+    // the message was used, so it is the last one of its bucket to be evicted
+    message_info& info = iter->second;
+    std::list<const message_hash_type*>& lru = info.bucket->messages;
+    lru.splice( lru.end(), lru, info.lru_position );
+    return info.message_body;
+  }
+
+  message_propagation_data blockchain_tied_message_cache::get_message_propagation_data(
+        const message_hash_type& hash_of_msg_contents_to_lookup )
+  {
+    if( hash_of_msg_contents_to_lookup != message_hash_type() )
+    {
+      auto iter = _messages_by_contents.find( hash_of_msg_contents_to_lookup );
+      if( iter != _messages_by_contents.end() )
+        return _messages.find( *iter->second )->second.propagation_data;
+    }
+    FC_THROW_EXCEPTION( fc::key_not_found_exception, "Requested message not in cache" );
+  }
+
+  void blockchain_tied_message_cache::set_max_bytes( uint64_t max_bytes )
+  {
+    _max_bytes = max_bytes;
+    evict_to_budget();
+  }
+
+  message_cache_statistics blockchain_tied_message_cache::get_statistics()const
+  {
+    message_cache_statistics result;
+    result.messages = static_cast<uint32_t>( _messages.size() );
+    result.bytes = _bytes;
+    result.max_bytes = _max_bytes;
+    result.hits = _hits;
+    result.misses = _misses;
+    result.evictions = _evictions;
+    result.expirations = _expirations;
+    return result;
+  }
+
+  void blockchain_tied_message_cache::erase( const message_hash_type& hash_of_message )
+  {
+    auto iter = _messages.find( hash_of_message );
+    if( iter == _messages.end() )
+      return;
+    const message_info& info = iter->second;
+
+    auto by_contents = _messages_by_contents.find( info.message_contents_hash );
+    if( by_contents != _messages_by_contents.end() && by_contents->second == &iter->first )
+      _messages_by_contents.erase( by_contents );
+
+    info.bucket->messages.erase( info.lru_position );
+    _bytes -= info.bytes;
+    _messages.erase( iter );
+  }
+
+  void blockchain_tied_message_cache::evict_to_budget()
+  {
+    // one message is always kept, even if it doesn't fit in the budget on its own
+    while( _bytes > _max_bytes && _messages.size() > 1 )
+    {
+      block_bucket& oldest = _buckets.front();
+      if( oldest.messages.empty() )
+      {
+        _buckets.pop_front();
+        continue;
+      }
+      erase( *oldest.messages.front() );
+      ++_evictions;
+    }
+    while( !_buckets.empty() && _buckets.front().messages.empty() )
+      _buckets.pop_front();
+  }
+
+} } // graphene::net
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/net/message_io_pool.hpp>
+
+#include <fc/exception/exception.hpp>
+
+namespace graphene { namespace net {
+
+  message_io_pool::message_io_pool( uint16_t num_threads, decoder_type decoder )
+    : _decoder( std::move( decoder ) )
+  {
+    FC_ASSERT( num_threads > 0, "A message I/O pool needs at least one thread" );
+    _threads.reserve( num_threads );
+    for( uint16_t i = 0; i < num_threads; ++i )
+      _threads.emplace_back( std::make_unique<fc::thread>( "p2p_io_" + std::to_string( i ) ) );
+  }
+
+  message_io_pool::~message_io_pool()
+  {
+    // the fc::thread destructors quit the threads
+  }
+
+  fc::thread& message_io_pool::next_thread()
+  {
+    return *_threads[ _next_thread++ % _threads.size() ];
+  }
+
+  message message_io_pool::prepare_message( const message_header& header, std::vector<char>&& payload )
+  {
+    const fc::time_point start = fc::time_point::now();
+    const message_hash_type id = fc::ripemd160::hash( payload.data(), (uint32_t)payload.size() );
+    std::shared_ptr<const void> decoded;
+    if( _decoder )
+    {
+      try
+      {
+        decoded = _decoder( header.msg_type.value(), payload.data(), payload.size() );
+      }
+      catch( const fc::exception& )
+      {
+        // leave it to the node thread to decode it again and report the error
+      }
+    }
+    ++_messages_prepared;
+    _bytes_prepared += payload.size();
+    _prepare_us += ( fc::time_point::now() - start ).count();
+
+    message result;
+    result.size = header.size;
+    result.msg_type = header.msg_type;
+    result.data = message_buffer( std::move( payload ), id, std::move( decoded ) );
+    return result;
+  }
+
+  message_io_statistics message_io_pool::get_statistics()const
+  {
+    message_io_statistics statistics;
+    statistics.threads = static_cast<uint32_t>( _threads.size() );
+    statistics.messages_prepared = _messages_prepared.load();
+    statistics.bytes_prepared = _bytes_prepared.load();
+    statistics.prepare_us = _prepare_us.load();
+    return statistics;
+  }
+
+} } // graphene::net
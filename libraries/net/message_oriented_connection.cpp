@@ -28,11 +28,16 @@
 #include <fc/log/logger.hpp>
 #include <fc/io/enum_type.hpp>
 
+#include <graphene/net/message_io_pool.hpp>
 #include <graphene/net/message_oriented_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
 #include <graphene/net/config.hpp>
 
+#include <boost/lockfree/spsc_queue.hpp>
+
+#include <algorithm>
 #include <atomic>
+#include <memory>
 
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
@@ -56,7 +61,7 @@ namespace graphene { namespace net {
       stcp_socket _sock;
       fc::promise<void>::ptr _ready_for_sending;
       fc::future<void> _read_loop_done;
-      uint64_t _bytes_received;
+      std::atomic<uint64_t> _bytes_received;
       uint64_t _bytes_sent;
 
       fc::time_point _connected_time;
@@ -69,8 +74,39 @@ namespace graphene { namespace net {
       fc::thread* _thread;
 #endif
 
+      /// When set, all the socket I/O of the connection runs on one thread of this pool, so that no two threads
+      /// use the socket at the same time.  The messages read there are passed to the delegate by the delivery
+      /// loop, on the thread which owns the connection
+      /// @{
+      message_io_pool* _io_pool;
+      fc::thread* _io_thread = nullptr;
+      fc::future<size_t> _write_done;
+      fc::future<void> _delivery_loop_done;
+      /// Messages read and not yet passed to the delegate, a null entry means the connection was closed
+      boost::lockfree::spsc_queue<message*, boost::lockfree::capacity<GRAPHENE_NET_MAX_UNDELIVERED_MESSAGES>>
+                       _received_messages;
+      /// The promises are published and taken with atomic operations, see @ref prepare_wait and @ref wake_up
+      std::atomic_bool _delivery_loop_waiting;
+      fc::promise<void>::ptr _messages_available;
+      /// Set while the read loop waits for the delivery loop to make room in the queue
+      std::atomic_bool _read_loop_waiting;
+      fc::promise<void>::ptr _queue_space_available;
+      std::atomic_bool _destroying;
+      /// @}
+
+      /// Publishes a new promise in @p waiter and sets @p waiting, returns the promise to wait on
+      static fc::promise<void>::ptr prepare_wait( std::atomic_bool& waiting, fc::promise<void>::ptr& waiter,
+                                                  const char* desc );
+      /// If @p waiting is set, clears it and fulfils the promise published in @p waiter.  The promise is taken
+      /// out of the member first, so the woken task may publish the next one at any time
+      static void wake_up( std::atomic_bool& waiting, fc::promise<void>::ptr& waiter );
+
       void read_loop();
       void start_read_loop();
+      void queue_received_message( std::unique_ptr<message> received_message );
+      void delivery_loop();
+      /// Writes a message to the socket, returns the number of bytes written
+      size_t write_message( const message& message_to_send );
     public:
       fc::tcp_socket& get_socket();
       void accept();
@@ -78,7 +114,8 @@ namespace graphene { namespace net {
       void bind(const fc::ip::endpoint& local_endpoint);
 
       message_oriented_connection_impl(message_oriented_connection* self,
-                                       message_oriented_connection_delegate* delegate = nullptr);
+                                       message_oriented_connection_delegate* delegate = nullptr,
+                                       message_io_pool* io_pool = nullptr);
       ~message_oriented_connection_impl();
 
       void send_message(const message& message_to_send);
@@ -95,7 +132,8 @@ namespace graphene { namespace net {
     };
 
     message_oriented_connection_impl::message_oriented_connection_impl(message_oriented_connection* self,
-                                                                       message_oriented_connection_delegate* delegate)
+                                                                       message_oriented_connection_delegate* delegate,
+                                                                       message_io_pool* io_pool)
     : _self(self),
       _delegate(delegate),
       _ready_for_sending(fc::promise<void>::create()),
@@ -106,6 +144,10 @@ namespace graphene { namespace net {
 #ifndef NDEBUG
       ,_thread(&fc::thread::current())
 #endif
+      ,_io_pool(io_pool)
+      ,_delivery_loop_waiting(false)
+      ,_read_loop_waiting(false)
+      ,_destroying(false)
     {
     }
     message_oriented_connection_impl::~message_oriented_connection_impl()
@@ -124,8 +166,7 @@ namespace graphene { namespace net {
     {
       VERIFY_CORRECT_THREAD();
       _sock.accept();
-      assert(!_read_loop_done.valid()); // check to be sure we never launch two read loops
-      _read_loop_done = fc::async([=](){ read_loop(); }, "message read_loop");
+      start_read_loop();
       _ready_for_sending->set_value();
     }
 
@@ -133,8 +174,7 @@ namespace graphene { namespace net {
     {
       VERIFY_CORRECT_THREAD();
       _sock.connect_to(remote_endpoint);
-      assert(!_read_loop_done.valid()); // check to be sure we never launch two read loops
-      _read_loop_done = fc::async([=](){ read_loop(); }, "message read_loop");
+      start_read_loop();
       _ready_for_sending->set_value();
     }
 
@@ -159,17 +199,110 @@ namespace graphene { namespace net {
       }
     };
 
-    void message_oriented_connection_impl::read_loop()
+    void message_oriented_connection_impl::start_read_loop()
     {
       VERIFY_CORRECT_THREAD();
+      assert(!_read_loop_done.valid()); // check to be sure we never launch two read loops
+      _connected_time = fc::time_point::now();
+      if( _io_pool )
+      {
+        _io_thread = &_io_pool->next_thread();
+        _read_loop_done = _io_thread->async([=](){ read_loop(); }, "message read_loop");
+        _delivery_loop_done = fc::async([=](){ delivery_loop(); }, "message delivery_loop");
+      }
+      else
+        _read_loop_done = fc::async([=](){ read_loop(); }, "message read_loop");
+    }
+
+    fc::promise<void>::ptr message_oriented_connection_impl::prepare_wait( std::atomic_bool& waiting,
+                                                                          fc::promise<void>::ptr& waiter,
+                                                                          const char* desc )
+    {
+      fc::promise<void>::ptr result = fc::promise<void>::create( desc );
+      std::atomic_store( &waiter, result );
+      waiting = true;
+      return result;
+    }
+
+    void message_oriented_connection_impl::wake_up( std::atomic_bool& waiting, fc::promise<void>::ptr& waiter )
+    {
+      if( !waiting.exchange( false ) )
+        return;
+      fc::promise<void>::ptr promise = std::atomic_exchange( &waiter, fc::promise<void>::ptr() );
+      if( promise )
+        promise->set_value();
+    }
+
+    // runs on the I/O thread
+    void message_oriented_connection_impl::queue_received_message( std::unique_ptr<message> received_message )
+    {
+      // when the queue is full, stop reading until the owning thread catches up
+      while( !_received_messages.push( received_message.get() ) )
+      {
+        fc::promise<void>::ptr space_available = prepare_wait( _read_loop_waiting, _queue_space_available,
+                                                               "graphene::net::queue_space_available" );
+        // room may have been made before the flag was set, in that case go on unless the owning thread is
+        // already waking us up
+        if( _received_messages.write_available() > 0 && _read_loop_waiting.exchange( false ) )
+          continue;
+        if( _destroying )
+          FC_THROW_EXCEPTION( fc::canceled_exception, "connection is being destroyed" );
+        space_available->wait();
+      }
+      received_message.release();
+      wake_up( _delivery_loop_waiting, _messages_available );
+    }
+
+    void message_oriented_connection_impl::delivery_loop()
+    {
+      VERIFY_CORRECT_THREAD();
+      while( !_delivery_loop_done.canceled() )
+      {
+        message* received_message = nullptr;
+        if( !_received_messages.pop( received_message ) )
+        {
+          fc::promise<void>::ptr messages_available = prepare_wait( _delivery_loop_waiting, _messages_available,
+                                                                    "graphene::net::messages_available" );
+          // a message may have arrived before the flag was set, in that case go on unless the I/O thread is
+          // already waking us up
+          if( _received_messages.read_available() > 0 && _delivery_loop_waiting.exchange( false ) )
+            continue;
+          messages_available->wait();
+          continue;
+        }
+        if( received_message == nullptr )
+        {
+          _delegate->on_connection_closed( _self );
+          return;
+        }
+
+        wake_up( _read_loop_waiting, _queue_space_available );
+        std::unique_ptr<message> message_holder( received_message );
+        _last_message_received_time = fc::time_point::now();
+        try
+        {
+          _delegate->on_message( _self, *received_message );
+        }
+        catch ( const fc::canceled_exception& ) { throw; }
+        catch ( const fc::exception& e )
+        {
+          elog( "disconnected ${er}", ("er", e.to_detail_string() ) );
+          _delegate->on_connection_closed( _self );
+          return;
+        }
+      }
+    }
+
+    void message_oriented_connection_impl::read_loop()
+    {
+      if( !_io_pool )
+        VERIFY_CORRECT_THREAD();
       const int BUFFER_SIZE = 16;
       const int LEFTOVER = BUFFER_SIZE - sizeof(message_header);
       static_assert(BUFFER_SIZE >= sizeof(message_header), "insufficient buffer");
 
       no_parallel_execution_guard guard( &_read_loop_in_progress );
 
-      _connected_time = fc::time_point::now();
-
       fc::oexception exception_to_rethrow;
       bool call_on_connection_closed = false;
 
@@ -185,14 +318,20 @@ namespace graphene { namespace net {
           FC_ASSERT( m.size.value() <= MAX_MESSAGE_SIZE, "", ("m.size",m.size.value())("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
 
           size_t remaining_bytes_with_padding = 16 * ((m.size.value() - LEFTOVER + 15) / 16);
-          m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
-          std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
+          std::vector<char> data(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
+          std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), data.begin());
           if (remaining_bytes_with_padding)
           {
-            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
+            _sock.read(&data[LEFTOVER], remaining_bytes_with_padding);
             _bytes_received += remaining_bytes_with_padding;
           }
-          m.data.resize(m.size.value()); // truncate off the padding bytes
+          data.resize(m.size.value()); // truncate off the padding bytes
+          if( _io_pool )
+          {
+            queue_received_message( std::make_unique<message>( _io_pool->prepare_message( m, std::move(data) ) ) );
+            continue;
+          }
+          m.data = std::move(data);
 
           _last_message_received_time = fc::time_point::now();
 
@@ -242,7 +381,12 @@ namespace graphene { namespace net {
       }
 
       if (call_on_connection_closed)
-        _delegate->on_connection_closed(_self);
+      {
+        if( _io_pool )
+          queue_received_message( std::unique_ptr<message>() );
+        else
+          _delegate->on_connection_closed(_self);
+      }
 
       if (exception_to_rethrow)
         throw *exception_to_rethrow;
@@ -268,29 +412,67 @@ namespace graphene { namespace net {
 
       try
       {
-        size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size.value();
-        if( message_to_send.size.value() > MAX_MESSAGE_SIZE )
-           elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
-        //pad the message we send to a multiple of 16 bytes
-        size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::vector<char> padded_message( size_with_padding );
-
-        memcpy( padded_message.data(), (const char*)&message_to_send, sizeof(message_header) );
-        memcpy( padded_message.data() + sizeof(message_header), message_to_send.data.data(),
-                message_to_send.size.value() );
-        char* padding_space = padded_message.data() + sizeof(message_header) + message_to_send.size.value();
-        memset(padding_space, 0, size_with_padding - size_of_message_and_header);
-        _sock.write( padded_message.data(), size_with_padding );
-        _sock.flush();
-        _bytes_sent += size_with_padding;
+        size_t bytes_written = 0;
+        if( _io_thread )
+        {
+          // the write holds its own copy of the message, which shares the payload, in case the caller is
+          // canceled while waiting for it
+          const message message_copy( message_to_send );
+          _write_done = _io_thread->async( [this, message_copy]() { return write_message( message_copy ); },
+                                           "message write" );
+          bytes_written = _write_done.wait();
+        }
+        else
+          bytes_written = write_message( message_to_send );
+        _bytes_sent += bytes_written;
         _last_message_sent_time = fc::time_point::now();
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" )
     }
 
+    size_t message_oriented_connection_impl::write_message( const message& message_to_send )
+    {
+      const size_t message_size = message_to_send.size.value();
+      size_t size_of_message_and_header = sizeof(message_header) + message_size;
+      if( message_size > MAX_MESSAGE_SIZE )
+         elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
+      //pad the message we send to a multiple of 16 bytes
+      size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
+
+      // The socket encrypts whole 16 byte blocks.  Only the first block, which holds the header, and the
+      // padded last block are assembled here, everything in between is encrypted straight from the payload,
+      // which may be shared with the other peers the message is sent to
+      const int BLOCK_SIZE = 16;
+      const char* payload = message_to_send.data.data();
+      char first_block[BLOCK_SIZE] = {};
+      memcpy( first_block, (const char*)&message_to_send, sizeof(message_header) );
+      const size_t payload_in_first_block = std::min<size_t>( message_size, BLOCK_SIZE - sizeof(message_header) );
+      if( payload_in_first_block > 0 )
+         memcpy( first_block + sizeof(message_header), payload, payload_in_first_block );
+      _sock.write( first_block, BLOCK_SIZE );
+
+      const size_t payload_left = message_size - payload_in_first_block;
+      const size_t payload_in_full_blocks = payload_left - payload_left % BLOCK_SIZE;
+      if( payload_in_full_blocks > 0 )
+         _sock.write( payload + payload_in_first_block, payload_in_full_blocks );
+
+      if( payload_left > payload_in_full_blocks )
+      {
+         char last_block[BLOCK_SIZE] = {};
+         memcpy( last_block, payload + payload_in_first_block + payload_in_full_blocks,
+                 payload_left - payload_in_full_blocks );
+         _sock.write( last_block, BLOCK_SIZE );
+      }
+      _sock.flush();
+      return size_with_padding;
+    }
+
     void message_oriented_connection_impl::close_connection()
     {
       VERIFY_CORRECT_THREAD();
-      _sock.close();
+      if( _io_thread )
+        _io_thread->async( [this]() { _sock.close(); }, "message close_connection" ).wait();
+      else
+        _sock.close();
     }
 
     void message_oriented_connection_impl::destroy_connection()
@@ -307,8 +489,12 @@ namespace graphene { namespace net {
              "The task calling send_message() should have been canceled already");
       assert(!_send_message_in_progress);
 
+      _destroying = true;
       try
       {
+        _read_loop_done.cancel(__FUNCTION__);
+        // cancel() doesn't wake up a read loop waiting for room in the queue
+        wake_up( _read_loop_waiting, _queue_space_available );
         _read_loop_done.cancel_and_wait(__FUNCTION__);
       }
       catch ( const fc::exception& e )
@@ -319,6 +505,45 @@ namespace graphene { namespace net {
       {
         wlog( "Exception thrown while canceling message_oriented_connection's read_loop, ignoring" );
       }
+
+      // a write left behind by a canceled send_message still uses the socket, closing it makes the write fail
+      if( _write_done.valid() && !_write_done.ready() )
+      {
+        try
+        {
+          _io_thread->async( [this]() { _sock.close(); }, "message close_connection" ).wait();
+          _write_done.wait();
+        }
+        catch ( const fc::exception& e )
+        {
+          dlog( "Pending write failed while destroying the connection: ${e}", ("e",e) );
+        }
+      }
+
+      if( _delivery_loop_done.valid() )
+      {
+        try
+        {
+          _delivery_loop_done.cancel(__FUNCTION__);
+          // cancel() doesn't wake up a task waiting on a promise
+          wake_up( _delivery_loop_waiting, _messages_available );
+          _delivery_loop_done.wait();
+        }
+        catch ( const fc::canceled_exception& )
+        {
+        }
+        catch ( const fc::exception& e )
+        {
+          wlog( "Exception thrown while canceling message_oriented_connection's delivery_loop, ignoring: ${e}", ("e",e) );
+        }
+        catch (...)
+        {
+          wlog( "Exception thrown while canceling message_oriented_connection's delivery_loop, ignoring" );
+        }
+        message* undelivered_message = nullptr;
+        while( _received_messages.pop( undelivered_message ) )
+          delete undelivered_message;
+      }
       _ready_for_sending->set_exception( std::make_shared<fc::canceled_exception>() );
     }
 
@@ -355,8 +580,9 @@ namespace graphene { namespace net {
   } // end namespace graphene::net::detail
 
 
-  message_oriented_connection::message_oriented_connection(message_oriented_connection_delegate* delegate) :
-    my( std::make_unique<detail::message_oriented_connection_impl>(this, delegate) )
+  message_oriented_connection::message_oriented_connection(message_oriented_connection_delegate* delegate,
+                                                           message_io_pool* io_pool) :
+    my( std::make_unique<detail::message_oriented_connection_impl>(this, delegate, io_pool) )
   {
   }
 
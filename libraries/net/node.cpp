@@ -93,48 +93,18 @@
 
 namespace graphene { namespace net { namespace detail {
 
-   void blockchain_tied_message_cache::block_accepted()
+   void advertise_inventory_statistics::record( size_t items_taken, size_t items_advertised,
+                                                const fc::microseconds& elapsed )
    {
-      ++block_clock;
-      if( block_clock > cache_duration_in_blocks )
-         _message_cache.get<block_clock_index>().erase(_message_cache.get<block_clock_index>().begin(),
-               _message_cache.get<block_clock_index>().lower_bound(block_clock - cache_duration_in_blocks ) );
+      const uint64_t us = elapsed.count();
+      ++iterations;
+      items += items_taken;
+      advertisements += items_advertised;
+      total_us += us;
+      max_us = std::max( max_us, us );
+      last_us = us;
    }
 
-   void blockchain_tied_message_cache::cache_message( const message& message_to_cache,
-                                                      const message_hash_type& hash_of_message_to_cache,
-                                                      const message_propagation_data& propagation_data,
-                                                      const message_hash_type& message_content_hash )
-   {
-      _message_cache.insert( message_info(hash_of_message_to_cache,
-                                         message_to_cache,
-                                         block_clock,
-                                         propagation_data,
-                                         message_content_hash ) );
-   }
-
-   message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup ) const
-   {
-      message_cache_container::index<message_hash_index>::type::const_iterator iter =
-         _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
-      if( iter != _message_cache.get<message_hash_index>().end() )
-         return iter->message_body;
-      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
-   }
-
-    message_propagation_data blockchain_tied_message_cache::get_message_propagation_data(
-             const message_hash_type& hash_of_msg_contents_to_lookup ) const
-    {
-      if( hash_of_msg_contents_to_lookup != message_hash_type() )
-      {
-        message_cache_container::index<message_contents_hash_index>::type::const_iterator iter =
-           _message_cache.get<message_contents_hash_index>().find(hash_of_msg_contents_to_lookup );
-        if( iter != _message_cache.get<message_contents_hash_index>().end() )
-          return iter->propagation_data;
-      }
-      FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
-    }
-
     void node_impl_deleter::operator()(node_impl* impl_to_delete)
     {
 #ifdef P2P_IN_DEDICATED_THREAD
@@ -175,8 +145,7 @@ namespace graphene { namespace net { namespace detail {
       _node_is_shutting_down = true;
 
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& active_peer : _active_connections)
+         for (const peer_connection_ptr& active_peer : _active_connections.snapshot())
          {
             fc::optional<fc::ip::endpoint> inbound_endpoint = active_peer->get_endpoint_for_connecting();
             if (inbound_endpoint)
@@ -402,7 +371,62 @@ namespace graphene { namespace net { namespace detail {
         peer->last_sync_item_received_time = fc::time_point::now();
         peer->sync_items_requested_from_peer.insert(item_to_request);
       }
-      peer->send_message(fetch_items_message(graphene::net::block_message_type, items_to_request));
+
+      if( !_block_range_sync_enabled || !( peer->features & block_range_sync_feature ) ||
+          peer->inhibit_block_range_requests )
+      {
+        peer->send_message(fetch_items_message(graphene::net::block_message_type, items_to_request));
+        return;
+      }
+
+      // the items are usually consecutive blocks of the peer's chain, ask for each run of consecutive block
+      // numbers with a single range request which the peer can answer straight from its block database
+      std::vector<item_hash_t> range_to_request;
+      for (const item_hash_t& item_to_request : items_to_request)
+      {
+        if( !range_to_request.empty() &&
+            graphene::protocol::block_header::num_from_id(item_to_request)
+                  != graphene::protocol::block_header::num_from_id(range_to_request.back()) + 1 )
+        {
+          request_sync_block_range_from_peer(peer, range_to_request);
+          range_to_request.clear();
+        }
+        range_to_request.push_back(item_to_request);
+      }
+      if( !range_to_request.empty() )
+        request_sync_block_range_from_peer(peer, range_to_request);
+    }
+
+    void node_impl::request_sync_block_range_from_peer( const peer_connection_ptr& peer,
+                                                        const std::vector<item_hash_t>& range_to_request )
+    {
+      VERIFY_CORRECT_THREAD();
+      const uint32_t first_block_num = graphene::protocol::block_header::num_from_id(range_to_request.front());
+      // replies are matched to requests by their first block number, there can't be two requests for one
+      if( peer->block_ranges_requested_from_peer.find(first_block_num) != peer->block_ranges_requested_from_peer.end() )
+      {
+        peer->send_message(fetch_items_message(graphene::net::block_message_type, range_to_request));
+        return;
+      }
+      const block_range_codec codec = ( _compress_block_ranges && ( peer->features & zlib_block_ranges_feature ) ) ?
+                                      block_range_codec::zlib : block_range_codec::uncompressed;
+      peer->block_ranges_requested_from_peer[first_block_num] = range_to_request;
+      peer->send_message(fetch_block_range_message(first_block_num, range_to_request.size(), codec));
+    }
+
+    void node_impl::continue_syncing_with_peer( peer_connection* peer )
+    {
+      VERIFY_CORRECT_THREAD();
+      if (peer->idle())
+      {
+        // we have finished fetching a batch of items, so we either need to grab another batch of items
+        // or we need to get another list of item ids.
+        if (peer->number_of_unfetched_item_ids > 0 &&
+            peer->ids_of_items_to_get.size() < GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH)
+          fetch_next_batch_of_item_ids_from_peer(peer);
+        else
+          trigger_fetch_sync_items_loop();
+      }
     }
 
     void node_impl::fetch_sync_items_loop()
@@ -421,8 +445,7 @@ namespace graphene { namespace net { namespace detail {
             std::set<item_hash_t> sync_items_to_request;
 
             // for each idle peer that we're syncing with
-            fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-            for( const peer_connection_ptr& peer : _active_connections )
+            for( const peer_connection_ptr& peer : _active_connections.snapshot() )
             {
               if( peer->we_need_sync_items_from_peer &&
                   // if we've already scheduled a request for this peer, don't consider scheduling another
@@ -485,10 +508,9 @@ namespace graphene { namespace net { namespace detail {
 
     bool node_impl::is_item_in_any_peers_inventory(const item_id& item) const
     {
-      fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-      for( const peer_connection_ptr& peer : _active_connections )
+      for( const peer_connection_ptr& peer : _active_connections.snapshot() )
       {
-        if (peer->inventory_peer_advertised_to_us.find(item) != peer->inventory_peer_advertised_to_us.end() )
+        if (peer->inventory_peer_advertised_to_us.contains(item))
           return true;
       }
       return false;
@@ -529,8 +551,7 @@ namespace graphene { namespace net { namespace detail {
 
         // initialize the fetch_messages_to_send with an empty set of items for all idle peers
         {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& peer : _active_connections)
+         for (const peer_connection_ptr& peer : _active_connections.snapshot())
             if (peer->idle())
                items_by_peer.insert(peer_and_items_to_fetch(peer));
         }
@@ -557,7 +578,7 @@ namespace graphene { namespace net { namespace detail {
               const peer_connection_ptr& peer = peer_iter->peer;
               // if they have the item and we haven't already decided to ask them for too many other items
               if (peer_iter->item_ids.size() < GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION &&
-                  peer->inventory_peer_advertised_to_us.find(item_iter->item) != peer->inventory_peer_advertised_to_us.end())
+                  peer->inventory_peer_advertised_to_us.contains(item_iter->item))
               {
                 if (item_iter->item.item_type == graphene::net::trx_message_type && peer->is_transaction_fetching_inhibited())
                   next_peer_unblocked_time = std::min(peer->transaction_fetching_inhibited_until, next_peer_unblocked_time);
@@ -637,67 +658,73 @@ namespace graphene { namespace net { namespace detail {
       while (!_advertise_inventory_loop_done.canceled())
       {
         dlog("beginning an iteration of advertise inventory");
+        const fc::time_point iteration_start = fc::time_point::now();
         // swap inventory into local variable, clearing the node's copy
         std::unordered_set<item_id> inventory_to_advertise;
         _new_inventory.swap( inventory_to_advertise );
 
+        // fingerprint the items once for all peers, grouped by type, because we'll need to send one
+        // inventory message per type
+        struct item_to_advertise
+        {
+          item_id item;
+          rolling_inventory_filter::fingerprint_type fingerprint;
+        };
+        std::vector<item_to_advertise> items_to_advertise;
+        items_to_advertise.reserve( inventory_to_advertise.size() );
+        for( const item_id& item : inventory_to_advertise )
+          items_to_advertise.push_back( { item, rolling_inventory_filter::fingerprint( item.item_hash ) } );
+        std::sort( items_to_advertise.begin(), items_to_advertise.end(),
+                   []( const item_to_advertise& a, const item_to_advertise& b ) {
+                      return a.item.item_type < b.item.item_type;
+                   } );
+        dlog("advertising ${count} new item(s)", ("count", items_to_advertise.size()));
+
         // process all inventory to advertise and construct the inventory messages we'll send
         // first, then send them all in a batch (to avoid any fiber interruption points while
         // we're computing the messages)
         std::list<std::pair<peer_connection_ptr, item_ids_inventory_message> > inventory_messages_to_send;
+        size_t total_advertisements = 0;
         {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& peer : _active_connections)
+         for (const peer_connection_ptr& peer : _active_connections.snapshot())
          {
+          peer->clear_old_inventory();
           // only advertise to peers who are in sync with us
-          idump((peer->peer_needs_sync_items_from_us));
-          if( !peer->peer_needs_sync_items_from_us )
+          if( !peer->peer_needs_sync_items_from_us && !items_to_advertise.empty() )
           {
-            std::map<uint32_t, std::vector<item_hash_t> > items_to_advertise_by_type;
             // don't send the peer anything we've already advertised to it
             // or anything it has advertised to us
-            // group the items we need to send by type, because we'll need to send one inventory message per type
             size_t total_items_to_send = 0;
-            idump((inventory_to_advertise));
-            for (const item_id& item_to_advertise : inventory_to_advertise)
+            std::vector<item_hash_t> items_of_type;
+            for( auto itr = items_to_advertise.begin(); itr != items_to_advertise.end(); ++itr )
             {
-               auto adv_to_peer = peer->inventory_advertised_to_peer.find(item_to_advertise);
-               auto adv_to_us   = peer->inventory_peer_advertised_to_us.find(item_to_advertise);
-
-              if (adv_to_peer == peer->inventory_advertised_to_peer.end() &&
-                  adv_to_us == peer->inventory_peer_advertised_to_us.end())
+              if( !peer->inventory_advertised_to_peer.contains( itr->fingerprint )
+                  && !peer->inventory_peer_advertised_to_us.contains( itr->fingerprint ) )
               {
-                items_to_advertise_by_type[item_to_advertise.item_type].push_back(item_to_advertise.item_hash);
-                peer->inventory_advertised_to_peer.insert(
-                         peer_connection::timestamped_item_id(item_to_advertise, fc::time_point::now()));
-                ++total_items_to_send;
-                if (item_to_advertise.item_type == trx_message_type)
+                peer->inventory_advertised_to_peer.insert( itr->fingerprint, iteration_start );
+                items_of_type.push_back( itr->item.item_hash );
+                if (itr->item.item_type == trx_message_type)
                   testnetlog("advertising transaction ${id} to peer ${endpoint}",
-                             ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
-                dlog("advertising item ${id} to peer ${endpoint}",
-                     ("id", item_to_advertise.item_hash)("endpoint", peer->get_remote_endpoint()));
+                             ("id", itr->item.item_hash)("endpoint", peer->get_remote_endpoint()));
               }
-              else
+              auto next = std::next( itr );
+              if( !items_of_type.empty() && ( next == items_to_advertise.end()
+                                              || next->item.item_type != itr->item.item_type ) )
               {
-                 if (adv_to_peer != peer->inventory_advertised_to_peer.end() )
-                    idump( (*adv_to_peer) );
-                 if (adv_to_us != peer->inventory_peer_advertised_to_us.end() )
-                    idump( (*adv_to_us) );
+                total_items_to_send += items_of_type.size();
+                inventory_messages_to_send.emplace_back( std::make_pair(
+                      peer, item_ids_inventory_message( itr->item.item_type, items_of_type ) ) );
+                items_of_type.clear();
               }
             }
-              dlog("advertising ${count} new item(s) of ${types} type(s) to peer ${endpoint}",
-                   ("count", total_items_to_send)
-                   ("types", items_to_advertise_by_type.size())
-                   ("endpoint", peer->get_remote_endpoint()));
-            for (auto items_group : items_to_advertise_by_type)
-            {
-               inventory_messages_to_send.emplace_back(std::make_pair(
-                     peer, item_ids_inventory_message(items_group.first, items_group.second)));
-            }
+            dlog("advertising ${count} of the new item(s) to peer ${endpoint}",
+                 ("count", total_items_to_send)("endpoint", peer->get_remote_endpoint()));
+            total_advertisements += total_items_to_send;
           }
-          peer->clear_old_inventory();
          }
-        } // lock_guard
+        }
+        _advertise_inventory_stats.record( items_to_advertise.size(), total_advertisements,
+                                           fc::time_point::now() - iteration_start );
 
         for (auto iter = inventory_messages_to_send.begin(); iter != inventory_messages_to_send.end(); ++iter)
           iter->first->send_message(iter->second);
@@ -720,6 +747,50 @@ namespace graphene { namespace net { namespace detail {
         _retrigger_advertise_inventory_loop_promise->set_value();
     }
 
+    void node_impl::process_relayed_transactions_loop()
+    {
+      VERIFY_CORRECT_THREAD();
+      while (!_process_relayed_transactions_loop_done.canceled())
+      {
+        fc::optional<transaction_relay_scheduler::queued_transaction> next_trx = _transaction_relay_scheduler.pop();
+        if (next_trx)
+        {
+          {
+            // counted with the time spent queueing the message when it was received
+            handler_timer handling_timer( _message_handling_stats[next_trx->message_received.msg_type.value()].handler_us );
+            handle_ordinary_message( next_trx->message_received, next_trx->message_hash, next_trx->originating_node,
+                                     next_trx->originating_endpoint, next_trx->received_time );
+          }
+          // let the other tasks run, the queue may hold thousands of transactions
+          fc::yield();
+          continue;
+        }
+
+        // nothing is ready: wait until a transaction arrives or a peer with queued transactions gets its next token
+        _retrigger_relayed_transactions_loop_promise
+              = fc::promise<void>::create("graphene::net::retrigger_relayed_transactions_loop");
+        const fc::time_point ready_time = _transaction_relay_scheduler.next_ready_time();
+        try
+        {
+          if (ready_time == fc::time_point::maximum())
+            _retrigger_relayed_transactions_loop_promise->wait();
+          else
+            _retrigger_relayed_transactions_loop_promise->wait_until(ready_time);
+        }
+        catch (const fc::timeout_exception&)
+        {
+        }
+        _retrigger_relayed_transactions_loop_promise.reset();
+      } // while !canceled
+    }
+
+    void node_impl::trigger_process_relayed_transactions_loop()
+    {
+      VERIFY_CORRECT_THREAD();
+      if( _retrigger_relayed_transactions_loop_promise )
+        _retrigger_relayed_transactions_loop_promise->set_value();
+    }
+
     void node_impl::kill_inactive_conns_loop(node_impl_ptr self)
     {
       VERIFY_CORRECT_THREAD();
@@ -748,8 +819,7 @@ namespace graphene { namespace net { namespace detail {
       uint32_t handshaking_timeout = _peer_inactivity_timeout;
       fc::time_point handshaking_disconnect_threshold = fc::time_point::now() - fc::seconds(handshaking_timeout);
       {
-         fc::scoped_lock<fc::mutex> lock(_handshaking_connections.get_mutex());
-         for( const peer_connection_ptr& handshaking_peer : _handshaking_connections )
+         for( const peer_connection_ptr& handshaking_peer : _handshaking_connections.snapshot() )
          {
             if( handshaking_peer->connection_initiation_time < handshaking_disconnect_threshold &&
                   handshaking_peer->get_last_message_received_time() < handshaking_disconnect_threshold &&
@@ -771,7 +841,7 @@ namespace graphene { namespace net { namespace detail {
                peers_to_disconnect_forcibly.push_back( handshaking_peer );
             } // if
          } // for
-      } // scoped_lock
+      }
       // timeout for any active peers is two block intervals
       uint32_t active_disconnect_timeout = 10 * _recent_block_interval_seconds;
       uint32_t active_send_keepalive_timeout = active_disconnect_timeout / 2;
@@ -790,9 +860,7 @@ namespace graphene { namespace net { namespace detail {
       fc::time_point active_send_keepalive_threshold = fc::time_point::now() - fc::seconds(active_send_keepalive_timeout);
       fc::time_point active_ignored_request_threshold = fc::time_point::now() - active_ignored_request_timeout;
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-
-         for( const peer_connection_ptr& active_peer : _active_connections )
+         for( const peer_connection_ptr& active_peer : _active_connections.snapshot() )
          {
             if( active_peer->connection_initiation_time < active_disconnect_threshold &&
                   active_peer->get_last_message_received_time() < active_disconnect_threshold )
@@ -859,12 +927,11 @@ namespace graphene { namespace net { namespace detail {
                }
             } // else
          } // for
-      } // scoped_lock
+      }
 
       fc::time_point closing_disconnect_threshold = fc::time_point::now() - fc::seconds(GRAPHENE_NET_PEER_DISCONNECT_TIMEOUT);
       {
-         fc::scoped_lock<fc::mutex> lock(_closing_connections.get_mutex());
-         for( const peer_connection_ptr& closing_peer : _closing_connections )
+         for( const peer_connection_ptr& closing_peer : _closing_connections.snapshot() )
          {
             if( closing_peer->connection_closed_time < closing_disconnect_threshold )
             {
@@ -875,12 +942,11 @@ namespace graphene { namespace net { namespace detail {
                peers_to_disconnect_forcibly.push_back( closing_peer );
             }
          } // for
-      } // scoped_lock
+      }
       uint32_t failed_terminate_timeout_seconds = 120;
       fc::time_point failed_terminate_threshold = fc::time_point::now() - fc::seconds(failed_terminate_timeout_seconds);
       {
-         fc::scoped_lock<fc::mutex> lock(_terminating_connections.get_mutex());
-         for (const peer_connection_ptr& peer : _terminating_connections )
+         for (const peer_connection_ptr& peer : _terminating_connections.snapshot() )
          {
             if (peer->get_connection_terminated_time() != fc::time_point::min() &&
                peer->get_connection_terminated_time() < failed_terminate_threshold)
@@ -889,7 +955,7 @@ namespace graphene { namespace net { namespace detail {
                peers_to_terminate.push_back(peer);
             }
          }
-      } // scoped_lock
+      }
       // That's the end of the sorting step; now all peers that require further processing are now in one of the
       // lists peers_to_disconnect_gently,  peers_to_disconnect_forcibly, peers_to_send_keep_alive, or peers_to_terminate
 
@@ -897,14 +963,13 @@ namespace graphene { namespace net { namespace detail {
       // and once we start yielding, we may find that we've moved that peer to another list (closed or active)
       // and that triggers assertions, maybe even errors
       {
-         fc::scoped_lock<fc::mutex> lock(_terminating_connections.get_mutex());
          for (const peer_connection_ptr& peer : peers_to_terminate )
          {
-            assert(_terminating_connections.find(peer) != _terminating_connections.end());
+            assert(_terminating_connections.contains(peer));
             _terminating_connections.erase(peer);
             schedule_peer_for_deletion(peer);
          }
-      } // scoped_lock
+      }
       peers_to_terminate.clear();
 
       // if we're going to abruptly disconnect anyone, do it here 
@@ -922,13 +987,12 @@ namespace graphene { namespace net { namespace detail {
       for( const peer_connection_ptr& peer : peers_to_disconnect_gently )
       {
          {
-            fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
             fc::exception detailed_error( FC_LOG_MESSAGE(warn, "Disconnecting due to inactivity",
                   ( "last_message_received_seconds_ago", (peer->get_last_message_received_time() 
                   - fc::time_point::now() ).count() / fc::seconds(1 ).count() )
                   ( "last_message_sent_seconds_ago", (peer->get_last_message_sent_time() 
                   - fc::time_point::now() ).count() / fc::seconds(1 ).count() )
-                  ( "inactivity_timeout", _active_connections.find(peer ) != _active_connections.end() 
+                  ( "inactivity_timeout", _active_connections.contains(peer) 
                   ? _peer_inactivity_timeout * 10 : _peer_inactivity_timeout ) ) );
             disconnect_from_peer( peer.get(), "Disconnecting due to inactivity", false, detailed_error );
          }
@@ -962,10 +1026,7 @@ namespace graphene { namespace net { namespace detail {
       VERIFY_CORRECT_THREAD();
       
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         // JMJ 2018-10-22 Unsure why we're making a copy here, but this is probably unnecessary
-         std::list<peer_connection_ptr> original_active_peers(_active_connections.begin(), _active_connections.end());
-         for( const peer_connection_ptr& active_peer : original_active_peers )
+         for( const peer_connection_ptr& active_peer : _active_connections.snapshot() )
          {
             try
             {
@@ -1085,10 +1146,10 @@ namespace graphene { namespace net { namespace detail {
     {
       VERIFY_CORRECT_THREAD();
 
-      assert(_handshaking_connections.find(peer_to_delete) == _handshaking_connections.end());
-      assert(_active_connections.find(peer_to_delete) == _active_connections.end());
-      assert(_closing_connections.find(peer_to_delete) == _closing_connections.end());
-      assert(_terminating_connections.find(peer_to_delete) == _terminating_connections.end());
+      assert(!_handshaking_connections.contains(peer_to_delete));
+      assert(!_active_connections.contains(peer_to_delete));
+      assert(!_closing_connections.contains(peer_to_delete));
+      assert(!_terminating_connections.contains(peer_to_delete));
 
 #ifdef USE_PEERS_TO_DELETE_MUTEX
       dlog("scheduling peer for deletion: ${peer} (may block on a mutex here)",
@@ -1154,14 +1215,12 @@ namespace graphene { namespace net { namespace detail {
     peer_connection_ptr node_impl::get_peer_by_node_id(const node_id_t& node_id)
     {
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& active_peer : _active_connections)
+         for (const peer_connection_ptr& active_peer : _active_connections.snapshot())
             if (node_id == active_peer->node_id)
                return active_peer;
       }
       {
-         fc::scoped_lock<fc::mutex> lock(_handshaking_connections.get_mutex());
-         for (const peer_connection_ptr& handshaking_peer : _handshaking_connections)
+         for (const peer_connection_ptr& handshaking_peer : _handshaking_connections.snapshot())
             if (node_id == handshaking_peer->node_id)
                return handshaking_peer;
       }
@@ -1177,8 +1236,7 @@ namespace graphene { namespace net { namespace detail {
         return true;
       }
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& active_peer : _active_connections)
+         for (const peer_connection_ptr& active_peer : _active_connections.snapshot())
          {
             if (node_id == active_peer->node_id)
             {
@@ -1188,8 +1246,7 @@ namespace graphene { namespace net { namespace detail {
          }
       }
       {
-         fc::scoped_lock<fc::mutex> lock(_handshaking_connections.get_mutex());
-         for (const peer_connection_ptr& handshaking_peer : _handshaking_connections)
+         for (const peer_connection_ptr& handshaking_peer : _handshaking_connections.snapshot())
             if (node_id == handshaking_peer->node_id)
             {
                dlog("is_already_connected_to_id returning true because the peer is already in our handshaking list");
@@ -1228,8 +1285,7 @@ namespace graphene { namespace net { namespace detail {
       dlog("   my id is ${id}", ("id", _node_id));
 
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& active_connection : _active_connections)
+         for (const peer_connection_ptr& active_connection : _active_connections.snapshot())
          {
             dlog("        active: ${endpoint} with ${id}   [${direction}]",
                   ("endpoint", active_connection->get_remote_endpoint())
@@ -1238,8 +1294,7 @@ namespace graphene { namespace net { namespace detail {
          }
       }
       {
-         fc::scoped_lock<fc::mutex> lock(_handshaking_connections.get_mutex());
-         for (const peer_connection_ptr& handshaking_connection : _handshaking_connections)
+         for (const peer_connection_ptr& handshaking_connection : _handshaking_connections.snapshot())
          {
             dlog("   handshaking: ${endpoint} with ${id}  [${direction}]",
                   ("endpoint", handshaking_connection->get_remote_endpoint())
@@ -1257,6 +1312,15 @@ namespace graphene { namespace net { namespace detail {
            ("type", graphene::net::core_message_type_enum(received_message.msg_type.value()))("hash", message_hash)
            ("size", received_message.size)
            ("endpoint", originating_peer->get_remote_endpoint()));
+      // messages of types we don't know are counted together, so that peers can't make the map grow
+      uint32_t handling_stats_type = received_message.msg_type.value();
+      if( handling_stats_type != trx_message_type && handling_stats_type != block_message_type &&
+          ( handling_stats_type < core_message_type_first || handling_stats_type > core_message_type_last ) )
+        handling_stats_type = 0;
+      message_handling_statistics& handling_stats = _message_handling_stats[handling_stats_type];
+      ++handling_stats.messages;
+      handling_stats.bytes += received_message.size;
+      handler_timer handling_timer( handling_stats.handler_us );
       switch ( received_message.msg_type.value() )
       {
       case core_message_type_enum::hello_message_type:
@@ -1285,6 +1349,12 @@ namespace graphene { namespace net { namespace detail {
       case core_message_type_enum::fetch_items_message_type:
         on_fetch_items_message(originating_peer, received_message.as<fetch_items_message>());
         break;
+      case core_message_type_enum::fetch_block_range_message_type:
+        on_fetch_block_range_message(originating_peer, received_message.as<fetch_block_range_message>());
+        break;
+      case core_message_type_enum::block_range_message_type:
+        on_block_range_message(originating_peer, received_message.as<block_range_message>());
+        break;
       case core_message_type_enum::item_not_available_message_type:
         on_item_not_available_message(originating_peer, received_message.as<item_not_available_message>());
         break;
@@ -1358,8 +1428,23 @@ namespace graphene { namespace net { namespace detail {
       if (!_hard_fork_block_numbers.empty())
         user_data["last_known_fork_block_number"] = _hard_fork_block_numbers.back();
 
+      user_data["features"] = get_supported_features();
+
       return user_data;
     }
+
+    uint32_t node_impl::get_supported_features() const
+    {
+      uint32_t features = 0;
+      if( _block_range_sync_enabled )
+      {
+        features |= block_range_sync_feature;
+        if( _compress_block_ranges )
+          features |= zlib_block_ranges_feature;
+      }
+      return features;
+    }
+
     void node_impl::parse_hello_user_data_for_peer(peer_connection* originating_peer, const fc::variant_object& user_data)
     {
       VERIFY_CORRECT_THREAD();
@@ -1382,6 +1467,8 @@ namespace graphene { namespace net { namespace detail {
         originating_peer->node_id = user_data["node_id"].as<node_id_t>(1);
       if (user_data.contains("last_known_fork_block_number"))
         originating_peer->last_known_fork_block_number = user_data["last_known_fork_block_number"].as<uint32_t>(1);
+      if (user_data.contains("features"))
+        originating_peer->features = user_data["features"].as<uint32_t>(1);
     }
 
     void node_impl::on_hello_message( peer_connection* originating_peer, const hello_message& hello_message_received )
@@ -1668,9 +1755,9 @@ namespace graphene { namespace net { namespace detail {
       address_message reply;
       if (!_peer_advertising_disabled)
       {
-        reply.addresses.reserve(_active_connections.size());
-        fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-        for (const peer_connection_ptr& active_peer : _active_connections)
+        const auto active_peers = _active_connections.snapshot();
+        reply.addresses.reserve(active_peers.size());
+        for (const peer_connection_ptr& active_peer : active_peers)
         {
           fc::optional<potential_peer_record> updated_peer_record = _potential_peer_db.lookup_entry_for_endpoint(*active_peer->get_remote_endpoint());
           if (updated_peer_record)
@@ -1707,7 +1794,7 @@ namespace graphene { namespace net { namespace detail {
       if (new_information_received)
         trigger_p2p_network_connect_loop();
 
-      if (_handshaking_connections.find(originating_peer->shared_from_this()) != _handshaking_connections.end())
+      if (_handshaking_connections.contains(originating_peer->shared_from_this()))
       {
         // if we were handshaking, we need to continue with the next step in handshaking (which is either
         // ending handshaking and starting synchronization or disconnecting)
@@ -1836,7 +1923,7 @@ namespace graphene { namespace net { namespace detail {
         }
 
       if (originating_peer->direction == peer_connection_direction::inbound &&
-          _handshaking_connections.find(originating_peer->shared_from_this()) != _handshaking_connections.end())
+          _handshaking_connections.contains(originating_peer->shared_from_this()))
       {
         // handshaking is done, move the connection to fully active status and start synchronizing
         dlog("peer ${endpoint} which was handshaking with us has started synchronizing with us, start syncing with it",
@@ -1860,8 +1947,7 @@ namespace graphene { namespace net { namespace detail {
     {
       VERIFY_CORRECT_THREAD();
       uint32_t max_number_of_unfetched_items = 0;
-      fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-      for( const peer_connection_ptr& peer : _active_connections )
+      for( const peer_connection_ptr& peer : _active_connections.snapshot() )
       {
         uint32_t this_peer_unfetched_items_count = (uint32_t)peer->ids_of_items_to_get.size()
                                                  + peer->number_of_unfetched_item_ids;
@@ -2087,8 +2173,7 @@ namespace graphene { namespace net { namespace detail {
           {
             bool is_first_item_for_other_peer = false;
             {
-               fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-               for (const peer_connection_ptr& peer : _active_connections)
+               for (const peer_connection_ptr& peer : _active_connections.snapshot())
                {
                   if (peer != originating_peer->shared_from_this() &&
                         !peer->ids_of_items_to_get.empty() &&
@@ -2340,6 +2425,132 @@ namespace graphene { namespace net { namespace detail {
       }
     }
 
+    void node_impl::on_fetch_block_range_message(peer_connection* originating_peer,
+                                                 const fetch_block_range_message& fetch_block_range_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      dlog("received request for ${count} blocks starting at ${first} from peer ${endpoint}",
+           ("count", fetch_block_range_message_received.block_count)
+           ("first", fetch_block_range_message_received.first_block_num)
+           ("endpoint", originating_peer->get_remote_endpoint()));
+
+      std::vector<std::vector<char>> packed_blocks;
+      if( _block_range_sync_enabled )
+      {
+        const uint32_t block_count = std::min<uint32_t>( fetch_block_range_message_received.block_count,
+                                                         GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING );
+        try
+        {
+          packed_blocks = _delegate->get_packed_blocks( fetch_block_range_message_received.first_block_num,
+                                                        block_count, GRAPHENE_NET_MAX_BLOCK_RANGE_BYTES );
+        }
+        catch (const fc::exception& e)
+        {
+          wlog("unable to read the blocks requested by peer ${endpoint}: ${e}",
+               ("endpoint", originating_peer->get_remote_endpoint())("e", e));
+        }
+      }
+
+      const block_range_codec codec = ( _compress_block_ranges &&
+                                        fetch_block_range_message_received.codec == block_range_codec::zlib ) ?
+                                      block_range_codec::zlib : block_range_codec::uncompressed;
+      block_range_message reply( fetch_block_range_message_received.first_block_num, packed_blocks, codec );
+
+      if( !packed_blocks.empty() )
+      {
+        // the header is at the start of a packed block, there's no need to unpack the transactions
+        const graphene::protocol::signed_block_header last_block =
+              fc::raw::unpack<graphene::protocol::signed_block_header>( packed_blocks.back() );
+        originating_peer->last_block_delegate_has_seen = last_block.id();
+        originating_peer->last_block_time_delegate_has_seen = last_block.timestamp;
+      }
+
+      ++_block_ranges_sent.ranges;
+      _block_ranges_sent.blocks += packed_blocks.size();
+      _block_ranges_sent.bytes += reply.packed_blocks.size();
+      for( const std::vector<char>& packed_block : packed_blocks )
+        _block_ranges_sent.uncompressed_bytes += packed_block.size();
+
+      originating_peer->send_message( reply );
+    }
+
+    void node_impl::on_block_range_message(peer_connection* originating_peer,
+                                           const block_range_message& block_range_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      auto range_iter = originating_peer->block_ranges_requested_from_peer.find(
+                              block_range_message_received.first_block_num );
+      if( range_iter == originating_peer->block_ranges_requested_from_peer.end() )
+      {
+        wlog("received a block range starting at ${first} I didn't ask for from peer ${endpoint}, disconnecting from peer",
+             ("first", block_range_message_received.first_block_num)
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        fc::exception detailed_error(FC_LOG_MESSAGE(error, "You sent me a block range that I didn't ask for, first block: ${first}",
+                                                    ("first", block_range_message_received.first_block_num)));
+        disconnect_from_peer(originating_peer, "You sent me a block range that I didn't ask for", true, detailed_error);
+        return;
+      }
+      const std::vector<item_hash_t> requested_ids = std::move( range_iter->second );
+      originating_peer->block_ranges_requested_from_peer.erase( range_iter );
+
+      // the requested ids stay in sync_items_requested_from_peer until here, if we disconnect
+      // they will be fetched from other peers
+      std::vector<signed_block> blocks;
+      try
+      {
+        FC_ASSERT( block_range_message_received.block_count <= requested_ids.size(),
+                   "Received ${received} blocks but only requested ${requested}",
+                   ("received", block_range_message_received.block_count)("requested", requested_ids.size()) );
+        blocks = block_range_message_received.get_blocks();
+      }
+      catch (const fc::exception& e)
+      {
+        wlog("received an invalid block range from peer ${endpoint}, disconnecting from peer: ${e}",
+             ("endpoint", originating_peer->get_remote_endpoint())("e", e));
+        disconnect_from_peer(originating_peer, "You sent me an invalid block range", true, e);
+        return;
+      }
+
+      ++_block_ranges_received.ranges;
+      _block_ranges_received.blocks += blocks.size();
+      _block_ranges_received.bytes += block_range_message_received.packed_blocks.size();
+
+      // the peer sends the blocks of its current chain, which are the ones we asked for unless it switched forks
+      size_t blocks_delivered = 0;
+      for( const signed_block& block : blocks )
+      {
+        graphene::net::block_message block_message_to_process( block );
+        if( block_message_to_process.block_id != requested_ids[blocks_delivered] )
+          break;
+        _block_ranges_received.uncompressed_bytes += fc::raw::pack_size( block_message_to_process.block );
+        originating_peer->sync_items_requested_from_peer.erase( block_message_to_process.block_id );
+        _active_sync_requests.erase( block_message_to_process.block_id );
+        process_block_during_syncing( originating_peer, block_message_to_process, message_hash_type() );
+        ++blocks_delivered;
+      }
+      if( blocks_delivered > 0 )
+        originating_peer->last_sync_item_received_time = fc::time_point::now();
+
+      // the peer left out the blocks which didn't fit in the reply, request them again
+      for( size_t i = blocks_delivered; i < requested_ids.size(); ++i )
+      {
+        originating_peer->sync_items_requested_from_peer.erase( requested_ids[i] );
+        _active_sync_requests.erase( requested_ids[i] );
+      }
+      if( blocks_delivered == 0 )
+      {
+        wlog("peer ${endpoint} sent none of the ${count} blocks starting at ${first} I asked for, fetching its blocks by id from now on",
+             ("endpoint", originating_peer->get_remote_endpoint())
+             ("count", requested_ids.size())
+             ("first", block_range_message_received.first_block_num));
+        originating_peer->inhibit_block_range_requests = true;
+      }
+
+      if( blocks_delivered < requested_ids.size() )
+        trigger_fetch_sync_items_loop();
+      continue_syncing_with_peer( originating_peer );
+    }
+
     void node_impl::on_item_not_available_message( peer_connection* originating_peer, const item_not_available_message& item_not_available_message_received )
     {
       VERIFY_CORRECT_THREAD();
@@ -2396,10 +2607,9 @@ namespace graphene { namespace net { namespace detail {
         bool we_advertised_this_item_to_a_peer = false;
         bool we_requested_this_item_from_a_peer = false;
         {
-           fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-            for (const peer_connection_ptr& peer : _active_connections)
+            for (const peer_connection_ptr& peer : _active_connections.snapshot())
             {
-               if (peer->inventory_advertised_to_peer.find(advertised_item_id) != peer->inventory_advertised_to_peer.end())
+               if (peer->inventory_advertised_to_peer.contains(advertised_item_id))
                {
                   we_advertised_this_item_to_a_peer = true;
                   break;
@@ -2408,6 +2618,10 @@ namespace graphene { namespace net { namespace detail {
                   we_requested_this_item_from_a_peer = true;
             }
         }
+        // a transaction waiting in the relay queue has been downloaded already
+        if (advertised_item_id.item_type == graphene::net::trx_message_type &&
+            _transaction_relay_scheduler.contains(item_hash))
+          we_requested_this_item_from_a_peer = true;
 
         // if we have already advertised it to a peer, we must have it, no need to do anything else
         if (!we_advertised_this_item_to_a_peer)
@@ -2419,7 +2633,7 @@ namespace graphene { namespace net { namespace detail {
                originating_peer->is_inventory_advertised_to_us_list_full_for_transactions()) ||
               originating_peer->is_inventory_advertised_to_us_list_full())
             break;
-          originating_peer->inventory_peer_advertised_to_us.insert(peer_connection::timestamped_item_id(advertised_item_id, fc::time_point::now()));
+          originating_peer->inventory_peer_advertised_to_us.insert(advertised_item_id);
           if (!we_requested_this_item_from_a_peer)
           {
             if (_recently_failed_items.find(item_id(item_ids_inventory_message_received.item_type, item_hash)) != _recently_failed_items.end())
@@ -2506,10 +2720,23 @@ namespace graphene { namespace net { namespace detail {
         }
       }
 
+      // transactions the peer sent us which we haven't processed yet are fetched again from other peers which
+      // advertised them, the ones dropped earlier because the queue of the peer was full are not
+      for (const message_hash_type& dropped_trx_hash : _transaction_relay_scheduler.remove_peer(originating_peer))
+      {
+        const item_id dropped_trx_id(graphene::net::trx_message_type, dropped_trx_hash);
+        if (_transaction_relay_scheduler.contains(dropped_trx_hash) ||
+            _items_to_fetch.get<item_id_index>().find(dropped_trx_id) != _items_to_fetch.get<item_id_index>().end())
+          continue;
+        _items_to_fetch.insert(prioritized_item_id(dropped_trx_id, _items_to_fetch_seq_counter));
+        ++_items_to_fetch_seq_counter;
+        trigger_fetch_items_loop();
+      }
+
       _closing_connections.erase(originating_peer_ptr);
       _handshaking_connections.erase(originating_peer_ptr);
       _terminating_connections.erase(originating_peer_ptr);
-      if (_active_connections.find(originating_peer_ptr) != _active_connections.end())
+      if (_active_connections.contains(originating_peer_ptr))
       {
         _active_connections.erase(originating_peer_ptr);
 
@@ -2644,9 +2871,7 @@ namespace graphene { namespace net { namespace detail {
                ("count", _total_num_of_unfetched_items));
          bool is_fork_block = is_hard_fork_block(block_message_to_send.block.block_num());
          {
-            fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-
-            for (const peer_connection_ptr& peer : _active_connections)
+            for (const peer_connection_ptr& peer : _active_connections.snapshot())
             {
                bool disconnecting_this_peer = false;
                if (is_fork_block)
@@ -2714,13 +2939,12 @@ namespace graphene { namespace net { namespace detail {
                   }
                }
             } // for
-         } // lock_guard
+         }
       }
       else
       {
         // invalid message received
-        fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-        for (const peer_connection_ptr& peer : _active_connections)
+        for (const peer_connection_ptr& peer : _active_connections.snapshot())
         {
           if (peer->ids_of_items_being_processed.find(block_message_to_send.block_id)
                  != peer->ids_of_items_being_processed.end())
@@ -2825,8 +3049,7 @@ namespace graphene { namespace net { namespace detail {
           // find out if this block is the next block on the active chain or one of the forks
           bool potential_first_block = false;
           {
-            fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-            for (const peer_connection_ptr& peer : _active_connections)
+            for (const peer_connection_ptr& peer : _active_connections.snapshot())
             {
                if (!peer->ids_of_items_to_get.empty() &&
                      peer->ids_of_items_to_get.front() == received_block_iter->block_id)
@@ -2862,8 +3085,7 @@ namespace graphene { namespace net { namespace detail {
             {
               dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
               std::vector< peer_connection_ptr > peers_needing_next_batch;
-              fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-              for (const peer_connection_ptr& peer : _active_connections)
+              for (const peer_connection_ptr& peer : _active_connections.snapshot())
               {
                 auto items_being_processed_iter = peer->ids_of_items_being_processed.find(received_block_iter->block_id);
                 if (items_being_processed_iter != peer->ids_of_items_being_processed.end())
@@ -2991,11 +3213,9 @@ namespace graphene { namespace net { namespace detail {
         uint32_t block_number = block_message_to_process.block.block_num();
         fc::time_point_sec block_time = block_message_to_process.block.timestamp;
         {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& peer : _active_connections)
+         for (const peer_connection_ptr& peer : _active_connections.snapshot())
          {
-            auto iter = peer->inventory_peer_advertised_to_us.find(block_message_item_id);
-            if (iter != peer->inventory_peer_advertised_to_us.end())
+            if (peer->inventory_peer_advertised_to_us.contains(block_message_item_id))
             {
                // this peer offered us the item.  It will eventually expire from the peer's
                // inventory_peer_advertised_to_us list after some time has passed (currently 2 minutes).
@@ -3016,8 +3236,7 @@ namespace graphene { namespace net { namespace detail {
         {
           // we just pushed a hard fork block.  Find out if any of our peers are running clients
           // that will be unable to process future blocks
-          fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-          for (const peer_connection_ptr& peer : _active_connections)
+          for (const peer_connection_ptr& peer : _active_connections.snapshot())
           {
             if (peer->last_known_fork_block_number != 0)
             {
@@ -3071,8 +3290,7 @@ namespace graphene { namespace net { namespace detail {
         disconnect_reason = "You offered me a block that I have deemed to be invalid";
 
         peers_to_disconnect.insert( originating_peer->shared_from_this() );
-        fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-        for (const peer_connection_ptr& peer : _active_connections)
+        for (const peer_connection_ptr& peer : _active_connections.snapshot())
           if (!peer->ids_of_items_to_get.empty() && peer->ids_of_items_to_get.front() == block_message_to_process.block_id)
             peers_to_disconnect.insert(peer);
       }
@@ -3102,7 +3320,10 @@ namespace graphene { namespace net { namespace detail {
       // (it's possible that we request an item during normal operation and then get kicked into sync
       // mode before we receive and process the item.  In that case, we should process the item as a normal
       // item to avoid confusing the sync code)
-      graphene::net::block_message block_message_to_process(message_to_process.as<graphene::net::block_message>());
+      // usually already decoded by the I/O thread which read it
+      const std::shared_ptr<const graphene::net::block_message> decoded_block
+            = message_to_process.as_shared<graphene::net::block_message>();
+      const graphene::net::block_message& block_message_to_process = *decoded_block;
       auto item_iter = originating_peer->items_requested_from_peer.find(
                              item_id(graphene::net::block_message_type, message_hash));
       if (item_iter != originating_peer->items_requested_from_peer.end())
@@ -3128,16 +3349,7 @@ namespace graphene { namespace net { namespace detail {
             originating_peer->last_sync_item_received_time = fc::time_point::now();
             _active_sync_requests.erase(block_message_to_process.block_id);
             process_block_during_syncing(originating_peer, block_message_to_process, message_hash);
-            if (originating_peer->idle())
-            {
-              // we have finished fetching a batch of items, so we either need to grab another batch of items
-              // or we need to get another list of item ids.
-              if (originating_peer->number_of_unfetched_item_ids > 0 &&
-                  originating_peer->ids_of_items_to_get.size() < GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH)
-                fetch_next_batch_of_item_ids_from_peer(originating_peer);
-              else
-                trigger_fetch_sync_items_loop();
-            }
+            continue_syncing_with_peer(originating_peer);
             return;
           }
           catch (const fc::canceled_exception& e)
@@ -3203,8 +3415,7 @@ namespace graphene { namespace net { namespace detail {
     void node_impl::forward_firewall_check_to_next_available_peer(firewall_check_state_data* firewall_check_state)
     {
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& peer : _active_connections)
+         for (const peer_connection_ptr& peer : _active_connections.snapshot())
          {
             if (firewall_check_state->expected_node_id != peer->node_id && // it's not the node who is asking us to test
                   !peer->firewall_check_state && // the peer isn't already performing a check for another node
@@ -3223,7 +3434,7 @@ namespace graphene { namespace net { namespace detail {
                return;
             }
          }
-      } // lock_guard
+      }
       wlog("Unable to forward firewall check for node ${to_check} to any other peers, returning 'unable'",
            ("to_check", firewall_check_state->endpoint_to_test));
 
@@ -3375,8 +3586,8 @@ namespace graphene { namespace net { namespace detail {
     // this handles any message we get that doesn't require any special processing.
     // currently, this is any message other than block messages and p2p-specific
     // messages.  (transaction messages would be handled here, for example)
-    // this just passes the message to the client, and does the bookkeeping
-    // related to requesting and rebroadcasting the message.
+    // this does the bookkeeping related to requesting the message, then either queues
+    // it (transactions) or passes it to the client right away (everything else).
     void node_impl::process_ordinary_message( peer_connection* originating_peer,
                                               const message& message_to_process,
                                               const message_hash_type& message_hash )
@@ -3397,65 +3608,108 @@ namespace graphene { namespace net { namespace detail {
         disconnect_from_peer( originating_peer, "You sent me a message that I didn't request", true, detailed_error );
         return;
       }
-      else
+
+      originating_peer->items_requested_from_peer.erase( iter );
+      if (originating_peer->idle())
+        trigger_fetch_items_loop();
+
+      if (message_to_process.msg_type.value() != trx_message_type)
       {
-        originating_peer->items_requested_from_peer.erase( iter );
-        if (originating_peer->idle())
-          trigger_fetch_items_loop();
+        handle_ordinary_message( message_to_process, message_hash, originating_peer->node_id,
+                                 originating_peer->get_remote_endpoint(), message_receive_time );
+        return;
+      }
 
-        // Next: have the delegate process the message
-        fc::time_point message_validated_time;
-        try
-        {
-          if (message_to_process.msg_type.value() == trx_message_type)
-          {
-            trx_message transaction_message_to_process = message_to_process.as<trx_message>();
-            dlog( "passing message containing transaction ${trx} to client",
-                  ("trx", transaction_message_to_process.trx.id()) );
-            _delegate->handle_transaction(transaction_message_to_process);
-          }
-          else
-            _delegate->handle_message( message_to_process );
-          message_validated_time = fc::time_point::now();
-        }
-        catch ( const fc::canceled_exception& )
+      // transactions are processed in the order chosen by the relay scheduler, which limits how much of
+      // our time each peer can take and serves the transactions paying the highest fees first
+      transaction_relay_scheduler::queued_transaction queued_trx;
+      try
+      {
+        queued_trx.priority = _delegate->get_transaction_priority( *message_to_process.as_shared<trx_message>() );
+      }
+      catch ( const fc::canceled_exception& )
+      {
+        throw;
+      }
+      catch ( const fc::exception& e )
+      {
+        wlog( "unable to evaluate transaction sent by peer ${peer}, ${e}",
+              ("peer", originating_peer->get_remote_endpoint())("e", e) );
+        _recently_failed_items.insert( peer_connection::timestamped_item_id(
+              item_id( message_to_process.msg_type.value(), message_hash ), fc::time_point::now() ) );
+        return;
+      }
+      queued_trx.message_received = message_to_process;
+      queued_trx.message_hash = message_hash;
+      queued_trx.originating_node = originating_peer->node_id;
+      queued_trx.originating_endpoint = originating_peer->get_remote_endpoint();
+      queued_trx.received_time = message_receive_time;
+      if( !_transaction_relay_scheduler.push( originating_peer, std::move(queued_trx), message_receive_time ) )
+        dlog( "relay queue of peer ${peer} is full, dropped the transaction paying the lowest fees",
+              ("peer", originating_peer->get_remote_endpoint()) );
+      trigger_process_relayed_transactions_loop();
+    }
+
+    // passes a message to the client and, if the client accepts it, broadcasts it to our other peers
+    void node_impl::handle_ordinary_message( const message& message_to_process,
+                                             const message_hash_type& message_hash,
+                                             const node_id_t& originating_node,
+                                             const fc::optional<fc::ip::endpoint>& originating_endpoint,
+                                             const fc::time_point& message_receive_time )
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::time_point message_validated_time;
+      try
+      {
+        if (message_to_process.msg_type.value() == trx_message_type)
         {
-          throw;
+          const std::shared_ptr<const trx_message> transaction_message_to_process
+                = message_to_process.as_shared<trx_message>();
+          dlog( "passing message containing transaction ${trx} to client",
+                ("trx", transaction_message_to_process->trx.id()) );
+          _delegate->handle_transaction(*transaction_message_to_process);
         }
-        catch ( const fc::exception& e )
+        else
+          _delegate->handle_message( message_to_process );
+        message_validated_time = fc::time_point::now();
+      }
+      catch ( const fc::canceled_exception& )
+      {
+        throw;
+      }
+      catch ( const fc::exception& e )
+      {
+        switch( e.code() )
         {
-          switch( e.code() )
-          {
-          // log common exceptions in debug level
-          case graphene::chain::duplicate_transaction::code_enum::code_value :
-          case graphene::chain::limit_order_create_kill_unfilled::code_enum::code_value :
-          case graphene::chain::limit_order_create_market_not_whitelisted::code_enum::code_value :
-          case graphene::chain::limit_order_create_market_blacklisted::code_enum::code_value :
-          case graphene::chain::limit_order_create_selling_asset_unauthorized::code_enum::code_value :
-          case graphene::chain::limit_order_create_receiving_asset_unauthorized::code_enum::code_value :
-          case graphene::chain::limit_order_create_insufficient_balance::code_enum::code_value :
-          case graphene::chain::limit_order_cancel_nonexist_order::code_enum::code_value :
-          case graphene::chain::limit_order_cancel_owner_mismatch::code_enum::code_value :
-             dlog( "client rejected message sent by peer ${peer}, ${e}",
-                   ("peer", originating_peer->get_remote_endpoint() )("e", e) );
-             break;
-          // log rarer exceptions in warn level
-          default:
-             wlog( "client rejected message sent by peer ${peer}, ${e}",
-                   ("peer", originating_peer->get_remote_endpoint() )("e", e) );
-             break;
-          }
-          // record it so we don't try to fetch this item again
-          _recently_failed_items.insert( peer_connection::timestamped_item_id(
-                item_id( message_to_process.msg_type.value(), message_hash ), fc::time_point::now() ) );
-          return;
+        // log common exceptions in debug level
+        case graphene::chain::duplicate_transaction::code_enum::code_value :
+        case graphene::chain::limit_order_create_kill_unfilled::code_enum::code_value :
+        case graphene::chain::limit_order_create_market_not_whitelisted::code_enum::code_value :
+        case graphene::chain::limit_order_create_market_blacklisted::code_enum::code_value :
+        case graphene::chain::limit_order_create_selling_asset_unauthorized::code_enum::code_value :
+        case graphene::chain::limit_order_create_receiving_asset_unauthorized::code_enum::code_value :
+        case graphene::chain::limit_order_create_insufficient_balance::code_enum::code_value :
+        case graphene::chain::limit_order_cancel_nonexist_order::code_enum::code_value :
+        case graphene::chain::limit_order_cancel_owner_mismatch::code_enum::code_value :
+           dlog( "client rejected message sent by peer ${peer}, ${e}",
+                 ("peer", originating_endpoint )("e", e) );
+           break;
+        // log rarer exceptions in warn level
+        default:
+           wlog( "client rejected message sent by peer ${peer}, ${e}",
+                 ("peer", originating_endpoint )("e", e) );
+           break;
         }
-
-        // finally, if the delegate validated the message, broadcast it to our other peers
-        message_propagation_data propagation_data { message_receive_time, message_validated_time,
-                                                    originating_peer->node_id };
-        broadcast( message_to_process, propagation_data );
+        // record it so we don't try to fetch this item again
+        _recently_failed_items.insert( peer_connection::timestamped_item_id(
+              item_id( message_to_process.msg_type.value(), message_hash ), fc::time_point::now() ) );
+        return;
       }
+
+      // finally, if the delegate validated the message, broadcast it to our other peers
+      message_propagation_data propagation_data { message_receive_time, message_validated_time,
+                                                  originating_node };
+      broadcast( message_to_process, propagation_data );
     }
 
     void node_impl::start_synchronizing_with_peer( const peer_connection_ptr& peer )
@@ -3472,8 +3726,7 @@ namespace graphene { namespace net { namespace detail {
 
     void node_impl::start_synchronizing()
     {
-      fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-      for( const peer_connection_ptr& peer : _active_connections )
+      for( const peer_connection_ptr& peer : _active_connections.snapshot() )
         start_synchronizing_with_peer( peer );
     }
 
@@ -3670,6 +3923,27 @@ namespace graphene { namespace net { namespace detail {
         wlog( "Exception thrown while terminating Advertise inventory loop, ignoring" );
       }
 
+      try
+      {
+        _process_relayed_transactions_loop_done.cancel("node_impl::close()");
+        // cancel() is currently broken, so we need to wake up the task to allow it to finish
+        trigger_process_relayed_transactions_loop();
+        _process_relayed_transactions_loop_done.wait();
+        dlog("Process relayed transactions loop terminated");
+      }
+      catch ( const fc::canceled_exception& )
+      {
+        dlog("Process relayed transactions loop terminated");
+      }
+      catch ( const fc::exception& e )
+      {
+        wlog( "Exception thrown while terminating Process relayed transactions loop, ignoring: ${e}", ("e", e) );
+      }
+      catch (...)
+      {
+        wlog( "Exception thrown while terminating Process relayed transactions loop, ignoring" );
+      }
+
 
       // Next, terminate our existing connections.  First, close all of the connections nicely.
       // This will close the sockets and may result in calls to our "on_connection_closing"
@@ -3677,19 +3951,9 @@ namespace graphene { namespace net { namespace detail {
       // the read loop before it gets an EOF).
       // operate off copies of the lists in case they change during iteration
       std::list<peer_connection_ptr> all_peers;
-      auto p_back = [&all_peers](const peer_connection_ptr& conn) { all_peers.push_back(conn); };
-      {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         std::for_each(_active_connections.begin(), _active_connections.end(), p_back);
-      }
-      {
-         fc::scoped_lock<fc::mutex> lock(_handshaking_connections.get_mutex());
-         std::for_each(_handshaking_connections.begin(), _handshaking_connections.end(), p_back);
-      }
-      {
-         fc::scoped_lock<fc::mutex> lock(_closing_connections.get_mutex());
-         std::for_each(_closing_connections.begin(), _closing_connections.end(), p_back);
-      }
+      for( const auto& connections : { _active_connections.snapshot(), _handshaking_connections.snapshot(),
+                                       _closing_connections.snapshot() } )
+         all_peers.insert( all_peers.end(), connections.begin(), connections.end() );
 
       for (const peer_connection_ptr& peer : all_peers)
       {
@@ -3976,9 +4240,9 @@ namespace graphene { namespace net { namespace detail {
         // whether the peer is firewalled, we want to disconnect now.
         _handshaking_connections.erase(new_peer);
         _terminating_connections.erase(new_peer);
-        assert(_active_connections.find(new_peer) == _active_connections.end());
+        assert(!_active_connections.contains(new_peer));
         _active_connections.erase(new_peer);
-        assert(_closing_connections.find(new_peer) == _closing_connections.end());
+        assert(!_closing_connections.contains(new_peer));
         _closing_connections.erase(new_peer);
 
         display_current_connections();
@@ -4193,6 +4457,7 @@ namespace graphene { namespace net { namespace detail {
              !_fetch_sync_items_loop_done.valid() &&
              !_fetch_item_loop_done.valid() &&
              !_advertise_inventory_loop_done.valid() &&
+             !_process_relayed_transactions_loop_done.valid() &&
              !_kill_inactive_conns_loop_done.valid() &&
              !_fetch_updated_peer_lists_loop_done.valid() &&
              !_bandwidth_monitor_loop_done.valid() &&
@@ -4206,6 +4471,8 @@ namespace graphene { namespace net { namespace detail {
       _fetch_item_loop_done = fc::async( [this]() { fetch_items_loop(); }, "fetch_items_loop" );
       _advertise_inventory_loop_done = fc::async( [this]() { advertise_inventory_loop(); },
                                                   "advertise_inventory_loop" );
+      _process_relayed_transactions_loop_done = fc::async( [this]() { process_relayed_transactions_loop(); },
+                                                           "process_relayed_transactions_loop" );
       _kill_inactive_conns_loop_done = fc::async( [this,self]() { kill_inactive_conns_loop(self); },
                                                   "kill_inactive_conns_loop" );
       _fetch_updated_peer_lists_loop_done = fc::async([this](){ fetch_updated_peer_lists_loop(); },
@@ -4296,8 +4563,7 @@ namespace graphene { namespace net { namespace detail {
     {
       VERIFY_CORRECT_THREAD();
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for( const peer_connection_ptr& active_peer : _active_connections )
+         for( const peer_connection_ptr& active_peer : _active_connections.snapshot() )
          {
             fc::optional<fc::ip::endpoint> endpoint_for_this_peer( active_peer->get_remote_endpoint() );
             if( endpoint_for_this_peer && *endpoint_for_this_peer == remote_endpoint )
@@ -4305,8 +4571,7 @@ namespace graphene { namespace net { namespace detail {
          }
       }
       {
-         fc::scoped_lock<fc::mutex> lock(_handshaking_connections.get_mutex());
-         for( const peer_connection_ptr& handshaking_peer : _handshaking_connections )
+         for( const peer_connection_ptr& handshaking_peer : _handshaking_connections.snapshot() )
          {
             fc::optional<fc::ip::endpoint> endpoint_for_this_peer( handshaking_peer->get_remote_endpoint() );
             if( endpoint_for_this_peer && *endpoint_for_this_peer == remote_endpoint )
@@ -4357,8 +4622,7 @@ namespace graphene { namespace net { namespace detail {
            ( "active", _active_connections.size() )("handshaking", _handshaking_connections.size() )("closing",_closing_connections.size() )
            ( "desired", _desired_number_of_connections )("maximum", _maximum_number_of_connections ) );
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for( const peer_connection_ptr& peer : _active_connections )
+         for( const peer_connection_ptr& peer : _active_connections.snapshot() )
          {
             ilog( "       active peer ${endpoint} peer_is_in_sync_with_us:${in_sync_with_us} we_are_in_sync_with_peer:${in_sync_with_them}",
                   ( "endpoint", peer->get_remote_endpoint() )
@@ -4371,8 +4635,7 @@ namespace graphene { namespace net { namespace detail {
          }
       }
       {
-         fc::scoped_lock<fc::mutex> lock(_handshaking_connections.get_mutex());
-         for( const peer_connection_ptr& peer : _handshaking_connections )
+         for( const peer_connection_ptr& peer : _handshaking_connections.snapshot() )
          {
             ilog( "  handshaking peer ${endpoint} in state ours(${our_state}) theirs(${their_state})",
                   ( "endpoint", peer->get_remote_endpoint() )("our_state", peer->our_state )("their_state", peer->their_state ) );
@@ -4385,8 +4648,7 @@ namespace graphene { namespace net { namespace detail {
       ilog( "node._items_to_fetch size: ${size}", ("size", _items_to_fetch.size() ) );
       ilog( "node._new_inventory size: ${size}", ("size", _new_inventory.size() ) );
       ilog( "node._message_cache size: ${size}", ("size", _message_cache.size() ) );
-      fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-      for( const peer_connection_ptr& peer : _active_connections )
+      for( const peer_connection_ptr& peer : _active_connections.snapshot() )
       {
         ilog( "  peer ${endpoint}", ("endpoint", peer->get_remote_endpoint() ) );
         ilog( "    peer.ids_of_items_to_get size: ${size}", ("size", peer->ids_of_items_to_get.size() ) );
@@ -4483,8 +4745,7 @@ namespace graphene { namespace net { namespace detail {
     {
       VERIFY_CORRECT_THREAD();
       std::vector<peer_status> statuses;
-      fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-      for (const peer_connection_ptr& peer : _active_connections)
+      for (const peer_connection_ptr& peer : _active_connections.snapshot())
       {
         peer_status this_peer_status;
         this_peer_status.version = 0;
@@ -4546,6 +4807,8 @@ namespace graphene { namespace net { namespace detail {
         peer_details["peer_needs_sync_items_from_us"] = peer->peer_needs_sync_items_from_us;
         peer_details["we_need_sync_items_from_peer"] = peer->we_need_sync_items_from_peer;
 
+        peer_details["relay_queue"] = fc::variant( _transaction_relay_scheduler.get_statistics( peer.get() ), 1 );
+
         this_peer_status.info = peer_details;
         statuses.push_back(this_peer_status);
       }
@@ -4589,6 +4852,21 @@ namespace graphene { namespace net { namespace detail {
       broadcast( item_to_broadcast, propagation_data );
     }
 
+    void node_impl::broadcast_transactions( const std::vector<signed_transaction>& trxs )
+    {
+      VERIFY_CORRECT_THREAD();
+      message_propagation_data propagation_data{fc::time_point::now(), fc::time_point::now(), _node_id};
+      for( const signed_transaction& trx : trxs )
+      {
+        const message item_to_broadcast( trx_message( trx ) );
+        const message_hash_type hash_of_item_to_broadcast = item_to_broadcast.id();
+        _message_cache.cache_message( item_to_broadcast, hash_of_item_to_broadcast, propagation_data, trx.id() );
+        _new_inventory.insert( item_id( trx_message_type, hash_of_item_to_broadcast ) );
+      }
+      // wake up the advertising loop once, it sends the whole batch in as few inventory messages as possible
+      trigger_advertise_inventory_loop();
+    }
+
     void node_impl::sync_from(const item_id& current_head_block, const std::vector<uint32_t>& hard_fork_block_numbers)
     {
       VERIFY_CORRECT_THREAD();
@@ -4629,12 +4907,21 @@ namespace graphene { namespace net { namespace detail {
         _max_sync_blocks_to_prefetch = params["max_sync_blocks_to_prefetch"].as<uint32_t>(1);
       if (params.contains("max_sync_blocks_per_peer"))
         _max_sync_blocks_per_peer = params["max_sync_blocks_per_peer"].as<uint32_t>(1);
+      if (params.contains("message_cache_max_bytes"))
+        _message_cache.set_max_bytes(params["message_cache_max_bytes"].as<uint64_t>(1));
+      // only affects the peers we connect to from now on, the others were told our features in our hello
+      if (params.contains("block_range_sync"))
+        _block_range_sync_enabled = params["block_range_sync"].as<bool>(1);
+      if (params.contains("compress_block_ranges"))
+        _compress_block_ranges = params["compress_block_ranges"].as<bool>(1);
 
       _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
       while (_active_connections.size() > _maximum_number_of_connections)
-        disconnect_from_peer(_active_connections.begin()->get(),
-                             "I have too many connections open");
+      {
+        const peer_connection_ptr peer_to_disconnect = *_active_connections.snapshot().begin();
+        disconnect_from_peer(peer_to_disconnect.get(), "I have too many connections open");
+      }
       trigger_p2p_network_connect_loop();
     }
 
@@ -4648,6 +4935,9 @@ namespace graphene { namespace net { namespace detail {
       result["max_blocks_to_handle_at_once"] = _max_blocks_to_handle_at_once;
       result["max_sync_blocks_to_prefetch"] = _max_sync_blocks_to_prefetch;
       result["max_sync_blocks_per_peer"] = _max_sync_blocks_per_peer;
+      result["message_cache_max_bytes"] = _message_cache.get_max_bytes();
+      result["block_range_sync"] = _block_range_sync_enabled;
+      result["compress_block_ranges"] = _compress_block_ranges;
       return result;
     }
 
@@ -4677,8 +4967,7 @@ namespace graphene { namespace net { namespace detail {
       std::list<peer_connection_ptr> peers_to_disconnect;
       if (!_allowed_peers.empty())
       {
-         fc::scoped_lock<fc::mutex> lock(_active_connections.get_mutex());
-         for (const peer_connection_ptr& peer : _active_connections)
+         for (const peer_connection_ptr& peer : _active_connections.snapshot())
             if (_allowed_peers.find(peer->node_id) == _allowed_peers.end())
                peers_to_disconnect.push_back(peer);
       }
@@ -4699,6 +4988,26 @@ namespace graphene { namespace net { namespace detail {
       _rate_limiter.set_download_limit( download_bytes_per_second );
     }
 
+    void node_impl::set_io_thread_count( uint16_t num_threads )
+    {
+      VERIFY_CORRECT_THREAD();
+      // the connections hold on to the pool they were made with
+      FC_ASSERT( !_message_io_pool, "The I/O threads are already started" );
+      if( num_threads == 0 )
+        return;
+      _message_io_pool = std::make_unique<message_io_pool>( num_threads, decode_message_payload );
+      ilog( "Reading p2p messages with ${n} I/O thread(s)", ("n", num_threads) );
+    }
+
+    message_io_pool* node_impl::get_message_io_pool()
+    {
+      VERIFY_CORRECT_THREAD();
+      // the rate limiter reads the sockets it throttles from the p2p thread
+      if( _rate_limiter.get_download_limit() > 0 )
+        return nullptr;
+      return _message_io_pool.get();
+    }
+
     void node_impl::disable_peer_advertising()
     {
       VERIFY_CORRECT_THREAD();
@@ -4719,6 +5028,18 @@ namespace graphene { namespace net { namespace detail {
       info["node_public_key"] = fc::variant( _node_public_key, 1 );
       info["node_id"] = fc::variant( _node_id, 1 );
       info["firewalled"] = fc::variant( _is_firewalled, 1 );
+      info["advertise_inventory"] = fc::variant( _advertise_inventory_stats, 1 );
+      info["message_cache"] = fc::variant( _message_cache.get_statistics(), 1 );
+      fc::mutable_variant_object message_handling;
+      for( const auto& type_and_stats : _message_handling_stats )
+        message_handling[type_and_stats.first == 0 ? std::string( "other" )
+                         : fc::variant( core_message_type_enum( type_and_stats.first ), 1 ).as_string()]
+              = fc::variant( type_and_stats.second, 2 );
+      info["message_handling"] = message_handling;
+      info["block_ranges_received"] = fc::variant( _block_ranges_received, 1 );
+      info["block_ranges_sent"] = fc::variant( _block_ranges_sent, 1 );
+      if( _message_io_pool )
+        info["message_io"] = fc::variant( _message_io_pool->get_statistics(), 1 );
       return info;
     }
     fc::variant_object node_impl::network_get_usage_stats() const
@@ -4855,6 +5176,11 @@ namespace graphene { namespace net { namespace detail {
     INVOKE_IN_IMPL(broadcast, msg);
   }
 
+  void node::broadcast_transactions( const std::vector<signed_transaction>& trxs )
+  {
+    INVOKE_IN_IMPL(broadcast_transactions, trxs);
+  }
+
   void node::sync_from(const item_id& current_head_block, const std::vector<uint32_t>& hard_fork_block_numbers)
   {
     INVOKE_IN_IMPL(sync_from, current_head_block, hard_fork_block_numbers);
@@ -4921,6 +5247,11 @@ namespace graphene { namespace net { namespace detail {
     INVOKE_IN_IMPL(get_call_statistics);
   }
 
+  void node::set_io_thread_count(uint16_t num_threads)
+  {
+    INVOKE_IN_IMPL(set_io_thread_count, num_threads);
+  }
+
   fc::variant_object node::network_get_info() const
   {
     INVOKE_IN_IMPL(network_get_info);
@@ -5060,6 +5391,12 @@ namespace graphene { namespace net { namespace detail {
       INVOKE_AND_COLLECT_STATISTICS(handle_transaction, transaction_message);
     }
 
+    uint64_t statistics_gathering_node_delegate_wrapper::get_transaction_priority(
+          const graphene::net::trx_message& transaction_message )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(get_transaction_priority, transaction_message);
+    }
+
     std::vector<item_hash_t> statistics_gathering_node_delegate_wrapper::get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                                                                        uint32_t& remaining_item_count,
                                                                                        uint32_t limit /* = 2000 */)
@@ -5072,6 +5409,12 @@ namespace graphene { namespace net { namespace detail {
       INVOKE_AND_COLLECT_STATISTICS(get_item, id);
     }
 
+    std::vector<std::vector<char>> statistics_gathering_node_delegate_wrapper::get_packed_blocks(
+          uint32_t first_block_num, uint32_t count, size_t max_bytes )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(get_packed_blocks, first_block_num, count, max_bytes);
+    }
+
     chain_id_type statistics_gathering_node_delegate_wrapper::get_chain_id() const
     {
       INVOKE_AND_COLLECT_STATISTICS(get_chain_id);
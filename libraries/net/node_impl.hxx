@@ -16,6 +16,7 @@
 #define testnetlog(...) do {} while (0)
 #endif
 
+#include <map>
 #include <memory>
 #include <mutex>
 #include <fc/thread/thread.hpp>
@@ -24,15 +25,20 @@
 #include <graphene/chain/config.hpp>
 #include <graphene/protocol/types.hpp>
 #include <graphene/net/node.hpp>
+#include <graphene/net/copy_on_write_set.hpp>
 #include <graphene/net/core_messages.hpp>
+#include <graphene/net/message_cache.hpp>
+#include <graphene/net/message_io_pool.hpp>
 #include <graphene/net/peer_connection.hpp>
+#include <graphene/net/relay_scheduler.hpp>
 
 namespace graphene { namespace net { namespace detail {
 
 namespace bmi = boost::multi_index;
 
 /*******
- * A class to wrap std::unordered_set for multithreading
+ * A class to wrap std::unordered_set for multithreading.  It can't be iterated, take the contents with swap(),
+ * sets which are iterated are copy_on_write_sets
  */
 template <class Key, class Hash = std::hash<Key>, class Pred = std::equal_to<Key> >
 class concurrent_unordered_set : private std::unordered_set<Key, Hash, Pred>
@@ -41,9 +47,6 @@ private:
    mutable fc::mutex mux;
 
 public:
-   /// Iterations require a lock. This exposes the mutex. Use with care (i.e. lock_guard)
-   fc::mutex& get_mutex()const { return mux; }
-
    /// Insertion
    /// @{
    std::pair< typename std::unordered_set<Key, Hash, Pred>::iterator, bool> emplace( Key key)
@@ -97,113 +100,50 @@ public:
       std::unordered_set<Key, Hash, Pred>::swap( other );
    }
    /// @}
-   /// Iteration
-   /// @{
-   typename std::unordered_set<Key, Hash, Pred>::iterator begin() noexcept 
-   { 
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::begin(); 
-   }
-   typename std::unordered_set<Key, Hash, Pred>::const_iterator begin() const noexcept 
-   { 
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::begin(); 
-   }
-   typename std::unordered_set<Key, Hash, Pred>::local_iterator begin(size_t n) 
-   { 
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::begin(n); 
-   }
-   typename std::unordered_set<Key, Hash, Pred>::const_local_iterator begin(size_t n) const 
-   { 
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::begin(n); 
-   }
-   typename std::unordered_set<Key, Hash, Pred>::iterator end() noexcept 
-   { 
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::end(); 
-   }
-   typename std::unordered_set<Key, Hash, Pred>::const_iterator end() const noexcept 
-   { 
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::end(); 
-   }
-   typename std::unordered_set<Key, Hash, Pred>::local_iterator end(size_t n) 
-   { 
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::end(n); 
-   }
-   typename std::unordered_set<Key, Hash, Pred>::const_local_iterator end(size_t n) const 
-   { 
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::end(n); 
-   }
-   /// @}
-   /// Search
-   typename std::unordered_set<Key, Hash, Pred>::const_iterator find(Key key)
-   {
-      fc::scoped_lock<fc::mutex> lock(mux);
-      return std::unordered_set<Key, Hash, Pred>::find(key); 
-   }
 };   
 
-class blockchain_tied_message_cache
+/// Time spent in the iterations of the advertise inventory loop
+struct advertise_inventory_statistics
 {
-private:
-   static const uint32_t cache_duration_in_blocks = GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS;
+   uint64_t iterations     = 0;
+   uint64_t items          = 0; ///< new items taken from the inventory
+   uint64_t advertisements = 0; ///< items advertised, counted once per peer
+   uint64_t total_us       = 0;
+   uint64_t max_us         = 0;
+   uint64_t last_us        = 0;
+
+   void record( size_t items_taken, size_t items_advertised, const fc::microseconds& elapsed );
+};
 
-   struct message_hash_index{};
-   struct message_contents_hash_index{};
-   struct block_clock_index{};
-   struct message_info
-   {
-      message_hash_type message_hash;
-      message           message_body;
-      uint32_t          block_clock_when_received;
-
-      /// for network performance stats
-      message_propagation_data propagation_data;
-      /// hash of whatever the message contains
-      /// (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
-      message_hash_type message_contents_hash;
-
-      message_info( const message_hash_type& message_hash,
-                    const message&           message_body,
-                    uint32_t                 block_clock_when_received,
-                    const message_propagation_data& propagation_data,
-                    message_hash_type        message_contents_hash ) :
-            message_hash( message_hash ),
-            message_body( message_body ),
-            block_clock_when_received( block_clock_when_received ),
-            propagation_data( propagation_data ),
-            message_contents_hash( message_contents_hash )
-      {}
-   };
-
-   using message_cache_container = boost::multi_index_container < message_info,
-               bmi::indexed_by<
-                  bmi::ordered_unique< bmi::tag<message_hash_index>,
-                     bmi::member<message_info, message_hash_type, &message_info::message_hash> >,
-                  bmi::ordered_non_unique< bmi::tag<message_contents_hash_index>,
-                     bmi::member<message_info, message_hash_type, &message_info::message_contents_hash> >,
-                  bmi::ordered_non_unique< bmi::tag<block_clock_index>,
-                     bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> > > >;
-
-   message_cache_container _message_cache;
-
-   uint32_t block_clock = 0;
+/// Messages of one type received from peers, and the time their handlers took
+struct message_handling_statistics
+{
+   uint64_t messages   = 0;
+   uint64_t bytes      = 0;
+   /// Wall clock time from start to end of the handlers.  It includes the time a handler waited, e.g. for the
+   /// delegate, and the other tasks the p2p thread ran meanwhile, so it is not the CPU time of the message type
+   uint64_t handler_us = 0;
+};
+
+/// Block ranges requested from or served to peers during syncing
+struct block_range_statistics
+{
+   uint64_t ranges             = 0;
+   uint64_t blocks             = 0;
+   uint64_t bytes              = 0; ///< as sent over the network, possibly compressed
+   uint64_t uncompressed_bytes = 0;
+};
 
+/// Adds the wall clock time of its lifetime to a counter
+class handler_timer
+{
 public:
-   void block_accepted();
-   void cache_message( const message& message_to_cache,
-                       const message_hash_type& hash_of_message_to_cache,
-                       const message_propagation_data& propagation_data,
-                       const message_hash_type& message_content_hash );
-   message get_message( const message_hash_type& hash_of_message_to_lookup ) const;
-   message_propagation_data get_message_propagation_data(
-         const message_hash_type& hash_of_msg_contents_to_lookup ) const;
-   size_t size() const { return _message_cache.size(); }
+   explicit handler_timer( uint64_t& total_us ) : _total_us( total_us ), _start( fc::time_point::now() ) {}
+   ~handler_timer() { _total_us += ( fc::time_point::now() - _start ).count(); }
+
+private:
+   uint64_t&            _total_us;
+   const fc::time_point _start;
 };
 
 /// When requesting items from peers, we want to prioritize any blocks before
@@ -245,8 +185,10 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
                                (handle_message) \
                                (handle_block) \
                                (handle_transaction) \
+                               (get_transaction_priority) \
                                (get_block_ids) \
                                (get_item) \
+                               (get_packed_blocks) \
                                (get_chain_id) \
                                (get_blockchain_synopsis) \
                                (sync_status) \
@@ -344,10 +286,13 @@ class statistics_gathering_node_delegate_wrapper : public node_delegate
       bool handle_block( const graphene::net::block_message& block_message, bool sync_mode,
                          std::vector<message_hash_type>& contained_transaction_msg_ids ) override;
       void handle_transaction( const graphene::net::trx_message& transaction_message ) override;
+      uint64_t get_transaction_priority( const graphene::net::trx_message& transaction_message ) override;
       std::vector<item_hash_t> get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                              uint32_t& remaining_item_count,
                                              uint32_t limit = 2000) override;
       message get_item( const item_id& id ) override;
+      std::vector<std::vector<char>> get_packed_blocks( uint32_t first_block_num, uint32_t count,
+                                                        size_t max_bytes ) override;
       graphene::protocol::chain_id_type get_chain_id() const override;
       std::vector<item_hash_t> get_blockchain_synopsis(const item_hash_t& reference_point,
                                                        uint32_t number_of_blocks_after_reference_point) override;
@@ -386,8 +331,12 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       std::unique_ptr<statistics_gathering_node_delegate_wrapper> _delegate;
       fc::sha256           _chain_id;
 
+      /// Reads, hashes and decodes the messages of new connections, if the node has I/O threads.  Declared
+      /// before the connections so that it outlives them.
+      std::unique_ptr<message_io_pool> _message_io_pool;
+
 #define NODE_CONFIGURATION_FILENAME      "node_config.json"
-#define POTENTIAL_PEER_DATABASE_FILENAME "peers.json"
+#define POTENTIAL_PEER_DATABASE_FILENAME "peers.dat" // converted from peers.json if that exists
       fc::path             _node_configuration_directory;
       node_configuration   _node_configuration;
 
@@ -463,10 +412,22 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       /// @{
       fc::promise<void>::ptr        _retrigger_advertise_inventory_loop_promise;
       fc::future<void>              _advertise_inventory_loop_done;
+      advertise_inventory_statistics _advertise_inventory_stats;
+      /// Keyed by message type
+      std::map<uint32_t, message_handling_statistics> _message_handling_stats;
       /// List of items we have received but not yet advertised to our peers
       concurrent_unordered_set<item_id>   _new_inventory;
       /// @}
 
+      /// Used by the task that processes the transactions received from our peers
+      /// @{
+      fc::promise<void>::ptr        _retrigger_relayed_transactions_loop_promise;
+      fc::future<void>              _process_relayed_transactions_loop_done;
+      transaction_relay_scheduler   _transaction_relay_scheduler { GRAPHENE_NET_MAX_TRX_PER_SECOND,
+                                          GRAPHENE_NET_MAX_TRX_PER_SECOND * GRAPHENE_NET_TRX_BURST_SECONDS,
+                                          GRAPHENE_NET_MAX_QUEUED_TRX_PER_PEER };
+      /// @}
+
       fc::future<void>     _kill_inactive_conns_loop_done;
       /// A cached copy of the block interval, to avoid a thread hop to the blockchain to get the current value
       uint8_t _recent_block_interval_seconds = GRAPHENE_MAX_BLOCK_INTERVAL;
@@ -502,15 +463,17 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
 
       /// Stores all connections which have not yet finished key exchange or are still sending
       /// initial handshaking messages back and forth (not yet ready to initiate syncing)
-      concurrent_unordered_set<graphene::net::peer_connection_ptr>               _handshaking_connections;
+      /// The connection sets are iterated through snapshots, which don't need a lock and stay valid
+      /// while connections are moved between the sets
+      copy_on_write_set<graphene::net::peer_connection_ptr>                      _handshaking_connections;
       /** Stores fully established connections we're either syncing with or in normal operation with */
-      concurrent_unordered_set<graphene::net::peer_connection_ptr>               _active_connections;
+      copy_on_write_set<graphene::net::peer_connection_ptr>                      _active_connections;
       /// Stores connections we've closed (sent closing message, not actually closed),
       /// but are still waiting for the remote end to close before we delete them
-      concurrent_unordered_set<graphene::net::peer_connection_ptr>               _closing_connections;
+      copy_on_write_set<graphene::net::peer_connection_ptr>                      _closing_connections;
       /// Stores connections we've closed, but are still waiting for the OS to notify us that the socket
       /// is really closed
-      concurrent_unordered_set<graphene::net::peer_connection_ptr>               _terminating_connections;
+      copy_on_write_set<graphene::net::peer_connection_ptr>                      _terminating_connections;
 
       /// The /n/ most recent blocks we've accepted (currently tuned to the max number of connections)
       boost::circular_buffer<item_hash_t> _most_recent_blocks_accepted { _maximum_number_of_connections };
@@ -587,6 +550,12 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       size_t _max_sync_blocks_to_prefetch = MAX_SYNC_BLOCKS_TO_PREFETCH;
       /// Maximum number of blocks per peer during syncing
       size_t _max_sync_blocks_per_peer = GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING;
+      /// Whether we request and serve ranges of blocks by number during syncing, with peers supporting it
+      bool _block_range_sync_enabled = true;
+      /// Whether we ask for and send zlib compressed block ranges, with peers supporting it
+      bool _compress_block_ranges = true;
+      block_range_statistics _block_ranges_received;
+      block_range_statistics _block_ranges_sent;
 
       std::list<fc::future<void> > _handle_message_calls_in_progress;
 
@@ -609,6 +578,9 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       bool have_already_received_sync_item( const item_hash_t& item_hash );
       void request_sync_item_from_peer( const peer_connection_ptr& peer, const item_hash_t& item_to_request );
       void request_sync_items_from_peer( const peer_connection_ptr& peer, const std::vector<item_hash_t>& items_to_request );
+      void request_sync_block_range_from_peer( const peer_connection_ptr& peer, const std::vector<item_hash_t>& range_to_request );
+      void continue_syncing_with_peer( peer_connection* peer );
+      uint32_t get_supported_features() const;
       void fetch_sync_items_loop();
       void trigger_fetch_sync_items_loop();
 
@@ -619,6 +591,9 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       void advertise_inventory_loop();
       void trigger_advertise_inventory_loop();
 
+      void process_relayed_transactions_loop();
+      void trigger_process_relayed_transactions_loop();
+
       void kill_inactive_conns_loop(node_impl_ptr self);
 
       void fetch_updated_peer_lists_loop();
@@ -666,6 +641,12 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       void on_fetch_items_message( peer_connection* originating_peer,
                                    const fetch_items_message& fetch_items_message_received ) const;
 
+      void on_fetch_block_range_message( peer_connection* originating_peer,
+                                         const fetch_block_range_message& fetch_block_range_message_received );
+
+      void on_block_range_message( peer_connection* originating_peer,
+                                   const block_range_message& block_range_message_received );
+
       void on_item_not_available_message( peer_connection* originating_peer,
                                           const item_not_available_message& item_not_available_message_received );
 
@@ -711,6 +692,12 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
                   peer_connection* originating_peer,
                   const message& message_to_process,
                   const message_hash_type& message_hash);
+      void handle_ordinary_message(
+                  const message& message_to_process,
+                  const message_hash_type& message_hash,
+                  const node_id_t& originating_node,
+                  const fc::optional<fc::ip::endpoint>& originating_endpoint,
+                  const fc::time_point& message_receive_time);
 
       void start_synchronizing();
       void start_synchronizing_with_peer(const peer_connection_ptr& peer);
@@ -762,6 +749,7 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
 
       void broadcast(const message& item_to_broadcast, const message_propagation_data& propagation_data);
       void broadcast(const message& item_to_broadcast);
+      void broadcast_transactions(const std::vector<signed_transaction>& trxs);
       void sync_from(const item_id& current_head_block, const std::vector<uint32_t>& hard_fork_block_numbers);
       bool is_connected() const;
       std::vector<potential_peer_record> get_potential_peers() const;
@@ -775,6 +763,8 @@ class node_impl : public peer_connection_delegate, public std::enable_shared_fro
       void                       set_allowed_peers( const std::vector<node_id_t>& allowed_peers );
       void                       clear_peer_database();
       void                       set_total_bandwidth_limit( uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second );
+      void                       set_io_thread_count( uint16_t num_threads );
+      message_io_pool*           get_message_io_pool() override;
       void                       disable_peer_advertising();
       fc::variant_object         get_call_statistics() const;
       message                    get_message_for_item(const item_id& item) override;
@@ -797,3 +787,11 @@ FC_REFLECT(graphene::net::detail::node_configuration, (listen_endpoint)
                                                  (accept_incoming_connections)
                                                  (wait_if_endpoint_is_busy)
                                                  (private_key))
+FC_REFLECT(graphene::net::detail::advertise_inventory_statistics, (iterations)
+                                                               (items)
+                                                               (advertisements)
+                                                               (total_us)
+                                                               (max_us)
+                                                               (last_us))
+FC_REFLECT(graphene::net::detail::message_handling_statistics, (messages)(bytes)(handler_us))
+FC_REFLECT(graphene::net::detail::block_range_statistics, (ranges)(blocks)(bytes)(uncompressed_bytes))
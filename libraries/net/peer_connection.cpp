@@ -49,11 +49,14 @@ namespace graphene { namespace net
       if (message_send_time_field_offset != (size_t)-1)
       {
         // patch the current time into the message.  Since this operates on the packed version of the structure,
-        // it won't work for anything after a variable-length field
+        // it won't work for anything after a variable-length field.
+        // The payload may be shared with other messages, so the patched message gets its own copy
         std::vector<char> packed_current_time = fc::raw::pack(fc::time_point::now());
         assert(message_send_time_field_offset + packed_current_time.size() <= message_to_send.data.size());
-        memcpy(message_to_send.data.data() + message_send_time_field_offset,
+        std::vector<char> patched_data = message_to_send.data.to_vector();
+        memcpy(patched_data.data() + message_send_time_field_offset,
                packed_current_time.data(), packed_current_time.size());
+        message_to_send.data = std::move(patched_data);
       }
       return message_to_send;
     }
@@ -73,7 +76,7 @@ namespace graphene { namespace net
 
     peer_connection::peer_connection(peer_connection_delegate* delegate) :
       _node(delegate),
-      _message_connection(this),
+      _message_connection(this, delegate ? delegate->get_message_io_pool() : nullptr),
       _total_queued_messages_size(0),
       direction(peer_connection_direction::unknown),
       is_firewalled(firewalled_state::unknown),
@@ -485,23 +488,14 @@ namespace graphene { namespace net
     void peer_connection::clear_old_inventory()
     {
       VERIFY_CORRECT_THREAD();
-      fc::time_point_sec oldest_inventory_to_keep(fc::time_point::now() - fc::minutes(GRAPHENE_NET_MAX_INVENTORY_SIZE_IN_MINUTES));
-
-      // expire old items from inventory_advertised_to_peer
-      auto oldest_inventory_to_keep_iter = inventory_advertised_to_peer.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-      auto begin_iter = inventory_advertised_to_peer.get<timestamp_index>().begin();
-      unsigned number_of_elements_advertised_to_peer_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-      inventory_advertised_to_peer.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
-
-      // also expire items from inventory_peer_advertised_to_us
-      oldest_inventory_to_keep_iter = inventory_peer_advertised_to_us.get<timestamp_index>().lower_bound(oldest_inventory_to_keep);
-      begin_iter = inventory_peer_advertised_to_us.get<timestamp_index>().begin();
-      unsigned number_of_elements_peer_advertised_to_discard = std::distance(begin_iter, oldest_inventory_to_keep_iter);
-      inventory_peer_advertised_to_us.get<timestamp_index>().erase(begin_iter, oldest_inventory_to_keep_iter);
-      dlog("Expiring old inventory for peer ${peer}: removing ${to_peer} items advertised to peer (${remain_to_peer} left), and ${to_us} advertised to us (${remain_to_us} left)",
-           ("peer", get_remote_endpoint())
-           ("to_peer", number_of_elements_advertised_to_peer_to_discard)("remain_to_peer", inventory_advertised_to_peer.size())
-           ("to_us", number_of_elements_peer_advertised_to_discard)("remain_to_us", inventory_peer_advertised_to_us.size()));
+      const fc::time_point now = fc::time_point::now();
+      const size_t number_of_elements_advertised_to_peer_to_discard = inventory_advertised_to_peer.expire(now);
+      const size_t number_of_elements_peer_advertised_to_discard = inventory_peer_advertised_to_us.expire(now);
+      if (number_of_elements_advertised_to_peer_to_discard > 0 || number_of_elements_peer_advertised_to_discard > 0)
+        dlog("Expiring old inventory for peer ${peer}: removing ${to_peer} items advertised to peer (${remain_to_peer} left), and ${to_us} advertised to us (${remain_to_us} left)",
+             ("peer", get_remote_endpoint())
+             ("to_peer", number_of_elements_advertised_to_peer_to_discard)("remain_to_peer", inventory_advertised_to_peer.size())
+             ("to_us", number_of_elements_peer_advertised_to_discard)("remain_to_us", inventory_peer_advertised_to_us.size()));
     }
 
     // we have a higher limit for blocks than transactions so we will still fetch blocks even when transactions are throttled
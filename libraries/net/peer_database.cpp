@@ -27,7 +27,9 @@
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/tag.hpp>
+#include <boost/endian/buffers.hpp>
 
+#include <fc/filesystem.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/io/raw_variant.hpp>
 #include <fc/log/logger.hpp>
@@ -36,11 +38,44 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/config.hpp>
 
+#include <fstream>
+
 namespace graphene { namespace net {
   namespace detail
   {
     using namespace boost::multi_index;
 
+    /**
+     * The peer database file is a log of changes to the set of potential peers.  It starts with a
+     * peer_log_header, followed by entries of a peer_log_entry_type byte, the size of the payload as a
+     * little endian uint32 and the raw packed payload: a potential_peer_record for updates, an endpoint for
+     * erasures and nothing for clearing the database.
+     *
+     * Changes are appended to the log as they are made, so they survive if the node is killed.  The log is
+     * rewritten with the current records only when it is opened, when it is closed, and when it has grown to
+     * more than twice the size needed.
+     */
+    enum class peer_log_entry_type : uint8_t
+    {
+      update = 0,
+      erase  = 1,
+      clear  = 2
+    };
+
+    struct peer_log_header
+    {
+      static constexpr uint32_t current_magic   = 0x52454550; // "PEER"
+      static constexpr uint32_t current_version = 1;
+
+      uint32_t magic   = current_magic;
+      uint32_t version = current_version;
+    };
+
+    /// the log is compacted when it has more entries than this and twice the number of records
+    static const uint64_t min_log_entries_to_compact = 1000;
+    /// larger entries are considered corrupt
+    static const uint32_t max_log_entry_size = 1024 * 1024;
+
     class peer_database_impl
     {
     public:
@@ -61,6 +96,13 @@ namespace graphene { namespace net {
     private:
       potential_peer_set     _potential_peer_set;
       fc::path _peer_database_filename;
+      std::ofstream _log;
+      uint64_t _log_entries = 0;
+
+      void load_log();
+      void load_legacy_json(const fc::path& json_filename);
+      void append_to_log(peer_log_entry_type type, const std::vector<char>& payload = std::vector<char>());
+      void compact_log();
 
     public:
       void open(const fc::path& databaseFilename);
@@ -91,59 +133,184 @@ namespace graphene { namespace net {
     void peer_database_impl::open(const fc::path& peer_database_filename)
     {
       _peer_database_filename = peer_database_filename;
-      if (fc::exists(_peer_database_filename))
+      fc::path legacy_json_filename = peer_database_filename;
+      legacy_json_filename.replace_extension(".json");
+      try
+      {
+        if (fc::exists(_peer_database_filename))
+          load_log();
+        else if (legacy_json_filename != _peer_database_filename && fc::exists(legacy_json_filename))
+          load_legacy_json(legacy_json_filename);
+      }
+      catch (const fc::exception& e)
+      {
+        elog("error opening peer database file ${peer_database_filename}, starting with a clean database: ${e}",
+             ("peer_database_filename", _peer_database_filename)("e", e.to_detail_string()));
+        _potential_peer_set.clear();
+      }
+      if (_potential_peer_set.size() > MAXIMUM_PEERDB_SIZE)
+      {
+        // prune database to a reasonable size
+        auto iter = _potential_peer_set.begin();
+        std::advance(iter, MAXIMUM_PEERDB_SIZE);
+        _potential_peer_set.erase(iter, _potential_peer_set.end());
+      }
+      compact_log();
+    }
+
+    void peer_database_impl::load_log()
+    {
+      std::ifstream in(_peer_database_filename.generic_string().c_str(), std::ios::in | std::ios::binary);
+      FC_ASSERT(in.good(), "Unable to open the peer database");
+      peer_log_header header;
+      in.read((char*)&header, sizeof(header));
+      FC_ASSERT(in.gcount() == sizeof(header) && header.magic == peer_log_header::current_magic,
+                "Not a peer database file");
+      FC_ASSERT(header.version == peer_log_header::current_version,
+                "Unsupported peer database version ${v}", ("v", header.version));
+
+      std::vector<char> payload;
+      uint64_t entries = 0;
+      while (true)
       {
-        try
+        char entry_prefix[sizeof(uint8_t) + sizeof(uint32_t)];
+        in.read(entry_prefix, sizeof(entry_prefix));
+        if (in.gcount() == 0)
+          break;
+        boost::endian::little_uint32_buf_t size;
+        memcpy(&size, entry_prefix + sizeof(uint8_t), sizeof(size));
+        if (in.gcount() != sizeof(entry_prefix) || size.value() > max_log_entry_size)
         {
-          std::vector<potential_peer_record> peer_records = fc::json::from_file(_peer_database_filename).as<std::vector<potential_peer_record> >( GRAPHENE_NET_MAX_NESTED_OBJECTS );
-          std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
-          if (_potential_peer_set.size() > MAXIMUM_PEERDB_SIZE)
-          {
-            // prune database to a reasonable size
-            auto iter = _potential_peer_set.begin();
-            std::advance(iter, MAXIMUM_PEERDB_SIZE);
-            _potential_peer_set.erase(iter, _potential_peer_set.end());
-          }
+          wlog("Ignoring a damaged entry at the end of the peer database after ${n} entries", ("n", entries));
+          break;
         }
-        catch (const fc::exception& e)
+        payload.resize(size.value());
+        in.read(payload.data(), payload.size());
+        if ((size_t)in.gcount() != payload.size())
+        {
+          // most likely the node was killed while writing the entry
+          wlog("Ignoring a truncated entry at the end of the peer database after ${n} entries", ("n", entries));
+          break;
+        }
+        switch (static_cast<peer_log_entry_type>(entry_prefix[0]))
+        {
+        case peer_log_entry_type::update:
         {
-          elog("error opening peer database file ${peer_database_filename}, starting with a clean database", 
-               ("peer_database_filename", _peer_database_filename));
+          potential_peer_record record = fc::raw::unpack<potential_peer_record>(payload, GRAPHENE_NET_MAX_NESTED_OBJECTS);
+          auto iter = _potential_peer_set.get<endpoint_index>().find(record.endpoint);
+          if (iter != _potential_peer_set.get<endpoint_index>().end())
+            _potential_peer_set.get<endpoint_index>().replace(iter, record);
+          else
+            _potential_peer_set.get<endpoint_index>().insert(std::move(record));
+          break;
         }
+        case peer_log_entry_type::erase:
+          _potential_peer_set.get<endpoint_index>().erase(fc::raw::unpack<fc::ip::endpoint>(payload));
+          break;
+        case peer_log_entry_type::clear:
+          _potential_peer_set.clear();
+          break;
+        default:
+          FC_THROW("Unknown peer database entry type ${t}", ("t", (uint32_t)(uint8_t)entry_prefix[0]));
+        }
+        ++entries;
       }
+      dlog("Loaded ${n} potential peers from ${e} entries of the peer database", ("n", _potential_peer_set.size())("e", entries));
     }
 
-    void peer_database_impl::close()
+    void peer_database_impl::load_legacy_json(const fc::path& json_filename)
+    {
+      ilog("Converting the peer database ${json_filename} to ${peer_database_filename}",
+           ("json_filename", json_filename)("peer_database_filename", _peer_database_filename));
+      std::vector<potential_peer_record> peer_records = fc::json::from_file(json_filename).as<std::vector<potential_peer_record> >( GRAPHENE_NET_MAX_NESTED_OBJECTS );
+      std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
+    }
+
+    static void write_log_entry(std::ostream& out, peer_log_entry_type type, const std::vector<char>& payload)
+    {
+      char entry_prefix[sizeof(uint8_t) + sizeof(uint32_t)];
+      entry_prefix[0] = static_cast<char>(type);
+      boost::endian::little_uint32_buf_t size(static_cast<uint32_t>(payload.size()));
+      memcpy(entry_prefix + sizeof(uint8_t), &size, sizeof(size));
+      out.write(entry_prefix, sizeof(entry_prefix));
+      out.write(payload.data(), payload.size());
+    }
+
+    void peer_database_impl::append_to_log(peer_log_entry_type type, const std::vector<char>& payload)
     {
-      std::vector<potential_peer_record> peer_records;
-      peer_records.reserve(_potential_peer_set.size());
-      std::copy(_potential_peer_set.begin(), _potential_peer_set.end(), std::back_inserter(peer_records));
+      if (!_log.is_open())
+        return;
+      write_log_entry(_log, type, payload);
+      _log.flush();
+      if (!_log.good())
+      {
+        elog("error writing to the peer database file ${peer_database_filename}",
+             ("peer_database_filename", _peer_database_filename));
+        _log.close();
+        return;
+      }
+      ++_log_entries;
+      if (_log_entries > std::max<uint64_t>(min_log_entries_to_compact, 2 * _potential_peer_set.size()))
+        compact_log();
+    }
 
+    void peer_database_impl::compact_log()
+    {
+      if (_peer_database_filename == fc::path())
+        return;
+      _log.close();
       try
       {
         fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
         if (!fc::exists(peer_database_filename_dir))
           fc::create_directories(peer_database_filename_dir);
-        fc::json::save_to_file( peer_records, _peer_database_filename, GRAPHENE_NET_MAX_NESTED_OBJECTS );
+
+        // write the records to a new file and replace the log with it, so that the log is never lost half written
+        fc::path new_filename = _peer_database_filename;
+        new_filename.replace_extension(".tmp");
+        {
+          std::ofstream out(new_filename.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+          const peer_log_header header;
+          out.write((const char*)&header, sizeof(header));
+          for (const potential_peer_record& record : _potential_peer_set)
+            write_log_entry(out, peer_log_entry_type::update, fc::raw::pack(record));
+          out.flush();
+          FC_ASSERT(out.good(), "Unable to write ${f}", ("f", new_filename));
+        }
+        fc::rename(new_filename, _peer_database_filename);
+        _log.open(_peer_database_filename.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::app);
+        _log_entries = _potential_peer_set.size();
       }
       catch (const fc::exception& e)
       {
-        elog("error saving peer database to file ${peer_database_filename}", 
-             ("peer_database_filename", _peer_database_filename));
+        elog("error saving peer database to file ${peer_database_filename}: ${e}",
+             ("peer_database_filename", _peer_database_filename)("e", e.to_detail_string()));
       }
+    }
+
+    void peer_database_impl::close()
+    {
+      compact_log();
+      _log.close();
+      _log_entries = 0;
+      _peer_database_filename = fc::path();
       _potential_peer_set.clear();
     }
 
     void peer_database_impl::clear()
     {
       _potential_peer_set.clear();
+      append_to_log(peer_log_entry_type::clear);
     }
 
     void peer_database_impl::erase(const fc::ip::endpoint& endpointToErase)
     {
       auto iter = _potential_peer_set.get<endpoint_index>().find(endpointToErase);
       if (iter != _potential_peer_set.get<endpoint_index>().end())
+      {
         _potential_peer_set.get<endpoint_index>().erase(iter);
+        append_to_log(peer_log_entry_type::erase, fc::raw::pack(endpointToErase));
+      }
     }
 
     void peer_database_impl::update_entry(const potential_peer_record& updatedRecord)
@@ -153,6 +320,7 @@ namespace graphene { namespace net {
         _potential_peer_set.get<endpoint_index>().modify(iter, [&updatedRecord](potential_peer_record& record) { record = updatedRecord; });
       else
         _potential_peer_set.get<endpoint_index>().insert(updatedRecord);
+      append_to_log(peer_log_entry_type::update, fc::raw::pack(updatedRecord));
     }
 
     potential_peer_record peer_database_impl::lookup_or_create_entry_for_endpoint(const fc::ip::endpoint& endpointToLookup)
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/net/relay_scheduler.hpp>
+
+#include <algorithm>
+#include <iterator>
+
+namespace graphene { namespace net {
+
+  transaction_relay_scheduler::transaction_relay_scheduler( double transactions_per_second, double burst,
+                                                            size_t max_queue_size )
+    : _transactions_per_second( transactions_per_second ),
+      _burst( std::max( burst, 1.0 ) ),
+      _max_queue_size( std::max<size_t>( max_queue_size, 1 ) )
+  {
+  }
+
+  double transaction_relay_scheduler::tokens_at( const peer_queue& queue, const fc::time_point& now )const
+  {
+    if( now <= queue.last_refill )
+      return queue.tokens;
+    const double elapsed_seconds = double( ( now - queue.last_refill ).count() ) / 1000000;
+    return std::min( _burst, queue.tokens + elapsed_seconds * _transactions_per_second );
+  }
+
+  void transaction_relay_scheduler::forget_hash( const message_hash_type& hash )
+  {
+    auto itr = _queued_hashes.find( hash );
+    if( itr != _queued_hashes.end() )
+      _queued_hashes.erase( itr );
+  }
+
+  bool transaction_relay_scheduler::push( peer_key peer, queued_transaction trx, const fc::time_point& now )
+  {
+    auto itr = _peers.find( peer );
+    if( itr == _peers.end() )
+    {
+      itr = _peers.emplace( peer, peer_queue() ).first;
+      itr->second.tokens = _burst;
+      itr->second.last_refill = now;
+    }
+    peer_queue& queue = itr->second;
+
+    const uint64_t sequence = _next_sequence++;
+    trx.sequence = sequence;
+    _queued_hashes.insert( trx.message_hash );
+    queue.transactions.insert( std::move( trx ) );
+    ++queue.statistics.received;
+    ++_size;
+
+    bool queued = true;
+    if( queue.transactions.size() > _max_queue_size )
+    {
+      auto lowest = std::prev( queue.transactions.end() );
+      queued = lowest->sequence != sequence;
+      forget_hash( lowest->message_hash );
+      queue.transactions.erase( lowest );
+      ++queue.statistics.dropped;
+      --_size;
+    }
+    if( !queue.scheduled )
+    {
+      queue.scheduled = true;
+      _round_robin.push_back( peer );
+    }
+    return queued;
+  }
+
+  fc::optional<transaction_relay_scheduler::queued_transaction> transaction_relay_scheduler::pop(
+        const fc::time_point& now )
+  {
+    for( size_t turns = _round_robin.size(); turns > 0; --turns )
+    {
+      const peer_key peer = _round_robin.front();
+      _round_robin.pop_front();
+      auto itr = _peers.find( peer );
+      if( itr == _peers.end() )
+        continue;
+      peer_queue& queue = itr->second;
+      if( queue.transactions.empty() )
+      {
+        queue.scheduled = false;
+        continue;
+      }
+      // the peer goes to the end of the line whether it is served now or not
+      _round_robin.push_back( peer );
+      queue.tokens = tokens_at( queue, now );
+      queue.last_refill = std::max( now, queue.last_refill );
+      if( queue.tokens < 1 )
+        continue;
+
+      queue.tokens -= 1;
+      auto next = queue.transactions.begin();
+      fc::optional<queued_transaction> result( std::move( const_cast<queued_transaction&>( *next ) ) );
+      queue.transactions.erase( next );
+      forget_hash( result->message_hash );
+      ++queue.statistics.dispatched;
+      --_size;
+      return result;
+    }
+    return fc::optional<queued_transaction>();
+  }
+
+  fc::time_point transaction_relay_scheduler::next_ready_time( const fc::time_point& now )const
+  {
+    fc::time_point ready = fc::time_point::maximum();
+    for( const peer_key peer : _round_robin )
+    {
+      auto itr = _peers.find( peer );
+      if( itr == _peers.end() || itr->second.transactions.empty() )
+        continue;
+      const double tokens = tokens_at( itr->second, now );
+      if( tokens >= 1 )
+        return now;
+      if( _transactions_per_second <= 0 )
+        continue;
+      const int64_t wait_us = int64_t( ( 1 - tokens ) / _transactions_per_second * 1000000 ) + 1;
+      ready = std::min( ready, now + fc::microseconds( wait_us ) );
+    }
+    return ready;
+  }
+
+  std::vector<message_hash_type> transaction_relay_scheduler::remove_peer( peer_key peer )
+  {
+    std::vector<message_hash_type> dropped;
+    auto itr = _peers.find( peer );
+    if( itr == _peers.end() )
+      return dropped;
+    dropped.reserve( itr->second.transactions.size() );
+    for( const queued_transaction& trx : itr->second.transactions )
+    {
+      forget_hash( trx.message_hash );
+      dropped.push_back( trx.message_hash );
+    }
+    _size -= itr->second.transactions.size();
+    _peers.erase( itr );
+    _round_robin.erase( std::remove( _round_robin.begin(), _round_robin.end(), peer ), _round_robin.end() );
+    return dropped;
+  }
+
+  relay_queue_statistics transaction_relay_scheduler::get_statistics( peer_key peer, const fc::time_point& now )const
+  {
+    auto itr = _peers.find( peer );
+    if( itr == _peers.end() )
+    {
+      relay_queue_statistics statistics;
+      statistics.tokens = _burst;
+      return statistics;
+    }
+    relay_queue_statistics statistics = itr->second.statistics;
+    statistics.queued = static_cast<uint32_t>( itr->second.transactions.size() );
+    statistics.tokens = tokens_at( itr->second, now );
+    return statistics;
+  }
+
+} } // graphene::net
@@ -28,6 +28,9 @@ class debug_api_impl
       void debug_update_object( const fc::variant_object& update );
       void debug_stream_json_objects( const std::string& filename );
       void debug_stream_json_objects_flush();
+      void debug_enable_apply_profiler( bool enable );
+      graphene::chain::apply_profile debug_get_apply_profile();
+      void debug_reset_apply_profile();
       std::shared_ptr< graphene::debug_witness_plugin::debug_witness_plugin > get_plugin();
 
       graphene::app::application& app;
@@ -121,6 +124,25 @@ void debug_api_impl::debug_stream_json_objects_flush()
    get_plugin()->flush_json_object_stream();
 }
 
+void debug_api_impl::debug_enable_apply_profiler( bool enable )
+{
+   app.chain_database()->enable_apply_profiler( enable );
+}
+
+graphene::chain::apply_profile debug_api_impl::debug_get_apply_profile()
+{
+   const graphene::chain::apply_profiler* profiler = app.chain_database()->get_apply_profiler();
+   FC_ASSERT( profiler != nullptr, "The block apply profiler is not enabled" );
+   return profiler->get_profile();
+}
+
+void debug_api_impl::debug_reset_apply_profile()
+{
+   graphene::chain::apply_profiler* profiler = app.chain_database()->get_apply_profiler();
+   FC_ASSERT( profiler != nullptr, "The block apply profiler is not enabled" );
+   profiler->reset();
+}
+
 } // detail
 
 debug_api::debug_api( graphene::app::application& app )
@@ -153,5 +175,19 @@ void debug_api::debug_stream_json_objects_flush()
    my->debug_stream_json_objects_flush();
 }
 
+void debug_api::debug_enable_apply_profiler( bool enable )
+{
+   my->debug_enable_apply_profiler( enable );
+}
+
+graphene::chain::apply_profile debug_api::debug_get_apply_profile()
+{
+   return my->debug_get_apply_profile();
+}
+
+void debug_api::debug_reset_apply_profile()
+{
+   my->debug_reset_apply_profile();
+}
 
 } } // graphene::debug_witness
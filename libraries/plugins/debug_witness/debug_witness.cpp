@@ -51,7 +51,10 @@ void debug_witness_plugin::plugin_set_program_options(
    command_line_options.add_options()
          ("debug-private-key", bpo::value<vector<string>>()->composing()->multitoken()->
           DEFAULT_VALUE_VECTOR(std::make_pair(chain::public_key_type(default_priv_key.get_public_key()), graphene::utilities::key_to_wif(default_priv_key))),
-          "Tuple of [PublicKey, WIF private key] (may specify multiple times)");
+          "Tuple of [PublicKey, WIF private key] (may specify multiple times)")
+         ("debug-profile-block-apply", bpo::value<bool>()->implicit_value(true),
+          "Whether to profile the time and object changes spent per operation type and block phase while applying "
+          "blocks, the profile is logged at the end of a replay and can be queried with debug_get_apply_profile");
    config_file_options.add(command_line_options);
 }
 
@@ -89,6 +92,9 @@ void debug_witness_plugin::plugin_initialize(const boost::program_options::varia
          _private_keys[key_id_to_wif_pair.first] = *private_key;
       }
    }
+   if( options.count("debug-profile-block-apply") > 0 && options["debug-profile-block-apply"].as<bool>() )
+      database().enable_apply_profiler( true );
+
    ilog("debug_witness plugin:  plugin_initialize() end");
 } FC_LOG_AND_RETHROW() }
 
@@ -26,6 +26,8 @@
 #include <memory>
 #include <string>
 
+#include <graphene/chain/apply_profiler.hpp>
+
 #include <fc/api.hpp>
 #include <fc/variant_object.hpp>
 
@@ -82,6 +84,21 @@ class debug_api
        */
       void debug_stream_json_objects_flush();
 
+      /**
+       * Enable or disable the block apply profiler. Disabling it discards the collected data.
+       */
+      void debug_enable_apply_profiler( bool enable );
+
+      /**
+       * Get the time and object changes spent per operation type and per block phase while applying blocks.
+       */
+      graphene::chain::apply_profile debug_get_apply_profile();
+
+      /**
+       * Clear the data collected by the block apply profiler.
+       */
+      void debug_reset_apply_profile();
+
       std::shared_ptr< detail::debug_api_impl > my;
 };
 
@@ -93,4 +110,7 @@ FC_API(graphene::debug_witness::debug_api,
        (debug_update_object)
        (debug_stream_json_objects)
        (debug_stream_json_objects_flush)
+       (debug_enable_apply_profiler)
+       (debug_get_apply_profile)
+       (debug_reset_apply_profile)
      )
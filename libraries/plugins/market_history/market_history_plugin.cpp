@@ -307,7 +307,7 @@ void market_history_plugin_impl::update_market_histories( const signed_block& b
    if( lp_meta_idx.size() > 0 )
       _lp_meta = &( *lp_meta_idx.begin() );
 
-   const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
+   const applied_operation_log& hist = db.get_applied_operations();
    for( const optional< operation_history_object >& o_op : hist )
    {
       if( o_op.valid() )
@@ -341,7 +341,9 @@ block_production_condition::block_production_condition_enum witness_plugin::mayb
    //
    assert( now > db.head_block_time() );
 
-   graphene::chain::witness_id_type scheduled_witness = db.get_scheduled_witness( slot );
+   // the schedule of the round is cached by the database along with the signing keys
+   const graphene::chain::scheduled_witness_slot scheduled = db.get_scheduled_witness_slot( slot );
+   const graphene::chain::witness_id_type scheduled_witness = scheduled.witness;
    // we must control the witness scheduled to produce the next block.
    if( _witnesses.find( scheduled_witness ) == _witnesses.end() )
    {
@@ -350,7 +352,7 @@ block_production_condition::block_production_condition_enum witness_plugin::mayb
    }
 
    fc::time_point_sec scheduled_time = db.get_slot_time( slot );
-   graphene::chain::public_key_type scheduled_key = *_witness_key_cache[scheduled_witness]; // should be valid
+   const graphene::chain::public_key_type& scheduled_key = scheduled.signing_key;
    auto private_key_itr = _private_keys.find( scheduled_key );
 
    if( private_key_itr == _private_keys.end() )
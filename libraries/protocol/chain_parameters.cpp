@@ -79,6 +79,14 @@ namespace graphene { namespace protocol {
       return *this;
    }
 
+   fee_schedule& chain_parameters::get_mutable_fees()
+   {
+      FC_ASSERT( current_fees );
+      auto& fees = const_cast<fee_schedule&>( *current_fees );
+      fees.invalidate_fee_table();
+      return fees;
+   }
+
    void chain_parameters::validate()const
    {
       get_current_fees().validate();
@@ -29,23 +29,31 @@
 
 namespace graphene { namespace protocol {
 
-void transfer_to_blind_operation::validate()const
+void transfer_to_blind_operation::validate( bool verify_commitments )const
 {
    FC_ASSERT( fee.amount >= 0 );
    FC_ASSERT( amount.amount > 0 );
 
-   vector<commitment_type> in;
-   vector<commitment_type> out(outputs.size());
-   int64_t                 net_public = amount.amount.value;
-   for( uint32_t i = 0; i < out.size(); ++i )
+   for( uint32_t i = 0; i < outputs.size(); ++i )
    {
-      out[i] = outputs[i].commitment;
       /// require all outputs to be sorted prevents duplicates AND prevents implementations
       /// from accidentally leaking information by how they arrange commitments.
-      if( i > 0 ) FC_ASSERT( out[i-1] < out[i], "all outputs must be sorted by commitment id" );
+      if( i > 0 ) FC_ASSERT( outputs[i-1].commitment < outputs[i].commitment,
+                             "all outputs must be sorted by commitment id" );
       FC_ASSERT( !outputs[i].owner.is_impossible() );
    }
-   FC_ASSERT( out.size(), "there must be at least one output" );
+   FC_ASSERT( outputs.size(), "there must be at least one output" );
+
+   if( verify_commitments )
+      this->verify_commitments();
+}
+
+void transfer_to_blind_operation::verify_commitments()const
+{
+   vector<commitment_type> out(outputs.size());
+   int64_t                 net_public = amount.amount.value;
+   for( uint32_t i = 0; i < out.size(); ++i )
+      out[i] = outputs[i].commitment;
 
    auto public_c = fc::ecc::blind(blinding_factor,net_public);
 
@@ -67,24 +75,31 @@ share_type transfer_to_blind_operation::calculate_fee( const fee_parameters_type
 }
 
 
-void transfer_from_blind_operation::validate()const
+void transfer_from_blind_operation::validate( bool verify_commitments )const
 {
    FC_ASSERT( amount.amount > 0 );
    FC_ASSERT( fee.amount >= 0 );
    FC_ASSERT( inputs.size() > 0 );
    FC_ASSERT( amount.asset_id == fee.asset_id );
 
+   for( uint32_t i = 1; i < inputs.size(); ++i )
+   {
+      /// by requiring all inputs to be sorted we also prevent duplicate commitments on the input
+      FC_ASSERT( inputs[i-1].commitment < inputs[i].commitment, "all inputs must be sorted by commitment id" );
+   }
+
+   if( verify_commitments )
+      this->verify_commitments();
+}
 
+void transfer_from_blind_operation::verify_commitments()const
+{
    vector<commitment_type> in(inputs.size());
    vector<commitment_type> out;
    int64_t                 net_public = fee.amount.value + amount.amount.value;
    out.push_back( fc::ecc::blind( blinding_factor, net_public ) );
    for( uint32_t i = 0; i < in.size(); ++i )
-   {
       in[i] = inputs[i].commitment;
-      /// by requiring all inputs to be sorted we also prevent duplicate commitments on the input
-      if( i > 0 ) FC_ASSERT( in[i-1] < in[i], "all inputs must be sorted by commitment id" );
-   }
    FC_ASSERT( in.size(), "there must be at least one input" );
    FC_ASSERT( fc::ecc::verify_sum( in, out, 0 ) );
 }
@@ -100,27 +115,36 @@ account_id_type blind_transfer_operation::fee_payer()const
 }
 
 
+void blind_transfer_operation::validate( bool verify_commitments )const
+{ try {
+   for( uint32_t i = 1; i < inputs.size(); ++i )
+   {
+      /// by requiring all inputs to be sorted we also prevent duplicate commitments on the input
+      FC_ASSERT( inputs[i-1].commitment < inputs[i].commitment );
+   }
+   for( uint32_t i = 0; i < outputs.size(); ++i )
+   {
+      if( i > 0 ) FC_ASSERT( outputs[i-1].commitment < outputs[i].commitment );
+      FC_ASSERT( !outputs[i].owner.is_impossible() );
+   }
+   FC_ASSERT( inputs.size(), "there must be at least one input" );
+
+   if( verify_commitments )
+      this->verify_commitments();
+} FC_CAPTURE_AND_RETHROW( (*this) ) }
+
 /**
  *  This method can be computationally intensive because it verifies that input commitments - output commitments add up to 0
  */
-void blind_transfer_operation::validate()const
+void blind_transfer_operation::verify_commitments()const
 { try {
    vector<commitment_type> in(inputs.size());
    vector<commitment_type> out(outputs.size());
    int64_t                 net_public = fee.amount.value;//from_amount.value - to_amount.value;
    for( uint32_t i = 0; i < in.size(); ++i )
-   {
       in[i] = inputs[i].commitment;
-      /// by requiring all inputs to be sorted we also prevent duplicate commitments on the input
-      if( i > 0 ) FC_ASSERT( in[i-1] < in[i] );
-   }
    for( uint32_t i = 0; i < out.size(); ++i )
-   {
       out[i] = outputs[i].commitment;
-      if( i > 0 ) FC_ASSERT( out[i-1] < out[i] );
-      FC_ASSERT( !outputs[i].owner.is_impossible() );
-   }
-   FC_ASSERT( in.size(), "there must be at least one input" );
    FC_ASSERT( fc::ecc::verify_sum( in, out, net_public ), "", ("net_public", net_public) );
 
    if( outputs.size() > 1 )
@@ -131,7 +155,6 @@ void blind_transfer_operation::validate()const
          FC_ASSERT( info.max_value <= GRAPHENE_INITIAL_MAX_SHARE_SUPPLY );
       }
    }
-   FC_ASSERT( fc::ecc::verify_sum( in, out, net_public ), "", ("net_public", net_public) );
 } FC_CAPTURE_AND_RETHROW( (*this) ) }
 
 share_type blind_transfer_operation::calculate_fee( const fee_parameters_type& k )const
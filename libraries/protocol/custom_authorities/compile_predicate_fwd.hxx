@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains forward declarations for externalized specializations of the compile_predicate_function
+ * template. Generate using the following shell code, and paste below.
+
+FWD_FIELD_TYPES="share_type asset_id_type flat_set<asset_id_type> asset price"
+FWD_FIELD_TYPES="$FWD_FIELD_TYPES string std::vector<char> time_point_sec"
+FWD_FIELD_TYPES="$FWD_FIELD_TYPES account_id_type flat_set<account_id_type> public_key_type authority"
+FWD_FIELD_TYPES="$FWD_FIELD_TYPES optional<authority>"
+FWD_FIELD_TYPES="$FWD_FIELD_TYPES bool uint8_t uint16_t uint32_t unsigned_int extensions_type"
+
+for T in $FWD_FIELD_TYPES; do
+    echo "extern template"
+    echo "void compile_predicate_function<$T>( "
+    echo "    restriction_function func, restriction_argument arg, restriction_code& code );"
+done
+ * ---------------- CUT ---------------- */
+
+extern template
+void compile_predicate_function<share_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<asset_id_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<flat_set<asset_id_type>>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<asset>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<price>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<string>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<std::vector<char>>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<time_point_sec>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<account_id_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<flat_set<account_id_type>>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<public_key_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<authority>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<optional<authority>>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<bool>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<uint8_t>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<uint16_t>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<uint32_t>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<unsigned_int>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+extern template
+void compile_predicate_function<extensions_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
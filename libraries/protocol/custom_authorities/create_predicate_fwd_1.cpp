@@ -22,9 +22,10 @@
  * THE SOFTWARE.
  */
 
-#include "restriction_predicate.hxx"
+#include "restriction_program.hxx"
 
-/* This file contains explicit specializations of the create_predicate_function template.
+/* This file contains explicit specializations of the create_predicate_function and compile_predicate_function
+ * templates.
  * Generate using the following shell code, and paste below.
 
 FWD_FIELD_TYPES="share_type asset_id_type flat_set<asset_id_type> asset price"
@@ -34,6 +35,12 @@ for T in $FWD_FIELD_TYPES; do
     echo "template"
     echo "object_restriction_predicate<$T> create_predicate_function( "
     echo "    restriction_function func, restriction_argument arg );"
+done
+echo
+for T in $FWD_FIELD_TYPES; do
+    echo "template"
+    echo "void compile_predicate_function<$T>( "
+    echo "    restriction_function func, restriction_argument arg, restriction_code& code );"
 done
  */
 
@@ -64,4 +71,29 @@ template
 object_restriction_predicate<time_point_sec> create_predicate_function(
     restriction_function func, restriction_argument arg );
 
+template
+void compile_predicate_function<share_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<asset_id_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<flat_set<asset_id_type>>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<asset>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<price>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<string>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<std::vector<char>>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<time_point_sec>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+
 } } // namespace graphene::protocol
@@ -22,9 +22,10 @@
  * THE SOFTWARE.
  */
 
-#include "restriction_predicate.hxx"
+#include "restriction_program.hxx"
 
-/* This file contains explicit specializations of the create_predicate_function template.
+/* This file contains explicit specializations of the create_predicate_function and compile_predicate_function
+ * templates.
  * Generate using the following shell code, and paste below.
 
 FWD_FIELD_TYPES="account_id_type flat_set<account_id_type> public_key_type authority optional<authority>"
@@ -33,6 +34,12 @@ for T in $FWD_FIELD_TYPES; do
     echo "template"
     echo "object_restriction_predicate<$T> create_predicate_function( "
     echo "    restriction_function func, restriction_argument arg );"
+done
+echo
+for T in $FWD_FIELD_TYPES; do
+    echo "template"
+    echo "void compile_predicate_function<$T>( "
+    echo "    restriction_function func, restriction_argument arg, restriction_code& code );"
 done
  */
 
@@ -54,4 +61,20 @@ template
 object_restriction_predicate<optional<authority>> create_predicate_function(
     restriction_function func, restriction_argument arg );
 
+template
+void compile_predicate_function<account_id_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<flat_set<account_id_type>>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<public_key_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<authority>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<optional<authority>>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+
 } } // namespace graphene::protocol
@@ -22,9 +22,10 @@
  * THE SOFTWARE.
  */
 
-#include "restriction_predicate.hxx"
+#include "restriction_program.hxx"
 
-/* This file contains explicit specializations of the create_predicate_function template.
+/* This file contains explicit specializations of the create_predicate_function and compile_predicate_function
+ * templates.
  * Generate using the following shell code, and paste below.
 
 FWD_FIELD_TYPES="bool uint8_t uint16_t uint32_t unsigned_int extensions_type"
@@ -33,6 +34,12 @@ for T in $FWD_FIELD_TYPES; do
     echo "template"
     echo "object_restriction_predicate<$T> create_predicate_function( "
     echo "    restriction_function func, restriction_argument arg );"
+done
+echo
+for T in $FWD_FIELD_TYPES; do
+    echo "template"
+    echo "void compile_predicate_function<$T>( "
+    echo "    restriction_function func, restriction_argument arg, restriction_code& code );"
 done
  */
 
@@ -57,4 +64,23 @@ template
 object_restriction_predicate<extensions_type> create_predicate_function(
     restriction_function func, restriction_argument arg );
 
+template
+void compile_predicate_function<bool>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<uint8_t>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<uint16_t>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<uint32_t>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<unsigned_int>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+template
+void compile_predicate_function<extensions_type>(
+    restriction_function func, restriction_argument arg, restriction_code& code );
+
 } } // namespace graphene::protocol
@@ -22,7 +22,7 @@
  * THE SOFTWARE.
  */
 
-#include "restriction_predicate.hxx"
+#include "restriction_program.hxx"
 #include "sliced_lists.hxx"
 
 namespace graphene { namespace protocol {
@@ -38,4 +38,12 @@ result_type get_restriction_predicate_list_10(size_t idx, vector<restriction> rs
       };
    });
 }
+
+void compile_restriction_program_list_10(size_t idx, vector<restriction> rs, restriction_code& code) {
+   typelist::runtime::dispatch(operation_list_10::list(), idx, [&rs, &code] (auto t) {
+      using Op = typename decltype(t)::type;
+      compile_operation_restrictions<Op>(std::move(rs), code);
+      return true;
+   });
+}
 } }
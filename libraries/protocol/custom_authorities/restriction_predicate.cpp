@@ -27,6 +27,8 @@
 #include "restriction_predicate.hxx"
 #include "sliced_lists.hxx"
 
+#include <boost/container/small_vector.hpp>
+
 namespace graphene { namespace protocol {
 
 restriction_predicate_function get_restriction_predicate(vector<restriction> rs, operation::tag_type op_type) {
@@ -78,6 +80,164 @@ restriction_predicate_function get_restriction_predicate(vector<restriction> rs,
    return [f=std::move(f)](const operation& op) { return f(op).reverse_path(); };
 }
 
+restriction_program compile_restriction_program(vector<restriction> rs, operation::tag_type op_type) {
+   vector<restriction_instruction> code;
+   typelist::runtime::dispatch(operation::list(), op_type, [&rs, &code](auto t) {
+      using Op = typename decltype(t)::type;
+      if (typelist::contains<operation_list_1::list, Op>())
+         compile_restriction_program_list_1(typelist::index_of<operation_list_1::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_2::list, Op>())
+         compile_restriction_program_list_2(typelist::index_of<operation_list_2::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_3::list, Op>())
+         compile_restriction_program_list_3(typelist::index_of<operation_list_3::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_4::list, Op>())
+         compile_restriction_program_list_4(typelist::index_of<operation_list_4::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_5::list, Op>())
+         compile_restriction_program_list_5(typelist::index_of<operation_list_5::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_6::list, Op>())
+         compile_restriction_program_list_6(typelist::index_of<operation_list_6::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_7::list, Op>())
+         compile_restriction_program_list_7(typelist::index_of<operation_list_7::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_8::list, Op>())
+         compile_restriction_program_list_8(typelist::index_of<operation_list_8::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_9::list, Op>())
+         compile_restriction_program_list_9(typelist::index_of<operation_list_9::list, Op>(), std::move(rs), code);
+      else if (typelist::contains<operation_list_10::list, Op>())
+         compile_restriction_program_list_10(typelist::index_of<operation_list_10::list, Op>(), std::move(rs),
+                                             code);
+      else if (typelist::contains<operation_list_11::list, Op>())
+         compile_restriction_program_list_11(typelist::index_of<operation_list_11::list, Op>(), std::move(rs),
+                                             code);
+      else if (typelist::contains<operation_list_12::list, Op>())
+         compile_restriction_program_list_12(typelist::index_of<operation_list_12::list, Op>(), std::move(rs),
+                                             code);
+      else if (typelist::contains<virtual_operations_list::list, Op>())
+         FC_THROW_EXCEPTION( fc::assert_exception, "Virtual operations not allowed!" );
+      else
+         FC_THROW_EXCEPTION(fc::assert_exception,
+                            "LOGIC ERROR: Operation type not handled by custom authorities implementation. "
+                            "Please report this error.");
+      return true;
+   });
+   return restriction_program(op_type, std::move(code));
+}
+
+restriction_program::restriction_program(operation::tag_type op_type, vector<restriction_instruction>&& code)
+   : _operation_type(op_type), _code(std::make_shared<const vector<restriction_instruction>>(std::move(code))) {}
+
+predicate_result restriction_program::operator()(const operation& op) const {
+   FC_ASSERT(op.which() == _operation_type, "Supplied operation is incorrect type for restriction predicate");
+   if (passes(0, &op))
+      return predicate_result::Success();
+   // As with the predicate functions, the rejection path is built from the innermost restriction outwards
+   return explain_rejection(0, &op).reverse_path();
+}
+
+bool restriction_program::passes(size_t pc, const void* value) const {
+   // An all_of or any_of whose children are being evaluated. Selections need no frame, their result is the one
+   // of their subtree, evaluated on the selected value.
+   struct frame {
+      size_t pc;
+      const void* value;
+      size_t next_child;
+      uint32_t children_left;
+   };
+   boost::container::small_vector<frame, 16> stack;
+   const vector<restriction_instruction>& code = *_code;
+
+   while (true) {
+      // Descend until the result of a subtree is known
+      bool result;
+      const restriction_instruction& instruction = code[pc];
+      switch (instruction.code) {
+      case restriction_instruction::all_of:
+      case restriction_instruction::any_of:
+         if (instruction.count == 0) {
+            result = instruction.code == restriction_instruction::all_of;
+            break;
+         }
+         stack.push_back({pc, value, pc + 1 + code[pc + 1].length, instruction.count - 1});
+         ++pc;
+         continue;
+      case restriction_instruction::select: {
+         predicate_result::rejection_reason reason = predicate_result::predicate_was_false;
+         value = instruction.select(value, reason);
+         if (value == nullptr) {
+            result = false;
+            break;
+         }
+         ++pc;
+         continue;
+      }
+      case restriction_instruction::test:
+         result = instruction.test(value, instruction.argument.get());
+         break;
+      default:
+         FC_THROW_EXCEPTION(fc::assert_exception,
+                            "LOGIC ERROR: Invalid restriction instruction. Please report this error.");
+      }
+
+      // Ascend until a block needs its next child evaluated
+      while (true) {
+         if (stack.empty())
+            return result;
+         frame& block = stack.back();
+         const bool decided = (code[block.pc].code == restriction_instruction::all_of) ? !result : result;
+         if (decided || block.children_left == 0) {
+            stack.pop_back();
+            continue;
+         }
+         pc = block.next_child;
+         value = block.value;
+         block.next_child += code[pc].length;
+         --block.children_left;
+         break;
+      }
+   }
+}
+
+predicate_result restriction_program::explain_rejection(size_t pc, const void* value) const {
+   const restriction_instruction& instruction = (*_code)[pc];
+   switch (instruction.code) {
+   case restriction_instruction::all_of: {
+      size_t child = pc + 1;
+      for (size_t i = 0; i < instruction.count; ++i) {
+         if (!passes(child, value)) {
+            auto result = explain_rejection(child, value);
+            result.rejection_path.push_back(i);
+            return result;
+         }
+         child += (*_code)[child].length;
+      }
+      return predicate_result::Success();
+   }
+   case restriction_instruction::any_of: {
+      // The subtree was rejected, so every branch was
+      vector<predicate_result> rejections;
+      rejections.reserve(instruction.count);
+      size_t child = pc + 1;
+      for (size_t i = 0; i < instruction.count; ++i) {
+         rejections.push_back(explain_rejection(child, value));
+         child += (*_code)[child].length;
+      }
+      return predicate_result::Rejection(std::move(rejections));
+   }
+   case restriction_instruction::select: {
+      predicate_result::rejection_reason reason = predicate_result::predicate_was_false;
+      const void* selected = instruction.select(value, reason);
+      if (selected == nullptr)
+         return predicate_result::Rejection(reason);
+      return explain_rejection(pc + 1, selected);
+   }
+   case restriction_instruction::test:
+      if (instruction.test(value, instruction.argument.get()))
+         return predicate_result::Success();
+      return predicate_result::Rejection(predicate_result::predicate_was_false);
+   }
+   FC_THROW_EXCEPTION(fc::assert_exception,
+                      "LOGIC ERROR: Invalid restriction instruction. Please report this error.");
+}
+
 predicate_result& predicate_result::reverse_path() {
    if (success == true)
       return *this;
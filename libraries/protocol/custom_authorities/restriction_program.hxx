@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include "restriction_predicate.hxx"
+
+namespace graphene { namespace protocol {
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// *** Restriction Program Compiler ***
+//
+// This file compiles restrictions into a restriction_program, a flat array of instructions which is evaluated by
+// restriction_program::evaluate(). It walks the restrictions and the operation types exactly like the layers of
+// restriction_predicate.hxx do, and uses the same predicate functors, so a program accepts and rejects exactly the
+// same operations as the predicate function created from the same restrictions, and rejects the same restrictions
+// as invalid.
+//
+// Each restriction list becomes an all_of instruction followed by one subtree per restriction, and each logical OR
+// becomes an any_of instruction followed by one all_of subtree per branch. A restriction on a field becomes a select
+// instruction which resolves the field, followed by either a test instruction which embeds the argument, or for
+// attribute and variant assertions, by the subtree of the nested restrictions (preceded by another select if the
+// field is an optional, an extension or a variant). Every instruction records the length of its subtree so the
+// evaluator can step over it.
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using restriction_code = vector<restriction_instruction>;
+
+// Appends an instruction and returns its position, the subtree is closed by end_subtree()
+inline size_t begin_subtree(restriction_code& code, restriction_instruction::opcode op, size_t count = 0) {
+   restriction_instruction instruction;
+   instruction.code = op;
+   instruction.count = static_cast<uint32_t>(count);
+   code.push_back(std::move(instruction));
+   return code.size() - 1;
+}
+inline void end_subtree(restriction_code& code, size_t position) {
+   code[position].length = static_cast<uint32_t>(code.size() - position);
+}
+inline size_t begin_select(restriction_code& code, restriction_instruction::select_function select) {
+   auto position = begin_subtree(code, restriction_instruction::select);
+   code[position].select = select;
+   return position;
+}
+
+//////////////////////////////////////////////// SELECT FUNCTIONS ////////////////////////////////////////////////
+template<typename Object, typename FieldReflection>
+const void* select_field(const void* object, predicate_result::rejection_reason&) {
+   return &FieldReflection::get(*static_cast<const Object*>(object));
+}
+template<typename Field>
+const void* select_optional(const void* optional, predicate_result::rejection_reason& reason) {
+   const auto& f = *static_cast<const fc::optional<Field>*>(optional);
+   if (!f.valid()) {
+      reason = predicate_result::null_optional;
+      return nullptr;
+   }
+   return &*f;
+}
+template<typename Extension>
+const void* select_extension(const void* x, predicate_result::rejection_reason&) {
+   return &static_cast<const extension<Extension>*>(x)->value;
+}
+template<typename Variant, typename Value>
+const void* select_variant(const void* variant, predicate_result::rejection_reason& reason) {
+   const auto& v = *static_cast<const Variant*>(variant);
+   if (v.which() != Variant::template tag<Value>::value) {
+      reason = predicate_result::incorrect_variant_type;
+      return nullptr;
+   }
+   return &v.template get<Value>();
+}
+template<typename Variant, typename Value>
+const void* select_optional_variant(const void* optional, predicate_result::rejection_reason& reason) {
+   const void* variant = select_optional<Variant>(optional, reason);
+   if (variant == nullptr)
+      return nullptr;
+   return select_variant<Variant, Value>(variant, reason);
+}
+////////////////////////////////////////////// END SELECT FUNCTIONS //////////////////////////////////////////////
+
+// Forward declaration of compile_restrictions, because attribute assertions and logical ORs recurse into it
+template<typename Object> void compile_restrictions(vector<restriction>, bool, restriction_code&);
+
+template<typename Field>
+struct attribute_assertion_compiler {
+   static void compile(vector<restriction>&& rs, restriction_code& code) {
+      compile_restrictions<Field>(std::move(rs), false, code);
+   }
+};
+template<typename Field>
+struct attribute_assertion_compiler<fc::optional<Field>> {
+   static void compile(vector<restriction>&& rs, restriction_code& code) {
+      auto position = begin_select(code, &select_optional<Field>);
+      compile_restrictions<Field>(std::move(rs), false, code);
+      end_subtree(code, position);
+   }
+};
+template<typename Extension>
+struct attribute_assertion_compiler<extension<Extension>> {
+   static void compile(vector<restriction>&& rs, restriction_code& code) {
+      auto position = begin_select(code, &select_extension<Extension>);
+      compile_restrictions<Extension>(std::move(rs), false, code);
+      end_subtree(code, position);
+   }
+};
+
+template<typename Variant>
+struct variant_assertion_compiler {
+   static void compile(restriction::variant_assert_argument_type&&, restriction_code&) {
+      FC_THROW_EXCEPTION(fc::assert_exception, "Invalid variant assertion on non-variant field",
+                         ("Field", fc::get_typename<Variant>::name()));
+   }
+};
+template<typename... Types>
+struct variant_assertion_compiler<static_variant<Types...>> {
+   using Variant = static_variant<Types...>;
+   static void compile(restriction::variant_assert_argument_type&& arg, restriction_code& code) {
+      typelist::runtime::dispatch(typelist::list<Types...>(), arg.first, [&arg, &code](auto t) {
+         using Value = typename decltype(t)::type;
+         auto position = begin_select(code, &select_variant<Variant, Value>);
+         compile_restrictions<Value>(std::move(arg.second), true, code);
+         end_subtree(code, position);
+         return true;
+      });
+   }
+};
+template<typename... Types>
+struct variant_assertion_compiler<fc::optional<static_variant<Types...>>> {
+   using Variant = static_variant<Types...>;
+   static void compile(restriction::variant_assert_argument_type&& arg, restriction_code& code) {
+      typelist::runtime::dispatch(typelist::list<Types...>(), arg.first, [&arg, &code](auto t) {
+         using Value = typename decltype(t)::type;
+         auto position = begin_select(code, &select_optional_variant<Variant, Value>);
+         compile_restrictions<Value>(std::move(arg.second), true, code);
+         end_subtree(code, position);
+         return true;
+      });
+   }
+};
+
+// Evaluate the predicate functor on a value and an argument stored in a test instruction
+template<typename F, typename P, typename A>
+bool run_test(const void* value, const void* argument) {
+   return P()(*static_cast<const F*>(value), *static_cast<const A*>(argument));
+}
+
+// Embed the argument into a test instruction
+template<typename F, typename P, typename A, typename = std::enable_if_t<P::valid>>
+void embed_test(P, A a, restriction_code& code, short) {
+   auto position = begin_subtree(code, restriction_instruction::test);
+   code[position].test = &run_test<F, P, A>;
+   code[position].argument = std::make_shared<const A>(std::move(a));
+}
+template<typename F, typename P, typename A>
+void embed_test(P, A, restriction_code&, long) {
+   FC_THROW_EXCEPTION(fc::assert_exception, "Invalid types for predicate");
+}
+
+// Resolve the argument type and compile a test for it
+template<template<typename...> class Predicate, typename Field, typename ArgVariant>
+void compile_test(ArgVariant arg, restriction_code& code) {
+   typelist::runtime::dispatch(typename ArgVariant::list(), arg.which(), [&arg, &code](auto t) mutable {
+      using Arg = typename decltype(t)::type;
+      embed_test<Field>(Predicate<Field, Arg>(), std::move(arg.template get<Arg>()), code, short());
+      return true;
+   });
+}
+
+template<typename Field>
+void compile_predicate_function(restriction_function func, restriction_argument arg, restriction_code& code) {
+   try {
+      switch(func) {
+      case restriction::func_eq:
+         return compile_test<predicate_eq, Field>(static_variant<equality_types_list>::import_from(std::move(arg)),
+                                                  code);
+      case restriction::func_ne:
+         return compile_test<predicate_ne, Field>(static_variant<equality_types_list>::import_from(std::move(arg)),
+                                                  code);
+      case restriction::func_lt:
+         return compile_test<predicate_lt, Field>(static_variant<comparable_types_list>
+                                                  ::import_from(std::move(arg)), code);
+      case restriction::func_le:
+         return compile_test<predicate_le, Field>(static_variant<comparable_types_list>
+                                                  ::import_from(std::move(arg)), code);
+      case restriction::func_gt:
+         return compile_test<predicate_gt, Field>(static_variant<comparable_types_list>
+                                                  ::import_from(std::move(arg)), code);
+      case restriction::func_ge:
+         return compile_test<predicate_ge, Field>(static_variant<comparable_types_list>
+                                                  ::import_from(std::move(arg)), code);
+      case restriction::func_in:
+         return compile_test<predicate_in, Field>(static_variant<list_types_list>::import_from(std::move(arg)),
+                                                  code);
+      case restriction::func_not_in:
+         return compile_test<predicate_not_in, Field>(static_variant<list_types_list>
+                                                      ::import_from(std::move(arg)), code);
+      case restriction::func_has_all:
+         return compile_test<predicate_has_all, Field>(static_variant<list_types_list>
+                                                       ::import_from(std::move(arg)), code);
+      case restriction::func_has_none:
+         return compile_test<predicate_has_none, Field>(static_variant<list_types_list>
+                                                        ::import_from(std::move(arg)), code);
+      case restriction::func_attr:
+         FC_ASSERT(arg.which() == restriction_argument::tag<vector<restriction>>::value,
+                   "Argument type for attribute assertion must be restriction list");
+         return attribute_assertion_compiler<Field>::compile(std::move(arg.get<vector<restriction>>()), code);
+      case restriction::func_variant_assert:
+         FC_ASSERT(arg.which() == restriction_argument::tag<restriction::variant_assert_argument_type>::value,
+                   "Argument type for attribute assertion must be pair of variant tag and restriction list");
+         return variant_assertion_compiler<Field>::compile(
+                  std::move(arg.get<restriction::variant_assert_argument_type>()), code);
+      default:
+          FC_THROW_EXCEPTION(fc::assert_exception, "Invalid function type on restriction");
+      }
+   } FC_CAPTURE_AND_RETHROW( (fc::get_typename<Field>::name())(func)(arg) )
+}
+
+#include "compile_predicate_fwd.hxx"
+
+// Compile a restriction on the field of the object it references, see create_field_predicate()
+template<typename Object,
+         typename = std::enable_if_t<typelist::length<typename fc::reflector<Object>::native_members>() != 0>>
+void compile_field_predicate(restriction&& r, restriction_code& code, short) {
+   using member_list = typename fc::reflector<Object>::native_members;
+   FC_ASSERT( r.member_index < static_cast<uint64_t>(typelist::length<member_list>()),
+              "Invalid member index ${I} for object ${O}",
+              ("I", r.member_index)("O", fc::get_typename<Object>::name()) );
+   auto compiler = [f=r.restriction_type, a=std::move(r.argument), &code](auto t) mutable {
+      using FieldReflection = typename decltype(t)::type;
+      using Field = typename FieldReflection::type;
+      auto position = begin_select(code, &select_field<Object, FieldReflection>);
+      compile_predicate_function<Field>(static_cast<restriction_function>(f), std::move(a), code);
+      end_subtree(code, position);
+      return true;
+   };
+   typelist::runtime::dispatch(member_list(), static_cast<size_t>(r.member_index.value), compiler);
+}
+template<typename Object>
+void compile_field_predicate(restriction&&, restriction_code&, long) {
+   FC_THROW_EXCEPTION(fc::assert_exception, "Invalid restriction references member of non-object type: ${O}",
+                      ("O", fc::get_typename<Object>::name()));
+}
+
+template<typename Object>
+void compile_logical_or_predicate(vector<vector<restriction>> rs, restriction_code& code) {
+   FC_ASSERT(rs.size() > 1, "Logical OR must have at least two branches");
+   auto position = begin_subtree(code, restriction_instruction::any_of, rs.size());
+   for (vector<restriction>& branch : rs)
+      compile_restrictions<Object>(std::move(branch), false, code);
+   end_subtree(code, position);
+}
+
+template<typename Object>
+void compile_restrictions(vector<restriction> rs, bool allow_empty, restriction_code& code) {
+   if (!allow_empty)
+      FC_ASSERT(!rs.empty(), "Empty attribute assertions and logical OR branches are not permitted");
+
+   auto position = begin_subtree(code, restriction_instruction::all_of, rs.size());
+   for (restriction& r : rs) {
+      if (r.restriction_type.value == restriction::func_logical_or) {
+          FC_ASSERT(r.argument.which() == restriction_argument::tag<vector<vector<restriction>>>::value,
+                    "Restriction argument for logical OR function type must be list of restriction lists.");
+          compile_logical_or_predicate<Object>(std::move(r.argument.get<vector<vector<restriction>>>()), code);
+      } else {
+          compile_field_predicate<Object>(std::move(r), code, short());
+      }
+   }
+   end_subtree(code, position);
+}
+
+// Compile the restrictions on an operation: select the operation out of the operation variant, then evaluate the
+// restrictions on it
+template<typename Op>
+void compile_operation_restrictions(vector<restriction> rs, restriction_code& code) {
+   auto position = begin_select(code, &select_variant<operation, Op>);
+   compile_restrictions<Op>(std::move(rs), true, code);
+   end_subtree(code, position);
+}
+
+} } // namespace graphene::protocol
@@ -46,13 +46,15 @@ using operation_list_11 = static_variant<typelist::builder<>
                                                 ::add_list<typelist::slice<operation::list, 47, 51>>
                                                 ::add<htlc_extend_operation>      // 52
                                                 ::finalize>;
-using operation_list_12 = static_variant<typelist::slice<operation::list, 54>>;
+using operation_list_12 = static_variant<typelist::slice<operation::list, 54, 64>>;
 using virtual_operations_list = static_variant<fill_order_operation,          // 4
                                                asset_settle_cancel_operation, // 42
                                                fba_distribute_operation,      // 44
                                                execute_bid_operation,         // 46
                                                htlc_redeemed_operation,       // 51
-                                               htlc_refund_operation          // 53
+                                               htlc_refund_operation,         // 53
+                                               ticket_merge_operation,        // 64
+                                               ticket_prune_operation         // 65
                                               >;
 
 object_restriction_predicate<operation> get_restriction_predicate_list_1(size_t idx, vector<restriction> rs);
@@ -68,4 +70,17 @@ object_restriction_predicate<operation> get_restriction_predicate_list_10(size_t
 object_restriction_predicate<operation> get_restriction_predicate_list_11(size_t idx, vector<restriction> rs);
 object_restriction_predicate<operation> get_restriction_predicate_list_12(size_t idx, vector<restriction> rs);
 
+void compile_restriction_program_list_1(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_2(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_3(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_4(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_5(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_6(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_7(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_8(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_9(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_10(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_11(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+void compile_restriction_program_list_12(size_t idx, vector<restriction> rs, vector<restriction_instruction>& code);
+
 } } // namespace graphene::protocol
@@ -34,6 +34,22 @@ namespace graphene { namespace protocol {
    {
    }
 
+   fee_schedule& fee_schedule::operator=( const fee_schedule& other )
+   {
+      parameters = other.parameters;
+      scale = other.scale;
+      invalidate_fee_table();
+      return *this;
+   }
+
+   fee_schedule& fee_schedule::operator=( fee_schedule&& other )
+   {
+      parameters = std::move( other.parameters );
+      scale = other.scale;
+      invalidate_fee_table();
+      return *this;
+   }
+
    fee_schedule fee_schedule::get_default()
    {
       fee_schedule result;
@@ -76,6 +92,7 @@ namespace graphene { namespace protocol {
       for( fee_parameters& i : parameters )
          i.visit( zero_fee_visitor() );
       this->scale = 0;
+      invalidate_fee_table();
    }
 
    asset fee_schedule::set_fee( operation& op, const price& core_exchange_rate )const
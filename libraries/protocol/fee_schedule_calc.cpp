@@ -31,54 +31,95 @@
 
 namespace graphene { namespace protocol {
 
+   namespace detail {
+      struct fee_table
+      {
+         size_t                 parameters_count = 0;         ///< number of schedule parameters it was built from
+         vector<fee_parameters> parameters;                   ///< indexed by operation type
+         uint32_t               transfer_price_per_kbyte = 0; ///< charged for the memo of htlc_create_operation
+         optional<uint64_t>     sub_asset_creation_fee;       ///< passed to asset_create_operation
+      };
+   }
+
+   /// Resolves the fee parameters of one operation type, or their defaults if they are missing
+   struct fee_table_builder
+   {
+      typedef void result_type;
+
+      const fee_schedule& param;
+      fee_parameters& result;
+      fee_table_builder( const fee_schedule& p, fee_parameters& r ):param(p),result(r){}
+
+      template<typename OpType>
+      result_type operator()( const OpType& )const
+      {
+         try {
+            result = fee_parameters( param.get<OpType>() );
+         } catch (fc::assert_exception&) {
+            result = fee_parameters( typename OpType::fee_parameters_type() );
+         }
+      }
+   };
+
+   std::shared_ptr<const detail::fee_table> fee_schedule::get_fee_table()const
+   {
+      auto table = std::atomic_load( &fee_table );
+      if( table && table->parameters_count == parameters.size() )
+         return table;
+
+      auto new_table = std::make_shared<detail::fee_table>();
+      new_table->parameters_count = parameters.size();
+      new_table->parameters.resize( operation().count() );
+      for( size_t i = 0; i < new_table->parameters.size(); ++i )
+      {
+         operation op; op.set_which(i);
+         op.visit( fee_table_builder( *this, new_table->parameters[i] ) );
+      }
+      if( exists<transfer_operation>() )
+         new_table->transfer_price_per_kbyte = get<transfer_operation>().price_per_kbyte;
+      else
+         new_table->transfer_price_per_kbyte = transfer_operation::fee_parameters_type().price_per_kbyte;
+      if( exists<account_transfer_operation>() && exists<ticket_create_operation>() )
+         new_table->sub_asset_creation_fee = get<account_transfer_operation>().fee;
+
+      table = new_table;
+      std::atomic_store( &fee_table, table );
+      return table;
+   }
+
    struct calc_fee_visitor
    {
       typedef uint64_t result_type;
 
-      const fee_schedule& param;
+      const detail::fee_table& table;
       const int current_op;
-      calc_fee_visitor( const fee_schedule& p, const operation& op ):param(p),current_op(op.which()){}
+      calc_fee_visitor( const detail::fee_table& t, const operation& op ):table(t),current_op(op.which()){}
 
       template<typename OpType>
       result_type operator()( const OpType& op )const
       {
-         try {
-            return op.calculate_fee( param.get<OpType>() ).value;
-         } catch (fc::assert_exception& e) {
-             fee_parameters params; params.set_which(current_op);
-             auto itr = param.parameters.find(params);
-             if( itr != param.parameters.end() ) params = *itr;
-             return op.calculate_fee( params.get<typename OpType::fee_parameters_type>() ).value;
-         }
+         return op.calculate_fee( table.parameters[current_op].get<typename OpType::fee_parameters_type>() ).value;
       }
    };
 
    template<>
    uint64_t calc_fee_visitor::operator()(const htlc_create_operation& op)const
    {
-      //TODO: refactor for performance (see https://github.com/bitshares/bitshares-core/issues/2150)
-      transfer_operation::fee_parameters_type t;
-      if (param.exists<transfer_operation>())
-         t = param.get<transfer_operation>();
-      return op.calculate_fee( param.get<htlc_create_operation>(), t.price_per_kbyte).value;
+      return op.calculate_fee( table.parameters[current_op].get<htlc_create_operation::fee_parameters_type>(),
+                               table.transfer_price_per_kbyte ).value;
    }
 
    template<>
    uint64_t calc_fee_visitor::operator()(const asset_create_operation& op)const
    {
-      //TODO: refactor for performance (see https://github.com/bitshares/bitshares-core/issues/2150)
-      optional<uint64_t> sub_asset_creation_fee;
-      if( param.exists<account_transfer_operation>() && param.exists<ticket_create_operation>() )
-         sub_asset_creation_fee = param.get<account_transfer_operation>().fee;
-      asset_create_operation::fee_parameters_type old_asset_creation_fee_params;
-      if( param.exists<asset_create_operation>() )
-         old_asset_creation_fee_params = param.get<asset_create_operation>();
-      return op.calculate_fee( old_asset_creation_fee_params, sub_asset_creation_fee ).value;
+      return op.calculate_fee( table.parameters[current_op].get<asset_create_operation::fee_parameters_type>(),
+                               table.sub_asset_creation_fee ).value;
    }
 
    asset fee_schedule::calculate_fee( const operation& op )const
    {
-      uint64_t required_fee = op.visit( calc_fee_visitor( *this, op ) );
+      const auto table = get_fee_table();
+      uint64_t required_fee = op.visit( calc_fee_visitor( *table, op ) );
       if( scale != GRAPHENE_100_PERCENT )
       {
          auto scaled = fc::uint128_t(required_fee) * scale;
@@ -48,7 +48,8 @@ namespace graphene { namespace protocol {
       /** using a shared_ptr breaks the circular dependency created between operations and the fee schedule */
       std::shared_ptr<const fee_schedule> current_fees;                  ///< current schedule of fees
       const fee_schedule& get_current_fees() const { FC_ASSERT(current_fees); return *current_fees; }
-      fee_schedule& get_mutable_fees() { FC_ASSERT(current_fees); return const_cast<fee_schedule&>(*current_fees); }
+      /// Also drops the lookup table of the fee schedule, see @ref fee_schedule::invalidate_fee_table
+      fee_schedule& get_mutable_fees();
 
       uint8_t                 block_interval                      = GRAPHENE_DEFAULT_BLOCK_INTERVAL; ///< interval in seconds between blocks
       uint32_t                maintenance_interval                = GRAPHENE_DEFAULT_MAINTENANCE_INTERVAL; ///< interval in sections between blockchain maintenance events
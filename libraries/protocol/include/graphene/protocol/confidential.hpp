@@ -162,7 +162,10 @@ struct transfer_to_blind_operation : public base_operation
    vector<blind_output>  outputs;
 
    account_id_type fee_payer()const { return from; }
-   void            validate()const;
+   /// @param verify_commitments whether to call @ref verify_commitments too
+   void            validate( bool verify_commitments = true )const;
+   /// Verifies the commitment sum and the range proofs, this is the expensive part of @ref validate
+   void            verify_commitments()const;
    share_type      calculate_fee(const fee_parameters_type& )const;
 };
 
@@ -183,7 +186,10 @@ struct transfer_from_blind_operation : public base_operation
    vector<blind_input>   inputs;
 
    account_id_type fee_payer()const { return GRAPHENE_TEMP_ACCOUNT; }
-   void            validate()const;
+   /// @param verify_commitments whether to call @ref verify_commitments too
+   void            validate( bool verify_commitments = true )const;
+   /// Verifies the commitment sum, this is the expensive part of @ref validate
+   void            verify_commitments()const;
 
    void            get_required_authorities( vector<authority>& a )const
    {
@@ -248,7 +254,10 @@ struct blind_transfer_operation : public base_operation
     
    /** graphene TEMP account */
    account_id_type fee_payer()const;
-   void            validate()const;
+   /// @param verify_commitments whether to call @ref verify_commitments too
+   void            validate( bool verify_commitments = true )const;
+   /// Verifies the commitment sum and the range proofs, this is the expensive part of @ref validate
+   void            verify_commitments()const;
    share_type      calculate_fee( const fee_parameters_type& k )const;
 
    void            get_required_authorities( vector<authority>& a )const
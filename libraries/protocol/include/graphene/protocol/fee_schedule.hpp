@@ -24,6 +24,8 @@
 #pragma once
 #include <graphene/protocol/operations.hpp>
 
+#include <memory>
+
 namespace graphene { namespace protocol {
 
    template<typename T> struct transform_to_fee_parameters;
@@ -167,12 +169,19 @@ namespace graphene { namespace protocol {
          return htlc_extend_operation_fee_dummy;
       }
    };
+   namespace detail { struct fee_table; }
+
    /**
     *  @brief contains all of the parameters necessary to calculate the fee for any operation
     */
    struct fee_schedule
    {
       fee_schedule();
+      /// The lookup table is not copied, the copy builds its own
+      fee_schedule( const fee_schedule& other ) : parameters( other.parameters ), scale( other.scale ) {}
+      fee_schedule( fee_schedule&& other ) : parameters( std::move(other.parameters) ), scale( other.scale ) {}
+      fee_schedule& operator=( const fee_schedule& other );
+      fee_schedule& operator=( fee_schedule&& other );
 
       static fee_schedule get_default();
 
@@ -207,6 +216,7 @@ namespace graphene { namespace protocol {
       template<typename Operation>
       typename Operation::fee_parameters_type& get()
       {
+         invalidate_fee_table();
          return fee_helper<Operation>().get(parameters);
       }
       template<typename Operation>
@@ -221,8 +231,23 @@ namespace graphene { namespace protocol {
        */
       fee_parameters::flat_set_type parameters;
       uint32_t                 scale = GRAPHENE_100_PERCENT; ///< fee * scale / GRAPHENE_100_PERCENT
+
+      /**
+       *  Drops the lookup table used by calculate_fee, it is rebuilt on the next call.
+       *  @note inserting or erasing @ref parameters is detected, but changing an element of a schedule which
+       *  was already used to calculate fees requires this call, or a non-const accessor which makes it
+       */
+      void invalidate_fee_table() { std::atomic_store( &fee_table, std::shared_ptr<const detail::fee_table>() ); }
+
       private:
       static void set_fee_parameters(fee_schedule& sched);
+
+      /// Returns the lookup table used by calculate_fee, building it if it is missing or the number of
+      /// parameters changed
+      std::shared_ptr<const detail::fee_table> get_fee_table()const;
+
+      /// Fee parameters resolved for every operation type, indexed by operation type. Not serialized or copied.
+      mutable std::shared_ptr<const detail::fee_table> fee_table;
    };
 
    typedef fee_schedule fee_schedule_type;
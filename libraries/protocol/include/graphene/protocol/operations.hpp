@@ -114,7 +114,9 @@ namespace graphene { namespace protocol {
             /* 60 */ liquidity_pool_delete_operation,
             /* 61 */ liquidity_pool_deposit_operation,
             /* 62 */ liquidity_pool_withdraw_operation,
-            /* 63 */ liquidity_pool_exchange_operation
+            /* 63 */ liquidity_pool_exchange_operation,
+            /* 64 */ ticket_merge_operation,          // VIRTUAL
+            /* 65 */ ticket_prune_operation           // VIRTUAL
          > operation;
 
    /// @} // operations group
@@ -131,7 +133,21 @@ namespace graphene { namespace protocol {
                                             vector<authority>& other,
                                             bool ignore_custom_operation_required_auths );
 
-   void operation_validate( const operation& op );
+   /**
+    *  @param verify_commitments whether to verify the commitments and range proofs of confidential operations,
+    *         see @ref operation_verify_commitments
+    */
+   void operation_validate( const operation& op, bool verify_commitments = true );
+
+   /**
+    *  Verifies the commitments and range proofs of a confidential operation, the expensive part of its validation.
+    *
+    *  @return whether @p op is a confidential operation
+    */
+   bool operation_verify_commitments( const operation& op );
+
+   /// Whether @p op is a confidential operation, see @ref operation_verify_commitments
+   bool operation_has_commitments( const operation& op );
 
    /**
     *  @brief necessary to support nested operations inside the proposal_create_operation
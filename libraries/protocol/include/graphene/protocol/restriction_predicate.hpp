@@ -27,6 +27,7 @@
 #include <graphene/protocol/operations.hpp>
 
 #include <functional>
+#include <memory>
 
 namespace graphene { namespace protocol {
 
@@ -69,6 +70,70 @@ using restriction_predicate_function = std::function<predicate_result(const oper
  */
 restriction_predicate_function get_restriction_predicate(vector<restriction> rs, operation::tag_type op_type);
 
+/// One instruction of a @ref restriction_program
+struct restriction_instruction {
+   enum opcode : uint8_t {
+      /// The following @ref count subtrees must all succeed on the current value
+      all_of,
+      /// At least one of the following @ref count subtrees (the branches of a logical OR) must succeed
+      any_of,
+      /// Evaluate the following subtree on a member, or on the contents of an optional, extension or variant
+      select,
+      /// Compare the current value against the embedded argument
+      test
+   };
+   using select_function = const void*(*)(const void* value, predicate_result::rejection_reason& reason);
+   using test_function = bool(*)(const void* value, const void* argument);
+
+   opcode code = all_of;
+   /// Number of child subtrees of all_of and any_of
+   uint32_t count = 0;
+   /// Number of instructions in the subtree starting with this one
+   uint32_t length = 1;
+   /// For select: returns the selected value, or nullptr after setting the reason for the rejection
+   select_function select = nullptr;
+   /// For test: evaluates the predicate on the current value and the argument
+   test_function test = nullptr;
+   std::shared_ptr<const void> argument;
+};
+
+/**
+ * @brief A list of restrictions compiled into a flat array of instructions
+ *
+ * Evaluating a program gives the same result as the predicate returned by @ref get_restriction_predicate for the
+ * same restrictions. Rather than calling through a tree of nested std::function objects, it walks a contiguous
+ * array of instructions whose member accesses and comparisons are resolved at compile time, and it allocates no
+ * memory unless the operation is rejected or the logical blocks are nested more than 16 deep. Copies share the
+ * instructions.
+ */
+class restriction_program {
+public:
+   predicate_result operator()(const operation& op) const;
+
+   operation::tag_type operation_type() const { return _operation_type; }
+   const vector<restriction_instruction>& instructions() const { return *_code; }
+
+private:
+   friend restriction_program compile_restriction_program(vector<restriction> rs, operation::tag_type op_type);
+   restriction_program(operation::tag_type op_type, vector<restriction_instruction>&& code);
+
+   /// Whether the subtree starting at @p pc accepts @p value, evaluated without recursion
+   bool passes(size_t pc, const void* value) const;
+   /// Builds the rejection of a subtree which doesn't pass, this is the only part which allocates memory
+   predicate_result explain_rejection(size_t pc, const void* value) const;
+
+   operation::tag_type _operation_type = 0;
+   std::shared_ptr<const vector<restriction_instruction>> _code;
+};
+
+/**
+ * @brief compile_restriction_program Compile the supplied restrictions into a @ref restriction_program
+ * @param rs The restrictions to evaluate operations against
+ * @param op_type The tag specifying which operation type the restrictions apply to
+ * @return A program which evaluates an operation to determine whether it complies with the restrictions
+ */
+restriction_program compile_restriction_program(vector<restriction> rs, operation::tag_type op_type);
+
 } } // namespace graphene::protocol
 
 FC_REFLECT_ENUM(graphene::protocol::predicate_result::rejection_reason,
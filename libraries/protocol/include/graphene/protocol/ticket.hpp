@@ -79,6 +79,59 @@ namespace graphene { namespace protocol {
       void            validate()const;
    };
 
+   /**
+    * @brief Merges a stable ticket into another stable ticket of the same account and type
+    * @ingroup operations
+    *
+    * This is a virtual operation, emitted when tickets are compacted.
+    */
+   struct ticket_merge_operation : public base_operation
+   {
+      struct fee_parameters_type {};
+
+      ticket_merge_operation() = default;
+      ticket_merge_operation( account_id_type a, ticket_id_type t, ticket_id_type into, const asset& amt )
+         : account(a), ticket(t), into_ticket(into), amount(amt) {}
+
+      asset           fee;         ///< Operation fee, always zero
+      account_id_type account;     ///< The account who owns the tickets
+      ticket_id_type  ticket;      ///< The ticket which is merged, it is removed
+      ticket_id_type  into_ticket; ///< The ticket which takes over the amount and the value of @ref ticket
+      asset           amount;      ///< The amount which is moved
+
+      account_id_type fee_payer()const { return account; }
+      void            validate()const { FC_ASSERT( !"virtual operation" ); }
+
+      /// This is a virtual operation; there is no fee
+      share_type      calculate_fee(const fee_parameters_type& k)const { return 0; }
+   };
+
+   /**
+    * @brief Removes a lock_forever ticket which has lost all its value
+    * @ingroup operations
+    *
+    * This is a virtual operation, emitted when tickets are compacted. The amount of the ticket stays locked.
+    */
+   struct ticket_prune_operation : public base_operation
+   {
+      struct fee_parameters_type {};
+
+      ticket_prune_operation() = default;
+      ticket_prune_operation( account_id_type a, ticket_id_type t, const asset& amt )
+         : account(a), ticket(t), amount(amt) {}
+
+      asset           fee;         ///< Operation fee, always zero
+      account_id_type account;     ///< The account who owned the ticket
+      ticket_id_type  ticket;      ///< The ticket which is removed
+      asset           amount;      ///< The amount of the ticket
+
+      account_id_type fee_payer()const { return account; }
+      void            validate()const { FC_ASSERT( !"virtual operation" ); }
+
+      /// This is a virtual operation; there is no fee
+      share_type      calculate_fee(const fee_parameters_type& k)const { return 0; }
+   };
+
 } } // graphene::protocol
 
 FC_REFLECT_ENUM( graphene::protocol::ticket_type,
@@ -86,14 +139,22 @@ FC_REFLECT_ENUM( graphene::protocol::ticket_type,
 
 FC_REFLECT( graphene::protocol::ticket_create_operation::fee_parameters_type, (fee) )
 FC_REFLECT( graphene::protocol::ticket_update_operation::fee_parameters_type, (fee) )
+FC_REFLECT( graphene::protocol::ticket_merge_operation::fee_parameters_type, ) // VIRTUAL
+FC_REFLECT( graphene::protocol::ticket_prune_operation::fee_parameters_type, ) // VIRTUAL
 
 FC_REFLECT( graphene::protocol::ticket_create_operation,
             (fee)(account)(target_type)(amount)(extensions) )
 FC_REFLECT( graphene::protocol::ticket_update_operation,
             (fee)(ticket)(account)(target_type)(amount_for_new_target)(extensions) )
+FC_REFLECT( graphene::protocol::ticket_merge_operation,
+            (fee)(account)(ticket)(into_ticket)(amount) )
+FC_REFLECT( graphene::protocol::ticket_prune_operation,
+            (fee)(account)(ticket)(amount) )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::ticket_create_operation::fee_parameters_type )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::ticket_update_operation::fee_parameters_type )
 
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::ticket_create_operation )
 GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::ticket_update_operation )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::ticket_merge_operation )
+GRAPHENE_DECLARE_EXTERNAL_SERIALIZATION( graphene::protocol::ticket_prune_operation )
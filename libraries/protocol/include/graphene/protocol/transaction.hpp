@@ -125,6 +125,8 @@ namespace graphene { namespace protocol {
    protected:
       // Calculate the digest used for signature validation
       digest_type sig_digest( const chain_id_type& chain_id )const;
+      /// Same as validate(), optionally without verifying the commitments of confidential operations
+      void _validate( bool verify_commitments )const;
       mutable transaction_id_type _tx_id_buffer;
    };
 
@@ -241,8 +243,17 @@ namespace graphene { namespace protocol {
       virtual void                             validate()const override;
       virtual const flat_set<public_key_type>& get_signature_keys( const chain_id_type& chain_id )const override;
       virtual uint64_t                         get_packed_size()const override;
+
+      /// Whether the transaction contains confidential operations, see @ref verify_commitments
+      bool has_commitments()const;
+      /**
+       * Verifies the commitments and range proofs of the confidential operations, the expensive part of
+       * @ref validate. The result is cached, so that this can be done in parallel ahead of @ref validate.
+       */
+      void verify_commitments()const;
    protected:
       mutable bool _validated = false;
+      mutable bool _commitments_verified = false;
       mutable uint64_t _packed_size = 0;
    };
 
@@ -55,8 +55,38 @@ void balance_claim_operation::validate()const
 struct operation_validator
 {
    typedef void result_type;
+   bool verify_commitments = true;
+   explicit operation_validator( bool verify = true ) : verify_commitments( verify ) {}
+
    template<typename T>
    void operator()( const T& v )const { v.validate(); }
+   void operator()( const transfer_to_blind_operation& v )const { v.validate( verify_commitments ); }
+   void operator()( const transfer_from_blind_operation& v )const { v.validate( verify_commitments ); }
+   void operator()( const blind_transfer_operation& v )const { v.validate( verify_commitments ); }
+};
+
+/**
+ * @brief Verifies the commitments of confidential operations, returns whether there were any
+ */
+struct operation_commitment_verifier
+{
+   typedef bool result_type;
+   const bool verify = true;
+   explicit operation_commitment_verifier( bool v ) : verify( v ) {}
+
+   template<typename T>
+   bool operator()( const T& )const { return false; }
+
+   template<typename T>
+   bool confidential( const T& v )const
+   {
+      if( verify )
+         v.verify_commitments();
+      return true;
+   }
+   bool operator()( const transfer_to_blind_operation& v )const { return confidential( v ); }
+   bool operator()( const transfer_from_blind_operation& v )const { return confidential( v ); }
+   bool operator()( const blind_transfer_operation& v )const { return confidential( v ); }
 };
 
 struct operation_get_required_auth
@@ -95,9 +125,19 @@ struct operation_get_required_auth
    }
 };
 
-void operation_validate( const operation& op )
+void operation_validate( const operation& op, bool verify_commitments )
+{
+   op.visit( operation_validator( verify_commitments ) );
+}
+
+bool operation_verify_commitments( const operation& op )
+{
+   return op.visit( operation_commitment_verifier( true ) );
+}
+
+bool operation_has_commitments( const operation& op )
 {
-   op.visit( operation_validator() );
+   return op.visit( operation_commitment_verifier( false ) );
 }
 
 void operation_get_required_authorities( const operation& op,
@@ -56,10 +56,15 @@ digest_type transaction::sig_digest( const chain_id_type& chain_id )const
 }
 
 void transaction::validate() const
+{
+   _validate( true );
+}
+
+void transaction::_validate( bool verify_commitments ) const
 {
    FC_ASSERT( operations.size() > 0, "A transaction must have at least one operation", ("trx",*this) );
    for( const auto& op : operations )
-      operation_validate(op);
+      operation_validate( op, verify_commitments );
 }
 
 uint64_t transaction::get_packed_size() const
@@ -441,10 +446,26 @@ const transaction_id_type& precomputable_transaction::id()const
 void precomputable_transaction::validate() const
 {
    if( _validated ) return;
-   transaction::validate();
+   transaction::_validate( !_commitments_verified );
    _validated = true;
 }
 
+bool precomputable_transaction::has_commitments() const
+{
+   for( const auto& op : operations )
+      if( operation_has_commitments( op ) )
+         return true;
+   return false;
+}
+
+void precomputable_transaction::verify_commitments() const
+{
+   if( _commitments_verified ) return;
+   for( const auto& op : operations )
+      operation_verify_commitments( op );
+   _commitments_verified = true;
+}
+
 uint64_t precomputable_transaction::get_packed_size()const
 {
    if( _packed_size == 0 )
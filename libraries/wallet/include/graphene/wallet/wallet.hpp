@@ -792,6 +792,21 @@ class wallet_api
       }
 
 
+      /** Transfer amounts between accounts in bulk, as listed in a file.
+       *
+       * All transfers are created, signed and then submitted to the node in batches, one batch after the
+       * other, in the order they appear in the file.  A transfer which can not be created or which is
+       * rejected by the node does not affect the others.
+       *
+       * @param filename a JSON file containing an array of transfers, each an object with the
+       *                 fields \c from, \c to, \c amount, \c asset_symbol_or_id and \c memo
+       *                 which have the meaning of the parameters of \c transfer
+       * @param broadcast true to broadcast the transactions on the network
+       * @returns for each transfer in the file the signed transaction, whether the node accepted it
+       *          and the reason in case of failure
+       */
+      vector<transfer_batch_result> transfer_batch(string filename, bool broadcast = false);
+
       /**
        *  This method is used to convert a JSON transaction to its transactin ID.
        * @param trx a JSON transaction
@@ -1857,6 +1872,7 @@ FC_API( graphene::wallet::wallet_api,
         (cancel_order)
         (transfer)
         (transfer2)
+        (transfer_batch)
         (get_transaction_id)
         (create_asset)
         (update_asset)
@@ -226,6 +226,23 @@ struct worker_vote_delta
    flat_set<worker_id_type> vote_abstain;
 };
 
+/// One transfer of a @ref wallet_api::transfer_batch file, see @ref wallet_api::transfer for the fields
+struct transfer_batch_entry
+{
+   string from;
+   string to;
+   string amount;
+   string asset_symbol_or_id;
+   string memo;
+};
+
+struct transfer_batch_result
+{
+   signed_transaction trx;
+   bool               accepted = false; ///< whether the node accepted the transaction, false if it was not broadcast
+   optional<string>   error;            ///< why the transaction could not be created or was rejected
+};
+
 struct signed_block_with_info : public signed_block
 {
    signed_block_with_info( const signed_block& block );
@@ -372,6 +389,10 @@ FC_REFLECT( graphene::wallet::worker_vote_delta,
    (vote_abstain)
 )
 
+FC_REFLECT( graphene::wallet::transfer_batch_entry, (from)(to)(amount)(asset_symbol_or_id)(memo) )
+
+FC_REFLECT( graphene::wallet::transfer_batch_result, (trx)(accepted)(error) )
+
 FC_REFLECT_DERIVED( graphene::wallet::signed_block_with_info, (graphene::chain::signed_block),
    (block_id)(signing_key)(transaction_ids) )
 
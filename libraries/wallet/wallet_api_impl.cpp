@@ -78,6 +78,12 @@ namespace graphene { namespace wallet { namespace detail {
       {
          on_block_applied( block_id );
       } );
+      // only the objects which are fetched into the object cache are subscribed to
+      _remote_db->set_subscribe_callback( [this](const variant& updates )
+      {
+         _object_cache.on_objects_changed( updates );
+      }, false );
+      _remote_db->set_auto_subscription( false );
 
       _wallet.chain_id = _chain_id;
       _wallet.ws_server = initial_data.ws_server;
@@ -172,19 +178,49 @@ namespace graphene { namespace wallet { namespace detail {
 
    chain_property_object wallet_api_impl::get_chain_properties() const
    {
-      return _remote_db->get_chain_properties();
+      if( auto cached = _object_cache.get_chain_properties() )
+         return *cached;
+      chain_property_object props = _remote_db->get_chain_properties();
+      _object_cache.store_chain_properties( props );
+      return props;
    }
    global_property_object wallet_api_impl::get_global_properties() const
    {
-      return _remote_db->get_global_properties();
+      if( auto cached = _object_cache.get_global_properties() )
+         return *cached;
+      uint64_t generation = _object_cache.generation();
+      // fetch it as an object to subscribe to it
+      global_property_object props = _remote_db->get_objects( { global_property_id_type() }, true ).front()
+                                        .as<global_property_object>( GRAPHENE_MAX_NESTED_OBJECTS );
+      _object_cache.store_global_properties( props, generation );
+      return props;
    }
    dynamic_global_property_object wallet_api_impl::get_dynamic_global_properties() const
    {
-      return _remote_db->get_dynamic_global_properties();
+      if( auto cached = _object_cache.get_dynamic_global_properties() )
+         return *cached;
+      uint64_t generation = _object_cache.generation();
+      dynamic_global_property_object props = _remote_db->get_dynamic_global_properties();
+      _object_cache.store_dynamic_global_properties( props, generation );
+      return props;
+   }
+
+   void wallet_api_impl::on_transaction_broadcast( const signed_transaction& tx )
+   {
+      // the node only notifies us of changes once they are included in a block
+      for( const operation& op : tx.operations )
+      {
+         if( !op.is_type<transfer_operation>() )
+         {
+            _object_cache.clear();
+            return;
+         }
+      }
    }
 
    void wallet_api_impl::on_block_applied( const variant& block_id )
    {
+      _object_cache.on_block_applied();
       fc::async([this]{resync();}, "Resync after block");
    }
 
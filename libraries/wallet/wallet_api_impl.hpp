@@ -31,6 +31,8 @@
 #include <graphene/wallet/wallet_structs.hpp>
 #include <graphene/wallet/reflect_util.hpp>
 
+#include "wallet_object_cache.hpp"
+
 namespace graphene { namespace wallet { 
 
 class wallet_api;
@@ -365,6 +367,8 @@ public:
    signed_transaction transfer(string from, string to, string amount,
          string asset_symbol, string memo, bool broadcast = false);
 
+   vector<transfer_batch_result> transfer_batch(string filename, bool broadcast = false);
+
    signed_transaction issue_asset(string to_account, string amount, string symbol,
          string memo, bool broadcast = false);
 
@@ -422,6 +426,8 @@ public:
 
    static_variant_map _operation_which_map = create_static_variant_map< operation >();
 
+   mutable wallet_object_cache _object_cache;
+
 private:
    std::string account_id_to_string(account_id_type id) const;
 
@@ -446,6 +452,24 @@ private:
    fc::mutex _resync_mutex;
    void resync();
 
+   // the default limit of network_broadcast_api::broadcast_transaction_batch
+   static constexpr size_t max_transfers_per_broadcast = 1000;
+
+   // broadcasts the given results of transfer_batch, splitting the batches the node refuses as a whole in
+   // halves, and lowers batch_size_limit to the size of the halves
+   void broadcast_transfers( vector<transfer_batch_result>& results, const vector<size_t>& indexes,
+                             size_t& batch_size_limit );
+
+   signed_transaction build_transfer_transaction( const string& from, const string& to, const string& amount,
+         const string& asset_symbol, const string& memo );
+
+   // drops the cached objects which the broadcast transaction may have changed before the node notifies us
+   void on_transaction_broadcast( const signed_transaction& tx );
+
+   // signs the transaction, bumping its expiration time if we have generated the same transaction recently
+   void sign_unique_transaction( signed_transaction& tx, const set<public_key_type>& approving_key_set,
+                                 const dynamic_global_property_object& dyn_props );
+
    void init_prototype_ops();
 
    map<transaction_handle_type, signed_transaction> _builder_transactions;
@@ -107,6 +107,7 @@ namespace graphene { namespace wallet { namespace detail {
    {
        try {
            _remote_net_broadcast->broadcast_transaction(tx);
+           on_transaction_broadcast(tx);
        }
        catch (const fc::exception& e) {
            elog("Caught exception while broadcasting tx ${id}:  ${e}",
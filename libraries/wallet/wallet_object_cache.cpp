@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "wallet_object_cache.hpp"
+
+namespace graphene { namespace wallet { namespace detail {
+
+uint64_t wallet_object_cache::generation()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _generation;
+}
+
+optional<account_object> wallet_object_cache::find_account( account_id_type id )const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   auto itr = _accounts.find( id );
+   if( itr == _accounts.end() )
+      return optional<account_object>();
+   return itr->second;
+}
+
+optional<account_object> wallet_object_cache::find_account( const std::string& name )const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   auto id_itr = _account_ids_by_name.find( name );
+   if( id_itr == _account_ids_by_name.end() )
+      return optional<account_object>();
+   return _accounts.at( id_itr->second );
+}
+
+void wallet_object_cache::store_account( const account_object& account, uint64_t fetched_at_generation )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( fetched_at_generation != _generation )
+      return;
+   _accounts[account.get_id()] = account;
+   _account_ids_by_name[account.name] = account.get_id();
+}
+
+optional<extended_asset_object> wallet_object_cache::find_asset( asset_id_type id )const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   auto itr = _assets.find( id );
+   if( itr == _assets.end() )
+      return optional<extended_asset_object>();
+   return itr->second;
+}
+
+optional<extended_asset_object> wallet_object_cache::find_asset( const std::string& symbol )const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   auto id_itr = _asset_ids_by_symbol.find( symbol );
+   if( id_itr == _asset_ids_by_symbol.end() )
+      return optional<extended_asset_object>();
+   return _assets.at( id_itr->second );
+}
+
+void wallet_object_cache::store_asset( const extended_asset_object& asset, uint64_t fetched_at_generation )
+{
+   // the collateral totals of market issued assets change with their call orders, which we are not notified of
+   if( asset.total_in_collateral.valid() )
+      return;
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( fetched_at_generation != _generation )
+      return;
+   _assets[asset.get_id()] = asset;
+   _asset_ids_by_symbol[asset.symbol] = asset.get_id();
+}
+
+optional<chain_property_object> wallet_object_cache::get_chain_properties()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _chain_properties;
+}
+
+void wallet_object_cache::store_chain_properties( const chain_property_object& props )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   _chain_properties = props;
+}
+
+optional<global_property_object> wallet_object_cache::get_global_properties()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _global_properties;
+}
+
+void wallet_object_cache::store_global_properties( const global_property_object& props,
+                                                   uint64_t fetched_at_generation )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( fetched_at_generation == _generation )
+      _global_properties = props;
+}
+
+optional<dynamic_global_property_object> wallet_object_cache::get_dynamic_global_properties()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _dynamic_global_properties;
+}
+
+void wallet_object_cache::store_dynamic_global_properties( const dynamic_global_property_object& props,
+                                                           uint64_t fetched_at_generation )
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   if( fetched_at_generation == _generation )
+      _dynamic_global_properties = props;
+}
+
+void wallet_object_cache::on_objects_changed( const fc::variant& updates )
+{
+   if( !updates.is_array() )
+      return;
+   std::lock_guard<std::mutex> lock( _mutex );
+   for( const fc::variant& item : updates.get_array() )
+   {
+      // changed objects are sent in full, removed ones only by ID
+      if( item.is_object() && item.get_object().contains( "id" ) )
+         invalidate( item.get_object()["id"].as<object_id_type>( 1 ) );
+      else if( item.is_string() )
+         invalidate( item.as<object_id_type>( 1 ) );
+   }
+}
+
+void wallet_object_cache::on_block_applied()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   invalidate( dynamic_global_property_id_type() );
+}
+
+void wallet_object_cache::clear()
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   ++_generation;
+   _accounts.clear();
+   _account_ids_by_name.clear();
+   _assets.clear();
+   _asset_ids_by_symbol.clear();
+   _global_properties.reset();
+   _dynamic_global_properties.reset();
+}
+
+void wallet_object_cache::invalidate( const object_id_type& id )
+{
+   ++_generation;
+   if( id.is<account_id_type>() )
+   {
+      auto itr = _accounts.find( account_id_type( id ) );
+      if( itr != _accounts.end() )
+      {
+         _account_ids_by_name.erase( itr->second.name );
+         _accounts.erase( itr );
+      }
+   }
+   else if( id.is<asset_id_type>() )
+   {
+      auto itr = _assets.find( asset_id_type( id ) );
+      if( itr != _assets.end() )
+      {
+         _asset_ids_by_symbol.erase( itr->second.symbol );
+         _assets.erase( itr );
+      }
+   }
+   else if( id == object_id_type( global_property_id_type() ) )
+      _global_properties.reset();
+   else if( id == object_id_type( dynamic_global_property_id_type() ) )
+      _dynamic_global_properties.reset();
+}
+
+}}} // namespace graphene::wallet::detail
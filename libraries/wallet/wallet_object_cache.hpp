@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <graphene/app/api_objects.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/global_property_object.hpp>
+#include <graphene/chain/chain_property_object.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace graphene { namespace wallet { namespace detail {
+
+using namespace graphene::chain;
+using graphene::app::extended_asset_object;
+
+/**
+ * @brief Local copies of the chain objects the wallet looks up for nearly every command
+ *
+ * Accounts, assets and the global properties are kept here after they were fetched from the remote node once.
+ * The wallet subscribes to the objects it caches, and @ref on_objects_changed drops an entry as soon as the node
+ * reports a change, so the next lookup fetches it again. The dynamic global properties change with every block
+ * and are dropped by @ref on_block_applied.
+ *
+ * A fetch which was started before an invalidation must not store its (possibly outdated) result, so every
+ * invalidation bumps a generation counter which the caller reads with @ref generation before fetching and
+ * passes to the store_* methods.
+ */
+class wallet_object_cache
+{
+   public:
+      uint64_t generation()const;
+
+      optional<account_object> find_account( account_id_type id )const;
+      optional<account_object> find_account( const std::string& name )const;
+      void store_account( const account_object& account, uint64_t fetched_at_generation );
+
+      optional<extended_asset_object> find_asset( asset_id_type id )const;
+      optional<extended_asset_object> find_asset( const std::string& symbol )const;
+      void store_asset( const extended_asset_object& asset, uint64_t fetched_at_generation );
+
+      optional<chain_property_object> get_chain_properties()const;
+      void store_chain_properties( const chain_property_object& props );
+
+      optional<global_property_object> get_global_properties()const;
+      void store_global_properties( const global_property_object& props, uint64_t fetched_at_generation );
+
+      optional<dynamic_global_property_object> get_dynamic_global_properties()const;
+      void store_dynamic_global_properties( const dynamic_global_property_object& props,
+                                            uint64_t fetched_at_generation );
+
+      /// Handles a notification of the database_api subscribe callback
+      void on_objects_changed( const fc::variant& updates );
+      void on_block_applied();
+
+      /// Drops everything except the chain properties, which never change
+      void clear();
+
+   private:
+      void invalidate( const object_id_type& id );
+
+      mutable std::mutex                                  _mutex;
+      uint64_t                                            _generation = 0;
+
+      std::map<account_id_type, account_object>           _accounts;
+      std::map<std::string, account_id_type>              _account_ids_by_name;
+      std::map<asset_id_type, extended_asset_object>      _assets;
+      std::map<std::string, asset_id_type>                _asset_ids_by_symbol;
+
+      optional<chain_property_object>                     _chain_properties;
+      optional<global_property_object>                    _global_properties;
+      optional<dynamic_global_property_object>            _dynamic_global_properties;
+};
+
+}}} // namespace graphene::wallet::detail
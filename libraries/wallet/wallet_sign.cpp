@@ -315,6 +315,7 @@ namespace graphene { namespace wallet { namespace detail {
          try
          {
             _remote_net_broadcast->broadcast_transaction( tx );
+            on_transaction_broadcast( tx );
          }
          catch ( const fc::exception &e )
          {
@@ -327,22 +328,9 @@ namespace graphene { namespace wallet { namespace detail {
       return tx;
    }
 
-   signed_transaction wallet_api_impl::sign_transaction( signed_transaction tx, bool broadcast )
+   void wallet_api_impl::sign_unique_transaction( signed_transaction& tx,
+         const set<public_key_type>& approving_key_set, const dynamic_global_property_object& dyn_props )
    {
-      return sign_transaction2(tx, {}, broadcast);
-   }
-
-   signed_transaction wallet_api_impl::sign_transaction2( signed_transaction tx,
-                                                         const vector<public_key_type>& signing_keys, bool broadcast)
-   {
-      set<public_key_type> approving_key_set = get_owned_required_keys(tx);
-
-      // Add any explicit keys to the approving_key_set
-      for (const public_key_type& explicit_key : signing_keys) {
-         approving_key_set.insert(explicit_key);
-      }
-
-      auto dyn_props = get_dynamic_global_properties();
       tx.set_reference_block( dyn_props.head_block_id );
 
       // first, some bookkeeping, expire old items from _recently_generated_transactions
@@ -379,12 +367,32 @@ namespace graphene { namespace wallet { namespace detail {
          // else we've generated a dupe, increment expiration time and re-sign it
          ++expiration_time_offset;
       }
+   }
+
+   signed_transaction wallet_api_impl::sign_transaction( signed_transaction tx, bool broadcast )
+   {
+      return sign_transaction2(tx, {}, broadcast);
+   }
+
+   signed_transaction wallet_api_impl::sign_transaction2( signed_transaction tx,
+                                                         const vector<public_key_type>& signing_keys, bool broadcast)
+   {
+      set<public_key_type> approving_key_set = get_owned_required_keys(tx);
+
+      // Add any explicit keys to the approving_key_set
+      for (const public_key_type& explicit_key : signing_keys) {
+         approving_key_set.insert(explicit_key);
+      }
+
+      auto dyn_props = get_dynamic_global_properties();
+      sign_unique_transaction( tx, approving_key_set, dyn_props );
 
       if( broadcast )
       {
          try
          {
             _remote_net_broadcast->broadcast_transaction( tx );
+            on_transaction_broadcast( tx );
          }
          catch (const fc::exception& e)
          {
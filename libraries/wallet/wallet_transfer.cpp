@@ -21,6 +21,9 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+
 #include "wallet_api_impl.hpp"
 #include <graphene/wallet/wallet.hpp>
 
@@ -48,10 +51,9 @@ namespace graphene { namespace wallet { namespace detail {
       FC_THROW_EXCEPTION( fc::invalid_arg_exception, "Unknown algorithm '${a}'", ("a",algorithm) );
    }
 
-   signed_transaction wallet_api_impl::transfer(string from, string to, string amount,
-                               string asset_symbol, string memo, bool broadcast )
-   { try {
-      FC_ASSERT( !self.is_locked() );
+   signed_transaction wallet_api_impl::build_transfer_transaction( const string& from, const string& to,
+         const string& amount, const string& asset_symbol, const string& memo )
+   {
       fc::optional<asset_object> asset_obj = get_asset(asset_symbol);
       FC_ASSERT(asset_obj, "Could not find asset matching ${asset}", ("asset", asset_symbol));
 
@@ -77,12 +79,151 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back(xfer_op);
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees( tx, get_global_properties().parameters.get_current_fees());
       tx.validate();
 
+      return tx;
+   }
+
+   signed_transaction wallet_api_impl::transfer(string from, string to, string amount,
+                               string asset_symbol, string memo, bool broadcast )
+   { try {
+      FC_ASSERT( !self.is_locked() );
+      signed_transaction tx = build_transfer_transaction( from, to, amount, asset_symbol, memo );
+
       return sign_transaction(tx, broadcast);
    } FC_CAPTURE_AND_RETHROW( (from)(to)(amount)(asset_symbol)(memo)(broadcast) ) }
 
+   vector<transfer_batch_result> wallet_api_impl::transfer_batch( string filename, bool broadcast )
+   { try {
+      FC_ASSERT( !self.is_locked() );
+      FC_ASSERT( fc::exists( filename ), "File ${f} does not exist", ("f", filename) );
+      const auto entries = fc::json::from_file<vector<transfer_batch_entry>>( filename );
+
+      vector<transfer_batch_result> results( entries.size() );
+
+      // All transactions refer to the same block.  A transfer needs the active authority of the sender only,
+      // so the keys to sign with are looked up once per sender instead of once per transaction.
+      const dynamic_global_property_object dyn_props = get_dynamic_global_properties();
+      const global_property_object global_props = get_global_properties();
+      const auto& params = global_props.parameters;
+      flat_map<account_id_type, set<public_key_type>> keys_by_sender;
+      for( size_t i = 0; i < entries.size(); ++i )
+      {
+         const transfer_batch_entry& entry = entries[i];
+         try
+         {
+            signed_transaction tx = build_transfer_transaction( entry.from, entry.to, entry.amount,
+                                                                entry.asset_symbol_or_id, entry.memo );
+            const account_id_type sender = tx.operations.front().get<transfer_operation>().from;
+            auto keys_itr = keys_by_sender.find( sender );
+            if( keys_itr == keys_by_sender.end() )
+               keys_itr = keys_by_sender.emplace( sender, get_owned_required_keys( tx ) ).first;
+            sign_unique_transaction( tx, keys_itr->second, dyn_props );
+            FC_ASSERT( fc::raw::pack_size( tx ) <= params.maximum_transaction_size,
+                       "Transaction is larger than the maximum transaction size of ${max} bytes",
+                       ("max", params.maximum_transaction_size) );
+            results[i].trx = std::move( tx );
+         }
+         catch( const fc::exception& e )
+         {
+            results[i].error = e.to_string();
+         }
+      }
+
+      if( !broadcast )
+         return results;
+
+      // A batch holds as many transactions of the maximum size as fit in a block, up to the default limit of
+      // the node.  The batches are broadcast one after the other, so the node receives the transactions in the
+      // order of the file, and a transfer may spend what an earlier one sent.
+      vector<size_t> pending;
+      pending.reserve( results.size() );
+      for( size_t i = 0; i < results.size(); ++i )
+      {
+         if( !results[i].error.valid() )
+            pending.push_back( i );
+      }
+      size_t batch_size_limit = std::max<size_t>( 1, std::min<size_t>( max_transfers_per_broadcast,
+            params.maximum_block_size / std::max<uint32_t>( params.maximum_transaction_size, 1 ) ) );
+      const size_t chunk_size = batch_size_limit;
+      for( size_t begin = 0; begin < pending.size(); begin += chunk_size )
+      {
+         const vector<size_t> chunk( pending.begin() + begin,
+                                     pending.begin() + std::min( pending.size(), begin + chunk_size ) );
+         broadcast_transfers( results, chunk, batch_size_limit );
+      }
+
+      return results;
+   } FC_CAPTURE_AND_RETHROW( (filename)(broadcast) ) }
+
+   void wallet_api_impl::broadcast_transfers( vector<transfer_batch_result>& results, const vector<size_t>& indexes,
+                                              size_t& batch_size_limit )
+   {
+      if( indexes.empty() )
+         return;
+      if( indexes.size() == 1 )
+      {
+         transfer_batch_result& result = results[indexes.front()];
+         try
+         {
+            _remote_net_broadcast->broadcast_transaction( result.trx );
+            result.accepted = true;
+         }
+         catch( const fc::exception& e )
+         {
+            result.error = e.to_string();
+         }
+         return;
+      }
+
+      if( indexes.size() <= batch_size_limit )
+      {
+         vector<precomputable_transaction> batch;
+         batch.reserve( indexes.size() );
+         for( size_t index : indexes )
+            batch.emplace_back( results[index].trx );
+         try
+         {
+            const auto batch_results = _remote_net_broadcast->broadcast_transaction_batch( batch );
+            FC_ASSERT( batch_results.size() == batch.size() );
+            for( size_t j = 0; j < indexes.size(); ++j )
+            {
+               transfer_batch_result& result = results[indexes[j]];
+               result.accepted = batch_results[j].accepted;
+               result.error = batch_results[j].error;
+            }
+            return;
+         }
+         catch( const fc::exception& e )
+         {
+            // Only a batch the node refused as a whole is split.  After any other error, e.g. a lost connection,
+            // the node may have accepted the transactions already, broadcasting them again would fail.
+            const string message = e.to_detail_string();
+            if( message.find( "no method with name" ) != string::npos )
+            {
+               dlog( "The node does not offer broadcast_transaction_batch, broadcasting one by one" );
+               batch_size_limit = 1;
+            }
+            else if( message.find( "Number of transactions can not be greater than" ) != string::npos )
+            {
+               dlog( "The node refused a batch of ${n} transactions, splitting it", ("n", indexes.size()) );
+               batch_size_limit = std::min( batch_size_limit, indexes.size() / 2 );
+            }
+            else
+            {
+               for( size_t index : indexes )
+                  results[index].error = e.to_string();
+               return;
+            }
+         }
+      }
+
+      const size_t half = ( indexes.size() + 1 ) / 2;
+      broadcast_transfers( results, vector<size_t>( indexes.begin(), indexes.begin() + half ), batch_size_limit );
+      broadcast_transfers( results, vector<size_t>( indexes.begin() + half, indexes.end() ), batch_size_limit );
+   }
+
    signed_transaction wallet_api_impl::htlc_create( string source, string destination, string amount,
          string asset_symbol, string hash_algorithm, const std::string& preimage_hash, uint32_t preimage_size,
          const uint32_t claim_period_seconds, const std::string& memo, bool broadcast )
@@ -114,7 +255,7 @@ namespace graphene { namespace wallet { namespace detail {
 
          signed_transaction tx;
          tx.operations.push_back(create_op);
-         set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees());
+         set_operation_fees( tx, get_global_properties().parameters.get_current_fees());
          tx.validate();
 
          return sign_transaction(tx, broadcast);
@@ -140,7 +281,7 @@ namespace graphene { namespace wallet { namespace detail {
 
          signed_transaction tx;
          tx.operations.push_back(update_op);
-         set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees());
+         set_operation_fees( tx, get_global_properties().parameters.get_current_fees());
          tx.validate();
 
          return sign_transaction(tx, broadcast);
@@ -165,7 +306,7 @@ namespace graphene { namespace wallet { namespace detail {
 
          signed_transaction tx;
          tx.operations.push_back(update_op);
-         set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees());
+         set_operation_fees( tx, get_global_properties().parameters.get_current_fees());
          tx.validate();
 
          return sign_transaction(tx, broadcast);
@@ -200,7 +341,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back(op);
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees( tx, get_global_properties().parameters.get_current_fees());
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -230,7 +371,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction trx;
       trx.operations = {op};
-      set_operation_fees( trx, _remote_db->get_global_properties().parameters.get_current_fees());
+      set_operation_fees( trx, get_global_properties().parameters.get_current_fees());
       trx.validate();
 
       return sign_transaction(trx, broadcast);
@@ -245,7 +386,7 @@ namespace graphene { namespace wallet { namespace detail {
          op.fee_paying_account = get_object(order_id).seller;
          op.order = order_id;
          trx.operations = {op};
-         set_operation_fees( trx, _remote_db->get_global_properties().parameters.get_current_fees());
+         set_operation_fees( trx, get_global_properties().parameters.get_current_fees());
 
          trx.validate();
          return sign_transaction(trx, broadcast);
@@ -272,7 +413,7 @@ namespace graphene { namespace wallet { namespace detail {
 
       signed_transaction tx;
       tx.operations.push_back( vesting_balance_withdraw_op );
-      set_operation_fees( tx, _remote_db->get_global_properties().parameters.get_current_fees() );
+      set_operation_fees( tx, get_global_properties().parameters.get_current_fees() );
       tx.validate();
 
       return sign_transaction( tx, broadcast );
@@ -32,6 +32,7 @@
 #include <fc/io/stdio.hpp>
 
 #include <graphene/app/api.hpp>
+#include <graphene/chain/genesis_loader.hpp>
 #include <graphene/protocol/address.hpp>
 #include <graphene/egenesis/egenesis.hpp>
 #include <graphene/utilities/key_conversion.hpp>
@@ -63,6 +64,8 @@ int main( int argc, char** argv )
             ("help,h", "Print this help message and exit.")
             ("genesis-json,g", bpo::value<boost::filesystem::path>(), "File to read genesis state from")
             ("out,o", bpo::value<boost::filesystem::path>(), "File to output new genesis to")
+            ("out-binary", bpo::value<boost::filesystem::path>(),
+             "File to also output new genesis to in binary form, for the genesis-binary node option")
             ("dev-account-prefix", bpo::value<std::string>()->default_value("devacct"), "Prefix for dev accounts")
             ("dev-key-prefix", bpo::value<std::string>()->default_value("devkey-"), "Prefix for dev key")
             ("dev-account-count", bpo::value<uint32_t>()->default_value(0), "Prefix for dev accounts")
@@ -106,7 +109,7 @@ int main( int argc, char** argv )
          std::cerr << "update_genesis:  Reading genesis from file " << genesis_json_filename.preferred_string() << "\n";
          std::string genesis_json;
          read_file_contents( genesis_json_filename, genesis_json );
-         genesis = fc::json::from_string( genesis_json ).as< genesis_state_type >(20);
+         genesis = parse_genesis_json( genesis_json );
       }
       else
       {
@@ -166,6 +169,16 @@ int main( int argc, char** argv )
 
       fc::path output_filename = options["out"].as<boost::filesystem::path>();
       fc::json::save_to_file( genesis, output_filename );
+
+      if( options.count("out-binary") > 0 )
+      {
+         // the chain ID is the hash of the JSON text, as computed by the node when loading it
+         std::string genesis_json;
+         read_file_contents( output_filename, genesis_json );
+         genesis.initial_chain_id = fc::sha256::hash( genesis_json );
+         write_binary_genesis( options["out-binary"].as<boost::filesystem::path>(), genesis );
+         std::cerr << "update_genesis:  Chain ID of the binary genesis is " << genesis.initial_chain_id.str() << "\n";
+      }
    }
    catch ( const fc::exception& e )
    {
@@ -0,0 +1,894 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Runs a number of p2p nodes in one process, connected over loopback, injects a stream of transactions and
+ * blocks into the network and reports how fast and how completely they propagated, the bandwidth each node
+ * used, the CPU time of the process and the time the message handlers took per message type.
+ *
+ * The nodes only connect along the edges of the chosen topology.  Each edge can go through a link shaper,
+ * which delays the bytes in both directions and limits the bandwidth of the link.  The nodes don't validate
+ * anything: blocks and transactions carry opaque payloads, and the chain never forks.
+ */
+
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/exceptions.hpp>
+#include <graphene/net/node.hpp>
+#include <graphene/protocol/block.hpp>
+#include <graphene/protocol/custom.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/future.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace graphene::net;
+using graphene::protocol::block_header;
+using graphene::protocol::chain_id_type;
+using graphene::protocol::custom_operation;
+using graphene::protocol::processed_transaction;
+using graphene::protocol::signed_block;
+using graphene::protocol::signed_transaction;
+namespace bpo = boost::program_options;
+
+namespace {
+
+const fc::ip::address loopback( "127.0.0.1" );
+
+/// Keeps the time each injected item was sent and the delays until each node received it
+class propagation_recorder
+{
+public:
+   void injected( uint32_t item_type, const fc::ripemd160& id, const fc::time_point& when )
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _items[id] = item_record{ item_type, when };
+      ++_injected[item_type];
+   }
+
+   void received( const fc::ripemd160& id, const fc::time_point& when )
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto item = _items.find( id );
+      if( item != _items.end() )
+         _delays_us[item->second.item_type].push_back( ( when - item->second.injected ).count() );
+   }
+
+   /// Statistics of the items of one type, each of which should have reached @p receivers nodes
+   fc::variant_object report( uint32_t item_type, uint32_t receivers )const
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      fc::mutable_variant_object result;
+      const auto injected = _injected.find( item_type );
+      const uint64_t injected_count = injected == _injected.end() ? 0 : injected->second;
+      std::vector<int64_t> delays;
+      const auto item_delays = _delays_us.find( item_type );
+      if( item_delays != _delays_us.end() )
+         delays = item_delays->second;
+      std::sort( delays.begin(), delays.end() );
+
+      const uint64_t expected = injected_count * receivers;
+      result["injected"] = injected_count;
+      result["expected_receptions"] = expected;
+      result["receptions"] = uint64_t( delays.size() );
+      result["coverage_percent"] = expected == 0 ? 0.0 : 100.0 * delays.size() / expected;
+      const auto percentile_ms = [&delays]( uint32_t percent ) {
+         if( delays.empty() )
+            return 0.0;
+         const size_t index = std::min( delays.size() - 1, delays.size() * percent / 100 );
+         return delays[index] / 1000.0;
+      };
+      result["p50_ms"] = percentile_ms( 50 );
+      result["p90_ms"] = percentile_ms( 90 );
+      result["p99_ms"] = percentile_ms( 99 );
+      result["max_ms"] = delays.empty() ? 0.0 : delays.back() / 1000.0;
+      return result;
+   }
+
+private:
+   struct item_record
+   {
+      uint32_t       item_type = 0;
+      fc::time_point injected;
+   };
+
+   mutable std::mutex                        _mutex;
+   std::map<fc::ripemd160, item_record>      _items;
+   std::map<uint32_t, uint64_t>              _injected;
+   std::map<uint32_t, std::vector<int64_t>>  _delays_us;
+};
+
+/**
+ * The blockchain of one node: it accepts any block which links to its head and any transaction, and keeps
+ * everything in memory.  Called from the thread of its node, and from the main thread for the items the
+ * benchmark injects through this node.
+ */
+class benchmark_node_delegate : public node_delegate
+{
+public:
+   benchmark_node_delegate( const chain_id_type& chain_id, uint8_t block_interval, propagation_recorder& recorder )
+      : _chain_id( chain_id ), _block_interval( block_interval ), _recorder( recorder ) {}
+
+   /// Adds a block produced by the benchmark on top of our head block
+   void add_local_block( const signed_block& block )
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      FC_ASSERT( block.previous == head_block_id_locked(), "Local blocks must build on the head block" );
+      store_block( block_message( block ) );
+   }
+
+   void add_local_transaction( const signed_transaction& trx )
+   {
+      const message trx_msg = trx_message( trx );
+      std::lock_guard<std::mutex> lock( _mutex );
+      _items.emplace( trx_msg.id(), trx_msg );
+   }
+
+   bool has_item( const item_id& id ) override
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      return _items.find( id.item_hash ) != _items.end();
+   }
+
+   bool handle_block( const block_message& blk_msg, bool sync_mode,
+                      std::vector<message_hash_type>& contained_transaction_msg_ids ) override
+   {
+      const fc::time_point now = fc::time_point::now();
+      std::lock_guard<std::mutex> lock( _mutex );
+      if( _items.find( blk_msg.block_id ) != _items.end() )
+         return false;
+      if( blk_msg.block.previous != head_block_id_locked() )
+         FC_THROW_EXCEPTION( graphene::net::unlinkable_block_exception,
+                             "Block ${n} doesn't link to our head block", ("n", blk_msg.block.block_num()) );
+      store_block( blk_msg );
+      for( const processed_transaction& trx : blk_msg.block.transactions )
+      {
+         const message trx_msg = trx_message( trx );
+         const message_hash_type trx_msg_id = trx_msg.id();
+         _items.emplace( trx_msg_id, trx_msg );
+         if( !sync_mode )
+            contained_transaction_msg_ids.push_back( trx_msg_id );
+      }
+      _recorder.received( blk_msg.block_id, now );
+      return false;
+   }
+
+   void handle_transaction( const trx_message& trx_msg ) override
+   {
+      const fc::time_point now = fc::time_point::now();
+      const message msg( trx_msg );
+      std::lock_guard<std::mutex> lock( _mutex );
+      if( _items.emplace( msg.id(), msg ).second )
+         _recorder.received( trx_msg.trx.id(), now );
+   }
+
+   void handle_message( const message& message_to_process ) override
+   {
+      FC_THROW( "Unexpected message of type ${type}", ("type", message_to_process.msg_type.value()) );
+   }
+
+   std::vector<item_hash_t> get_block_ids( const std::vector<item_hash_t>& blockchain_synopsis,
+                                           uint32_t& remaining_item_count, uint32_t limit ) override
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      remaining_item_count = 0;
+      std::vector<item_hash_t> result;
+      if( _chain.empty() )
+         return result;
+
+      uint32_t first_block_num = 1;
+      for( auto id = blockchain_synopsis.rbegin(); id != blockchain_synopsis.rend(); ++id )
+      {
+         const uint32_t block_num = block_header::num_from_id( *id );
+         if( *id == item_hash_t() || ( block_num >= 1 && block_num <= _chain.size() && _chain[block_num - 1] == *id ) )
+         {
+            first_block_num = std::max<uint32_t>( block_num, 1 );
+            break;
+         }
+      }
+      const uint32_t head_block_num = uint32_t( _chain.size() );
+      for( uint32_t block_num = first_block_num; block_num <= head_block_num && result.size() < limit; ++block_num )
+         result.push_back( _chain[block_num - 1] );
+      if( !result.empty() )
+         remaining_item_count = head_block_num - block_header::num_from_id( result.back() );
+      return result;
+   }
+
+   message get_item( const item_id& id ) override
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      auto item = _items.find( id.item_hash );
+      if( item == _items.end() )
+         FC_THROW_EXCEPTION( fc::key_not_found_exception, "Item ${id} not found", ("id", id) );
+      return item->second;
+   }
+
+   chain_id_type get_chain_id()const override { return _chain_id; }
+
+   /// The chain never forks, so the synopsis always describes our own chain up to the head block
+   std::vector<item_hash_t> get_blockchain_synopsis( const item_hash_t& reference_point,
+                                                     uint32_t number_of_blocks_after_reference_point ) override
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      std::vector<item_hash_t> synopsis;
+      for( uint64_t block_num = _chain.size(), step = 1; block_num >= 1; block_num -= std::min( step, block_num ),
+                                                                           step *= 2 )
+         synopsis.push_back( _chain[block_num - 1] );
+      std::reverse( synopsis.begin(), synopsis.end() );
+      return synopsis;
+   }
+
+   void sync_status( uint32_t item_type, uint32_t item_count ) override {}
+   void connection_count_changed( uint32_t c ) override {}
+
+   uint32_t get_block_number( const item_hash_t& block_id ) override
+   {
+      return block_header::num_from_id( block_id );
+   }
+
+   fc::time_point_sec get_block_time( const item_hash_t& block_id ) override
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      if( block_id == item_hash_t() )
+         return _genesis_time;
+      auto block_time = _block_times.find( block_id );
+      return block_time == _block_times.end() ? fc::time_point_sec::min() : block_time->second;
+   }
+
+   item_hash_t get_head_block_id()const override
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      return head_block_id_locked();
+   }
+
+   uint32_t estimate_last_known_fork_from_git_revision_timestamp( uint32_t unix_timestamp )const override
+   {
+      return 0;
+   }
+
+   void error_encountered( const std::string& message, const fc::oexception& error ) override
+   {
+      elog( "p2p error: ${message}", ("message", message) );
+   }
+
+   uint8_t get_current_block_interval_in_seconds()const override { return _block_interval; }
+
+private:
+   item_hash_t head_block_id_locked()const
+   {
+      return _chain.empty() ? item_hash_t() : _chain.back();
+   }
+
+   void store_block( const block_message& blk_msg )
+   {
+      _chain.push_back( blk_msg.block_id );
+      _block_times[blk_msg.block_id] = blk_msg.block.timestamp;
+      // the block is known both by its id (sync) and by the hash of its message (normal operation)
+      const message msg( blk_msg );
+      _items.emplace( blk_msg.block_id, msg );
+      _items.emplace( msg.id(), msg );
+   }
+
+   const chain_id_type                          _chain_id;
+   const uint8_t                                _block_interval;
+   const fc::time_point_sec                     _genesis_time = fc::time_point::now();
+   propagation_recorder&                        _recorder;
+
+   mutable std::mutex                           _mutex;
+   std::vector<item_hash_t>                     _chain; ///< block ids, by block number - 1
+   std::map<item_hash_t, fc::time_point_sec>    _block_times;
+   std::map<item_hash_t, message>               _items;
+};
+
+/**
+ * Forwards the connections made to a local port to the listening port of a node, delaying the bytes in both
+ * directions by a fixed latency and limiting the bandwidth of each direction.  All the forwarding runs on the
+ * thread given to the constructor.
+ */
+class link_shaper
+{
+public:
+   link_shaper( fc::thread& thread, const fc::ip::endpoint& target, const fc::microseconds& latency,
+                uint64_t bytes_per_second )
+      : _thread( thread ), _target( target ), _latency( latency ), _bytes_per_second( bytes_per_second ) {}
+
+   /// Starts listening, returns the endpoint the connecting node should use instead of the target
+   fc::ip::endpoint start()
+   {
+      return _thread.async( [this]() {
+         _server.listen( fc::ip::endpoint( loopback, 0 ) );
+         _accept_loop_done = fc::async( [this]() { accept_loop(); }, "link_shaper accept_loop" );
+         return fc::ip::endpoint( loopback, _server.get_local_endpoint().port() );
+      }, "link_shaper start" ).wait();
+   }
+
+   /// Stops accepting new connections, the current ones end when the nodes close them
+   void close()
+   {
+      _thread.async( [this]() {
+         _server.close();
+         try
+         {
+            _accept_loop_done.wait();
+         }
+         catch( const fc::exception& )
+         {
+         }
+      }, "link_shaper close" ).wait();
+   }
+
+private:
+   static constexpr size_t max_queued_bytes = 4 * 1024 * 1024;
+
+   struct direction
+   {
+      std::shared_ptr<fc::tcp_socket>                               from;
+      std::shared_ptr<fc::tcp_socket>                               to;
+      std::deque<std::pair<fc::time_point, std::vector<char>>>     chunks; ///< with the time they were read
+      size_t                                                        queued_bytes = 0;
+      bool                                                          closed = false;
+      fc::promise<void>::ptr                                        chunks_available;
+
+      void notify()
+      {
+         if( chunks_available && !chunks_available->ready() )
+            chunks_available->set_value();
+      }
+   };
+
+   void accept_loop()
+   {
+      try
+      {
+         for( ;; )
+         {
+            auto inbound = std::make_shared<fc::tcp_socket>();
+            _server.accept( *inbound );
+            auto outbound = std::make_shared<fc::tcp_socket>();
+            outbound->connect_to( _target );
+            forward( inbound, outbound );
+            forward( outbound, inbound );
+         }
+      }
+      catch( const fc::exception& )
+      {
+         // the server was closed
+      }
+   }
+
+   void forward( const std::shared_ptr<fc::tcp_socket>& from, const std::shared_ptr<fc::tcp_socket>& to )
+   {
+      auto d = std::make_shared<direction>();
+      d->from = from;
+      d->to = to;
+      // the loops only hold the direction, so they can outlive the shaper
+      fc::async( [d]() { read_loop( d ); }, "link_shaper read_loop" );
+      fc::async( [d, latency = _latency, bytes_per_second = _bytes_per_second]() {
+         write_loop( d, latency, bytes_per_second );
+      }, "link_shaper write_loop" );
+   }
+
+   static void read_loop( const std::shared_ptr<direction>& d )
+   {
+      try
+      {
+         std::vector<char> buffer( 64 * 1024 );
+         for( ;; )
+         {
+            // stop reading while the link is backed up, so that the sender sees the usual TCP back pressure
+            while( d->queued_bytes > max_queued_bytes && !d->closed )
+               fc::usleep( fc::milliseconds( 1 ) );
+            const size_t bytes_read = d->from->readsome( buffer.data(), buffer.size() );
+            d->chunks.emplace_back( fc::time_point::now(),
+                                    std::vector<char>( buffer.begin(), buffer.begin() + bytes_read ) );
+            d->queued_bytes += bytes_read;
+            d->notify();
+         }
+      }
+      catch( const fc::exception& )
+      {
+      }
+      d->closed = true;
+      d->notify();
+   }
+
+   static void write_loop( const std::shared_ptr<direction>& d, const fc::microseconds& latency,
+                           uint64_t bytes_per_second )
+   {
+      fc::time_point link_free_time;
+      try
+      {
+         for( ;; )
+         {
+            if( d->chunks.empty() )
+            {
+               if( d->closed )
+                  break;
+               d->chunks_available = fc::promise<void>::create( "link_shaper::chunks_available" );
+               d->chunks_available->wait();
+               d->chunks_available.reset();
+               continue;
+            }
+            std::pair<fc::time_point, std::vector<char>> chunk = std::move( d->chunks.front() );
+            d->chunks.pop_front();
+
+            fc::time_point send_time = chunk.first + latency;
+            if( bytes_per_second > 0 )
+            {
+               // the chunk leaves when the link is done with the previous ones and has transmitted this one
+               send_time = std::max( send_time, link_free_time )
+                           + fc::microseconds( int64_t( chunk.second.size() * 1000000 / bytes_per_second ) );
+               link_free_time = send_time;
+            }
+            const fc::time_point now = fc::time_point::now();
+            if( send_time > now )
+               fc::usleep( send_time - now );
+            d->to->write( chunk.second.data(), chunk.second.size() );
+            d->queued_bytes -= chunk.second.size();
+         }
+      }
+      catch( const fc::exception& )
+      {
+      }
+      d->closed = true;
+      try
+      {
+         d->to->close();
+         d->from->close();
+      }
+      catch( const fc::exception& )
+      {
+      }
+   }
+
+   fc::thread&            _thread;
+   const fc::ip::endpoint _target;
+   const fc::microseconds _latency;
+   const uint64_t         _bytes_per_second;
+   fc::tcp_server         _server;
+   fc::future<void>       _accept_loop_done;
+};
+
+/// Returns the edges (lower index first) of a topology of @p node_count nodes
+std::set<std::pair<uint32_t, uint32_t>> make_topology( const std::string& topology, uint32_t node_count,
+                                                       uint32_t degree, std::mt19937& rng )
+{
+   std::set<std::pair<uint32_t, uint32_t>> edges;
+   const auto add_edge = [&edges]( uint32_t a, uint32_t b ) {
+      if( a != b )
+         edges.insert( std::make_pair( std::min( a, b ), std::max( a, b ) ) );
+   };
+
+   if( topology == "full" )
+   {
+      for( uint32_t a = 0; a < node_count; ++a )
+         for( uint32_t b = a + 1; b < node_count; ++b )
+            add_edge( a, b );
+   }
+   else if( topology == "star" )
+   {
+      for( uint32_t b = 1; b < node_count; ++b )
+         add_edge( 0, b );
+   }
+   else if( topology == "ring" || topology == "random" )
+   {
+      for( uint32_t a = 0; a < node_count; ++a )
+         add_edge( a, ( a + 1 ) % node_count );
+      if( topology == "random" && node_count > 2 )
+      {
+         // a ring keeps the network connected, random edges are added until every node has about `degree` peers
+         std::vector<uint32_t> degrees( node_count, 0 );
+         for( const auto& edge : edges )
+         {
+            ++degrees[edge.first];
+            ++degrees[edge.second];
+         }
+         std::uniform_int_distribution<uint32_t> pick( 0, node_count - 1 );
+         for( uint32_t a = 0; a < node_count; ++a )
+            for( uint32_t attempt = 0; degrees[a] < degree && attempt < 10 * degree; ++attempt )
+            {
+               const uint32_t b = pick( rng );
+               const auto edge = std::make_pair( std::min( a, b ), std::max( a, b ) );
+               if( a == b || edges.count( edge ) || degrees[b] >= degree + 1 )
+                  continue;
+               edges.insert( edge );
+               ++degrees[a];
+               ++degrees[b];
+            }
+      }
+   }
+   else
+      FC_THROW( "Unknown topology ${t}, expected full, ring, star or random", ("t", topology) );
+   return edges;
+}
+
+/// Total CPU time used by this process so far
+uint64_t process_cpu_time_us()
+{
+#ifndef WIN32
+   rusage usage;
+   if( getrusage( RUSAGE_SELF, &usage ) == 0 )
+      return uint64_t( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1000000
+             + uint64_t( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec );
+#endif
+   return 0;
+}
+
+struct traffic_counters
+{
+   uint64_t sent = 0;
+   uint64_t received = 0;
+};
+
+/// Bytes sent and received by a node over its current connections
+traffic_counters get_traffic( const node& n )
+{
+   traffic_counters result;
+   for( const peer_status& peer : n.get_connected_peers() )
+   {
+      if( peer.info.contains( "bytessent" ) )
+         result.sent += peer.info["bytessent"].as_uint64();
+      if( peer.info.contains( "bytesrecv" ) )
+         result.received += peer.info["bytesrecv"].as_uint64();
+   }
+   return result;
+}
+
+struct handling_counters
+{
+   uint64_t messages = 0;
+   uint64_t bytes = 0;
+   uint64_t handler_us = 0;
+};
+
+/// The message handling statistics of all nodes, added up by message type
+std::map<std::string, handling_counters> get_message_handling( const std::vector<node_ptr>& nodes )
+{
+   std::map<std::string, handling_counters> result;
+   for( const node_ptr& n : nodes )
+   {
+      const fc::variant_object info = n->network_get_info();
+      if( !info.contains( "message_handling" ) )
+         continue;
+      for( const auto& entry : info["message_handling"].get_object() )
+      {
+         const fc::variant_object& stats = entry.value().get_object();
+         handling_counters& counters = result[entry.key()];
+         counters.messages += stats["messages"].as_uint64();
+         counters.bytes += stats["bytes"].as_uint64();
+         counters.handler_us += stats["handler_us"].as_uint64();
+      }
+   }
+   return result;
+}
+
+fc::variant_object min_avg_max( const std::vector<double>& values )
+{
+   fc::mutable_variant_object result;
+   if( values.empty() )
+      return result;
+   double sum = 0;
+   for( double value : values )
+      sum += value;
+   result["min"] = *std::min_element( values.begin(), values.end() );
+   result["avg"] = sum / values.size();
+   result["max"] = *std::max_element( values.begin(), values.end() );
+   return result;
+}
+
+} // anonymous namespace
+
+int main( int argc, char** argv )
+{
+   try
+   {
+      bpo::options_description cli_options( "Measures the propagation of transactions and blocks between p2p nodes" );
+      cli_options.add_options()
+            ("help,h", "Print this help message and exit.")
+            ("nodes", bpo::value<uint32_t>()->default_value( 10 ), "Number of nodes")
+            ("topology", bpo::value<std::string>()->default_value( "random" ),
+             "How the nodes are connected: full, ring, star or random (a ring plus random links)")
+            ("degree", bpo::value<uint32_t>()->default_value( 4 ), "Peers per node in the random topology")
+            ("seed", bpo::value<uint32_t>()->default_value( 1 ), "Seed of the random topology and payloads")
+            ("latency-ms", bpo::value<uint32_t>()->default_value( 0 ), "One way latency of each link")
+            ("bandwidth-kbps", bpo::value<uint64_t>()->default_value( 0 ),
+             "Bandwidth of each direction of each link in kilobits per second, 0 for unlimited")
+            ("io-threads", bpo::value<uint16_t>()->default_value( 0 ), "Message I/O threads per node")
+            ("tps", bpo::value<uint32_t>()->default_value( 100 ), "Transactions injected per second")
+            ("trx-size", bpo::value<uint32_t>()->default_value( 200 ), "Payload bytes per transaction")
+            ("block-interval", bpo::value<uint32_t>()->default_value( 3 ),
+             "Seconds between blocks, which include the transactions injected since the previous block")
+            ("warmup", bpo::value<uint32_t>()->default_value( 10 ), "Maximum seconds to wait for the connections")
+            ("duration", bpo::value<uint32_t>()->default_value( 30 ), "Seconds to inject transactions and blocks")
+            ("drain", bpo::value<uint32_t>()->default_value( 5 ), "Seconds to wait for the propagation to finish")
+            ("data-dir", bpo::value<boost::filesystem::path>(),
+             "Directory for the node configurations, a temporary directory if not given")
+            ("output", bpo::value<boost::filesystem::path>(), "Also write the JSON report to this file")
+            ;
+
+      bpo::variables_map options;
+      try
+      {
+         bpo::store( bpo::parse_command_line( argc, argv, cli_options ), options );
+      }
+      catch( const bpo::error& e )
+      {
+         std::cerr << "network_benchmark: error parsing command line: " << e.what() << "\n";
+         return 1;
+      }
+      if( options.count( "help" ) > 0 )
+      {
+         std::cout << cli_options << "\n";
+         return 0;
+      }
+
+      const uint32_t node_count = options["nodes"].as<uint32_t>();
+      const uint32_t tps = options["tps"].as<uint32_t>();
+      const uint32_t trx_size = options["trx-size"].as<uint32_t>();
+      const uint32_t block_interval = std::max<uint32_t>( options["block-interval"].as<uint32_t>(), 1 );
+      const fc::microseconds latency = fc::milliseconds( options["latency-ms"].as<uint32_t>() );
+      const uint64_t link_bytes_per_second = options["bandwidth-kbps"].as<uint64_t>() * 1000 / 8;
+      const fc::microseconds duration = fc::seconds( options["duration"].as<uint32_t>() );
+      FC_ASSERT( node_count >= 2, "At least 2 nodes are needed" );
+
+      std::unique_ptr<fc::temp_directory> temp_dir;
+      fc::path data_dir;
+      if( options.count( "data-dir" ) )
+         data_dir = options["data-dir"].as<boost::filesystem::path>();
+      else
+      {
+         temp_dir.reset( new fc::temp_directory( graphene::utilities::temp_directory_path() ) );
+         data_dir = temp_dir->path();
+      }
+
+      std::mt19937 rng( options["seed"].as<uint32_t>() );
+      const chain_id_type chain_id = fc::sha256::hash( std::string( "network_benchmark" ) );
+      propagation_recorder recorder;
+
+      // start the nodes, they only connect where the topology tells them to
+      std::vector<std::shared_ptr<benchmark_node_delegate>> delegates;
+      std::vector<node_ptr> nodes;
+      std::vector<fc::ip::endpoint> endpoints;
+      for( uint32_t i = 0; i < node_count; ++i )
+      {
+         delegates.push_back( std::make_shared<benchmark_node_delegate>( chain_id, uint8_t( block_interval ),
+                                                                         recorder ) );
+         node_ptr n = std::make_shared<node>( "network_benchmark" );
+         n->load_configuration( data_dir / ( "node-" + std::to_string( i ) ) );
+         n->set_node_delegate( delegates.back() );
+         n->set_io_thread_count( options["io-threads"].as<uint16_t>() );
+         n->listen_on_endpoint( fc::ip::endpoint( loopback, 0 ), false );
+         n->listen_to_p2p_network();
+         n->disable_peer_advertising();
+         fc::mutable_variant_object params;
+         params["desired_number_of_connections"] = 0;
+         params["maximum_number_of_connections"] = node_count;
+         n->set_advanced_node_parameters( params );
+         n->connect_to_p2p_network();
+         n->sync_from( item_id( block_message_type, item_hash_t() ), std::vector<uint32_t>() );
+         endpoints.push_back( fc::ip::endpoint( loopback, n->get_actual_listening_endpoint().port() ) );
+         nodes.push_back( n );
+      }
+
+      const auto edges = make_topology( options["topology"].as<std::string>(), node_count,
+                                        options["degree"].as<uint32_t>(), rng );
+      std::vector<uint32_t> degrees( node_count, 0 );
+      fc::thread shaper_thread( "link_shaper" );
+      std::vector<std::unique_ptr<link_shaper>> shapers;
+      for( const auto& edge : edges )
+      {
+         ++degrees[edge.first];
+         ++degrees[edge.second];
+         fc::ip::endpoint target = endpoints[edge.second];
+         if( latency > fc::microseconds() || link_bytes_per_second > 0 )
+         {
+            shapers.emplace_back( new link_shaper( shaper_thread, target, latency, link_bytes_per_second ) );
+            target = shapers.back()->start();
+         }
+         nodes[edge.first]->connect_to_endpoint( target );
+      }
+
+      const fc::time_point warmup_end = fc::time_point::now() + fc::seconds( options["warmup"].as<uint32_t>() );
+      const auto all_connected = [&nodes, &degrees]() {
+         for( size_t i = 0; i < nodes.size(); ++i )
+            if( nodes[i]->get_connection_count() < degrees[i] )
+               return false;
+         return true;
+      };
+      while( !all_connected() && fc::time_point::now() < warmup_end )
+         fc::usleep( fc::milliseconds( 100 ) );
+      uint32_t connections = 0;
+      for( const node_ptr& n : nodes )
+         connections += n->get_connection_count();
+      std::cerr << "network_benchmark: " << node_count << " nodes, " << edges.size() << " links, "
+                << connections / 2 << " connected\n";
+
+      std::vector<traffic_counters> traffic_before;
+      for( const node_ptr& n : nodes )
+         traffic_before.push_back( get_traffic( *n ) );
+      const std::map<std::string, handling_counters> handling_before = get_message_handling( nodes );
+      const uint64_t cpu_before = process_cpu_time_us();
+
+      // inject the transactions in batches every few milliseconds, through random nodes, and the blocks
+      // through node 0
+      const fc::time_point start = fc::time_point::now();
+      const fc::time_point end = start + duration;
+      fc::time_point next_block_time = start + fc::seconds( block_interval );
+      std::uniform_int_distribution<uint32_t> pick_node( 0, node_count - 1 );
+      std::uniform_int_distribution<uint32_t> pick_byte( 0, 255 );
+      std::vector<signed_transaction> pending_transactions;
+      uint64_t transactions_injected = 0;
+      uint64_t blocks_injected = 0;
+      while( fc::time_point::now() < end )
+      {
+         const fc::time_point now = fc::time_point::now();
+         const uint64_t transactions_due = uint64_t( ( now - start ).count() ) * tps / 1000000;
+         std::map<uint32_t, std::vector<signed_transaction>> batches;
+         for( ; transactions_injected < transactions_due; ++transactions_injected )
+         {
+            custom_operation op;
+            op.data.resize( std::max<uint32_t>( trx_size, sizeof(transactions_injected) ) );
+            for( char& c : op.data )
+               c = char( pick_byte( rng ) );
+            memcpy( op.data.data(), &transactions_injected, sizeof(transactions_injected) );
+            signed_transaction trx;
+            trx.set_expiration( now + fc::minutes( 1 ) );
+            trx.operations.push_back( op );
+
+            const uint32_t origin = pick_node( rng );
+            delegates[origin]->add_local_transaction( trx );
+            recorder.injected( trx_message_type, trx.id(), now );
+            batches[origin].push_back( trx );
+            pending_transactions.push_back( trx );
+         }
+         for( const auto& batch : batches )
+            nodes[batch.first]->broadcast_transactions( batch.second );
+
+         if( now >= next_block_time )
+         {
+            signed_block block;
+            block.previous = delegates[0]->get_head_block_id();
+            block.timestamp = now;
+            for( const signed_transaction& trx : pending_transactions )
+               block.transactions.push_back( processed_transaction( trx ) );
+            block.transaction_merkle_root = block.calculate_merkle_root();
+            pending_transactions.clear();
+
+            delegates[0]->add_local_block( block );
+            const block_message blk_msg( block );
+            recorder.injected( block_message_type, blk_msg.block_id, now );
+            nodes[0]->broadcast( blk_msg );
+            ++blocks_injected;
+            next_block_time += fc::seconds( block_interval );
+         }
+         fc::usleep( fc::milliseconds( 5 ) );
+      }
+      fc::usleep( fc::seconds( options["drain"].as<uint32_t>() ) );
+      const double elapsed_seconds = ( fc::time_point::now() - start ).count() / 1000000.0;
+      const uint64_t cpu_used = process_cpu_time_us() - cpu_before;
+
+      // the report
+      std::vector<double> upload;
+      std::vector<double> download;
+      for( size_t i = 0; i < nodes.size(); ++i )
+      {
+         const traffic_counters traffic = get_traffic( *nodes[i] );
+         upload.push_back( ( traffic.sent - std::min( traffic.sent, traffic_before[i].sent ) ) / elapsed_seconds );
+         download.push_back( ( traffic.received - std::min( traffic.received, traffic_before[i].received ) )
+                             / elapsed_seconds );
+      }
+
+      fc::mutable_variant_object by_message_type;
+      for( const auto& entry : get_message_handling( nodes ) )
+      {
+         handling_counters counters = entry.second;
+         const auto before = handling_before.find( entry.first );
+         if( before != handling_before.end() )
+         {
+            counters.messages -= before->second.messages;
+            counters.bytes -= before->second.bytes;
+            counters.handler_us -= before->second.handler_us;
+         }
+         if( counters.messages == 0 )
+            continue;
+         fc::mutable_variant_object stats;
+         stats["messages"] = counters.messages;
+         stats["bytes"] = counters.bytes;
+         // wall clock time, including waits and the other tasks of the p2p thread meanwhile
+         stats["handler_us"] = counters.handler_us;
+         stats["handler_us_per_message"] = double( counters.handler_us ) / counters.messages;
+         by_message_type[entry.first] = stats;
+      }
+
+      fc::mutable_variant_object configuration;
+      configuration["nodes"] = node_count;
+      configuration["topology"] = options["topology"].as<std::string>();
+      configuration["links"] = uint64_t( edges.size() );
+      configuration["latency_ms"] = options["latency-ms"].as<uint32_t>();
+      configuration["bandwidth_kbps"] = options["bandwidth-kbps"].as<uint64_t>();
+      configuration["io_threads"] = options["io-threads"].as<uint16_t>();
+      configuration["tps"] = tps;
+      configuration["trx_size"] = trx_size;
+      configuration["block_interval"] = block_interval;
+      configuration["duration"] = options["duration"].as<uint32_t>();
+
+      fc::mutable_variant_object bandwidth;
+      bandwidth["upload_bytes_per_second"] = min_avg_max( upload );
+      bandwidth["download_bytes_per_second"] = min_avg_max( download );
+
+      fc::mutable_variant_object cpu;
+      cpu["process_us"] = cpu_used;
+      cpu["process_cores"] = cpu_used / 1000000.0 / elapsed_seconds;
+
+      fc::mutable_variant_object report;
+      report["configuration"] = configuration;
+      report["connections"] = connections / 2;
+      report["transactions"] = recorder.report( trx_message_type, node_count - 1 );
+      report["blocks"] = recorder.report( block_message_type, node_count - 1 );
+      report["bandwidth_per_node"] = bandwidth;
+      report["cpu"] = cpu;
+      report["message_handling"] = by_message_type;
+
+      const std::string report_json = fc::json::to_pretty_string( fc::variant( report ) );
+      std::cout << report_json << "\n";
+      if( options.count( "output" ) )
+         fc::json::save_to_file( fc::variant( report ), options["output"].as<boost::filesystem::path>() );
+
+      std::cerr << "network_benchmark: injected " << transactions_injected << " transactions and "
+                << blocks_injected << " blocks, shutting down\n";
+      for( const node_ptr& n : nodes )
+         n->close();
+      for( const auto& shaper : shapers )
+         shaper->close();
+      return 0;
+   }
+   catch( const fc::exception& e )
+   {
+      std::cerr << "network_benchmark: " << e.to_detail_string() << "\n";
+      return 1;
+   }
+}
@@ -26,6 +26,7 @@
 #include <graphene/app/config_util.hpp>
 
 #include <graphene/chain/balance_object.hpp>
+#include <graphene/chain/genesis_loader.hpp>
 
 #include <graphene/utilities/tempdir.hpp>
 
@@ -42,6 +43,8 @@
 
 #include <boost/filesystem/path.hpp>
 
+#include <fstream>
+
 #include "../../libraries/app/application_impl.hxx"
 
 #include "../common/init_unit_test_suite.hpp"
@@ -391,6 +394,63 @@ BOOST_AUTO_TEST_CASE( two_node_network )
    }
 }
 
+BOOST_AUTO_TEST_CASE( genesis_loader_test )
+{
+   using namespace graphene::chain;
+   try {
+      fc::temp_directory app_dir( graphene::utilities::temp_directory_path() );
+      auto genesis_file = create_genesis_file(app_dir);
+      std::string genesis_json;
+      fc::read_file_contents( genesis_file, genesis_json );
+      const chain_id_type json_chain_id = fc::sha256::hash( genesis_json );
+
+      BOOST_TEST_MESSAGE( "Streaming genesis parser matches the full parser" );
+      genesis_state_type streamed = parse_genesis_json( genesis_json );
+      const auto full = fc::json::from_string( genesis_json ).as<genesis_state_type>( 20 );
+      BOOST_CHECK( fc::raw::pack( streamed ) == fc::raw::pack( full ) );
+      BOOST_CHECK_EQUAL( streamed.initial_accounts.size(), full.initial_accounts.size() );
+      BOOST_CHECK_EQUAL( streamed.initial_witness_candidates.size(), full.initial_witness_candidates.size() );
+      BOOST_CHECK( parse_genesis_json( "{ }" ).initial_accounts.empty() );
+      BOOST_CHECK_THROW( parse_genesis_json( "{\"initial_accounts\":[" ), fc::exception );
+      BOOST_CHECK_THROW( parse_genesis_json( "{} {}" ), fc::exception );
+
+      BOOST_TEST_MESSAGE( "Binary genesis round trip keeps the chain ID" );
+      streamed.initial_chain_id = json_chain_id;
+      const fc::path binary_file = app_dir.path() / "genesis.bin";
+      write_binary_genesis( binary_file, streamed );
+      const genesis_state_type loaded = read_binary_genesis( binary_file );
+      BOOST_CHECK( loaded.initial_chain_id == json_chain_id );
+      BOOST_CHECK( fc::raw::pack( loaded ) == fc::raw::pack( streamed ) );
+
+      BOOST_TEST_MESSAGE( "Corrupted binary genesis is rejected" );
+      std::string contents;
+      fc::read_file_contents( binary_file, contents );
+      contents.back() ^= 1;
+      const fc::path corrupted_file = app_dir.path() / "corrupted.bin";
+      {
+         std::ofstream out( corrupted_file.generic_string(), std::ios::binary );
+         out.write( contents.data(), contents.size() );
+      }
+      BOOST_CHECK_THROW( read_binary_genesis( corrupted_file ), fc::exception );
+      BOOST_CHECK_THROW( read_binary_genesis( genesis_file ), fc::exception );
+
+      BOOST_TEST_MESSAGE( "A node started from the binary genesis has the chain ID of the JSON genesis" );
+      graphene::app::application app;
+      auto sharable_cfg = std::make_shared<boost::program_options::variables_map>();
+      auto& cfg = *sharable_cfg;
+      fc::set_option( cfg, "p2p-endpoint",
+                      string("127.0.0.1:") + std::to_string( fc::network::get_available_port() ) );
+      fc::set_option( cfg, "genesis-binary", boost::filesystem::path( binary_file.generic_string() ) );
+      fc::set_option( cfg, "seed-nodes", string("[]") );
+      app.initialize( app_dir.path(), sharable_cfg );
+      app.startup();
+      BOOST_CHECK( app.chain_database()->get_chain_id() == json_chain_id );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 /// a contrived example to test the breaking out of application_impl to a header file
 BOOST_AUTO_TEST_CASE(application_impl_breakout) {
 
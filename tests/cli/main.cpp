@@ -434,6 +434,51 @@ BOOST_FIXTURE_TEST_CASE( create_new_account, cli_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( cli_transfer_batch, cli_fixture )
+{
+   try
+   {
+      INVOKE(create_new_account);
+
+      BOOST_TEST_MESSAGE("Transferring in a batch from Nathan to jmjatlanta and init0");
+      vector<graphene::wallet::transfer_batch_entry> entries;
+      entries.push_back( { "nathan", "jmjatlanta", "100", "1.3.0", "" } );
+      entries.push_back( { "nathan", "init0", "200", "1.3.0", "" } );
+      entries.push_back( { "nathan", "nobody-by-that-name", "300", "1.3.0", "" } );
+      entries.push_back( { "nathan", "jmjatlanta", "100", "1.3.0", "" } ); // same as the first one
+      const fc::path filename = app_dir.path() / "transfers.json";
+      fc::json::save_to_file( entries, filename );
+
+      auto results = con.wallet_api_ptr->transfer_batch( filename.generic_string(), true );
+      BOOST_REQUIRE_EQUAL( results.size(), 4u );
+      BOOST_CHECK( results[0].accepted );
+      BOOST_CHECK( results[1].accepted );
+      BOOST_CHECK( !results[2].accepted );
+      BOOST_CHECK( results[2].error.valid() );
+      // identical transfers must still result in distinct transactions
+      BOOST_CHECK( results[3].accepted );
+      BOOST_CHECK( results[0].trx.id() != results[3].trx.id() );
+
+      BOOST_CHECK(generate_block(app1));
+      auto balances = con.wallet_api_ptr->list_account_balances( "jmjatlanta" );
+      BOOST_REQUIRE_EQUAL( balances.size(), 1u );
+      BOOST_CHECK_EQUAL( balances[0].amount.value, 10200 * GRAPHENE_BLOCKCHAIN_PRECISION );
+
+      BOOST_TEST_MESSAGE("Transfers larger than the maximum transaction size are not broadcast");
+      entries.clear();
+      entries.push_back( { "nathan", "jmjatlanta", "100", "1.3.0", std::string( 4096, 'x' ) } );
+      fc::json::save_to_file( entries, filename );
+      results = con.wallet_api_ptr->transfer_batch( filename.generic_string(), true );
+      BOOST_REQUIRE_EQUAL( results.size(), 1u );
+      BOOST_CHECK( !results[0].accepted );
+      BOOST_REQUIRE( results[0].error.valid() );
+      BOOST_CHECK( results[0].error->find( "maximum transaction size" ) != std::string::npos );
+   } catch( fc::exception& e ) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_FIXTURE_TEST_CASE( uia_tests, cli_fixture )
 {
    try
@@ -187,7 +187,9 @@ std::shared_ptr<boost::program_options::variables_map> database_fixture_base::in
    /**
     * Test specific settings
     */
-   if (fixture.current_test_name == "broadcast_transaction_with_callback_test")
+   if (fixture.current_test_name == "broadcast_transaction_with_callback_test"
+         || fixture.current_test_name == "broadcast_transaction_batch_test"
+         || fixture.current_test_name == "broadcast_transaction_batch_benchmark")
       fc::set_option( options, "enable-p2p-network", true );
    else if (fixture.current_test_name == "broadcast_transaction_disabled_p2p_test")
       fc::set_option( options, "enable-p2p-network", false );
@@ -543,6 +545,9 @@ void database_fixture_base::verify_asset_supplies( const database& db )
       }
       total_balances[ to.amount.asset_id ] += to.amount.amount;
    }
+   // removed lock_forever tickets without value are still counted as inactive and in the supply
+   core_inactive += db.get_dynamic_global_properties().total_pruned_inactive;
+   total_balances[asset_id_type()] += db.get_dynamic_global_properties().total_pruned_inactive;
    for( const liquidity_pool_object& o : db.get_index_type<liquidity_pool_index>().indices() )
    {
       total_balances[o.asset_a] += o.balance_a;
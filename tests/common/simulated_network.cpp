@@ -85,6 +85,12 @@ namespace graphene { namespace net {
     }
   }
 
+  void simulated_network::broadcast_transactions( const std::vector<signed_transaction>& trxs )
+  {
+    for( const signed_transaction& trx : trxs )
+      broadcast( trx_message( trx ) );
+  }
+
   void simulated_network::add_node_delegate( std::shared_ptr<node_delegate> node_delegate_to_add )
   {
     network_nodes.push_back(std::make_shared<node_info>(node_delegate_to_add));
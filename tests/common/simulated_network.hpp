@@ -42,6 +42,7 @@ public:
 
    void      sync_from(const item_id& current_head_block, const std::vector<uint32_t>& hard_fork_block_numbers) override {}
    void      broadcast(const message& item_to_broadcast) override;
+   void      broadcast_transactions(const std::vector<signed_transaction>& trxs) override;
    void      add_node_delegate(std::shared_ptr<node_delegate> node_delegate_to_add);
 
    uint32_t get_connection_count() const override { return 8; }
@@ -24,22 +24,58 @@
 
 #include "../common/init_unit_test_suite.hpp"
 
+#include <graphene/app/api.hpp>
+
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/asset_object.hpp>
+#include <graphene/chain/hardfork.hpp>
+#include <graphene/chain/market_object.hpp>
 #include <graphene/chain/proposal_object.hpp>
+#include <graphene/chain/ticket_object.hpp>
+#include <graphene/chain/witness_object.hpp>
+#include <graphene/chain/witness_schedule_object.hpp>
 
 #include <graphene/db/simple_index.hpp>
 
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/message_io_pool.hpp>
+
 #include <fc/crypto/digest.hpp>
 
 #include "../common/database_fixture.hpp"
+#include <atomic>
 #include <cstdlib>
 #include <iostream>
+#include <new>
+#include <thread>
 
 using namespace graphene::chain;
 
+namespace {
+   /// Number of heap allocations made by this program, see the replaced operator new below
+   std::atomic<uint64_t> allocation_count { 0 };
+}
+
+void* operator new( std::size_t size )
+{
+   ++allocation_count;
+   if( void* p = std::malloc( size == 0 ? 1 : size ) )
+      return p;
+   throw std::bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
+
+void operator delete( void* p, std::size_t ) noexcept
+{
+   std::free( p );
+}
+
 BOOST_FIXTURE_TEST_SUITE( performance_tests, database_fixture )
 
 BOOST_AUTO_TEST_CASE( sigcheck_benchmark )
@@ -208,4 +244,388 @@ BOOST_AUTO_TEST_CASE( one_hundred_k_benchmark )
    db._undo_db.enable();
 } FC_LOG_AND_RETHROW() }
 
+// Compares pushing transactions one RPC call at a time with pushing them in batches
+BOOST_AUTO_TEST_CASE( broadcast_transaction_batch_benchmark )
+{ try {
+   ACTORS( (alice) );
+   fund( alice, asset(100000000) );
+   generate_block();
+
+   auto nb_api = std::make_shared< graphene::app::network_broadcast_api >( app );
+   const uint64_t batch_size = app.get_options().api_limit_broadcast_transaction_batch;
+   const uint64_t cycles = 4;
+
+   // distinct amounts keep the transactions distinct
+   int64_t amount = 0;
+   auto make_transfers = [&]() {
+      std::vector<precomputable_transaction> result;
+      result.reserve( batch_size );
+      for( uint64_t i = 0; i < batch_size; ++i )
+      {
+         signed_transaction tx;
+         test::set_expiration( db, tx );
+         transfer_operation op;
+         op.from = alice_id;
+         op.to = account_id_type();
+         op.amount = asset( ++amount );
+         tx.operations.push_back( op );
+         tx.sign( alice_private_key, db.get_chain_id() );
+         result.emplace_back( tx );
+      }
+      return result;
+   };
+
+   uint64_t single_us = 0;
+   uint64_t batch_us = 0;
+   for( uint64_t c = 0; c < cycles; ++c )
+   {
+      auto trxs = make_transfers();
+      auto start = fc::time_point::now();
+      for( const auto& tx : trxs )
+         nb_api->broadcast_transaction( tx );
+      single_us += ( fc::time_point::now() - start ).count();
+      generate_block();
+
+      trxs = make_transfers();
+      start = fc::time_point::now();
+      auto results = nb_api->broadcast_transaction_batch( trxs );
+      batch_us += ( fc::time_point::now() - start ).count();
+      for( const auto& r : results )
+         BOOST_REQUIRE( r.accepted );
+      generate_block();
+   }
+
+   const uint64_t total = cycles * batch_size;
+   wlog( "Single submission: ${tps} transactions/s over ${total}ms",
+         ("tps", total * 1000000 / std::max<uint64_t>( single_us, 1 ))("total", single_us / 1000) );
+   wlog( "Batch submission of ${n}: ${tps} transactions/s over ${total}ms",
+         ("n", batch_size)("tps", total * 1000000 / std::max<uint64_t>( batch_us, 1 ))("total", batch_us / 1000) );
+} FC_LOG_AND_RETHROW() }
+
+// Calculates the fees of all operation types, once with the prebuilt lookup table and once rebuilding it each time
+BOOST_AUTO_TEST_CASE( fee_calculation_benchmark )
+{ try {
+   const fee_schedule& fees = db.get_global_properties().parameters.get_current_fees();
+   const uint64_t cycles = 20000;
+
+   std::vector<operation> ops;
+   for( int i = 0; i < operation().count(); ++i )
+   {
+      operation op;
+      op.set_which( i );
+      try {
+         fees.calculate_fee( op );
+         ops.push_back( op );
+      } catch( const fc::exception& e ) {
+         wlog( "Skipping operation type ${i}: ${e}", ("i", i)("e", e.to_string()) );
+      }
+   }
+
+   uint64_t slowest_us = 0;
+   int slowest_op = 0;
+   auto start = fc::time_point::now();
+   for( const auto& op : ops )
+   {
+      const auto op_start = fc::time_point::now();
+      for( uint64_t i = 0; i < cycles; ++i )
+         fees.calculate_fee( op );
+      const uint64_t op_us = ( fc::time_point::now() - op_start ).count();
+      if( op_us > slowest_us )
+      {
+         slowest_us = op_us;
+         slowest_op = op.which();
+      }
+   }
+   const uint64_t cached_us = ( fc::time_point::now() - start ).count();
+
+   fee_schedule uncached = fees;
+   start = fc::time_point::now();
+   for( const auto& op : ops )
+      for( uint64_t i = 0; i < cycles / 100; ++i )
+      {
+         uncached.invalidate_fee_table();
+         uncached.calculate_fee( op );
+      }
+   const uint64_t uncached_us = ( fc::time_point::now() - start ).count();
+
+   const uint64_t total = cycles * ops.size();
+   wlog( "Fee calculation over ${n} operation types: ${cps} fees/s, slowest operation type ${op} at ${ns}ns",
+         ("n", ops.size())("cps", total * 1000000 / std::max<uint64_t>( cached_us, 1 ))
+         ("op", slowest_op)("ns", slowest_us * 1000 / cycles) );
+   wlog( "Fee calculation with a table rebuild each time: ${cps} fees/s",
+         ("cps", total / 100 * 1000000 / std::max<uint64_t>( uncached_us, 1 )) );
+} FC_LOG_AND_RETHROW() }
+
+// Follows a million tickets until they are stable, before and after the ticket compaction hard fork
+BOOST_AUTO_TEST_CASE( ticket_compaction_benchmark )
+{ try {
+   generate_blocks( HARDFORK_CORE_2262_TIME );
+   generate_block();
+   db._undo_db.disable();
+
+   const uint32_t num_accounts = 100;
+   const uint32_t tickets_per_account = 10000;
+   const uint32_t ops_per_trx = 100;
+   // lock_forever tickets lose all the value after 4 charging steps and 4 update steps
+   const uint32_t ticket_days = 4 * 15 + 4 * 180 + 1;
+
+   std::vector<account_id_type> accounts;
+   for( uint32_t i = 0; i < num_accounts; ++i )
+   {
+      const account_object& acct = create_account( "tickets" + fc::to_string(i) );
+      fund( acct, asset( 2000000 * GRAPHENE_BLOCKCHAIN_PRECISION ) ); // fees and amounts of two rounds
+      accounts.push_back( acct.id );
+   }
+
+   // Half of the tickets are lock_180_days and become stable, the others are lock_forever and lose all the value
+   const auto create_tickets = [&]() {
+      ticket_create_operation op;
+      op.amount = asset( 1000 );
+      op.fee = db.current_fee_schedule().calculate_fee( op );
+      signed_transaction tx;
+      test::set_expiration( db, tx );
+      for( const auto& account : accounts )
+         for( uint32_t i = 0; i < tickets_per_account; ++i )
+         {
+            op.account = account;
+            op.target_type = static_cast<uint8_t>( i % 2 == 0 ? lock_180_days : lock_forever );
+            tx.operations.push_back( op );
+            if( tx.operations.size() == ops_per_trx )
+            {
+               db.apply_transaction( tx, ~0 );
+               tx.operations.clear();
+            }
+         }
+   };
+   const auto num_tickets = [this]() {
+      return db.get_index_type<ticket_index>().indices().size();
+   };
+   const auto phase = [this]( const std::string& name ) {
+      const apply_profile profile = db.get_apply_profiler()->get_profile();
+      auto itr = profile.phases.find( name );
+      return itr == profile.phases.end() ? apply_profile_entry() : itr->second;
+   };
+   const auto follow_tickets = [&]( const char* label ) {
+      db.get_apply_profiler()->reset();
+      generate_blocks( db.head_block_time() + fc::days( ticket_days ) );
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      const apply_profile_entry tickets = phase( "process_tickets" );
+      db.get_apply_profiler()->reset();
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      const apply_profile_entry maintenance = phase( "maintenance" );
+      wlog( "${label}: process_tickets took ${t}ms in total and up to ${m}ms per block, "
+            "maintenance takes ${mt}ms with ${n} tickets left",
+            ("label", label)("t", tickets.total_us / 1000)("m", tickets.max_us / 1000)
+            ("mt", maintenance.max_us / 1000)("n", num_tickets()) );
+   };
+
+   db.enable_apply_profiler( true );
+
+   create_tickets();
+   follow_tickets( "Without compaction" );
+
+   const size_t tickets_before = num_tickets();
+   db.get_apply_profiler()->reset();
+   generate_blocks( HARDFORK_TICKET_COMPACTION_TIME ); // the maintenance interval which compacts the tickets
+   wlog( "Compaction at the hard fork: ${b} tickets compacted to ${a}, maintenance took ${ms}ms",
+         ("b", tickets_before)("a", num_tickets())("ms", phase( "maintenance" ).max_us / 1000) );
+
+   create_tickets();
+   follow_tickets( "With compaction" );
+
+   db.enable_apply_profiler( false );
+   db._undo_db.enable();
+} FC_LOG_AND_RETHROW() }
+
+// Produces empty blocks in a loop and looks up the scheduled witnesses of many slots
+BOOST_AUTO_TEST_CASE( block_production_benchmark )
+{ try {
+   const fc::ecc::private_key key = init_account_priv_key;
+   const uint32_t blocks = 20000;
+   const uint32_t lookups = 1000000;
+
+   auto start = fc::time_point::now();
+   for( uint32_t i = 0; i < blocks; ++i )
+      db.generate_block( db.get_slot_time( 1 ), db.get_scheduled_witness( 1 ), key, database::skip_nothing );
+   const uint64_t production_us = ( fc::time_point::now() - start ).count();
+
+   uint64_t checksum = 0;
+   start = fc::time_point::now();
+   for( uint32_t i = 0; i < lookups; ++i )
+   {
+      const scheduled_witness_slot slot = db.get_scheduled_witness_slot( i % 1000 + 1 );
+      checksum += slot.witness.instance.value + slot.signing_key.key_data.data[1];
+   }
+   const uint64_t cached_us = ( fc::time_point::now() - start ).count();
+
+   // the lookup as it is done without the cached schedule
+   start = fc::time_point::now();
+   for( uint32_t i = 0; i < lookups; ++i )
+   {
+      const auto& dpo = db.get_dynamic_global_properties();
+      const auto& shuffled = db.get_witness_schedule_object().current_shuffled_witnesses;
+      const witness_id_type witness = shuffled[ ( dpo.current_aslot + i % 1000 + 1 ) % shuffled.size() ];
+      checksum -= witness.instance.value + witness(db).signing_key.key_data.data[1];
+   }
+   const uint64_t uncached_us = ( fc::time_point::now() - start ).count();
+   BOOST_CHECK_EQUAL( checksum, 0u );
+
+   wlog( "Produced ${n} empty blocks at ${bps} blocks/s, ${us}us per block",
+         ("n", blocks)("bps", uint64_t(blocks) * 1000000 / std::max<uint64_t>( production_us, 1 ))
+         ("us", production_us / blocks) );
+   wlog( "Scheduled witness lookups: ${c} lookups/s from the cached schedule, ${u} lookups/s from the objects",
+         ("c", uint64_t(lookups) * 1000000 / std::max<uint64_t>( cached_us, 1 ))
+         ("u", uint64_t(lookups) * 1000000 / std::max<uint64_t>( uncached_us, 1 )) );
+} FC_LOG_AND_RETHROW() }
+
+// Applies a block with a single order which fills thousands of orders, and counts the heap allocations
+BOOST_AUTO_TEST_CASE( applied_operations_benchmark )
+{ try {
+   ACTORS( (seller)(buyer) );
+   const asset_id_type uia_id = create_user_issued_asset( "FILLS" ).id;
+   const uint32_t orders = 2000;
+   const uint32_t ops_per_trx = 100;
+
+   issue_uia( seller_id, asset( 10000000, uia_id ) );
+   fund( buyer, asset( 10000000 ) );
+
+   // distinct amounts, so that no two transactions are equal
+   signed_transaction tx;
+   test::set_expiration( db, tx );
+   share_type total = 0;
+   for( uint32_t i = 0; i < orders; ++i )
+   {
+      limit_order_create_operation op;
+      op.seller = seller_id;
+      op.amount_to_sell = asset( 1000 + i, uia_id );
+      op.min_to_receive = asset( 1000 + i );
+      total += 1000 + i;
+      tx.operations.push_back( op );
+      if( tx.operations.size() == ops_per_trx )
+      {
+         db.push_transaction( tx, ~0 );
+         tx.operations.clear();
+      }
+   }
+   generate_block();
+
+   limit_order_create_operation buy;
+   buy.seller = buyer_id;
+   buy.amount_to_sell = asset( total );
+   buy.min_to_receive = asset( total, uia_id );
+   tx.operations.push_back( buy );
+   db.push_transaction( tx, ~0 );
+
+   // the log is cleared after the block is applied unless an observer holds it
+   std::shared_ptr<const applied_operation_log> shared;
+   boost::signals2::scoped_connection connection = db.applied_block.connect( [&shared,this]( const signed_block& ) {
+      shared = db.share_applied_operations();
+   } );
+
+   const uint64_t allocations_before = allocation_count.load();
+   const auto start = fc::time_point::now();
+   generate_block();
+   const uint64_t block_us = ( fc::time_point::now() - start ).count();
+   const uint64_t block_allocations = allocation_count.load() - allocations_before;
+
+   connection.disconnect();
+   BOOST_REQUIRE( shared );
+   const applied_operation_log& applied = *shared;
+   const uint64_t applied_ops = std::max<uint64_t>( applied.size(), 1 );
+   BOOST_CHECK_GT( applied.size(), 2 * orders );
+   BOOST_CHECK( db.find( limit_order_id_type() ) == nullptr );
+
+   // what the previous layout of the applied operations costs on top, one reallocating vector of copies
+   uint64_t copy_allocations = allocation_count.load();
+   {
+      std::vector< optional< operation_history_object > > copies;
+      for( const auto& entry : applied )
+         copies.push_back( entry );
+   }
+   copy_allocations = allocation_count.load() - copy_allocations;
+
+   wlog( "Applied a block with ${n} operations in ${us}us with ${a} allocations, ${p} allocations per operation",
+         ("n", applied.size())("us", block_us)("a", block_allocations)("p", block_allocations / applied_ops) );
+   wlog( "Copying the operations into a vector of optional operation_history_object takes ${a} more allocations",
+         ("a", copy_allocations) );
+} FC_LOG_AND_RETHROW() }
+
+// Hashes and decodes received p2p messages on the p2p thread and on pools of I/O threads
+BOOST_AUTO_TEST_CASE( message_decode_benchmark )
+{ try {
+   ACTORS( (alice)(bob) );
+   transfer_operation op;
+   op.from = alice_id;
+   op.to = bob_id;
+   op.amount = asset( 1 );
+   signed_transaction trx;
+   trx.operations.push_back( op );
+   test::set_expiration( db, trx );
+   trx.sign( alice_private_key, db.get_chain_id() );
+
+   signed_block block;
+   block.transactions.assign( 1000, processed_transaction( trx ) );
+   const graphene::net::message block_msg{ graphene::net::block_message( block ) };
+   const graphene::net::message trx_msg{ graphene::net::trx_message( trx ) };
+
+   // what a busy node receives: one block for every 100 transactions
+   std::vector<const graphene::net::message*> received;
+   for( uint32_t i = 0; i < 20; ++i )
+   {
+      received.push_back( &block_msg );
+      for( uint32_t j = 0; j < 100; ++j )
+         received.push_back( &trx_msg );
+   }
+   const uint32_t rounds = 20;
+   const uint64_t messages = uint64_t( rounds ) * received.size();
+
+   // on the p2p thread, as the node does without I/O threads
+   uint64_t checksum = 0;
+   auto start = fc::time_point::now();
+   for( uint32_t round = 0; round < rounds; ++round )
+      for( const graphene::net::message* m : received )
+      {
+         const graphene::net::message copy( *m );
+         checksum += copy.id()._hash[0];
+         if( copy.msg_type.value() == graphene::net::block_message_type )
+            checksum += copy.as<graphene::net::block_message>().block.transactions.size();
+         else
+            checksum += copy.as<graphene::net::trx_message>().trx.operations.size();
+      }
+   const uint64_t inline_us = std::max<int64_t>( ( fc::time_point::now() - start ).count(), 1 );
+   wlog( "Decoded ${n} messages on one thread: ${mps} messages/s",
+         ("n", messages)("mps", messages * 1000000 / inline_us) );
+
+   const uint16_t max_threads = std::max<uint16_t>( std::thread::hardware_concurrency(), 1 );
+   for( uint16_t num_threads = 1; num_threads <= max_threads; num_threads *= 2 )
+   {
+      graphene::net::message_io_pool pool( num_threads, graphene::net::decode_message_payload );
+      std::atomic<uint64_t> pool_checksum { 0 };
+      start = fc::time_point::now();
+      std::vector<fc::future<void>> done;
+      for( uint16_t t = 0; t < num_threads; ++t )
+         done.push_back( pool.next_thread().async( [&,t]() {
+            uint64_t local_checksum = 0;
+            for( uint32_t round = t; round < rounds; round += num_threads )
+               for( const graphene::net::message* m : received )
+               {
+                  const graphene::net::message prepared = pool.prepare_message( *m, m->data.to_vector() );
+                  local_checksum += prepared.id()._hash[0];
+                  if( prepared.msg_type.value() == graphene::net::block_message_type )
+                     local_checksum += prepared.as_shared<graphene::net::block_message>()->block.transactions.size();
+                  else
+                     local_checksum += prepared.as_shared<graphene::net::trx_message>()->trx.operations.size();
+               }
+            pool_checksum += local_checksum;
+         } ) );
+      for( auto& f : done )
+         f.wait();
+      const uint64_t pool_us = std::max<int64_t>( ( fc::time_point::now() - start ).count(), 1 );
+      BOOST_CHECK_EQUAL( pool_checksum.load(), checksum );
+      wlog( "Decoded ${n} messages on ${t} I/O thread(s): ${mps} messages/s, ${mpc} messages/s per thread",
+            ("n", messages)("t", num_threads)("mps", messages * 1000000 / pool_us)
+            ("mpc", messages * 1000000 / pool_us / num_threads) );
+   }
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -27,8 +27,10 @@
 #include <graphene/chain/database.hpp>
 
 #include <graphene/chain/account_object.hpp>
+#include <graphene/chain/applied_operation_log.hpp>
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/exceptions.hpp>
+#include <graphene/chain/expiry_wheel.hpp>
 
 #include <graphene/db/simple_index.hpp>
 
@@ -629,4 +631,137 @@ BOOST_AUTO_TEST_CASE( bitasset_feed_expiration_test )
    BOOST_CHECK( !o.feed_is_expired( now ) );
 }
 
+
+BOOST_AUTO_TEST_CASE( expiry_wheel_test )
+{
+   expiry_wheel wheel;
+   const time_point_sec start( 1600000000 );
+   const object_id_type near_id( 1, 7, 1 );
+   const object_id_type far_id( 1, 7, 2 );
+   const object_id_type other_id( 1, 10, 1 );
+
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_limit_order, start ) );
+
+   wheel.schedule( expiry_wheel::expiring_limit_order, near_id, start + 100 );
+   wheel.schedule( expiry_wheel::expiring_limit_order, far_id, start + 3 * expiry_wheel::near_slots + 5 );
+   wheel.schedule( expiry_wheel::expiring_proposal, other_id, start + 50 );
+   wheel.schedule( expiry_wheel::expiring_htlc, object_id_type( 1, 16, 1 ), time_point_sec::maximum() );
+   BOOST_CHECK_EQUAL( wheel.size(), 3u );
+
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_limit_order, start + 49 ) );
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_proposal, start + 49 ) );
+   BOOST_CHECK( wheel.has_due( expiry_wheel::expiring_proposal, start + 50 ) );
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_limit_order, start + 99 ) );
+   BOOST_CHECK( wheel.has_due( expiry_wheel::expiring_limit_order, start + 100 ) );
+   BOOST_CHECK_EQUAL( wheel.due_count( expiry_wheel::expiring_limit_order ), 1u );
+
+   // due entries stay due until they are removed or rescheduled, also if time goes back
+   BOOST_CHECK( wheel.has_due( expiry_wheel::expiring_limit_order, start ) );
+   wheel.cancel( near_id );
+   wheel.schedule( expiry_wheel::expiring_proposal, other_id, start + 1000 );
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_limit_order, start + 100 ) );
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_proposal, start + 100 ) );
+   BOOST_CHECK( wheel.has_due( expiry_wheel::expiring_proposal, start + 1000 ) );
+   BOOST_CHECK_EQUAL( wheel.size(), 2u );
+
+   // a far deadline comes into range and expires on time, also when the wheel skips several turns
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_limit_order, start + 2 * expiry_wheel::near_slots ) );
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_limit_order, start + 3 * expiry_wheel::near_slots + 4 ) );
+   BOOST_CHECK( wheel.has_due( expiry_wheel::expiring_limit_order, start + 3 * expiry_wheel::near_slots + 5 ) );
+
+   // rescheduling moves the entry, the stale slot entry is ignored
+   wheel.schedule( expiry_wheel::expiring_limit_order, far_id, start + 10 * expiry_wheel::near_slots );
+   const time_point_sec later = start + 10 * expiry_wheel::near_slots;
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_limit_order, later - 1 ) );
+   BOOST_CHECK( wheel.has_due( expiry_wheel::expiring_limit_order, later ) );
+
+   // scheduling a deadline in the past makes the entry due immediately
+   wheel.schedule( expiry_wheel::expiring_htlc, object_id_type( 1, 16, 2 ), start );
+   BOOST_CHECK_EQUAL( wheel.due_count( expiry_wheel::expiring_htlc ), 1u );
+
+   wheel.clear();
+   BOOST_CHECK_EQUAL( wheel.size(), 0u );
+   BOOST_CHECK( !wheel.has_due( expiry_wheel::expiring_limit_order, later ) );
+}
+
+BOOST_AUTO_TEST_CASE( applied_operation_log_test )
+{
+   applied_operation_log log;
+   const size_t count = applied_operation_log::chunk_size * 3 + 5;
+
+   transfer_operation first;
+   first.amount = asset( 1 );
+   const operation_history_object& first_entry = log.push_back( first );
+   for( size_t i = 1; i < count; ++i )
+   {
+      transfer_operation op;
+      op.amount = asset( i + 1 );
+      log.push_back( operation( op ) );
+   }
+   BOOST_REQUIRE_EQUAL( log.size(), count );
+   // entries do not move when the log grows
+   BOOST_CHECK( &first_entry == &*log[0] );
+   BOOST_CHECK_EQUAL( first_entry.op.get<transfer_operation>().amount.amount.value, 1 );
+
+   size_t n = 0;
+   for( const auto& entry : log )
+   {
+      BOOST_REQUIRE( entry.valid() );
+      BOOST_CHECK_EQUAL( entry->op.get<transfer_operation>().amount.amount.value, int64_t( ++n ) );
+   }
+   BOOST_CHECK_EQUAL( n, count );
+
+   log.truncate( 10 );
+   BOOST_CHECK_EQUAL( log.size(), 10u );
+   BOOST_CHECK( log[9].valid() );
+   log.truncate( 20 ); // does not grow
+   BOOST_CHECK_EQUAL( log.size(), 10u );
+
+   // clearing keeps the chunks for the next block
+   const size_t capacity = log.capacity();
+   BOOST_CHECK_GE( capacity, count );
+   log.clear();
+   BOOST_CHECK( log.empty() );
+   BOOST_CHECK( log.begin() == log.end() );
+   BOOST_CHECK_EQUAL( log.capacity(), capacity );
+   log.push_back( first );
+   BOOST_CHECK( &*log[0] == &first_entry );
+   BOOST_CHECK_EQUAL( log.capacity(), capacity );
+}
+
+BOOST_AUTO_TEST_CASE( shared_applied_operations )
+{ try {
+   ACTORS( (alice) );
+   fund( alice );
+   generate_block();
+
+   std::shared_ptr<const applied_operation_log> shared;
+   size_t shared_size = 0;
+   auto connection = db.applied_block.connect( [&]( const signed_block& ) {
+      if( !shared )
+      {
+         shared = db.share_applied_operations();
+         shared_size = shared->size();
+      }
+   } );
+
+   transfer( alice_id, account_id_type(), asset( 1 ) );
+   generate_block();
+   BOOST_REQUIRE( shared );
+   BOOST_CHECK_GT( shared_size, 0u );
+
+   // the shared log of the last block is kept unchanged while the next blocks use a new one
+   transfer( alice_id, account_id_type(), asset( 2 ) );
+   generate_block();
+   BOOST_CHECK( db.share_applied_operations() != shared );
+   BOOST_CHECK_EQUAL( shared->size(), shared_size );
+   bool found = false;
+   for( const auto& entry : *shared )
+      if( entry.valid() && entry->op.is_type<transfer_operation>() )
+         found = entry->op.get<transfer_operation>().amount.amount == 1;
+   BOOST_CHECK( found );
+
+   connection.disconnect();
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -133,6 +133,114 @@ BOOST_AUTO_TEST_CASE( block_database_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( block_database_id_index )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      std::vector<block_id_type> ids;
+      clearable_block b;
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+      }
+
+      BOOST_CHECK( bdb.fetch_block_ids( 1, 10 ) == ids );
+      BOOST_CHECK( bdb.fetch_block_ids( 2, 2 ) == std::vector<block_id_type>( ids.begin() + 1, ids.begin() + 3 ) );
+      BOOST_CHECK( bdb.fetch_block_ids( 6, 10 ).empty() );
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         BOOST_CHECK( bdb.contains( ids[i] ) );
+         BOOST_CHECK( bdb.fetch_block_id( i+1 ) == ids[i] );
+      }
+
+      // a block from another fork replaces the one with the same number
+      clearable_block fork_block;
+      fork_block.previous = ids[1];
+      fork_block.witness = witness_id_type(10);
+      fork_block.clear();
+      bdb.store( fork_block.id(), fork_block );
+      BOOST_CHECK( !bdb.contains( ids[2] ) );
+      BOOST_CHECK( bdb.contains( fork_block.id() ) );
+      BOOST_CHECK( bdb.fetch_block_id( 3 ) == fork_block.id() );
+      ids[2] = fork_block.id();
+
+      // removed blocks are gone from the index
+      bdb.remove( ids[4] );
+      BOOST_CHECK( !bdb.contains( ids[4] ) );
+      BOOST_CHECK( bdb.fetch_block_ids( 1, 10 ) == std::vector<block_id_type>( ids.begin(), ids.begin() + 4 ) );
+      GRAPHENE_CHECK_THROW( bdb.fetch_block_id( 5 ), fc::exception );
+
+      // the index is rebuilt from the disk when the database is opened again
+      bdb.close();
+      bdb.open( data_dir.path() );
+      BOOST_CHECK( bdb.fetch_block_ids( 1, 10 ) == std::vector<block_id_type>( ids.begin(), ids.begin() + 4 ) );
+      BOOST_CHECK( bdb.contains( fork_block.id() ) );
+      BOOST_CHECK( !bdb.contains( ids[4] ) );
+      BOOST_CHECK( *bdb.last_id() == ids[3] );
+
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_packed_range )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      std::vector<signed_block> blocks;
+      clearable_block b;
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         b.clear();
+         bdb.store( b.id(), b );
+         blocks.push_back( b );
+      }
+      const size_t block_size = fc::raw::pack_size( blocks[0] );
+
+      // the blocks are returned as they were packed
+      std::vector<std::vector<char>> packed = bdb.fetch_packed_range( 2, 3, 1024 * 1024 );
+      BOOST_REQUIRE_EQUAL( packed.size(), 3u );
+      for( size_t i = 0; i < packed.size(); ++i )
+         BOOST_CHECK( packed[i] == fc::raw::pack( blocks[i+1] ) );
+
+      BOOST_CHECK_EQUAL( bdb.fetch_packed_range( 1, 10, 1024 * 1024 ).size(), 5u );
+      BOOST_CHECK( bdb.fetch_packed_range( 6, 10, 1024 * 1024 ).empty() );
+      BOOST_CHECK( bdb.fetch_packed_range( 1, 0, 1024 * 1024 ).empty() );
+
+      // the size limit is respected, but the first block is always returned
+      BOOST_CHECK_EQUAL( bdb.fetch_packed_range( 1, 10, 2 * block_size ).size(), 2u );
+      BOOST_CHECK_EQUAL( bdb.fetch_packed_range( 1, 10, 1 ).size(), 1u );
+
+      // a removed block ends the range
+      bdb.remove( blocks[2].id() );
+      BOOST_CHECK_EQUAL( bdb.fetch_packed_range( 1, 10, 1024 * 1024 ).size(), 2u );
+      BOOST_CHECK( bdb.fetch_packed_range( 3, 10, 1024 * 1024 ).empty() );
+      BOOST_CHECK_EQUAL( bdb.fetch_packed_range( 4, 10, 1024 * 1024 ).size(), 2u );
+
+      // reading past the end doesn't break the following reads
+      BOOST_CHECK( bdb.fetch_by_number( 4 ).valid() );
+
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
@@ -1949,4 +2057,81 @@ BOOST_FIXTURE_TEST_CASE( block_size_test, database_fixture )
    }
 }
 
+BOOST_FIXTURE_TEST_CASE( witness_schedule_cache_test, database_fixture )
+{ try {
+   const auto check_schedule = [this]() {
+      const witness_schedule_object& wso = db.get_witness_schedule_object();
+      const auto& dpo = db.get_dynamic_global_properties();
+      const size_t n = wso.current_shuffled_witnesses.size();
+      const witness_schedule_ptr schedule = db.get_witness_schedule();
+      BOOST_REQUIRE_EQUAL( schedule->size(), n );
+      for( uint32_t slot = 1; slot <= n; ++slot )
+      {
+         const scheduled_witness_slot scheduled = db.get_scheduled_witness_slot( slot );
+         BOOST_CHECK( scheduled.witness == wso.current_shuffled_witnesses[ ( dpo.current_aslot + slot ) % n ] );
+         BOOST_CHECK( scheduled.witness == db.get_scheduled_witness( slot ) );
+         BOOST_CHECK( scheduled.signing_key == scheduled.witness(db).signing_key );
+      }
+   };
+
+   generate_block();
+   check_schedule();
+
+   BOOST_TEST_MESSAGE( "The schedule is shared by the blocks of a round" );
+   const size_t round_size = db.get_global_properties().active_witnesses.size();
+   for( size_t i = 0; i < 2 * round_size; ++i )
+   {
+      const witness_schedule_ptr before = db.get_witness_schedule();
+      generate_block();
+      if( db.head_block_num() % round_size != 0 )
+         BOOST_CHECK( db.get_witness_schedule() == before );
+      check_schedule();
+   }
+
+   BOOST_TEST_MESSAGE( "A new signing key of a scheduled witness drops the schedule" );
+   const witness_id_type witness_id = db.get_scheduled_witness( 1 );
+   const public_key_type old_key = witness_id(db).signing_key;
+   const public_key_type new_key = generate_private_key( "new_signing_key" ).get_public_key();
+   const witness_schedule_ptr before = db.get_witness_schedule();
+   {
+      witness_update_operation wuop;
+      wuop.witness_account = witness_id(db).witness_account;
+      wuop.witness = witness_id;
+      wuop.new_signing_key = new_key;
+      signed_transaction trx;
+      trx.operations.push_back( wuop );
+      set_expiration( db, trx );
+      PUSH_TX( db, trx, ~0 );
+   }
+   BOOST_CHECK( db.get_witness_schedule() != before );
+   BOOST_CHECK( db.get_scheduled_witness_slot( 1 ).signing_key == new_key );
+   check_schedule();
+
+   BOOST_TEST_MESSAGE( "Undo restores the old signing key in the schedule" );
+   db.clear_pending();
+   BOOST_CHECK( db.get_scheduled_witness_slot( 1 ).signing_key == old_key );
+   check_schedule();
+
+   BOOST_TEST_MESSAGE( "Popping a block restores the schedule of its round" );
+   {
+      witness_update_operation wuop;
+      wuop.witness_account = witness_id(db).witness_account;
+      wuop.witness = witness_id;
+      wuop.new_signing_key = new_key;
+      signed_transaction trx;
+      trx.operations.push_back( wuop );
+      set_expiration( db, trx );
+      PUSH_TX( db, trx, ~0 );
+   }
+   generate_block();
+   BOOST_CHECK( witness_id(db).signing_key == new_key );
+   check_schedule();
+   db.pop_block();
+   db._popped_tx.clear();
+   db.clear_pending();
+   BOOST_CHECK( witness_id(db).signing_key == old_key );
+   check_schedule();
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -129,5 +129,66 @@ BOOST_AUTO_TEST_CASE( confidential_test )
 } FC_LOG_AND_RETHROW() }
 
 
+BOOST_AUTO_TEST_CASE( confidential_commitments_precomputed )
+{ try {
+   ACTORS( (dan) )
+   const asset_object& core = asset_id_type()(db);
+
+   transfer_to_blind_operation to_blind;
+   to_blind.amount = core.amount(1000);
+   to_blind.from   = dan.id;
+
+   auto owner_key = fc::ecc::private_key::generate();
+   auto InB1  = fc::sha256::hash("InB1");
+   auto InB2  = fc::sha256::hash("InB2");
+   auto nonce = fc::sha256::hash("nonce");
+
+   blind_output out1, out2;
+   out1.owner = authority( 1, public_key_type(owner_key.get_public_key()), 1 );
+   out2.owner = out1.owner;
+   out1.commitment  = fc::ecc::blind(InB1,250);
+   out1.range_proof = fc::ecc::range_proof_sign( 0, out1.commitment, InB1, nonce, 0, 0, 250 );
+   out2.commitment  = fc::ecc::blind(InB2,750);
+   out2.range_proof = fc::ecc::range_proof_sign( 0, out2.commitment, InB2, nonce, 0, 0, 750 );
+   to_blind.outputs = {out1,out2};
+   if( to_blind.outputs[1].commitment < to_blind.outputs[0].commitment )
+      std::swap( to_blind.outputs[0], to_blind.outputs[1] );
+
+   // A blinding factor which does not match the outputs only fails the expensive part of the validation
+   to_blind.blinding_factor = fc::ecc::blind_sum( {InB1}, 1 );
+   to_blind.validate( false );
+   BOOST_CHECK_THROW( to_blind.validate(), fc::exception );
+   BOOST_CHECK_THROW( to_blind.verify_commitments(), fc::exception );
+
+   signed_transaction tx;
+   tx.operations = {to_blind};
+   test::set_expiration( db, tx );
+   precomputable_transaction bad_trx( tx );
+   BOOST_CHECK( bad_trx.has_commitments() );
+   BOOST_CHECK_THROW( bad_trx.verify_commitments(), fc::exception );
+   BOOST_CHECK_THROW( bad_trx.validate(), fc::exception );
+
+   // The commitments are verified during the precomputation of a block
+   signed_block block;
+   block.transactions.emplace_back( tx );
+   const uint32_t skip = database::skip_witness_signature | database::skip_merkle_check;
+   BOOST_CHECK_THROW( db.precompute_parallel( block, skip ).wait(), fc::exception );
+
+   to_blind.blinding_factor = fc::ecc::blind_sum( {InB1,InB2}, 2 );
+   to_blind.verify_commitments();
+   tx.operations = {to_blind};
+   signed_block good_block;
+   good_block.transactions.emplace_back( tx );
+   db.precompute_parallel( good_block, skip ).wait();
+
+   // Both results are cached on the transaction of the block
+   const auto& good_trx = good_block.transactions.front();
+   good_trx.validate();
+   good_trx.verify_commitments();
+
+   transfer_operation transfer;
+   tx.operations = {transfer};
+   BOOST_CHECK( !precomputable_transaction( tx ).has_commitments() );
+} FC_LOG_AND_RETHROW() }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -94,6 +94,30 @@ void expect_exception_string(const string& s, Expression e) {
     BOOST_TEST_CHECKPOINT("Expect exception containing string: " S); \
     expect_exception_string(S, E)
 
+/**
+ * Get the predicate function for the restrictions, and also compile them into a restriction_program. The returned
+ * function evaluates both and checks that they agree on the result, including the rejection path, so every
+ * restriction tested here also tests the compiled program against the predicate function.
+ */
+restriction_predicate_function get_differential_predicate(const vector<restriction>& rs, operation::tag_type op_type) {
+   restriction_predicate_function predicate;
+   try {
+      predicate = get_restriction_predicate(rs, op_type);
+   } catch (const fc::exception&) {
+      // Restrictions the predicate function rejects must not compile either
+      BOOST_CHECK_THROW(compile_restriction_program(rs, op_type), fc::exception);
+      throw;
+   }
+   auto program = compile_restriction_program(rs, op_type);
+   return [predicate, program](const operation& op) {
+      auto expected = predicate(op);
+      auto actual = program(op);
+      BOOST_CHECK_EQUAL(fc::json::to_string(fc::variant(actual, GRAPHENE_MAX_NESTED_OBJECTS)),
+                        fc::json::to_string(fc::variant(expected, GRAPHENE_MAX_NESTED_OBJECTS)));
+      return expected;
+   };
+}
+
 BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    using namespace graphene::protocol;
    //////
@@ -109,7 +133,7 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    //////
    transfer_operation transfer;
    // Check that the proposed operation to account ID 0 is not compliant with the restriction to account ID 12
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == false);
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == false);
    // Inspect the reasons why the proposed operation was rejected
    // The rejection path will reference portions of the restrictions
    //[
@@ -124,13 +148,13 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    //  }
    //]
    BOOST_CHECK_EQUAL(restriction::restriction_count(restrictions), 1);
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path.size() == 2);
    // Index 0 (the outer-most) rejection path refers to the first and only outer-most sub-restriction
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path[0].get<size_t>() == 0);
    // Index 1 (the inner-most) rejection path refers to the first and only argument for an account ID of 1.2.12
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path[1].get<predicate_result::rejection_reason>() == predicate_result::predicate_was_false);
 
    //////
@@ -138,8 +162,8 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    // This should satisfy the restriction
    //////
    transfer.to = account_id_type(12);
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == true);
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == true);
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path.size() == 0);
 
 
@@ -167,7 +191,7 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    //   r.member_index < typelist::length<member_list>(): Invalid member index 6 for object graphene::protocol::transfer_operation
    //           {"I":6,"O":"graphene::protocol::transfer_operation"}
    //   th_a  restriction_predicate.hxx:493 create_field_predicate
-   BOOST_CHECK_THROW(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value),
+   BOOST_CHECK_THROW(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value),
                      fc::assert_exception);
 
 
@@ -195,7 +219,7 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    //
    //   {"fc::get_typename<Field>::name()":"graphene::protocol::account_id_type","func":"func_eq","arg":[8,"1.3.12"]}
    //   th_a  restriction_predicate.hxx:476 create_predicate_function
-   BOOST_CHECK_THROW(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value),
+   BOOST_CHECK_THROW(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value),
                      fc::assert_exception);
 
    //////
@@ -210,8 +234,8 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    // Check the transfer operation that pays the fee with Asset ID 0
    // This should satisfy the restriction.
    //////
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == true);
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == true);
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path.size() == 0);
 
    //////
@@ -245,20 +269,20 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    // Check the transfer operation that pays the fee with Asset ID 0 against the restriction.
    // This should violate the restriction.
    //////
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == false);
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == false);
    // Inspect the reasons why the proposed operation was rejected
    // The rejection path will reference portions of the restrictions
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path.size() == 3);
    // Index 0 (the outer-most) rejection path refers to the first and only outer-most sub-restriction
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path[0].get<size_t>() == 0);
    // Index 1 rejection path refers to the first and only attribute of the restriction
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path[1].get<size_t>() == 0);
    // Index 2 (the inner-most) rejection path refers to the expected rejection reason
    // The rejection reason should be that the predicate was false
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path[2].get<predicate_result::rejection_reason>() == predicate_result::predicate_was_false);
 
    //////
@@ -303,8 +327,8 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    //////
    transfer.to = account_id_type(12);
    transfer.fee.asset_id = asset_id_type(1);
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == true);
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == true);
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path.size() == 0);
 
    //////
@@ -312,16 +336,16 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    // This operation should violate the restriction
    //////
    transfer.to = account_id_type(10);
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == false);
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer) == false);
    // Inspect the reasons why the proposed operation was rejected
    // The rejection path will reference portions of the restrictions
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path.size() == 2);
    // Index 0 (the outer-most) rejection path refers to the first and only outer-most sub-restriction
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path[0].get<size_t>() == 1);
    // Index 1 (the inner-most) rejection path refers to the first and only argument
-   BOOST_CHECK(get_restriction_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
+   BOOST_CHECK(get_differential_predicate(restrictions, operation::tag<transfer_operation>::value)(transfer)
                .rejection_path[1].get<predicate_result::rejection_reason>() == predicate_result::predicate_was_false);
 
    //////
@@ -354,7 +378,7 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    //  }
    //]
    BOOST_CHECK_EQUAL(restriction::restriction_count(restrictions), 2);
-   auto predicate = get_restriction_predicate(restrictions, operation::tag<account_update_operation>::value);
+   auto predicate = get_differential_predicate(restrictions, operation::tag<account_update_operation>::value);
 
    //////
    // Create an account update operation without any owner_special_authority extension
@@ -411,7 +435,7 @@ BOOST_AUTO_TEST_CASE(restriction_predicate_tests) { try {
    //////
    // The update operation should satisfy the new restriction because the ext.owner_special_authority is specified
    //////
-   predicate = get_restriction_predicate(restrictions, operation::tag<account_update_operation>::value);
+   predicate = get_differential_predicate(restrictions, operation::tag<account_update_operation>::value);
    BOOST_CHECK(predicate(update) == true);
 } FC_LOG_AND_RETHROW() }
 
@@ -419,7 +443,7 @@ BOOST_AUTO_TEST_CASE(container_in_not_in_checks) { try {
    vector<restriction> restrictions;
    restrictions.emplace_back(member_index<asset_update_feed_producers_operation>("new_feed_producers"), FUNC(in),
                              flat_set<account_id_type>{account_id_type(5), account_id_type(6), account_id_type(7)});
-   auto pred = get_restriction_predicate(restrictions, operation::tag<asset_update_feed_producers_operation>::value);
+   auto pred = get_differential_predicate(restrictions, operation::tag<asset_update_feed_producers_operation>::value);
 
    asset_update_feed_producers_operation op;
    BOOST_CHECK(pred(op));
@@ -437,7 +461,7 @@ BOOST_AUTO_TEST_CASE(container_in_not_in_checks) { try {
    BOOST_CHECK(!pred(op));
 
    restrictions.front().restriction_type = FUNC(not_in);
-   pred = get_restriction_predicate(restrictions, operation::tag<asset_update_feed_producers_operation>::value);
+   pred = get_differential_predicate(restrictions, operation::tag<asset_update_feed_producers_operation>::value);
    op.new_feed_producers.clear();
    BOOST_CHECK(pred(op));
    op.new_feed_producers = {account_id_type(1)};
@@ -509,7 +533,7 @@ BOOST_AUTO_TEST_CASE(container_in_not_in_checks) { try {
          //  }
          //]
          BOOST_CHECK_EQUAL(restriction::restriction_count(or_restrictions), 3);
-         auto predicate = get_restriction_predicate(or_restrictions, operation::tag<transfer_operation>::value);
+         auto predicate = get_differential_predicate(or_restrictions, operation::tag<transfer_operation>::value);
 
          //////
          // Create an operation that transfers to Account ID 12
@@ -604,6 +628,145 @@ BOOST_AUTO_TEST_CASE(container_in_not_in_checks) { try {
    }
 
 
+   /**
+    * Differential test of the compiled restriction programs against the predicate functions, for the corner cases of
+    * optionals, extensions and variants
+    */
+   BOOST_AUTO_TEST_CASE(restriction_program_matches_predicate) {
+      try {
+         using namespace graphene::protocol;
+         const auto transfer_tag = operation::tag<transfer_operation>::value;
+         const auto update_tag = operation::tag<account_update_operation>::value;
+
+         auto memo_index = member_index<transfer_operation>("memo");
+         auto amount_index = member_index<transfer_operation>("amount");
+         auto to_index = member_index<transfer_operation>("to");
+         auto owner_index = member_index<account_update_operation>("owner");
+         auto options_index = member_index<account_update_operation>("new_options");
+         auto extensions_index = member_index<account_update_operation>("extensions");
+         using update_ext = account_update_operation::ext;
+         auto owner_special_index = member_index<update_ext>("owner_special_authority");
+         auto num_top_holders_index = member_index<top_holders_special_authority>("num_top_holders");
+
+         vector<vector<restriction>> transfer_restrictions = {
+            { restriction(memo_index, FUNC(eq), void_t()) },
+            { restriction(memo_index, FUNC(ne), void_t()) },
+            { restriction(memo_index, FUNC(attr), vector<restriction>{
+                 restriction(member_index<memo_data>("message"), FUNC(eq), int64_t(0)) }) },
+            { restriction(amount_index, FUNC(attr), vector<restriction>{
+                 restriction(member_index<asset>("amount"), FUNC(le), int64_t(100)),
+                 restriction(member_index<asset>("asset_id"), FUNC(in),
+                             flat_set<asset_id_type>{ asset_id_type(1) }) }) },
+            { restriction(0, FUNC(logical_or), vector<vector<restriction>>{
+                 { restriction(to_index, FUNC(eq), account_id_type(12)) },
+                 { restriction(amount_index, FUNC(attr), vector<restriction>{
+                      restriction(member_index<asset>("amount"), FUNC(lt), int64_t(100)) }) } }) }
+         };
+         vector<transfer_operation> transfers(4);
+         transfers[1].to = account_id_type(12);
+         transfers[2].amount = asset(500, asset_id_type(1));
+         transfers[3].memo = memo_data();
+         transfers[3].memo->message = { 'a', 'b' };
+
+         for (const auto& rs : transfer_restrictions) {
+            auto predicate = get_differential_predicate(rs, transfer_tag);
+            for (const auto& transfer : transfers)
+               predicate(transfer);
+         }
+
+         vector<vector<restriction>> update_restrictions = {
+            { restriction(owner_index, FUNC(attr), vector<restriction>{
+                 restriction(member_index<authority>("weight_threshold"), FUNC(le), int64_t(1)) }) },
+            { restriction(options_index, FUNC(attr), vector<restriction>{
+                 restriction(member_index<account_options>("num_witness"), FUNC(lt), int64_t(5)),
+                 restriction(member_index<account_options>("num_committee"), FUNC(ge), int64_t(5)) }) },
+            { restriction(extensions_index, FUNC(attr), vector<restriction>{
+                 restriction(owner_special_index, FUNC(variant_assert),
+                             restriction::variant_assert_argument_type(1, vector<restriction>{
+                                restriction(num_top_holders_index, FUNC(ge), int64_t(2)) })) }) },
+            { restriction(extensions_index, FUNC(attr), vector<restriction>{
+                 restriction(owner_special_index, FUNC(variant_assert),
+                             restriction::variant_assert_argument_type(0, vector<restriction>())) }) }
+         };
+         vector<account_update_operation> updates(5);
+         updates[1].owner = authority(1, account_id_type(5), 1);
+         updates[1].new_options = account_options();
+         updates[1].new_options->num_witness = 7;
+         updates[2].owner = authority(3, account_id_type(5), 1);
+         updates[2].new_options = account_options();
+         updates[2].new_options->num_committee = 9;
+         updates[3].extensions.value.owner_special_authority = special_authority(no_special_authority());
+         top_holders_special_authority top_holders;
+         top_holders.num_top_holders = 3;
+         updates[4].extensions.value.owner_special_authority = special_authority(top_holders);
+
+         for (const auto& rs : update_restrictions) {
+            auto predicate = get_differential_predicate(rs, update_tag);
+            for (const auto& update : updates)
+               predicate(update);
+         }
+
+         // The compiled program asserts on the operation type just like the predicate function
+         auto program = compile_restriction_program(transfer_restrictions.front(), transfer_tag);
+         BOOST_CHECK_THROW(program(updates.front()), fc::assert_exception);
+      } FC_LOG_AND_RETHROW()
+   }
+
+   BOOST_AUTO_TEST_CASE(predicate_cache_shares_programs) {
+      try {
+         using namespace graphene::protocol;
+         auto& cache = custom_authority_predicate_cache::instance();
+         cache.clear();
+
+         const auto transfer_tag = operation::tag<transfer_operation>::value;
+         vector<restriction> rs = { restriction(member_index<transfer_operation>("to"), FUNC(eq),
+                                                account_id_type(12)) };
+
+         // Custom authorities with identical restrictions share the compiled predicate
+         custom_authority_object first;
+         first.operation_type = transfer_tag;
+         first.restrictions[0] = rs.front();
+         custom_authority_object second = first;
+         second.clear_predicate_cache();
+         auto first_predicate = first.get_predicate();
+         BOOST_CHECK(second.get_predicate() == first_predicate);
+         auto stats = cache.get_stats();
+         BOOST_CHECK_EQUAL(stats.size, 1u);
+         BOOST_CHECK_EQUAL(stats.hits, 1u);
+         BOOST_CHECK_EQUAL(stats.misses, 1u);
+
+         // Copies, e.g. in undo state, keep the predicate
+         custom_authority_object copy = first;
+         BOOST_CHECK(copy.get_predicate() == first_predicate);
+         BOOST_CHECK_EQUAL(cache.get_stats().hits, 1u);
+
+         transfer_operation transfer;
+         BOOST_CHECK(!(*first_predicate)(transfer).success);
+         transfer.to = account_id_type(12);
+         BOOST_CHECK((*first_predicate)(transfer).success);
+
+         // The operation type is part of the key
+         auto update_predicate = cache.get({}, operation::tag<account_update_operation>::value);
+         BOOST_CHECK(update_predicate != first_predicate);
+         BOOST_CHECK_EQUAL(cache.get_stats().misses, 2u);
+         auto empty_transfer_predicate = cache.get({}, transfer_tag);
+         BOOST_CHECK(empty_transfer_predicate != update_predicate);
+         BOOST_CHECK_EQUAL(cache.get_stats().misses, 3u);
+
+         // Predicates are released when no custom authority uses them any more
+         first.clear_predicate_cache();
+         second.clear_predicate_cache();
+         copy.clear_predicate_cache();
+         first_predicate.reset();
+         BOOST_CHECK_EQUAL(cache.get_stats().size, 2u);
+         first.get_predicate();
+         stats = cache.get_stats();
+         BOOST_CHECK_EQUAL(stats.size, 3u);
+         BOOST_CHECK_EQUAL(stats.misses, 4u);
+      } FC_LOG_AND_RETHROW()
+   }
+
+
 BOOST_AUTO_TEST_CASE(custom_auths) { try {
    //////
    // Initialize the test
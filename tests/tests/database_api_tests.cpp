@@ -24,6 +24,8 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <graphene/app/api_call_statistics.hpp>
+#include <graphene/app/api_worker_pool.hpp>
 #include <graphene/app/database_api.hpp>
 #include <graphene/chain/hardfork.hpp>
 
@@ -1909,4 +1911,148 @@ BOOST_AUTO_TEST_CASE( get_trade_history )
 } FC_LOG_AND_RETHROW() }
 
 
+BOOST_AUTO_TEST_CASE( api_worker_pool_reads )
+{ try {
+   ACTORS( (alice) );
+   generate_block();
+
+   graphene::app::api_worker_pool pool( 2 );
+   graphene::app::database_api pooled_api( db, &( app.get_options() ), &pool );
+   graphene::app::database_api inline_api( db, &( app.get_options() ) );
+
+   BOOST_CHECK( pooled_api.get_account_by_name( "alice" )->id == alice_id );
+   BOOST_CHECK( pooled_api.get_dynamic_global_properties().head_block_number == db.head_block_num() );
+
+   // results must match the ones computed on the calling thread, also after new blocks were applied
+   generate_block();
+   transfer( account_id_type(), alice_id, asset(1000) );
+   generate_block();
+   BOOST_CHECK( pooled_api.get_dynamic_global_properties().head_block_number == db.head_block_num() );
+   BOOST_CHECK( pooled_api.get_account_balances( "alice", {} ) == inline_api.get_account_balances( "alice", {} ) );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( api_call_statistics_recording )
+{ try {
+   ACTORS( (alice) );
+   generate_block();
+
+   // sample the result of every 2nd call
+   graphene::app::api_call_statistics stats( 2 );
+   const uint64_t conn = stats.register_connection();
+   stats.set_connection_user( conn, "alice" );
+   graphene::app::database_api db_api( db, &( app.get_options() ), nullptr, &stats, conn );
+
+   for( int i = 0; i < 3; ++i )
+      BOOST_CHECK( db_api.get_account_by_name( "alice" )->id == alice_id );
+   GRAPHENE_CHECK_THROW( db_api.get_account_balances( "no-such-account", {} ), fc::exception );
+
+   auto methods = stats.get_method_statistics();
+   BOOST_REQUIRE( methods.find( "database_api.get_account_by_name" ) != methods.end() );
+   const auto& by_name = methods["database_api.get_account_by_name"];
+   BOOST_CHECK_EQUAL( by_name.calls, 3u );
+   BOOST_CHECK_EQUAL( by_name.errors, 0u );
+   BOOST_CHECK_EQUAL( by_name.latency.count, 3u );
+   uint64_t bucketed = 0;
+   for( auto n : by_name.latency.buckets )
+      bucketed += n;
+   BOOST_CHECK_EQUAL( bucketed, by_name.latency.count );
+   BOOST_CHECK_EQUAL( by_name.sampled_calls, 2u ); // the 1st and the 3rd call
+   BOOST_CHECK_GT( by_name.sampled_result_bytes, 0u );
+   BOOST_CHECK_GE( by_name.sampled_result_bytes, by_name.max_result_bytes );
+
+   const auto& balances = methods["database_api.get_account_balances"];
+   BOOST_CHECK_EQUAL( balances.calls, 1u );
+   BOOST_CHECK_EQUAL( balances.errors, 1u );
+   BOOST_CHECK_EQUAL( balances.sampled_calls, 0u );
+
+   auto connections = stats.get_connection_statistics();
+   BOOST_REQUIRE_EQUAL( connections.size(), 1u );
+   BOOST_CHECK_EQUAL( connections[0].connection_id, conn );
+   BOOST_CHECK_EQUAL( connections[0].user, "alice" );
+   BOOST_CHECK_EQUAL( connections[0].methods["database_api.get_account_by_name"].calls, 3u );
+
+   const std::string text = stats.get_prometheus_text();
+   BOOST_CHECK( text.find( "graphene_api_calls_total{method=\"database_api.get_account_by_name\"} 3\n" )
+                != std::string::npos );
+   BOOST_CHECK( text.find( "graphene_api_call_latency_microseconds_count{method=\"database_api.get_account_by_name\"} 3\n" )
+                != std::string::npos );
+   BOOST_CHECK( text.find( "graphene_api_call_errors_total{method=\"database_api.get_account_balances\"} 1\n" )
+                != std::string::npos );
+
+   stats.unregister_connection( conn );
+   BOOST_CHECK( stats.get_connection_statistics().empty() );
+   BOOST_CHECK_EQUAL( stats.get_method_statistics()["database_api.get_account_by_name"].calls, 3u );
+
+   stats.reset();
+   BOOST_CHECK( stats.get_method_statistics().empty() );
+
+} FC_LOG_AND_RETHROW() }
+
+BOOST_AUTO_TEST_CASE( subscription_filter_test )
+{ try {
+   using graphene::app::subscription_filter;
+
+   BOOST_TEST_MESSAGE( "IDs of different types with the same instance do not collide" );
+   subscription_filter filter;
+   filter.insert( account_id_type( 5 ) );
+   BOOST_CHECK( filter.contains( account_id_type( 5 ) ) );
+   BOOST_CHECK( !filter.contains( asset_id_type( 5 ) ) );
+   BOOST_CHECK( !filter.contains( account_id_type( 6 ) ) );
+   filter.insert( account_id_type( 5 ) );
+   BOOST_CHECK_EQUAL( filter.size(), 1u );
+
+   BOOST_TEST_MESSAGE( "The filter grows without losing or inventing subscriptions" );
+   const uint32_t count = 20000;
+   for( uint32_t i = 0; i < count; ++i )
+      filter.insert( limit_order_id_type( i ) );
+   auto stats = filter.get_statistics();
+   BOOST_CHECK_EQUAL( stats.items, count + 1 );
+   BOOST_CHECK_GT( stats.resizes, 0u );
+   BOOST_CHECK( !stats.saturated );
+   BOOST_CHECK_LE( stats.fill_ratio, 1.0 );
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      BOOST_CHECK( filter.contains( limit_order_id_type( i ) ) );
+      BOOST_CHECK( !filter.contains( call_order_id_type( i ) ) );
+   }
+
+   BOOST_TEST_MESSAGE( "Removed IDs are not subscribed any more" );
+   for( uint32_t i = 0; i < count; i += 2 )
+      BOOST_CHECK( filter.remove( limit_order_id_type( i ) ) );
+   BOOST_CHECK( !filter.remove( limit_order_id_type( 0 ) ) );
+   for( uint32_t i = 0; i < count; ++i )
+      BOOST_CHECK_EQUAL( filter.contains( limit_order_id_type( i ) ), i % 2 == 1 );
+   BOOST_CHECK_EQUAL( filter.size(), count / 2 + 1 );
+
+   BOOST_TEST_MESSAGE( "A full filter saturates and reports everything as subscribed" );
+   const uint64_t max_items = uint64_t( subscription_filter::max_buckets ) * subscription_filter::slots_per_bucket;
+   for( uint64_t i = 0; i < max_items && !filter.get_statistics().saturated; ++i )
+      filter.insert( force_settlement_id_type( i ) );
+   BOOST_CHECK( filter.get_statistics().saturated );
+   BOOST_CHECK( filter.contains( call_order_id_type( 1 ) ) );
+   BOOST_CHECK_GT( filter.get_statistics().saturated_matches, 0u );
+
+   filter.clear();
+   stats = filter.get_statistics();
+   BOOST_CHECK( !stats.saturated );
+   BOOST_CHECK_EQUAL( stats.items, 0u );
+   BOOST_CHECK_EQUAL( stats.capacity, subscription_filter::initial_buckets * subscription_filter::slots_per_bucket );
+   BOOST_CHECK( !filter.contains( account_id_type( 5 ) ) );
+
+   BOOST_TEST_MESSAGE( "The statistics of a connection follow its subscriptions" );
+   ACTORS( (alice)(bob) );
+   generate_block();
+   graphene::app::database_api db_api( db );
+   db_api.set_subscribe_callback( []( const variant& ){}, false );
+   db_api.get_accounts( { "alice", "bob" } );
+   db_api.get_accounts( { "alice" } );
+   stats = db_api.get_subscription_statistics();
+   BOOST_CHECK_EQUAL( stats.items, 2u );
+   BOOST_CHECK( !stats.saturated );
+   db_api.cancel_all_subscriptions();
+   BOOST_CHECK_EQUAL( db_api.get_subscription_statistics().items, 0u );
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -310,4 +310,43 @@ BOOST_AUTO_TEST_CASE( required_approval_index_test ) // see https://github.com/b
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( apply_profiler_test )
+{ try {
+   ACTORS( (alice) );
+   generate_block();
+
+   BOOST_CHECK( db.get_apply_profiler() == nullptr );
+   db.enable_apply_profiler( true );
+   BOOST_REQUIRE( db.get_apply_profiler() != nullptr );
+
+   transfer( account_id_type(), alice_id, asset(1000) );
+   generate_block();
+
+   apply_profile profile = db.get_apply_profiler()->get_profile();
+   BOOST_CHECK_EQUAL( profile.blocks, 1u );
+   BOOST_REQUIRE( profile.operations.find( "transfer" ) != profile.operations.end() );
+   const apply_profile_entry& transfers = profile.operations["transfer"];
+   BOOST_CHECK_GE( transfers.count, 1u );
+   BOOST_CHECK_GE( transfers.modifies, 2u ); // at least the balances of both accounts
+
+   BOOST_REQUIRE( profile.phases.find( "transactions" ) != profile.phases.end() );
+   BOOST_CHECK_EQUAL( profile.phases["transactions"].count, 1u );
+   BOOST_CHECK_EQUAL( profile.phases["validate_header"].count, 1u );
+   BOOST_CHECK_EQUAL( profile.phases["notify_changed_objects"].count, 1u );
+   BOOST_CHECK( profile.phases.find( "maintenance" ) == profile.phases.end() );
+   // the block is pushed with undo enabled, so the modified objects are saved
+   BOOST_CHECK_GT( profile.phases["update_global_data"].undo_bytes, 0u );
+
+   db.get_apply_profiler()->reset();
+   profile = db.get_apply_profiler()->get_profile();
+   BOOST_CHECK_EQUAL( profile.blocks, 0u );
+   BOOST_CHECK( profile.operations.empty() );
+   BOOST_CHECK( profile.phases.empty() );
+
+   db.enable_apply_profiler( false );
+   BOOST_CHECK( db.get_apply_profiler() == nullptr );
+   generate_block();
+
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
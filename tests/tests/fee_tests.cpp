@@ -714,6 +714,55 @@ BOOST_AUTO_TEST_CASE( account_create_fee_scaling )
    BOOST_CHECK_EQUAL(db.get_global_properties().parameters.get_current_fees().get<account_create_operation>().basic_fee, 1u);
 } FC_LOG_AND_RETHROW() }
 
+BOOST_AUTO_TEST_CASE( fee_table_follows_schedule_changes )
+{ try {
+   fee_schedule fees = fee_schedule::get_default();
+   const fee_schedule& const_fees = fees;
+   transfer_operation transfer;
+   transfer.memo = memo_data();
+   transfer.memo->message = vector<char>( 2048, 'x' );
+   const int64_t transfer_fee = fees.calculate_fee( transfer ).amount.value;
+   BOOST_CHECK_GT( transfer_fee, int64_t(const_fees.get<transfer_operation>().fee) );
+
+   // Modifying the parameters drops the lookup table
+   account_create_operation account_create;
+   const int64_t data_fee = fees.calculate_fee( account_create ).amount.value
+                            - int64_t(const_fees.get<account_create_operation>().basic_fee);
+   fees.get<account_create_operation>().basic_fee = 7;
+   BOOST_CHECK_EQUAL( fees.calculate_fee( account_create ).amount.value, 7 + data_fee );
+
+   // Copies build their own table, the fees of missing parameters are calculated with the defaults
+   fee_schedule copy = fees;
+   BOOST_CHECK_EQUAL( copy.calculate_fee( transfer ).amount.value, transfer_fee );
+   copy.parameters.erase( transfer_operation::fee_parameters_type() );
+   BOOST_CHECK_EQUAL( copy.calculate_fee( transfer ).amount.value, transfer_fee );
+   BOOST_CHECK_EQUAL( fees.calculate_fee( transfer ).amount.value, transfer_fee );
+
+   // htlc_create charges its memo with the price per kbyte of transfers
+   htlc_create_operation htlc;
+   htlc.extensions.value.memo = memo_data();
+   htlc.extensions.value.memo->message = vector<char>( 2048, 'x' );
+   const int64_t htlc_fee = fees.calculate_fee( htlc ).amount.value;
+   BOOST_CHECK_GT( htlc_fee, int64_t(const_fees.get<htlc_create_operation>().fee) );
+   fees.zero_all_fees();
+   BOOST_CHECK_EQUAL( fees.calculate_fee( htlc ).amount.value, 0 );
+   fees = fee_schedule::get_default();
+   BOOST_CHECK_EQUAL( fees.calculate_fee( htlc ).amount.value, htlc_fee );
+
+   // Changes of the chain parameters are picked up
+   db.modify( global_property_id_type()(db), []( global_property_object& gpo )
+   {
+      gpo.parameters.get_mutable_fees() = fee_schedule::get_default();
+   });
+   const auto& current_fees = db.get_global_properties().parameters.get_current_fees();
+   BOOST_CHECK_EQUAL( current_fees.calculate_fee( transfer ).amount.value, transfer_fee );
+   db.modify( global_property_id_type()(db), []( global_property_object& gpo )
+   {
+      gpo.parameters.get_mutable_fees().get<account_create_operation>().basic_fee = 3;
+   });
+   BOOST_CHECK_EQUAL( current_fees.calculate_fee( account_create ).amount.value, 3 + data_fee );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( fee_refund_test )
 {
    try
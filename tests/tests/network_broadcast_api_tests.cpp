@@ -127,4 +127,60 @@ BOOST_AUTO_TEST_CASE( broadcast_transaction_too_large ) {
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( broadcast_transaction_batch_test ) {
+   try {
+
+      fc::ecc::private_key cid_key = fc::ecc::private_key::regenerate( fc::digest("key") );
+      const account_id_type cid_id = create_account( "cid", cid_key.get_public_key() ).id;
+      fund( cid_id(db), asset(1000000) );
+      const int64_t initial_balance = get_balance( cid_id, asset_id_type() );
+
+      auto nb_api = std::make_shared< graphene::app::network_broadcast_api >( app );
+
+      std::vector<precomputable_transaction> trxs;
+      auto add_transfer = [&]( const asset& amount, const fc::ecc::private_key& key ) {
+         signed_transaction tx;
+         set_expiration( db, tx );
+         transfer_operation trans;
+         trans.from = cid_id;
+         trans.to   = account_id_type();
+         trans.amount = amount;
+         tx.operations.push_back( trans );
+         sign( tx, key );
+         trxs.emplace_back( tx );
+      };
+      add_transfer( asset(1), cid_key );
+      add_transfer( asset(2), generate_private_key( "wrong" ) ); // missing authority
+      add_transfer( asset(3), cid_key );
+      trxs.push_back( trxs[0] );                                  // duplicate
+
+      auto results = nb_api->broadcast_transaction_batch( trxs );
+      BOOST_REQUIRE_EQUAL( results.size(), trxs.size() );
+      for( size_t i = 0; i < trxs.size(); ++i )
+         BOOST_CHECK( results[i].id == trxs[i].id() );
+      BOOST_CHECK( results[0].accepted );
+      BOOST_CHECK( !results[0].error.valid() );
+      BOOST_CHECK( !results[1].accepted );
+      BOOST_CHECK( results[1].error.valid() );
+      BOOST_CHECK( results[2].accepted );
+      BOOST_CHECK( !results[3].accepted );
+      BOOST_CHECK( results[3].error.valid() );
+
+      generate_block();
+
+      // only the two accepted transfers were applied
+      BOOST_CHECK_EQUAL( get_balance( cid_id, asset_id_type() ), initial_balance - 4 );
+      BOOST_CHECK( db.is_known_transaction( trxs[0].id() ) );
+      BOOST_CHECK( !db.is_known_transaction( trxs[1].id() ) );
+      BOOST_CHECK( db.is_known_transaction( trxs[2].id() ) );
+
+      // an empty batch is fine, an oversized one is rejected as a whole
+      BOOST_CHECK( nb_api->broadcast_transaction_batch( {} ).empty() );
+      std::vector<precomputable_transaction> too_many( app.get_options().api_limit_broadcast_transaction_batch + 1,
+                                                       trxs[0] );
+      BOOST_CHECK_THROW( nb_api->broadcast_transaction_batch( too_many ), fc::exception );
+
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,690 @@
+/*
+ * Copyright (c) 2021 Contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/net/copy_on_write_set.hpp>
+#include <graphene/net/core_messages.hpp>
+#include <graphene/net/inventory_filter.hpp>
+#include <graphene/net/message.hpp>
+#include <graphene/net/message_cache.hpp>
+#include <graphene/net/message_io_pool.hpp>
+#include <graphene/net/peer_database.hpp>
+#include <graphene/net/relay_scheduler.hpp>
+#include <graphene/utilities/tempdir.hpp>
+#include <graphene/protocol/custom.hpp>
+
+#include <fc/crypto/ripemd160.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/string.hpp>
+#include <fc/thread/thread.hpp>
+
+#include "../common/simulated_network.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace graphene::net;
+using namespace graphene::protocol;
+
+namespace {
+
+/// A node delegate which only counts the blocks delivered to it
+class counting_node_delegate : public node_delegate
+{
+   public:
+      uint32_t blocks_received = 0;
+      uint64_t peak_live_message_bytes = 0;
+
+      bool has_item( const item_id& ) override { return false; }
+      bool handle_block( const block_message&, bool, std::vector<message_hash_type>& ) override
+      {
+         ++blocks_received;
+         peak_live_message_bytes = std::max( peak_live_message_bytes, message_buffer::live_bytes() );
+         return false;
+      }
+      void handle_transaction( const trx_message& ) override {}
+      void handle_message( const message& ) override {}
+      std::vector<item_hash_t> get_block_ids( const std::vector<item_hash_t>&, uint32_t& remaining_item_count,
+                                              uint32_t ) override
+      {
+         remaining_item_count = 0;
+         return {};
+      }
+      message get_item( const item_id& id ) override { return item_not_available_message( id ); }
+      chain_id_type get_chain_id()const override { return chain_id_type(); }
+      std::vector<item_hash_t> get_blockchain_synopsis( const item_hash_t&, uint32_t ) override { return {}; }
+      void sync_status( uint32_t, uint32_t ) override {}
+      void connection_count_changed( uint32_t ) override {}
+      uint32_t get_block_number( const item_hash_t& ) override { return 0; }
+      fc::time_point_sec get_block_time( const item_hash_t& ) override { return fc::time_point_sec::min(); }
+      item_hash_t get_head_block_id()const override { return item_hash_t(); }
+      uint32_t estimate_last_known_fork_from_git_revision_timestamp( uint32_t ) const override { return 0; }
+      void error_encountered( const std::string&, const fc::oexception& ) override {}
+      uint8_t get_current_block_interval_in_seconds()const override { return 5; }
+};
+
+/// Returns a block with a custom operation carrying @p payload_size bytes
+signed_block make_large_block( size_t payload_size )
+{
+   custom_operation op;
+   op.data.resize( payload_size, 'x' );
+   signed_transaction trx;
+   trx.operations.push_back( op );
+   signed_block blk;
+   blk.transactions.push_back( trx );
+   return blk;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( p2p_node_tests )
+
+BOOST_AUTO_TEST_CASE( message_buffer_sharing )
+{
+   const block_message blk_msg( make_large_block( 1000 ) );
+   const uint64_t live_before = message_buffer::live_bytes();
+
+   const message original( blk_msg );
+   BOOST_CHECK_EQUAL( original.data.size(), original.size.value() );
+   BOOST_CHECK_EQUAL( message_buffer::live_bytes(), live_before + original.data.size() );
+
+   // copies share the payload
+   message copy( original );
+   BOOST_CHECK( copy.data.data() == original.data.data() );
+   BOOST_CHECK_EQUAL( original.data.use_count(), 2 );
+   BOOST_CHECK_EQUAL( message_buffer::live_bytes(), live_before + original.data.size() );
+   BOOST_CHECK( copy.id() == original.id() );
+   BOOST_CHECK( copy.as<block_message>().block_id == blk_msg.block_id );
+
+   // assigning a new payload detaches the copy
+   std::vector<char> bytes = copy.data.to_vector();
+   bytes.back() ^= 1;
+   copy.data = std::move( bytes );
+   BOOST_CHECK( copy.data.data() != original.data.data() );
+   BOOST_CHECK_EQUAL( original.data.use_count(), 1 );
+   BOOST_CHECK( copy.id() != original.id() );
+   BOOST_CHECK_EQUAL( message_buffer::live_bytes(), live_before + 2 * original.data.size() );
+
+   // the serialization is the one of a plain vector
+   const std::vector<char> packed = fc::raw::pack( original );
+   std::vector<char> expected( (const char*)&original, (const char*)&original + sizeof(message_header) );
+   const std::vector<char> packed_data = fc::raw::pack( original.data.to_vector() );
+   expected.insert( expected.end(), packed_data.begin(), packed_data.end() );
+   BOOST_CHECK( packed == expected );
+
+   const message unpacked = fc::raw::unpack<message>( packed );
+   BOOST_CHECK( unpacked.id() == original.id() );
+   BOOST_CHECK_EQUAL( unpacked.size.value(), original.size.value() );
+
+   copy = message();
+   BOOST_CHECK( copy.data.empty() );
+   BOOST_CHECK( copy.data.data() == nullptr );
+}
+
+// Messages prepared by the I/O threads carry their hash and decoded payload to the node thread
+BOOST_AUTO_TEST_CASE( message_io_pool_prepare )
+{
+   message_io_pool pool( 2, decode_message_payload );
+   const block_message blk_msg( make_large_block( 100 ) );
+   const message original( blk_msg );
+
+   const message prepared = pool.next_thread().async( [&pool,&original]() {
+      return pool.prepare_message( original, original.data.to_vector() );
+   } ).wait();
+   BOOST_REQUIRE( prepared.data.precomputed_id().valid() );
+   BOOST_CHECK( prepared.id() == original.id() );
+   BOOST_CHECK_EQUAL( prepared.size.value(), original.size.value() );
+   BOOST_REQUIRE( prepared.data.decoded() );
+   const std::shared_ptr<const block_message> decoded = prepared.as_shared<block_message>();
+   BOOST_CHECK( decoded.get() == prepared.data.decoded().get() );
+   BOOST_CHECK( decoded->block_id == blk_msg.block_id );
+
+   // caches keep the payload only
+   blockchain_tied_message_cache cache( 1024 * 1024, 2 );
+   cache.cache_message( prepared, prepared.id(),
+                        message_propagation_data{ fc::time_point::now(), fc::time_point::now(), node_id_t() },
+                        blk_msg.block_id );
+   const message cached = cache.get_message( prepared.id() );
+   BOOST_CHECK( !cached.data.decoded() );
+   BOOST_CHECK( cached.data.data() == prepared.data.data() );
+   BOOST_CHECK( prepared.data.decoded() );
+
+   // the precomputed hash and decoded payload don't survive a change of the payload
+   message copy( prepared );
+   copy.data = copy.data.to_vector();
+   BOOST_CHECK( !copy.data.precomputed_id().valid() );
+   BOOST_CHECK( !copy.data.decoded() );
+   BOOST_CHECK( copy.id() == original.id() );
+   BOOST_CHECK( copy.as_shared<block_message>()->block_id == blk_msg.block_id );
+
+   // other types are only hashed
+   const message inventory( item_ids_inventory_message( trx_message_type, { original.id() } ) );
+   const message prepared_inventory = pool.prepare_message( inventory, inventory.data.to_vector() );
+   BOOST_CHECK( prepared_inventory.id() == inventory.id() );
+   BOOST_CHECK( !prepared_inventory.data.decoded() );
+   BOOST_CHECK_EQUAL( prepared_inventory.as<item_ids_inventory_message>().item_hashes_available.size(), 1u );
+
+   // a payload which can't be decoded is left for the node thread to reject
+   message_header header;
+   header.msg_type = block_message_type;
+   header.size = 3;
+   const message garbage = pool.prepare_message( header, std::vector<char>{ 1, 2, 3 } );
+   BOOST_CHECK( !garbage.data.decoded() );
+   BOOST_CHECK_THROW( garbage.as_shared<block_message>(), fc::exception );
+
+   const message_io_statistics stats = pool.get_statistics();
+   BOOST_CHECK_EQUAL( stats.threads, 2u );
+   BOOST_CHECK_EQUAL( stats.messages_prepared, 3u );
+   BOOST_CHECK_EQUAL( stats.bytes_prepared, original.data.size() + inventory.data.size() + 3 );
+}
+
+// Broadcasts a large block to many nodes and checks that the payload is held in memory only once
+BOOST_AUTO_TEST_CASE( broadcast_fan_out_memory )
+{
+   const uint32_t num_nodes = 100;
+   const size_t payload_size = 1024 * 1024;
+
+   simulated_network network( "fan-out" );
+   std::vector<std::shared_ptr<counting_node_delegate>> delegates;
+   for( uint32_t i = 0; i < num_nodes; ++i )
+   {
+      delegates.push_back( std::make_shared<counting_node_delegate>() );
+      network.add_node_delegate( delegates.back() );
+   }
+
+   const uint64_t live_before = message_buffer::live_bytes();
+   uint64_t message_size = 0;
+   {
+      const message block_to_broadcast( block_message( make_large_block( payload_size ) ) );
+      message_size = block_to_broadcast.data.size();
+      BOOST_REQUIRE_GT( message_size, payload_size );
+
+      network.broadcast( block_to_broadcast );
+      // all nodes have the message queued now, and nothing has been delivered yet
+      BOOST_CHECK_EQUAL( block_to_broadcast.data.use_count(), long( num_nodes ) + 1 );
+      BOOST_CHECK_EQUAL( message_buffer::live_bytes(), live_before + message_size );
+   }
+
+   const fc::time_point deadline = fc::time_point::now() + fc::seconds( 30 );
+   const auto all_delivered = [&delegates]() {
+      return std::all_of( delegates.begin(), delegates.end(),
+                          []( const std::shared_ptr<counting_node_delegate>& d ) { return d->blocks_received > 0; } );
+   };
+   while( !all_delivered() && fc::time_point::now() < deadline )
+      fc::usleep( fc::milliseconds( 10 ) );
+   BOOST_REQUIRE( all_delivered() );
+
+   uint64_t peak = 0;
+   for( const auto& d : delegates )
+   {
+      BOOST_CHECK_EQUAL( d->blocks_received, 1u );
+      peak = std::max( peak, d->peak_live_message_bytes );
+   }
+   BOOST_CHECK_LE( peak, live_before + message_size );
+   BOOST_CHECK_EQUAL( message_buffer::live_bytes(), live_before );
+   BOOST_TEST_MESSAGE( "Peak message memory while delivering " << message_size << " bytes to " << num_nodes
+                       << " nodes: " << ( peak - live_before ) << " bytes" );
+}
+
+BOOST_AUTO_TEST_CASE( rolling_inventory_filter_test )
+{
+   const fc::microseconds lifetime = fc::minutes( 2 );
+   rolling_inventory_filter filter( lifetime, 8 ); // buckets of 15 seconds
+   const fc::time_point start = fc::time_point::now();
+
+   // one new item per second for four minutes
+   const uint32_t seconds = 240;
+   std::vector<item_hash_t> hashes;
+   for( uint32_t i = 0; i < seconds; ++i )
+      hashes.push_back( fc::ripemd160::hash( fc::to_string( i ) ) );
+
+   for( uint32_t i = 0; i < seconds; ++i )
+   {
+      const fc::time_point now = start + fc::seconds( i );
+      filter.expire( now );
+      BOOST_CHECK( filter.insert( hashes[i], now ) );
+      BOOST_CHECK( !filter.insert( hashes[i], now ) );
+      BOOST_CHECK( filter.contains( item_id( trx_message_type, hashes[i] ) ) );
+      for( uint32_t j = 0; j < i; ++j )
+      {
+         // items are kept for the lifetime, and forgotten at most one bucket later
+         const fc::microseconds age = fc::seconds( i - j );
+         if( age < lifetime )
+            BOOST_CHECK( filter.contains( hashes[j] ) );
+         else if( age >= lifetime + fc::seconds( 15 ) )
+            BOOST_CHECK( !filter.contains( hashes[j] ) );
+      }
+      BOOST_CHECK_LE( filter.size(), 135u );
+   }
+   BOOST_CHECK_GE( filter.size(), 120u );
+
+   // erased items are gone, the others stay
+   const size_t size_before = filter.size();
+   BOOST_CHECK( filter.erase( hashes[seconds - 1] ) );
+   BOOST_CHECK( !filter.erase( hashes[seconds - 1] ) );
+   BOOST_CHECK( !filter.contains( hashes[seconds - 1] ) );
+   BOOST_CHECK( filter.contains( hashes[seconds - 2] ) );
+   BOOST_CHECK_EQUAL( filter.size(), size_before - 1 );
+
+   // everything is forgotten eventually
+   BOOST_CHECK_EQUAL( filter.expire( start + fc::seconds( seconds ) + lifetime + fc::seconds( 15 ) ), size_before - 1 );
+   BOOST_CHECK( filter.empty() );
+   BOOST_CHECK( !filter.contains( hashes[seconds - 2] ) );
+
+   // erasing and inserting many items in the same bucket
+   for( uint32_t round = 0; round < 20; ++round )
+   {
+      for( const item_hash_t& hash : hashes )
+         BOOST_CHECK( filter.insert( hash, start ) );
+      for( const item_hash_t& hash : hashes )
+         BOOST_CHECK( filter.erase( hash ) );
+   }
+   BOOST_CHECK( filter.empty() );
+   for( const item_hash_t& hash : hashes )
+      BOOST_CHECK( !filter.contains( hash ) );
+}
+
+BOOST_AUTO_TEST_CASE( copy_on_write_set_test )
+{
+   copy_on_write_set<uint32_t> set;
+   BOOST_CHECK( set.empty() );
+   BOOST_CHECK( set.insert( 1 ) );
+   BOOST_CHECK( set.insert( 2 ) );
+   BOOST_CHECK( !set.insert( 2 ) );
+   BOOST_CHECK_EQUAL( set.size(), 2u );
+   BOOST_CHECK( set.contains( 1 ) );
+   BOOST_CHECK( !set.contains( 3 ) );
+
+   // a snapshot keeps its contents while the set changes, so the set can be changed while iterating it
+   const auto before = set.snapshot();
+   for( uint32_t element : set.snapshot() )
+   {
+      BOOST_CHECK_EQUAL( set.erase( element ), 1u );
+      set.insert( element + 10 );
+   }
+   BOOST_CHECK_EQUAL( before.size(), 2u );
+   BOOST_CHECK( before.contains( 1 ) && before.contains( 2 ) );
+   BOOST_CHECK_EQUAL( set.size(), 2u );
+   BOOST_CHECK( set.contains( 11 ) && set.contains( 12 ) );
+   BOOST_CHECK_EQUAL( set.erase( 1 ), 0u );
+
+   set.clear();
+   BOOST_CHECK( set.empty() );
+   BOOST_CHECK_EQUAL( before.size(), 2u );
+
+   // readers on other threads always see a consistent set while it is being changed
+   const uint32_t rounds = 2000;
+   std::vector<std::unique_ptr<fc::thread>> readers;
+   for( uint32_t i = 0; i < 4; ++i )
+      readers.emplace_back( new fc::thread( "reader" + fc::to_string( i ) ) );
+   std::vector<fc::future<uint32_t>> inconsistent_snapshots;
+   for( const auto& reader : readers )
+      inconsistent_snapshots.push_back( reader->async( [&set, rounds]() {
+         uint32_t inconsistent = 0;
+         for( uint32_t i = 0; i < rounds; ++i )
+         {
+            // the writer always keeps the elements even, and removes one before adding the next
+            const auto snapshot = set.snapshot();
+            if( snapshot.size() > 1 )
+               ++inconsistent;
+            for( uint32_t element : snapshot )
+               if( element % 2 != 0 )
+                  ++inconsistent;
+         }
+         return inconsistent;
+      } ) );
+   for( uint32_t i = 0; i < rounds; ++i )
+   {
+      set.insert( 2 * i );
+      set.erase( 2 * i );
+   }
+   for( fc::future<uint32_t>& inconsistent : inconsistent_snapshots )
+      BOOST_CHECK_EQUAL( inconsistent.wait(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( message_cache_test )
+{
+   const size_t payload_size = 1000;
+   const auto make_message = [payload_size]( uint32_t i ) {
+      message result;
+      result.msg_type = trx_message_type;
+      result.data = std::vector<char>( payload_size, char( i ) );
+      result.size = uint32_t( payload_size );
+      return result;
+   };
+   const auto contents_hash = []( uint32_t i ) { return fc::ripemd160::hash( "contents" + fc::to_string( i ) ); };
+
+   std::vector<message> messages;
+   for( uint32_t i = 0; i < 10; ++i )
+      messages.push_back( make_message( i ) );
+   const message_propagation_data propagation_data{ fc::time_point::now(), fc::time_point::now(), node_id_t() };
+
+   // messages are kept while at most 2 blocks were accepted after the one they were cached in
+   {
+      blockchain_tied_message_cache cache( 1024 * 1024, 2 );
+      for( uint32_t i = 0; i < 4; ++i )
+      {
+         cache.cache_message( messages[i], messages[i].id(), propagation_data, contents_hash( i ) );
+         cache.cache_message( messages[i], messages[i].id(), propagation_data, contents_hash( i ) );
+         cache.block_accepted();
+      }
+      // 4 blocks were accepted, the messages of blocks 0 and 1 expired, those of blocks 2 and 3 are still there
+      BOOST_CHECK_EQUAL( cache.size(), 2u );
+      for( uint32_t i = 0; i < 2; ++i )
+      {
+         BOOST_CHECK_THROW( cache.get_message( messages[i].id() ), fc::key_not_found_exception );
+         BOOST_CHECK_THROW( cache.get_message_propagation_data( contents_hash( i ) ), fc::key_not_found_exception );
+      }
+      for( uint32_t i = 2; i < 4; ++i )
+      {
+         BOOST_CHECK( cache.get_message( messages[i].id() ).id() == messages[i].id() );
+         BOOST_CHECK( cache.get_message_propagation_data( contents_hash( i ) ).received_time
+                      == propagation_data.received_time );
+      }
+      BOOST_CHECK_THROW( cache.get_message_propagation_data( message_hash_type() ), fc::key_not_found_exception );
+
+      cache.block_accepted();
+      cache.block_accepted();
+      cache.block_accepted();
+      BOOST_CHECK_EQUAL( cache.size(), 0u );
+
+      const message_cache_statistics stats = cache.get_statistics();
+      BOOST_CHECK_EQUAL( stats.messages, 0u );
+      BOOST_CHECK_EQUAL( stats.bytes, 0u );
+      BOOST_CHECK_EQUAL( stats.hits, 2u );
+      BOOST_CHECK_EQUAL( stats.misses, 2u );
+      BOOST_CHECK_EQUAL( stats.evictions, 0u );
+      BOOST_CHECK_EQUAL( stats.expirations, 4u );
+   }
+
+   // the byte budget evicts the least recently used messages of the oldest block first
+   {
+      blockchain_tied_message_cache cache( 1024 * 1024, 5 );
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         cache.cache_message( messages[i], messages[i].id(), propagation_data, contents_hash( i ) );
+         if( i % 5 == 4 )
+            cache.block_accepted();
+      }
+      BOOST_REQUIRE_EQUAL( cache.size(), 10u );
+      const uint64_t bytes_per_message = cache.get_statistics().bytes / 10;
+      BOOST_REQUIRE_GT( bytes_per_message, payload_size );
+
+      // messages 0 to 4 are in the oldest block, 0 and 1 were requested recently
+      cache.get_message( messages[1].id() );
+      cache.get_message( messages[0].id() );
+
+      cache.set_max_bytes( bytes_per_message * 7 );
+      BOOST_CHECK_EQUAL( cache.size(), 7u );
+      BOOST_CHECK_LE( cache.get_statistics().bytes, bytes_per_message * 7 );
+      for( uint32_t i : { 2, 3, 4 } )
+         BOOST_CHECK_THROW( cache.get_message( messages[i].id() ), fc::key_not_found_exception );
+      for( uint32_t i : { 0, 1, 5, 6, 7, 8, 9 } )
+         BOOST_CHECK( cache.get_message( messages[i].id() ).id() == messages[i].id() );
+
+      // the newer block is only touched when the older one is gone
+      cache.set_max_bytes( bytes_per_message * 4 );
+      BOOST_CHECK_EQUAL( cache.size(), 4u );
+      for( uint32_t i : { 0, 1, 5 } )
+         BOOST_CHECK_THROW( cache.get_message( messages[i].id() ), fc::key_not_found_exception );
+      BOOST_CHECK_THROW( cache.get_message_propagation_data( contents_hash( 5 ) ), fc::key_not_found_exception );
+      BOOST_CHECK_NO_THROW( cache.get_message_propagation_data( contents_hash( 6 ) ) );
+
+      // a message larger than the budget is still kept until the next one arrives
+      cache.set_max_bytes( 0 );
+      BOOST_CHECK_EQUAL( cache.size(), 1u );
+      cache.cache_message( messages[0], messages[0].id(), propagation_data, contents_hash( 0 ) );
+      BOOST_CHECK_EQUAL( cache.size(), 1u );
+      BOOST_CHECK_NO_THROW( cache.get_message( messages[0].id() ) );
+
+      const message_cache_statistics stats = cache.get_statistics();
+      BOOST_CHECK_EQUAL( stats.messages, 1u );
+      BOOST_CHECK_EQUAL( stats.max_bytes, 0u );
+      BOOST_CHECK_EQUAL( stats.evictions, 10u );
+      BOOST_CHECK_EQUAL( stats.expirations, 0u );
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_range_message_test )
+{
+   std::vector<signed_block> blocks;
+   std::vector<std::vector<char>> packed_blocks;
+   size_t total_size = 0;
+   for( uint32_t i = 0; i < 5; ++i )
+   {
+      signed_block blk = make_large_block( 10000 );
+      if( !blocks.empty() )
+         blk.previous = blocks.back().id();
+      blocks.push_back( blk );
+      packed_blocks.push_back( fc::raw::pack( blk ) );
+      total_size += packed_blocks.back().size();
+   }
+
+   for( const block_range_codec codec : { block_range_codec::uncompressed, block_range_codec::zlib } )
+   {
+      const block_range_message range( 1, packed_blocks, codec );
+      BOOST_CHECK_EQUAL( range.block_count, blocks.size() );
+      if( codec == block_range_codec::uncompressed )
+         BOOST_CHECK_EQUAL( range.packed_blocks.size(), total_size );
+      else
+         BOOST_CHECK_LT( range.packed_blocks.size(), total_size / 10 );
+
+      // through the wire format and back
+      const message range_message( range );
+      const std::vector<signed_block> received = range_message.as<block_range_message>().get_blocks();
+      BOOST_REQUIRE_EQUAL( received.size(), blocks.size() );
+      for( size_t i = 0; i < blocks.size(); ++i )
+         BOOST_CHECK( received[i].id() == blocks[i].id() );
+
+      // a peer claiming more blocks than it sent, or sending more data than it claims, is caught
+      block_range_message wrong_count = range;
+      ++wrong_count.block_count;
+      BOOST_CHECK_THROW( wrong_count.get_blocks(), fc::exception );
+      --wrong_count.block_count;
+      --wrong_count.block_count;
+      BOOST_CHECK_THROW( wrong_count.get_blocks(), fc::exception );
+
+      block_range_message truncated = range;
+      truncated.packed_blocks.resize( truncated.packed_blocks.size() / 2 );
+      BOOST_CHECK_THROW( truncated.get_blocks(), fc::exception );
+   }
+
+   // a compressed range may not inflate to more than fits in a message
+   const std::vector<std::vector<char>> huge_block{ std::vector<char>( MAX_MESSAGE_SIZE + 1, 0 ) };
+   const block_range_message zip_bomb( 1, huge_block, block_range_codec::zlib );
+   BOOST_CHECK_LT( zip_bomb.packed_blocks.size(), 100000u );
+   BOOST_CHECK_THROW( zip_bomb.get_blocks(), fc::exception );
+
+   const block_range_message empty_range( 1, std::vector<std::vector<char>>(), block_range_codec::zlib );
+   BOOST_CHECK_EQUAL( empty_range.block_count, 0u );
+   BOOST_CHECK( empty_range.get_blocks().empty() );
+}
+
+BOOST_AUTO_TEST_CASE( transaction_relay_scheduler_test )
+{
+   // 10 transactions per second, bursts of 2, at most 3 queued per peer
+   transaction_relay_scheduler scheduler( 10, 2, 3 );
+   const fc::time_point start = fc::time_point::now();
+   int peer_a = 0;
+   int peer_b = 0;
+   auto make_trx = []( uint64_t priority ) {
+      transaction_relay_scheduler::queued_transaction trx;
+      trx.priority = priority;
+      trx.message_hash = fc::ripemd160::hash( fc::to_string( priority ) );
+      return trx;
+   };
+
+   BOOST_CHECK( !scheduler.pop( start ) );
+   BOOST_CHECK( scheduler.next_ready_time( start ) == fc::time_point::maximum() );
+
+   // the cheapest transaction is dropped when the queue is full
+   BOOST_CHECK( scheduler.push( &peer_a, make_trx( 5 ), start ) );
+   BOOST_CHECK( scheduler.push( &peer_a, make_trx( 1 ), start ) );
+   BOOST_CHECK( scheduler.push( &peer_a, make_trx( 9 ), start ) );
+   BOOST_CHECK( scheduler.push( &peer_a, make_trx( 3 ), start ) );
+   BOOST_CHECK( !scheduler.push( &peer_a, make_trx( 0 ), start ) );
+   BOOST_CHECK( scheduler.push( &peer_b, make_trx( 0 ), start ) );
+   BOOST_CHECK_EQUAL( scheduler.size(), 4u );
+   BOOST_CHECK( scheduler.contains( make_trx( 3 ).message_hash ) );
+   BOOST_CHECK( !scheduler.contains( make_trx( 1 ).message_hash ) );
+   BOOST_CHECK( scheduler.contains( make_trx( 0 ).message_hash ) );
+
+   // peers take turns, each serving its best transaction first
+   BOOST_CHECK_EQUAL( scheduler.pop( start )->priority, 9u );
+   BOOST_CHECK_EQUAL( scheduler.pop( start )->priority, 0u );
+   BOOST_CHECK_EQUAL( scheduler.pop( start )->priority, 5u );
+   BOOST_CHECK( !scheduler.contains( make_trx( 5 ).message_hash ) );
+
+   // peer a has used its burst, the next token comes 100 ms later
+   BOOST_CHECK( !scheduler.pop( start ) );
+   const fc::time_point ready = scheduler.next_ready_time( start );
+   BOOST_CHECK( ready > start + fc::milliseconds( 99 ) );
+   BOOST_CHECK( ready <= start + fc::milliseconds( 101 ) );
+   BOOST_CHECK( !scheduler.pop( start + fc::milliseconds( 50 ) ) );
+   BOOST_CHECK_EQUAL( scheduler.pop( ready )->priority, 3u );
+   BOOST_CHECK_EQUAL( scheduler.size(), 0u );
+   BOOST_CHECK( scheduler.next_ready_time( ready ) == fc::time_point::maximum() );
+
+   relay_queue_statistics stats = scheduler.get_statistics( &peer_a, ready );
+   BOOST_CHECK_EQUAL( stats.queued, 0u );
+   BOOST_CHECK_EQUAL( stats.received, 5u );
+   BOOST_CHECK_EQUAL( stats.dispatched, 3u );
+   BOOST_CHECK_EQUAL( stats.dropped, 2u );
+   BOOST_CHECK_LT( stats.tokens, 1 );
+
+   // the budget is refilled up to the burst size
+   stats = scheduler.get_statistics( &peer_a, ready + fc::seconds( 10 ) );
+   BOOST_CHECK_EQUAL( stats.tokens, 2 );
+
+   // a peer which disconnects loses its queue
+   scheduler.push( &peer_b, make_trx( 7 ), ready );
+   scheduler.push( &peer_b, make_trx( 8 ), ready );
+   BOOST_CHECK_EQUAL( scheduler.size(), 2u );
+   const auto dropped = scheduler.remove_peer( &peer_b );
+   BOOST_CHECK_EQUAL( dropped.size(), 2u );
+   BOOST_CHECK( std::find( dropped.begin(), dropped.end(), make_trx( 7 ).message_hash ) != dropped.end() );
+   BOOST_CHECK_EQUAL( scheduler.size(), 0u );
+   BOOST_CHECK( !scheduler.contains( make_trx( 8 ).message_hash ) );
+   BOOST_CHECK( !scheduler.pop( ready + fc::seconds( 10 ) ) );
+   BOOST_CHECK_EQUAL( scheduler.get_statistics( &peer_b ).received, 0u );
+}
+
+BOOST_AUTO_TEST_CASE( peer_database_log )
+{
+   fc::temp_directory td( graphene::utilities::temp_directory_path() );
+   const fc::path filename = td.path() / "peers.dat";
+   const auto endpoint = []( uint32_t i ) {
+      return fc::ip::endpoint( fc::ip::address( 0x0a000000 + i ), 1776 );
+   };
+   const fc::time_point_sec now( fc::time_point::now() );
+
+   {
+      peer_database db;
+      db.open( filename );
+      BOOST_CHECK_EQUAL( db.size(), 0u );
+      for( uint32_t i = 0; i < 10; ++i )
+         db.update_entry( potential_peer_record( endpoint( i ), now + i ) );
+      db.erase( endpoint( 3 ) );
+      potential_peer_record updated = db.lookup_or_create_entry_for_endpoint( endpoint( 5 ) );
+      updated.number_of_successful_connection_attempts = 7;
+      updated.last_connection_disposition = last_connection_succeeded;
+      db.update_entry( updated );
+      // the node is killed without closing the database
+      BOOST_CHECK( fc::exists( filename ) );
+      std::ofstream( ( td.path() / "copy.dat" ).generic_string().c_str(), std::ios::binary )
+            << std::ifstream( filename.generic_string().c_str(), std::ios::binary ).rdbuf();
+      db.close();
+   }
+
+   const auto check_records = [&]( peer_database& db ) {
+      BOOST_CHECK_EQUAL( db.size(), 9u );
+      BOOST_CHECK( !db.lookup_entry_for_endpoint( endpoint( 3 ) ) );
+      const fc::optional<potential_peer_record> record = db.lookup_entry_for_endpoint( endpoint( 5 ) );
+      BOOST_REQUIRE( record );
+      BOOST_CHECK_EQUAL( record->number_of_successful_connection_attempts, 7u );
+      BOOST_CHECK( record->last_connection_disposition == last_connection_succeeded );
+      BOOST_CHECK( record->last_seen_time == now + 5 );
+      // ordered by last seen time, newest first
+      BOOST_CHECK( db.begin()->endpoint == endpoint( 9 ) );
+   };
+
+   {
+      peer_database db;
+      db.open( filename );
+      check_records( db );
+      db.close();
+   }
+
+   // a truncated entry at the end of the log is ignored
+   {
+      std::ofstream out( ( td.path() / "copy.dat" ).generic_string().c_str(), std::ios::binary | std::ios::app );
+      out.write( "\0\xff\x00", 3 );
+   }
+   {
+      peer_database db;
+      db.open( td.path() / "copy.dat" );
+      check_records( db );
+
+      // the log is compacted while it grows
+      const uint64_t compacted_size = fc::file_size( td.path() / "copy.dat" );
+      potential_peer_record record = *db.lookup_entry_for_endpoint( endpoint( 1 ) );
+      for( uint32_t i = 0; i < 10000; ++i )
+      {
+         record.number_of_failed_connection_attempts = i;
+         db.update_entry( record );
+      }
+      BOOST_CHECK_LT( fc::file_size( td.path() / "copy.dat" ), compacted_size * 300 );
+      db.close();
+      BOOST_CHECK_EQUAL( fc::file_size( td.path() / "copy.dat" ), compacted_size );
+   }
+
+   // the JSON file of older versions is converted
+   {
+      std::vector<potential_peer_record> records;
+      for( uint32_t i = 0; i < 5; ++i )
+         records.emplace_back( endpoint( i ), now + i );
+      fc::create_directories( td.path() / "legacy" );
+      fc::json::save_to_file( records, td.path() / "legacy" / "peers.json" );
+      peer_database db;
+      db.open( td.path() / "legacy" / "peers.dat" );
+      BOOST_CHECK_EQUAL( db.size(), 5u );
+      BOOST_CHECK( db.lookup_entry_for_endpoint( endpoint( 4 ) ) );
+      db.close();
+      BOOST_CHECK( fc::exists( td.path() / "legacy" / "peers.dat" ) );
+   }
+
+   // a file which is not a peer database is ignored
+   {
+      fc::json::save_to_file( std::vector<potential_peer_record>(), td.path() / "bad.dat" );
+      peer_database db;
+      db.open( td.path() / "bad.dat" );
+      BOOST_CHECK_EQUAL( db.size(), 0u );
+      db.close();
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3739,5 +3739,86 @@ BOOST_AUTO_TEST_CASE( hf2262_auto_update_test )
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE( ticket_compaction_test )
+{ try {
+
+      generate_blocks( HARDFORK_CORE_2262_TIME );
+      generate_block();
+      set_expiration( db, trx );
+
+      ACTORS((sam)(ted));
+
+      auto init_amount = 10000000 * GRAPHENE_BLOCKCHAIN_PRECISION;
+      fund( sam, asset(init_amount) );
+      fund( ted, asset(init_amount) );
+
+      // create tickets which will be stable before the hard fork
+      ticket_id_type sam_1_id = create_ticket( sam_id, lock_180_days, asset(100) ).id;
+      ticket_id_type sam_2_id = create_ticket( sam_id, lock_180_days, asset(200) ).id;
+      ticket_id_type sam_3_id = create_ticket( sam_id, lock_360_days, asset(300) ).id;
+      ticket_id_type sam_4_id = create_ticket( sam_id, lock_forever, asset(400) ).id;
+      ticket_id_type ted_1_id = create_ticket( ted_id, lock_180_days, asset(500) ).id;
+
+      // the lock_forever ticket loses all the value after 4 charging steps and 4 update steps
+      generate_blocks( db.head_block_time() + fc::days( 4 * 15 + 4 * 180 + 1 ) );
+      set_expiration( db, trx );
+
+      BOOST_CHECK( sam_1_id(db).status == stable );
+      BOOST_CHECK( sam_2_id(db).status == stable );
+      BOOST_CHECK( sam_3_id(db).status == stable );
+      BOOST_CHECK( sam_4_id(db).status == stable );
+      BOOST_CHECK_EQUAL( sam_4_id(db).value.value, 0 );
+      BOOST_CHECK( ted_1_id(db).status == stable );
+
+      // nothing is compacted before the hard fork
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      BOOST_CHECK( db.find( sam_2_id ) );
+      BOOST_CHECK( db.find( sam_4_id ) );
+
+      const auto inactive_before = db.get_dynamic_global_properties().total_inactive;
+
+      // pass the hard fork
+      generate_blocks( HARDFORK_TICKET_COMPACTION_TIME );
+      generate_blocks( db.get_dynamic_global_properties().next_maintenance_time );
+      set_expiration( db, trx );
+
+      // the lock_180 tickets of sam are merged into the oldest one
+      BOOST_CHECK( !db.find( sam_2_id ) );
+      BOOST_CHECK( sam_1_id(db).amount == asset(300) );
+      BOOST_CHECK_EQUAL( sam_1_id(db).value.value, 300 * 2 );
+      BOOST_CHECK( sam_3_id(db).amount == asset(300) );
+      BOOST_CHECK( ted_1_id(db).amount == asset(500) );
+
+      // the lock_forever ticket without value is removed, its amount stays inactive and in the supply
+      BOOST_CHECK( !db.find( sam_4_id ) );
+      BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().total_pruned_inactive.value, 400 );
+      BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().total_inactive.value, inactive_before.value );
+      BOOST_CHECK_EQUAL( sam_id(db).statistics(db).total_core_inactive.value, 400 );
+      BOOST_CHECK_EQUAL( sam_id(db).statistics(db).total_core_pol.value, 600 );
+      BOOST_CHECK_EQUAL( sam_id(db).statistics(db).total_pol_value.value, 300 * 2 + 300 * 4 );
+      verify_asset_supplies( db );
+
+      // a ticket which becomes stable after the hard fork is merged right away
+      ticket_id_type sam_5_id = create_ticket( sam_id, lock_180_days, asset(50) ).id;
+      generate_blocks( db.head_block_time() + fc::days(15) );
+      set_expiration( db, trx );
+
+      BOOST_CHECK( !db.find( sam_5_id ) );
+      BOOST_CHECK( sam_1_id(db).amount == asset(350) );
+      BOOST_CHECK_EQUAL( sam_1_id(db).value.value, 350 * 2 );
+      BOOST_CHECK_EQUAL( sam_id(db).statistics(db).total_core_pol.value, 650 );
+
+      // a lock_forever ticket is removed as soon as it loses all the value
+      ticket_id_type ted_2_id = create_ticket( ted_id, lock_forever, asset(1000) ).id;
+      generate_blocks( db.head_block_time() + fc::days( 4 * 15 + 4 * 180 + 1 ) );
+      set_expiration( db, trx );
+
+      BOOST_CHECK( !db.find( ted_2_id ) );
+      BOOST_CHECK_EQUAL( db.get_dynamic_global_properties().total_pruned_inactive.value, 1400 );
+      BOOST_CHECK_EQUAL( ted_id(db).statistics(db).total_core_inactive.value, 1000 );
+      BOOST_CHECK_EQUAL( ted_id(db).statistics(db).total_core_pob.value, 0 );
+
+   } FC_LOG_AND_RETHROW()
+}
 
 BOOST_AUTO_TEST_SUITE_END()